@@ -95,6 +95,11 @@ void Client::sendMovement() {
 	}
 }
 
+void Client::sendEntitySnapshotAck(uint32_t sequence) {
+	_messageSender->sendClientMessage(_snapshotAckFbb, network::ClientMsgType::EntitySnapshotAck,
+			network::CreateEntitySnapshotAck(_snapshotAckFbb, sequence).Union(), 0u);
+}
+
 void Client::onEvent(const network::DisconnectEvent& event) {
 	_network->destroy();
 	pushWindow("login");
@@ -102,6 +107,8 @@ void Client::onEvent(const network::DisconnectEvent& event) {
 }
 
 void Client::onEvent(const network::NewConnectionEvent& event) {
+	// the server starts with full states for a new connection
+	_snapshotDecoder.reset();
 	flatbuffers::FlatBufferBuilder fbb;
 	const core::String& email = core::Var::getSafe(cfg::ClientEmail)->strVal();
 	const core::String& password = core::Var::getSafe(cfg::ClientPassword)->strVal();
@@ -170,6 +177,7 @@ app::AppState Client::onInit() {
 	regHandler(network::ServerMsgType::EntitySpawn, EntitySpawnHandler);
 	regHandler(network::ServerMsgType::EntityRemove, EntityRemoveHandler);
 	regHandler(network::ServerMsgType::EntityUpdate, EntityUpdateHandler);
+	regHandler(network::ServerMsgType::EntitySnapshot, EntitySnapshotHandler);
 	regHandler(network::ServerMsgType::UserSpawn, UserSpawnHandler);
 	regHandler(network::ServerMsgType::AuthFailed, AuthFailedHandler);
 	regHandler(network::ServerMsgType::StartCooldown, StartCooldownHandler);
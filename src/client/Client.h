@@ -26,6 +26,7 @@
 #include "stock/StockDataProvider.h"
 #include "voxel/ClientPager.h"
 #include "cooldown/CooldownHandler.h"
+#include "shared/EntitySnapshot.h"
 
 class Client: public ui::nuklear::LUAUIApp, public core::IEventBusHandler<network::NewConnectionEvent>, public core::IEventBusHandler<
 		network::DisconnectEvent>, public core::IEventBusHandler<voxelworld::WorldCreatedEvent> {
@@ -41,6 +42,8 @@ protected:
 	flatbuffers::FlatBufferBuilder _moveFbb;
 	frontend::PlayerMovement _movement;
 	flatbuffers::FlatBufferBuilder _actionFbb;
+	flatbuffers::FlatBufferBuilder _snapshotAckFbb;
+	shared::EntitySnapshotDecoder _snapshotDecoder;
 	frontend::PlayerAction _action;
 	client::CooldownHandler _cooldownHandler;
 	network::MoveDirection _lastMoveMask = network::MoveDirection::NONE;
@@ -90,6 +93,11 @@ public:
 	void onWindowResize(int windowWidth, int windowHeight) override;
 
 	client::CooldownHandler& cooldownHandler();
+	shared::EntitySnapshotDecoder& snapshotDecoder();
+	/**
+	 * @brief Tell the server that the snapshot was applied - the server uses it as baseline for the next deltas
+	 */
+	void sendEntitySnapshotAck(uint32_t sequence);
 
 	/**
 	 * @brief We send the user connect message to the server and we get the seed and a user spawn message back.
@@ -115,4 +123,8 @@ inline client::CooldownHandler& Client::cooldownHandler() {
 	return _cooldownHandler;
 }
 
+inline shared::EntitySnapshotDecoder& Client::snapshotDecoder() {
+	return _snapshotDecoder;
+}
+
 typedef std::shared_ptr<Client> ClientPtr;
@@ -6,6 +6,7 @@
 
 #include "IClientProtocolHandler.h"
 #include "animation/Animation.h"
+#include "shared/EntitySnapshot.h"
 
 /**
  * Updates @c frontend::ClientEntity instances identified by the given @c frontend::ClientEntityId
@@ -25,3 +26,25 @@ CLIENTPROTOHANDLERIMPL(EntityUpdate) {
 	// TODO: get all animations from server - the full array
 	entity->setAnimation(animation, true);
 }
+
+/**
+ * Applies the batched entity states of a @c network::EntitySnapshot and acknowledges it to the server
+ * @sa shared::EntitySnapshotDecoder
+ */
+CLIENTPROTOHANDLERIMPL(EntitySnapshot) {
+	shared::EntityStates changed;
+	if (!client->snapshotDecoder().decode(message, changed)) {
+		Log::debug("Could not decode the entity snapshot %u", message->sequence());
+		return;
+	}
+	for (const shared::EntityState& state : changed) {
+		const frontend::ClientEntityPtr& entity = client->getEntity(state.id);
+		if (!entity) {
+			continue;
+		}
+		entity->setPosition(shared::dequantizePosition(state.pos));
+		entity->setOrientation(shared::dequantizeOrientation(state.orientation));
+		entity->setAnimation(state.animation, true);
+	}
+	client->sendEntitySnapshotAck(message->sequence());
+}
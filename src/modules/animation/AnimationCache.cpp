@@ -39,6 +39,16 @@ bool AnimationCache::load(const core::String& filename, size_t meshIndex, const
 
 bool AnimationCache::getMeshes(const AnimationSettings& settings, const voxel::Mesh* (&meshes)[AnimationSettings::MAX_ENTRIES],
 		const std::function<bool(const voxel::Mesh* (&meshes)[AnimationSettings::MAX_ENTRIES])>& loadAdditional) {
+	// extract (or load from disk) all the meshes that are not yet cached in parallel
+	core::DynamicArray<core::String> fullPaths;
+	for (size_t i = 0; i < AnimationSettings::MAX_ENTRIES; ++i) {
+		if (settings.paths[i].empty()) {
+			continue;
+		}
+		fullPaths.push_back(settings.fullPath(i));
+	}
+	_meshCache->loadMeshes(fullPaths);
+
 	int cnt = 0;
 	for (size_t i = 0; i < AnimationSettings::MAX_ENTRIES; ++i) {
 		if (settings.paths[i].empty()) {
@@ -98,8 +108,19 @@ bool AnimationCache::getBoneModel(const AnimationSettings& settings, Vertices& v
 
 	vertices.clear();
 	indices.clear();
-	vertices.reserve(3000);
-	indices.reserve(5000);
+	size_t vertexCount = 0u;
+	size_t indexCount = 0u;
+	for (size_t i = 0; i < AnimationSettings::MAX_ENTRIES; ++i) {
+		if (meshes[i] == nullptr) {
+			continue;
+		}
+		// every bone of a mesh gets its own copy of the vertices
+		const size_t bones = settings.boneIds(i).num;
+		vertexCount += meshes[i]->getNoOfVertices() * bones;
+		indexCount += meshes[i]->getNoOfIndices() * bones;
+	}
+	vertices.reserve(vertexCount);
+	indices.reserve(indexCount);
 	IndexType indexOffset = (IndexType)0;
 	int meshCount = 0;
 	// merge everything into one buffer
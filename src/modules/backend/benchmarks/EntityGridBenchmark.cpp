@@ -0,0 +1,130 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/world/EntityGrid.h"
+#include "backend/world/Map.h"
+#include "attrib/ContainerProvider.h"
+#include "core/collection/SetUtil.h"
+#include "math/PooledQuadTree.h"
+#include "math/Random.h"
+#include <glm/common.hpp>
+#include <vector>
+
+namespace backend {
+
+class EntityGridBenchmark : public app::AbstractBenchmark {
+public:
+	static constexpr float ViewDistance = 32.0f;
+
+	struct QuadTreeNode {
+		Entity* entity;
+
+		math::RectFloat getRect() const {
+			return entity->rect();
+		}
+
+		bool operator==(const QuadTreeNode& rhs) const {
+			return rhs.entity == entity;
+		}
+	};
+
+	// roughly the same density for all entity counts
+	static float worldSize(int n) {
+		return glm::sqrt((float)n) * 16.0f;
+	}
+
+	std::vector<EntityPtr> createEntities(int n) const {
+		math::Random random(1);
+		const float size = worldSize(n);
+		std::vector<EntityPtr> entities;
+		entities.reserve(n);
+		for (int i = 0; i < n; ++i) {
+			const EntityPtr& entity = std::make_shared<Entity>((EntityId)i, MapPtr(), network::ServerMessageSenderPtr(),
+					core::TimeProviderPtr(), attrib::ContainerProviderPtr());
+			entity->setPos(glm::vec3(random.randomf(0.0f, size), 0.0f, random.randomf(0.0f, size)));
+			entities.push_back(entity);
+		}
+		return entities;
+	}
+
+	static void moveEntities(const std::vector<EntityPtr>& entities, int tick) {
+		// every entity moves a few units per tick - some of them cross a cell border
+		for (size_t i = 0; i < entities.size(); ++i) {
+			const float delta = ((tick + i) & 1) ? 2.0f : -2.0f;
+			entities[i]->setPos(entities[i]->pos() + glm::vec3(delta, 0.0f, delta));
+		}
+	}
+
+	static math::RectFloat viewRect(const Entity& entity) {
+		const glm::vec3& pos = entity.pos();
+		return math::RectFloat(pos.x - ViewDistance, pos.z - ViewDistance, pos.x + ViewDistance, pos.z + ViewDistance);
+	}
+};
+
+/**
+ * The previous implementation: a quad tree query per entity that fills a set of shared pointers. The deltas
+ * are computed with set operations.
+ */
+BENCHMARK_DEFINE_F(EntityGridBenchmark, QuadTreeEntitySet) (benchmark::State& state) {
+	const std::vector<EntityPtr>& entities = createEntities((int)state.range(0));
+	math::PooledQuadTree<QuadTreeNode, float> quadTree(math::RectFloat::getMaxRect(), 100);
+	std::vector<math::PooledQuadTree<QuadTreeNode, float>::ItemId> itemIds;
+	for (const EntityPtr& entity : entities) {
+		itemIds.push_back(quadTree.add(QuadTreeNode{entity.get()}));
+	}
+	std::vector<EntitySet> visible(entities.size());
+	int tick = 0;
+	for (auto _ : state) {
+		moveEntities(entities, tick++);
+		size_t changes = 0u;
+		for (size_t i = 0; i < entities.size(); ++i) {
+			const EntityPtr& entity = entities[i];
+			quadTree.move(itemIds[i]);
+			EntitySet set;
+			quadTree.visitContents(viewRect(*entity), [&] (const QuadTreeNode& node) {
+				if (node.entity != entity.get()) {
+					set.insert(entities[node.entity->id()]);
+				}
+			});
+			const EntitySet& stillVisible = core::setIntersection(visible[i], set);
+			const EntitySet& remove = core::setDifference(visible[i], stillVisible);
+			const EntitySet& add = core::setDifference(set, stillVisible);
+			changes += remove.size() + add.size();
+			visible[i] = set;
+		}
+		benchmark::DoNotOptimize(changes);
+	}
+}
+
+BENCHMARK_DEFINE_F(EntityGridBenchmark, EntityGrid) (benchmark::State& state) {
+	const std::vector<EntityPtr>& entities = createEntities((int)state.range(0));
+	EntityGrid grid;
+	for (const EntityPtr& entity : entities) {
+		grid.add(entity, ViewDistance);
+	}
+	VisibleEntities visible;
+	int tick = 0;
+	for (auto _ : state) {
+		moveEntities(entities, tick++);
+		for (const EntityPtr& entity : entities) {
+			grid.update(entity.get(), ViewDistance);
+			grid.visible(entity.get(), visible);
+			entity->updateVisible(visible);
+		}
+		benchmark::DoNotOptimize(visible.size());
+	}
+	for (const EntityPtr& entity : entities) {
+		// break the cyclic references of the visible entities
+		visible.clear();
+		entity->updateVisible(visible);
+	}
+}
+
+BENCHMARK_REGISTER_F(EntityGridBenchmark, QuadTreeEntitySet)->Arg(1000)->Arg(5000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(EntityGridBenchmark, EntityGrid)->Arg(1000)->Arg(5000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+}
+
+BENCHMARK_MAIN();
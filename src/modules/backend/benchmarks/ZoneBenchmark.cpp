@@ -0,0 +1,84 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/entity/ai/AI.h"
+#include "backend/entity/ai/AIRegistry.h"
+#include "backend/entity/ai/ICharacter.h"
+#include "backend/entity/ai/tree/TreeNode.h"
+#include "backend/entity/ai/tree/loaders/lua/LUATreeLoader.h"
+#include "backend/entity/ai/zone/Zone.h"
+
+namespace backend {
+
+namespace {
+/**
+ * Mirrors the shape of the default animal trees (see ai/shared.lua) with nodes and conditions that
+ * don't need a map or a real npc: a flee branch that is not taken, a population branch that is guarded
+ * by a condition chain and the wander fallback.
+ */
+const char *TREES = R"lua(function init()
+	local rootNode = AI.createTree("ANIMAL"):createRoot("PrioritySelector", "ANIMAL")
+	rootNode:addNode("Steer(Wander)", "fleefromhunter"):setCondition("And(False,True)")
+
+	local parallel = rootNode:addNode("Parallel", "increasepopulation")
+	parallel:setCondition("And(Not(True),True)")
+	parallel:addNode("Idle{1000}", "followincreasepartner")
+	local spawn = parallel:addNode("Sequence", "spawn")
+	spawn:addNode("Limit{10}", "spawnlimit")
+	spawn:addNode("Idle{100}", "increasecooldown")
+
+	local prio = rootNode:addNode("PrioritySelector", "walkuncrowded")
+	prio:addNode("Sequence", "wanderathome"):setCondition("Not(False)")
+	prio:addNode("Idle{500}", "wanderidle")
+	prio:addNode("Steer(Wander)", "wanderfreely")
+end)lua";
+}
+
+class ZoneBenchmark : public app::AbstractBenchmark {
+protected:
+	AIRegistry _registry;
+	LUATreeLoader _loader;
+public:
+	ZoneBenchmark() :
+			_loader(_registry) {
+	}
+
+	void SetUp(benchmark::State& state) override {
+		app::AbstractBenchmark::SetUp(state);
+		if (!_loader.init(TREES)) {
+			state.SkipWithError(_loader.getError().c_str());
+		}
+	}
+
+	void TearDown(benchmark::State& state) override {
+		_loader.shutdown();
+		app::AbstractBenchmark::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(ZoneBenchmark, Update) (benchmark::State& state) {
+	const TreeNodePtr& root = _loader.load("ANIMAL");
+	if (!root) {
+		state.SkipWithError("Could not load the behaviour tree");
+		return;
+	}
+	const int n = (int)state.range(0);
+	Zone zone("benchmark");
+	for (int i = 0; i < n; ++i) {
+		const AIPtr& ai = std::make_shared<AI>(root);
+		ai->setCharacter(core::make_shared<ICharacter>(i + 1));
+		zone.addAI(ai);
+	}
+	// apply the scheduled additions
+	zone.update(0L);
+	for (auto _ : state) {
+		zone.update(16L);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_REGISTER_F(ZoneBenchmark, Update)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+}
@@ -3,7 +3,6 @@
  */
 
 #include "Entity.h"
-#include "core/collection/SetUtil.h"
 #include "core/ArrayLength.h"
 #include "core/Assert.h"
 #include "core/Log.h"
@@ -17,6 +16,7 @@
 #include "shared/ProtocolEnum.h"
 #include "attrib/ContainerProvider.h"
 #include <glm/trigonometric.hpp>
+#include <algorithm>
 
 namespace backend {
 
@@ -33,17 +33,17 @@ Entity::Entity(EntityId id,
 Entity::~Entity() {
 }
 
-void Entity::visibleAdd(const EntitySet& entities) {
-	for (const EntityPtr& e : entities) {
-		Log::trace("entity %i is visible for %i", (int)e->id(), (int)id());
-		sendEntitySpawn(e);
+void Entity::visibleAdd(const VisibleEntities& entities) {
+	for (const VisibleEntity& e : entities) {
+		Log::trace("entity %i is visible for %i", (int)e.id, (int)id());
+		sendEntitySpawn(e.entity);
 	}
 }
 
-void Entity::visibleRemove(const EntitySet& entities) {
-	for (const EntityPtr& e : entities) {
-		Log::trace("entity %i is no longer visible for %i", (int)e->id(), (int)id());
-		sendEntityRemove(e);
+void Entity::visibleRemove(const VisibleEntities& entities) {
+	for (const VisibleEntity& e : entities) {
+		Log::trace("entity %i is no longer visible for %i", (int)e.id, (int)id());
+		sendEntityRemove(e.entity);
 	}
 }
 
@@ -66,21 +66,23 @@ bool Entity::attack(EntityId victimId) {
 
 void Entity::sendToVisible(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type,
 		flatbuffers::Offset<void> data, bool sendToSelf, uint32_t flags) const {
-	const EntitySet& visible = visibleCopy();
 	std::vector<ENetPeer*> peers;
-	peers.reserve(visible.size() + 1);
 	if (sendToSelf) {
 		ENetPeer* p = peer();
 		if (p != nullptr) {
 			peers.push_back(p);
 		}
 	}
-	for (const EntityPtr& e : visible) {
-		ENetPeer* peer = e->peer();
-		if (peer == nullptr) {
-			continue;
+	{
+		core::ScopedReadLock lock(_visibleLock);
+		peers.reserve(peers.size() + _visible.size());
+		for (const VisibleEntity& e : _visible) {
+			ENetPeer* peer = e.entity->peer();
+			if (peer == nullptr) {
+				continue;
+			}
+			peers.push_back(peer);
 		}
-		peers.push_back(peer);
 	}
 	if (peers.empty()) {
 		Log::debug("don't send message of type '%s' - no peers found", network::toString(type, network::EnumNamesServerMsgType()));
@@ -177,35 +179,44 @@ bool Entity::update(long dt) {
 }
 
 void Entity::updateVisible(const EntitySet& set) {
+	VisibleEntities visible;
+	visible.reserve(set.size());
+	for (const EntityPtr& e : set) {
+		visible.push_back(VisibleEntity{e->id(), e});
+	}
+	std::sort(visible.begin(), visible.end());
+	updateVisible(visible);
+}
+
+void Entity::updateVisible(VisibleEntities& visible) {
 	core_trace_scoped(UpdateVisible);
+	_entered.clear();
+	_left.clear();
 	_visibleLock.lockWrite();
-	const auto& stillVisible = core::setIntersection(set, _visible);
-	const EntitySet& remove = core::setDifference(stillVisible, _visible);
-	const EntitySet& add = core::setDifference(set, stillVisible);
-	_visible = core::setUnion(stillVisible, add);
-	_visibleLock.unlockWrite();
-
-	for (const auto& e : _visible) {
-		sendEntityUpdate(e);
+	auto oldIter = _visible.begin();
+	auto newIter = visible.begin();
+	while (oldIter != _visible.end() || newIter != visible.end()) {
+		if (newIter == visible.end() || (oldIter != _visible.end() && oldIter->id < newIter->id)) {
+			_left.push_back(*oldIter++);
+		} else if (oldIter == _visible.end() || newIter->id < oldIter->id) {
+			_entered.push_back(*newIter++);
+		} else {
+			++oldIter;
+			++newIter;
+		}
 	}
+	_visible.swap(visible);
+	_visibleLock.unlockWrite();
 
-	if (!add.empty()) {
-		visibleAdd(add);
-	}
-	if (!remove.empty()) {
-		visibleRemove(remove);
+	if (!_entered.empty()) {
+		visibleAdd(_entered);
 	}
-}
-
-void Entity::sendEntityUpdate(const EntityPtr& entity) const {
-	if (_peer == nullptr) {
-		return;
+	if (!_left.empty()) {
+		visibleRemove(_left);
 	}
-	const glm::vec3& _pos = entity->pos();
-	const network::Vec3 pos { _pos.x, _pos.y, _pos.z };
-	_entityUpdateFBB.Clear();
-	_messageSender->sendServerMessage(_peer, _entityUpdateFBB, network::ServerMsgType::EntityUpdate,
-			network::CreateEntityUpdate(_entityUpdateFBB, entity->id(), &pos, entity->orientation(), entity->animation()).Union());
+	// don't keep the references to the entities that left
+	_left.clear();
+	_entered.clear();
 }
 
 void Entity::sendEntitySpawn(const EntityPtr& entity) const {
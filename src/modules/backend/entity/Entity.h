@@ -16,26 +16,44 @@
 
 #include <unordered_set>
 #include <memory>
+#include <vector>
 
 namespace backend {
 
 typedef std::unordered_set<EntityPtr> EntitySet;
 
+struct VisibleEntity {
+	EntityId id;
+	EntityPtr entity;
+
+	inline bool operator<(const VisibleEntity& rhs) const {
+		return id < rhs.id;
+	}
+};
+/**
+ * @brief The visible entities sorted by their id - see @c EntityGrid::visible()
+ */
+typedef std::vector<VisibleEntity> VisibleEntities;
+
 /**
  * @brief Every actor in the world is an entity
  *
- * Entities are updated via @c network::ServerMsgType::EntityUpdate
+ * Entities are updated via the @c network::ServerMsgType::EntitySnapshot
  * message for the clients that are seeing the entity
  *
+ * @sa User::sendEntitySnapshot()
  * @sa EntityUpdateHandler
  */
 class Entity {
 private:
 	core::ReadWriteLock _visibleLock {"Entity"};
-	EntitySet _visible;
+	// sorted by the entity id
+	VisibleEntities _visible;
+	// the deltas of the last visibility update - they are members to reduce memory allocations
+	VisibleEntities _entered;
+	VisibleEntities _left;
 	// they are stored as members to reduce memory allocations
 	mutable flatbuffers::FlatBufferBuilder _attribUpdateFBB;
-	mutable flatbuffers::FlatBufferBuilder _entityUpdateFBB;
 	mutable flatbuffers::FlatBufferBuilder _entitySpawnFBB;
 	mutable flatbuffers::FlatBufferBuilder _entityRemoveFBB;
 
@@ -60,16 +78,15 @@ protected:
 	float _size = 1.0f;
 
 	/**
-	 * @brief Called with the set of entities that just get visible for this entity
+	 * @brief Called with the entities that just get visible for this entity
 	 */
-	void visibleAdd(const EntitySet& entities);
+	void visibleAdd(const VisibleEntities& entities);
 	/**
-	 * @brief Called with the set of entities that just get invisible for this entity
+	 * @brief Called with the entities that just get invisible for this entity
 	 */
-	void visibleRemove(const EntitySet& entities);
+	void visibleRemove(const VisibleEntities& entities);
 
 	void broadcastAttribUpdate();
-	void sendEntityUpdate(const EntityPtr& entity) const;
 	void sendEntitySpawn(const EntityPtr& entity) const;
 	void sendEntityRemove(const EntityPtr& entity) const;
 
@@ -127,8 +144,8 @@ public:
 	void visitVisible(Func&& func) {
 		core_trace_scoped(VisitVisibleUpdate);
 		core::ScopedReadLock lock(_visibleLock);
-		for (const EntityPtr& e : _visible) {
-			func(e);
+		for (const VisibleEntity& e : _visible) {
+			func(e.entity);
 		}
 	}
 
@@ -138,16 +155,28 @@ public:
 	 */
 	inline EntitySet visibleCopy() const {
 		core::ScopedReadLock lock(_visibleLock);
-		return EntitySet(_visible);
+		EntitySet set;
+		set.reserve(_visible.size());
+		for (const VisibleEntity& e : _visible) {
+			set.insert(e.entity);
+		}
+		return set;
 	}
 
 	/**
 	 * @brief This will inform the entity about all the other entities that it can see.
 	 * @param[in] set The entities that are currently visible
-	 * @note All entities have the same view range - see @c Entity::regionRect
 	 * @note This is thread safe
 	 */
 	void updateVisible(const EntitySet& set);
+	/**
+	 * @brief This will inform the entity about all the other entities that it can see. The entities that
+	 * entered or left the view are found by walking the sorted lists in parallel.
+	 * @param[in,out] visible The entities that are currently visible - sorted by their id. The list is
+	 * swapped with the previously visible entities to reuse its memory.
+	 * @note This is thread safe - but it must not be called for the same entity from several threads
+	 */
+	void updateVisible(VisibleEntities& visible);
 
 	/**
 	 * @brief The tick of the entity
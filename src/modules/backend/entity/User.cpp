@@ -7,6 +7,8 @@
 #include "backend/world/Map.h"
 #include "voxel/PagedVolume.h"
 #include "voxelworld/WorldMgr.h"
+#include "core/Trace.h"
+#include <algorithm>
 
 namespace backend {
 
@@ -82,9 +84,41 @@ ENetPeer* User::setPeer(ENetPeer* peer) {
 	if (_peer) {
 		_peer->data = this;
 	}
+	if (old != _peer) {
+		// the new client doesn't know any of the previous snapshots
+		_snapshotEncoder.reset();
+	}
 	return old;
 }
 
+void User::sendEntitySnapshot() {
+	core_trace_scoped(UserEntitySnapshot);
+	ENetPeer* p = peer();
+	if (p == nullptr) {
+		return;
+	}
+	_snapshotStates.clear();
+	// the visible entities are sorted by their id
+	visitVisible([this] (const EntityPtr& e) {
+		_snapshotStates.push_back(shared::entityState(e->id(), e->pos(), e->orientation(), e->animation()));
+	});
+	// the own state is needed to correct the movement prediction of the client
+	const shared::EntityState& self = shared::entityState(id(), pos(), orientation(), animation());
+	_snapshotStates.insert(std::lower_bound(_snapshotStates.begin(), _snapshotStates.end(), self), self);
+
+	flatbuffers::Offset<network::EntitySnapshot> snapshot;
+	if (!_snapshotEncoder.encode(_snapshotFBB, _snapshotStates, snapshot)) {
+		_snapshotFBB.Clear();
+		return;
+	}
+	// lost snapshots are not resent - the next one contains the changes relative to the acknowledged baseline
+	_messageSender->sendServerMessage(p, _snapshotFBB, network::ServerMsgType::EntitySnapshot, snapshot.Union(), 0u);
+}
+
+void User::ackEntitySnapshot(uint32_t sequence) {
+	_snapshotEncoder.ack(sequence);
+}
+
 void User::onConnect() {
 	Log::info("connect user");
 	_attribs.markAsDirty();
@@ -14,6 +14,7 @@
 #include "user/UserMovementMgr.h"
 #include "persistence/DBHandler.h"
 #include "stock/StockDataProvider.h"
+#include "shared/EntitySnapshot.h"
 
 namespace backend {
 
@@ -33,6 +34,11 @@ private:
 	UserLogoutMgr _logoutMgr;
 	UserMovementMgr _movementMgr;
 
+	shared::EntitySnapshotEncoder _snapshotEncoder;
+	// they are stored as members to reduce memory allocations
+	shared::EntityStates _snapshotStates;
+	flatbuffers::FlatBufferBuilder _snapshotFBB;
+
 public:
 	User(ENetPeer* peer,
 			EntityId id,
@@ -86,6 +92,18 @@ public:
 	/**
 	 * @brief Informs the user that the login was successful
 	 */
+	/**
+	 * @brief Sends the states of all visible entities (and the own state) that changed since the last
+	 * snapshot the client acknowledged in one message
+	 * @note Called once per tick after all entities of the map were updated
+	 */
+	void sendEntitySnapshot();
+	/**
+	 * @brief The client applied the snapshot with the given sequence
+	 * @sa EntitySnapshotAckHandler
+	 */
+	void ackEntitySnapshot(uint32_t sequence);
+
 	void broadcastUserSpawn() const;
 	/**
 	 * @brief Send all replicate vars from the server to the user
@@ -7,6 +7,42 @@
 
 namespace backend {
 
+AI::AI(const TreeNodePtr& behaviour) :
+		_behaviour(behaviour), _pause(false), _debuggingActive(false), _time(0L), _zone(nullptr), _reset(false) {
+	resetNodeStates();
+}
+
+AI::TreeNodeState& AI::nodeState(int index) {
+	if (index < 0) {
+		// the node is not part of an indexed tree - this should only happen for nodes that
+		// are executed manually
+		_invalidNodeState = TreeNodeState();
+		return _invalidNodeState;
+	}
+	if (index >= (int)_nodeStates.size()) {
+		_nodeStates.resize(index + 1);
+	}
+	return _nodeStates[index];
+}
+
+const AI::TreeNodeState* AI::findNodeState(int index) const {
+	if (index < 0 || index >= (int)_nodeStates.size()) {
+		return nullptr;
+	}
+	return &_nodeStates[index];
+}
+
+void AI::resetNodeStates() {
+	int nodeCount = 0;
+	if (_behaviour) {
+		nodeCount = _behaviour->getNodeCount();
+		if (nodeCount == 0) {
+			nodeCount = _behaviour->indexNodes();
+		}
+	}
+	_nodeStates.assign(nodeCount, TreeNodeState());
+}
+
 ai::CharacterId AI::getId() const {
 	if (!_character) {
 		return AI_NOTHING_SELECTED;
@@ -17,6 +53,9 @@ ai::CharacterId AI::getId() const {
 TreeNodePtr AI::setBehaviour(const TreeNodePtr& newBehaviour) {
 	TreeNodePtr current = _behaviour;
 	_behaviour = newBehaviour;
+	if (_behaviour && _behaviour->getNodeCount() == 0) {
+		_behaviour->indexNodes();
+	}
 	_reset = true;
 	return current;
 }
@@ -33,10 +72,8 @@ void AI::update(int64_t dt, bool debuggingActive) {
 	if (_reset) {
 		// safe to do it like this, because update is not called from multiple threads
 		_reset = false;
-		_lastStatus.clear();
-		_lastExecMillis.clear();
+		resetNodeStates();
 		_filteredEntities.clear();
-		_selectorStates.clear();
 	}
 
 	_debuggingActive = debuggingActive;
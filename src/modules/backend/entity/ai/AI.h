@@ -14,6 +14,7 @@
 #include "core/NonCopyable.h"
 
 #include <memory>
+#include <vector>
 #include <glm/vec3.hpp>
 
 namespace backend {
@@ -45,17 +46,31 @@ class AI : public core::NonCopyable {
 	friend class IFilter;
 	friend class Filter;
 	friend class Server;
-protected:
+public:
 	/**
-	 * This map is only filled if we are in debugging mode for this entity
+	 * @brief The state of one @ai{TreeNode} for this entity.
+	 * @note The status and the last execution time are only recorded if we are in debugging mode for this entity
 	 */
-	typedef core::Map<int, ai::TreeNodeStatus> NodeStates;
-	NodeStates _lastStatus;
+	struct TreeNodeState {
+		static constexpr int64_t TimerNotStarted = -1;
+		// the remaining millis of the @ai{ITimedNode}
+		int64_t timerMillis = TimerNotStarted;
+		int64_t lastExecMillis = -1;
+		// often @ai{Selector} states must be stored to continue in the next step at a particular
+		// position in the behaviour tree
+		int selector = AI_NOTHING_SELECTED;
+		// the amount of executions for the @ai{Limit} node
+		int limit = 0;
+		ai::TreeNodeStatus status = ai::TreeNodeStatus::UNKNOWN;
+	};
+protected:
 	/**
-	 * This map is only filled if we are in debugging mode for this entity
+	 * The states of all nodes of the behaviour tree in one contiguous block. Indexed by
+	 * @ai{TreeNode::getStateIndex()}.
 	 */
-	typedef core::Map<int, uint64_t> LastExecMap;
-	LastExecMap _lastExecMillis;
+	std::vector<TreeNodeState> _nodeStates;
+	// used for nodes that are not part of an indexed tree
+	TreeNodeState _invalidNodeState;
 
 	/**
 	 * @note The filtered entities are kept even over several ticks. The caller should decide
@@ -64,19 +79,6 @@ protected:
 	 */
 	mutable FilteredEntities _filteredEntities;
 
-	/**
-	 * Often @ai{Selector} states must be stored to continue in the next step at a particular
-	 * position in the behaviour tree. This map is doing exactly this.
-	 */
-	typedef core::Map<int, int> SelectorStates;
-	SelectorStates _selectorStates;
-
-	/**
-	 * This map stores the amount of execution for the @ai{Limit} node. The key is the node id
-	 */
-	typedef core::Map<int, int> LimitStates;
-	LimitStates _limitStates;
-
 	TreeNodePtr _behaviour;
 	AggroMgr _aggroMgr;
 
@@ -90,13 +92,15 @@ protected:
 	Zone* _zone;
 
 	core::AtomicBool _reset;
+
+	TreeNodeState& nodeState(int index);
+	const TreeNodeState* findNodeState(int index) const;
+	void resetNodeStates();
 public:
 	/**
 	 * @param behaviour The behaviour tree node that is applied to this ai entity
 	 */
-	explicit AI(const TreeNodePtr& behaviour) :
-			_behaviour(behaviour), _pause(false), _debuggingActive(false), _time(0L), _zone(nullptr), _reset(false) {
-	}
+	explicit AI(const TreeNodePtr& behaviour);
 	virtual ~AI() {
 	}
 
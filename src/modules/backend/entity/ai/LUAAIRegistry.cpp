@@ -6,6 +6,7 @@
 #include "LUAAIRegistry.h"
 #include "LUAFunctions.h"
 #include "common/Common.h"
+#include "core/Common.h"
 #include "core/concurrent/Lock.h"
 #include "core/Assert.h"
 #include "backend/entity/ai/AI.h"
@@ -19,6 +20,25 @@
 
 namespace backend {
 
+namespace {
+// source of the context keys - every registry instance gets a unique key
+core::AtomicInt _nextContextKey { 1 };
+
+struct ContextCache {
+	uint32_t key = 0u;
+	LUAAIContext* context = nullptr;
+};
+// the context of the registry that was used last by this thread
+thread_local ContextCache _contextCache;
+}
+
+void LUAAIContext::setRef(int slot, int ref) {
+	if (slot >= (int)refs.size()) {
+		refs.resize(slot + 1, LUA_NOREF);
+	}
+	refs[slot] = ref;
+}
+
 static void luaAI_setupmetatable(lua_State* s, const core::String& type, const luaL_Reg *funcs, const core::String& name) {
 	const core::String& metaFull = "__meta_" + name + "_" + type;
 	// make global
@@ -58,6 +78,27 @@ static void luaAI_globalpointer(lua_State* s, void* pointer, const char *name) {
 	lua_setglobal(s, name);
 }
 
+static const char* luaAI_metacontext() {
+	return "__meta_context";
+}
+
+/***
+ * Gives you access the the light userdata for the LUAAIContext of the lua state.
+ * @return the context userdata
+ */
+static LUAAIContext* luaAI_tocontext(lua_State * s) {
+	return luaAI_getlightuserdata<LUAAIContext>(s, luaAI_metacontext());
+}
+
+/***
+ * Stores a registry reference to the userdata on top of the stack in the context of the lua state.
+ * The userdata stays on the stack.
+ */
+static void luaAI_storeref(lua_State* s, int slot) {
+	lua_pushvalue(s, -1);
+	luaAI_tocontext(s)->setRef(slot, luaL_ref(s, LUA_REGISTRYINDEX));
+}
+
 /***
  * Gives you access the the light userdata for the LUAAIRegistry.
  * @return the registry userdata
@@ -130,10 +171,20 @@ static int luaAI_nodetostring(lua_State* s) {
 static int luaAI_createnode(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUATreeNodeFactoryPtr& factory = std::make_shared<LuaNodeFactory>(s, type);
-	const bool inserted = r->registerNodeFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "tree node %s is already registered", type.c_str());
+	// the scripts are replayed in the lua states of the other threads - the factory already exists then
+	const bool replica = r->getLuaState() != s;
+	LUATreeNodeFactoryPtr factory;
+	if (replica) {
+		factory = r->treeNodeFactory(type);
+		if (!factory) {
+			return clua_error(s, "tree node %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaNodeFactory>(r, type, r->allocSlot());
+		const bool inserted = r->registerNodeFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "tree node %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaNodeFactory*>(s, factory.get());
@@ -144,7 +195,10 @@ static int luaAI_createnode(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "node");
-	r->addTreeNodeFactory(type, factory);
+	luaAI_storeref(s, factory->slot());
+	if (!replica) {
+		r->addTreeNodeFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -171,10 +225,20 @@ static int luaAI_conditiontostring(lua_State* s) {
 static int luaAI_createcondition(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAConditionFactoryPtr& factory = std::make_shared<LuaConditionFactory>(s, type);
-	const bool inserted = r->registerConditionFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "condition %s is already registered", type.c_str());
+	// the scripts are replayed in the lua states of the other threads - the factory already exists then
+	const bool replica = r->getLuaState() != s;
+	LUAConditionFactoryPtr factory;
+	if (replica) {
+		factory = r->conditionFactory(type);
+		if (!factory) {
+			return clua_error(s, "condition %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaConditionFactory>(r, type, r->allocSlot());
+		const bool inserted = r->registerConditionFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "condition %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaConditionFactory*>(s, factory.get());
@@ -185,7 +249,10 @@ static int luaAI_createcondition(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "condition");
-	r->addConditionFactory(type, factory);
+	luaAI_storeref(s, factory->slot());
+	if (!replica) {
+		r->addConditionFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -208,10 +275,20 @@ static int luaAI_filtertostring(lua_State* s) {
 static int luaAI_createfilter(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAFilterFactoryPtr& factory = std::make_shared<LuaFilterFactory>(s, type);
-	const bool inserted = r->registerFilterFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "filter %s is already registered", type.c_str());
+	// the scripts are replayed in the lua states of the other threads - the factory already exists then
+	const bool replica = r->getLuaState() != s;
+	LUAFilterFactoryPtr factory;
+	if (replica) {
+		factory = r->filterFactory(type);
+		if (!factory) {
+			return clua_error(s, "filter %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaFilterFactory>(r, type, r->allocSlot());
+		const bool inserted = r->registerFilterFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "filter %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaFilterFactory*>(s, factory.get());
@@ -222,7 +299,10 @@ static int luaAI_createfilter(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "filter");
-	r->addFilterFactory(type, factory);
+	luaAI_storeref(s, factory->slot());
+	if (!replica) {
+		r->addFilterFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -240,10 +320,20 @@ static int luaAI_steeringtostring(lua_State* s) {
 static int luaAI_createsteering(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUASteeringFactoryPtr& factory = std::make_shared<LuaSteeringFactory>(s, type);
-	const bool inserted = r->registerSteeringFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "steering %s is already registered", type.c_str());
+	// the scripts are replayed in the lua states of the other threads - the factory already exists then
+	const bool replica = r->getLuaState() != s;
+	LUASteeringFactoryPtr factory;
+	if (replica) {
+		factory = r->steeringFactory(type);
+		if (!factory) {
+			return clua_error(s, "steering %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaSteeringFactory>(r, type, r->allocSlot());
+		const bool inserted = r->registerSteeringFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "steering %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaSteeringFactory*>(s, factory.get());
@@ -254,15 +344,27 @@ static int luaAI_createsteering(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "steering");
-	r->addSteeringFactory(type, factory);
+	luaAI_storeref(s, factory->slot());
+	if (!replica) {
+		r->addSteeringFactory(type, factory);
+	}
 	return 1;
 }
 
-LUAAIRegistry::LUAAIRegistry() {
+LUAAIRegistry::LUAAIRegistry() :
+		_contextKey((uint32_t)_nextContextKey.increment(1)) {
 	_s = _lua.state();
+	_mainContext.s = _s;
+	setupState(_mainContext);
+	core::ScopedLock scopedLock(_lock);
+	_contexts.emplace(std::this_thread::get_id(), std::unique_ptr<LUAAIContext>());
+}
+
+void LUAAIRegistry::setupState(LUAAIContext& ctx) {
+	lua_State* s = ctx.s;
 	// TODO: random module
 
-	lua_gc(_s, LUA_GCSTOP, 0);
+	lua_gc(s, LUA_GCSTOP, 0);
 
 	static const luaL_Reg registryFuncs[] = {
 		{"createNode", luaAI_createnode},
@@ -271,10 +373,60 @@ LUAAIRegistry::LUAAIRegistry() {
 		{"createSteering", luaAI_createsteering},
 		{nullptr, nullptr}
 	};
-	clua_registerfuncsglobal(_s, registryFuncs, "META_REGISTRY", "REGISTRY");
+	clua_registerfuncsglobal(s, registryFuncs, "META_REGISTRY", "REGISTRY");
 
-	luaAI_globalpointer(_s, this, luaAI_metaregistry());
-	luaAI_registerAll(_s);
+	luaAI_globalpointer(s, this, luaAI_metaregistry());
+	luaAI_globalpointer(s, &ctx, luaAI_metacontext());
+	luaAI_registerAll(s);
+}
+
+void LUAAIRegistry::syncContext(LUAAIContext& ctx) {
+	core_trace_scoped(LUAAIRegistrySyncContext);
+	std::vector<core::String> scripts;
+	{
+		core::ScopedLock scopedLock(_lock);
+		scripts.assign(_scripts.begin() + ctx.scripts, _scripts.end());
+		ctx.scripts = (int)_scripts.size();
+	}
+	for (const core::String& script : scripts) {
+		if (luaL_loadbufferx(ctx.s, script.c_str(), script.size(), "", nullptr) || lua_pcall(ctx.s, 0, 0, 0)) {
+			Log::error("Failed to replay script in thread lua state: %s", lua_tostring(ctx.s, -1));
+			lua_pop(ctx.s, 1);
+		}
+	}
+}
+
+LUAAIContext* LUAAIRegistry::context() {
+	LUAAIContext* ctx = nullptr;
+	if (_contextCache.key == _contextKey) {
+		ctx = _contextCache.context;
+	} else {
+		core::ScopedLock scopedLock(_lock);
+		if (_s == nullptr) {
+			return nullptr;
+		}
+		auto i = _contexts.find(std::this_thread::get_id());
+		if (i == _contexts.end()) {
+			std::unique_ptr<LUAAIContext> replica(new LUAAIContext());
+			replica->lua = std::unique_ptr<lua::LUA>(new lua::LUA());
+			replica->s = replica->lua->state();
+			setupState(*replica);
+			i = _contexts.emplace(std::this_thread::get_id(), core::move(replica)).first;
+		}
+		// the main context isn't owned by the map
+		ctx = i->second ? i->second.get() : &_mainContext;
+		_contextCache.key = _contextKey;
+		_contextCache.context = ctx;
+	}
+	if (ctx->lua && ctx->scripts != (int)_scriptCount) {
+		syncContext(*ctx);
+	}
+	return ctx;
+}
+
+int LUAAIRegistry::allocSlot() {
+	core::ScopedLock scopedLock(_lock);
+	return _slots++;
 }
 
 lua_State* LUAAIRegistry::getLuaState() {
@@ -295,9 +447,7 @@ bool LUAAIRegistry::init(const core::String& file) {
 	const char* script = ""
 		"UNKNOWN, CANNOTEXECUTE, RUNNING, FINISHED, FAILED, EXCEPTION = 0, 1, 2, 3, 4, 5\n";
 
-	if (luaL_loadbufferx(_s, script, SDL_strlen(script), "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		Log::error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
+	if (!evaluate(script, SDL_strlen(script))) {
 		return false;
 	}
 	const core::String& btScript = io::filesystem()->load(file);
@@ -316,8 +466,13 @@ void LUAAIRegistry::shutdown() {
 		_conditionFactories.clear();
 		_filterFactories.clear();
 		_steeringFactories.clear();
+		// the userdata of the replicated states is pointing to the factories
+		_contexts.clear();
+		_scripts.clear();
+		// invalidate the thread local context caches
+		_contextKey = (uint32_t)_nextContextKey.increment(1);
+		_s = nullptr;
 	}
-	_s = nullptr;
 }
 
 LUAAIRegistry::~LUAAIRegistry() {
@@ -334,6 +489,9 @@ bool LUAAIRegistry::evaluate(const char* luaBuffer, size_t size) {
 		lua_pop(_s, 1);
 		return false;
 	}
+	core::ScopedLock scopedLock(_lock);
+	_scripts.emplace_back(luaBuffer, size);
+	_scriptCount = (int)_scripts.size();
 	return true;
 }
 
@@ -357,4 +515,40 @@ void LUAAIRegistry::addSteeringFactory(const core::String& type, const LUASteeri
 	_steeringFactories.emplace(type, factory);
 }
 
+LUATreeNodeFactoryPtr LUAAIRegistry::treeNodeFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _treeNodeFactories.find(type);
+	if (i == _treeNodeFactories.end()) {
+		return LUATreeNodeFactoryPtr();
+	}
+	return i->second;
+}
+
+LUAConditionFactoryPtr LUAAIRegistry::conditionFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _conditionFactories.find(type);
+	if (i == _conditionFactories.end()) {
+		return LUAConditionFactoryPtr();
+	}
+	return i->second;
+}
+
+LUAFilterFactoryPtr LUAAIRegistry::filterFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _filterFactories.find(type);
+	if (i == _filterFactories.end()) {
+		return LUAFilterFactoryPtr();
+	}
+	return i->second;
+}
+
+LUASteeringFactoryPtr LUAAIRegistry::steeringFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	auto i = _steeringFactories.find(type);
+	if (i == _steeringFactories.end()) {
+		return LUASteeringFactoryPtr();
+	}
+	return i->second;
+}
+
 }
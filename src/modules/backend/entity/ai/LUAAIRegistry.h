@@ -13,7 +13,12 @@
 #include "backend/entity/ai/condition/LUACondition.h"
 #include "backend/entity/ai/filter/LUAFilter.h"
 #include "backend/entity/ai/movement/LUASteering.h"
+#include "core/concurrent/Atomic.h"
 #include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace backend {
 
@@ -33,6 +38,30 @@ using LuaSteeringFactory = movement::LUASteering::LUASteeringFactory;
 typedef std::shared_ptr<LuaSteeringFactory> LUASteeringFactoryPtr;
 typedef std::map<core::String, LUASteeringFactoryPtr> SteeringFactoryMap;
 
+/**
+ * @brief The lua state that is used by one thread to execute the lua nodes
+ *
+ * @see LUAAIRegistry::context()
+ */
+struct LUAAIContext {
+	// only set for the states that replicate the main state of the registry
+	std::unique_ptr<lua::LUA> lua;
+	lua_State* s = nullptr;
+	// registry references to the userdata of the lua nodes - indexed by the slot of the node factory
+	std::vector<int> refs;
+	// the amount of registry scripts that were executed in this state
+	int scripts = 0;
+
+	inline int ref(int slot) const {
+		if (slot < 0 || slot >= (int)refs.size()) {
+			return LUA_NOREF;
+		}
+		return refs[slot];
+	}
+
+	void setRef(int slot, int ref);
+};
+
 /**
  * @brief Allows you to register lua @ai{TreeNode}s, @ai{Conditions}, @ai{Filter}s and @ai{ISteering}s.
  *
@@ -85,17 +114,39 @@ typedef std::map<core::String, LUASteeringFactoryPtr> SteeringFactoryMap;
  * @par AI metatable
  * There is a metatable that you can modify by calling @ai{LUAAIRegistry::pushAIMetatable()}.
  * This metatable is applied to all @ai{AI} pointers that are forwarded to the lua functions.
+ *
+ * @par Threads
+ * Every thread that executes lua nodes gets its own lua state (see @c context()). The scripts that were
+ * given to @c init() and @c evaluate() are executed in each of these states. Modifications that are done
+ * via @c getLuaState() are only visible to the thread that created the registry.
  */
 class LUAAIRegistry : public AIRegistry {
 protected:
 	lua::LUA _lua;
 	lua_State* _s = nullptr;
 
-	core_trace_mutex(core::Lock, _lock, "LUAAIRegistry");
+	mutable core_trace_mutex(core::Lock, _lock, "LUAAIRegistry");
 	TreeNodeFactoryMap _treeNodeFactories;
 	ConditionFactoryMap _conditionFactories;
 	FilterFactoryMap _filterFactories;
 	SteeringFactoryMap _steeringFactories;
+
+	// the context of the thread that created the registry - this one is using the main lua state
+	LUAAIContext _mainContext;
+	std::unordered_map<std::thread::id, std::unique_ptr<LUAAIContext> > _contexts;
+	// all successfully evaluated scripts - they are replayed in the lua states of the other threads
+	std::vector<core::String> _scripts;
+	core::AtomicInt _scriptCount { 0 };
+	// the amount of slots that were handed out to the lua node factories
+	int _slots = 0;
+	// identifies the registry instance for the thread local context lookup - changed on shutdown
+	uint32_t _contextKey;
+
+	void setupState(LUAAIContext& ctx);
+	/**
+	 * @brief Execute the scripts that were evaluated since the last call in the given context
+	 */
+	void syncContext(LUAAIContext& ctx);
 public:
 	LUAAIRegistry();
 
@@ -104,8 +155,26 @@ public:
 	void addFilterFactory(const core::String& type, const LUAFilterFactoryPtr& factory);
 	void addSteeringFactory(const core::String& type, const LUASteeringFactoryPtr& factory);
 
+	LUATreeNodeFactoryPtr treeNodeFactory(const core::String& type) const;
+	LUAConditionFactoryPtr conditionFactory(const core::String& type) const;
+	LUAFilterFactoryPtr filterFactory(const core::String& type) const;
+	LUASteeringFactoryPtr steeringFactory(const core::String& type) const;
+
+	/**
+	 * @return A new slot for a lua node factory. The slot is the index of the userdata reference
+	 * in @c LUAAIContext::refs
+	 */
+	int allocSlot();
+
+	/**
+	 * @brief The lua context of the calling thread. The lua state is created on the first call
+	 * of a thread.
+	 * @return @c nullptr if the registry is not initialized or already shut down
+	 */
+	LUAAIContext* context();
+
 	/**
-	 * @brief Access to the lua state.
+	 * @brief Access to the lua state of the thread that created the registry.
 	 * @see pushAIMetatable()
 	 */
 	lua_State* getLuaState();
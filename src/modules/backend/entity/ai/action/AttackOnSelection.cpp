@@ -5,6 +5,7 @@
 #include "AttackOnSelection.h"
 #include "backend/entity/ai/AICharacter.h"
 #include "backend/entity/Npc.h"
+#include "backend/entity/ai/zone/Zone.h"
 
 namespace backend {
 
@@ -13,12 +14,18 @@ AI_TASK_IMPL(AttackOnSelection) {
 	if (selection.empty()) {
 		return ai::TreeNodeStatus::FAILED;
 	}
-	bool attacked = false;
-	Npc& npc = getNpc(entity);
-	for (ai::CharacterId id : selection) {
-		attacked |= npc.attack(id);
+	Zone* zone = entity->getZone();
+	if (zone == nullptr) {
+		return ai::TreeNodeStatus::FAILED;
 	}
-	return attacked ? ai::TreeNodeStatus::FINISHED : ai::TreeNodeStatus::FAILED;
+	// the attacks are registered in the attack manager of the map - not in parallel to the ai tick
+	zone->executeAfterTick(entity, [selection] (const AIPtr& ai) {
+		Npc& npc = getNpc(ai);
+		for (ai::CharacterId id : selection) {
+			npc.attack(id);
+		}
+	});
+	return ai::TreeNodeStatus::FINISHED;
 }
 
 }
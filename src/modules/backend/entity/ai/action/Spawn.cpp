@@ -7,6 +7,8 @@
 #include "backend/entity/Npc.h"
 #include "backend/world/Map.h"
 #include "backend/entity/ai/AICharacter.h"
+#include "backend/entity/ai/zone/Zone.h"
+#include "core/Log.h"
 
 namespace backend {
 
@@ -14,14 +16,21 @@ namespace backend {
  * @ingroup AI
  */
 AI_TASK_IMPL(Spawn) {
-	Npc& npc = getNpc(entity);
-	const glm::ivec3 pos = entity->getCharacter()->getPosition();
-	SpawnMgr& spawnMgr = npc.map()->spawnMgr();
-	// TODO: amount, type and radius
-	if (spawnMgr.spawn(npc.entityType(), 1, &pos) == 1) {
-		return ai::TreeNodeStatus::FINISHED;
+	Zone* zone = entity->getZone();
+	if (zone == nullptr) {
+		return ai::TreeNodeStatus::FAILED;
 	}
-	return ai::TreeNodeStatus::FAILED;
+	// the spawn modifies the map - this must not happen in parallel to the tick of the other ai instances
+	zone->executeAfterTick(entity, [] (const AIPtr& ai) {
+		Npc& npc = getNpc(ai);
+		const glm::ivec3 pos = ai->getCharacter()->getPosition();
+		SpawnMgr& spawnMgr = npc.map()->spawnMgr();
+		// TODO: amount, type and radius
+		if (spawnMgr.spawn(npc.entityType(), 1, &pos) != 1) {
+			Log::debug("Failed to spawn an npc at %i:%i:%i", pos.x, pos.y, pos.z);
+		}
+	});
+	return ai::TreeNodeStatus::FINISHED;
 }
 
 }
@@ -26,13 +26,17 @@ ai::TreeNodeStatus TriggerCooldownOnSelection::doAction(const AIPtr& entity, int
 	if (zone == nullptr) {
 		return ai::TreeNodeStatus::FAILED;
 	}
-	for (ai::CharacterId id : selection) {
-		auto func = [=] (const AIPtr& ai) {
-			Npc& npc = getNpc(entity);
-			npc.cooldownMgr().triggerCooldown(_cooldownId);
-		};
-		zone->executeAsync(id, func);
-	}
+	// the cooldowns of other entities are modified - not in parallel to the ai tick
+	const cooldown::Type cooldownId = _cooldownId;
+	zone->executeAfterTick(entity, [zone, selection, cooldownId] (const AIPtr& ai) {
+		for (ai::CharacterId id : selection) {
+			const AIPtr& target = zone->getAI(id);
+			if (!target) {
+				continue;
+			}
+			getNpc(target).cooldownMgr().triggerCooldown(cooldownId);
+		}
+	});
 	return ai::TreeNodeStatus::FINISHED;
 }
 
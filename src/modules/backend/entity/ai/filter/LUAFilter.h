@@ -10,36 +10,45 @@
 
 namespace backend {
 
+class LUAAIRegistry;
+
 /**
  * @see @ai{LUAAIRegistry}
  */
 class LUAFilter : public IFilter {
 protected:
-	lua_State* _s;
+	LUAAIRegistry* _registry;
+	// the index of the userdata reference in the lua context of the executing thread
+	int _slot;
 
 	void filterLUA(const AIPtr& entity);
 
 public:
 	class LUAFilterFactory : public IFilterFactory {
 	private:
-		lua_State* _s;
+		LUAAIRegistry* _registry;
 		core::String _type;
+		int _slot;
 	public:
-		LUAFilterFactory(lua_State* s, const core::String& typeStr) :
-				_s(s), _type(typeStr) {
+		LUAFilterFactory(LUAAIRegistry* registry, const core::String& typeStr, int slot) :
+				_registry(registry), _type(typeStr), _slot(slot) {
 		}
 
 		inline const core::String& type() const {
 			return _type;
 		}
 
+		inline int slot() const {
+			return _slot;
+		}
+
 		FilterPtr create(const FilterFactoryContext* ctx) const override {
-			return std::make_shared<LUAFilter>(_type, ctx->parameters, _s);
+			return std::make_shared<LUAFilter>(_type, ctx->parameters, _registry, _slot);
 		}
 	};
 
-	LUAFilter(const core::String& name, const core::String& parameters, lua_State* s) :
-			IFilter(name, parameters), _s(s) {
+	LUAFilter(const core::String& name, const core::String& parameters, LUAAIRegistry* registry, int slot) :
+			IFilter(name, parameters), _registry(registry), _slot(slot) {
 	}
 
 	~LUAFilter() {
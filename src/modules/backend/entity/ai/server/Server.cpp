@@ -328,6 +328,16 @@ void Server::resetSelection() {
 	_selectedCharacterId = AI_NOTHING_SELECTED;
 }
 
+void Server::reindexTree(Zone* zone, const TreeNodePtr& root) const {
+	root->indexNodes();
+	zone->executeParallel([&root] (const AIPtr& ai) {
+		if (ai->getBehaviour() == root) {
+			// the node states are reset with the next update of the ai
+			ai->_reset = true;
+		}
+	});
+}
+
 bool Server::updateNode(const ai::CharacterId& characterId, int32_t nodeId, const core::String& name, const core::String& type, const core::String& condition) {
 	Zone* zone = _zone;
 	if (zone == nullptr) {
@@ -365,6 +375,7 @@ bool Server::updateNode(const ai::CharacterId& characterId, int32_t nodeId, cons
 			return false;
 		}
 		parent->replaceChild(nodeId, newNode);
+		reindexTree(zone, root);
 	}
 
 	Event event;
@@ -403,6 +414,7 @@ bool Server::addNode(const ai::CharacterId& characterId, int32_t parentNodeId, c
 	if (!node->addChild(newNode)) {
 		return false;
 	}
+	reindexTree(zone, ai->getBehaviour());
 
 	Event event;
 	event.type = EV_UPDATESTATICCHRDETAILS;
@@ -429,6 +441,7 @@ bool Server::deleteNode(const ai::CharacterId& characterId, int32_t nodeId) {
 		return false;
 	}
 	parent->replaceChild(nodeId, TreeNodePtr());
+	reindexTree(zone, root);
 	Event event;
 	event.type = EV_UPDATESTATICCHRDETAILS;
 	event.data.zone = zone;
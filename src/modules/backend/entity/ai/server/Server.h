@@ -102,6 +102,11 @@ protected:
 
 	void addChildren(const TreeNodePtr& node, core::DynamicArray<ai::AIStateNodeStatic>& out) const;
 	void addChildren(const TreeNodePtr& node, ai::AIStateNode& parent, const AIPtr& ai) const;
+	/**
+	 * @brief Assign new node state indices after the structure of the given tree was modified and
+	 * reset the node states of all @c AI instances that are using the tree.
+	 */
+	void reindexTree(Zone* zone, const TreeNodePtr& root) const;
 
 	// only call these from the Server::update method
 	void broadcastState(const Zone* zone);
@@ -3,13 +3,14 @@
  */
 
 #include "ITimedNode.h"
+#include "backend/entity/ai/AI.h"
 #include <stdlib.h>
-#define NOTSTARTED (-1)
+#define NOTSTARTED AI::TreeNodeState::TimerNotStarted
 
 namespace backend {
 
 ITimedNode::ITimedNode(const core::String& name, const core::String& parameters, const ConditionPtr& condition) :
-		TreeNode(name, parameters, condition), _timerMillis(NOTSTARTED) {
+		TreeNode(name, parameters, condition) {
 	if (!parameters.empty()) {
 		_millis = ::atol(parameters.c_str());
 	} else {
@@ -22,23 +23,24 @@ ai::TreeNodeStatus ITimedNode::execute(const AIPtr& entity, int64_t deltaMillis)
 	if (result == ai::TreeNodeStatus::CANNOTEXECUTE)
 		return ai::TreeNodeStatus::CANNOTEXECUTE;
 
-	if (_timerMillis == NOTSTARTED) {
-		_timerMillis = _millis;
+	const int64_t timerMillis = getTimerMillis(entity);
+	if (timerMillis == NOTSTARTED) {
+		setTimerMillis(entity, _millis);
 		const ai::TreeNodeStatus status = executeStart(entity, deltaMillis);
 		if (status == ai::TreeNodeStatus::FINISHED)
-			_timerMillis = NOTSTARTED;
+			setTimerMillis(entity, NOTSTARTED);
 		return state(entity, status);
 	}
 
-	if (_timerMillis - deltaMillis > 0) {
-		_timerMillis -= deltaMillis;
+	if (timerMillis - deltaMillis > 0) {
+		setTimerMillis(entity, timerMillis - deltaMillis);
 		const ai::TreeNodeStatus status = executeRunning(entity, deltaMillis);
 		if (status == ai::TreeNodeStatus::FINISHED)
-			_timerMillis = NOTSTARTED;
+			setTimerMillis(entity, NOTSTARTED);
 		return state(entity, status);
 	}
 
-	_timerMillis = NOTSTARTED;
+	setTimerMillis(entity, NOTSTARTED);
 	return state(entity, executeExpired(entity, deltaMillis));
 }
 
@@ -19,10 +19,10 @@ namespace backend {
 
 /**
  * @brief A timed node is a @c TreeNode that is executed until a given time (millis) is elapsed.
+ * @note The remaining time is stored in the node state of the @c AI instance
  */
 class ITimedNode : public TreeNode {
 protected:
-	int64_t _timerMillis;
 	int64_t _millis;
 public:
 	ITimedNode(const core::String& name, const core::String& parameters, const ConditionPtr& condition);
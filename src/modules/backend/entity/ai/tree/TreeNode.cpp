@@ -14,6 +14,28 @@ int TreeNode::getId() const {
 	return _id;
 }
 
+int TreeNode::indexNodes() {
+	int index = 0;
+	indexNodes_r(index);
+	_nodeCount = index;
+	return _nodeCount;
+}
+
+void TreeNode::indexNodes_r(int& index) {
+	_stateIndex = index++;
+	for (auto& c : _children) {
+		c->indexNodes_r(index);
+	}
+}
+
+int TreeNode::getNodeCount() const {
+	return _nodeCount;
+}
+
+int TreeNode::getStateIndex() const {
+	return _stateIndex;
+}
+
 void TreeNode::setName(const core::String& name) {
 	if (name.empty()) {
 		return;
@@ -71,38 +93,50 @@ void TreeNode::setLastExecMillis(const AIPtr& entity) {
 	if (!entity->_debuggingActive) {
 		return;
 	}
-	entity->_lastExecMillis.put(getId(), entity->_time);
+	entity->nodeState(_stateIndex).lastExecMillis = entity->_time;
 }
 
 int TreeNode::getSelectorState(const AIPtr& entity) const {
-	auto i = entity->_selectorStates.find(getId());
-	if (i == entity->_selectorStates.end()) {
+	const AI::TreeNodeState* nodeState = entity->findNodeState(_stateIndex);
+	if (nodeState == nullptr) {
 		return AI_NOTHING_SELECTED;
 	}
-	return i->second;
+	return nodeState->selector;
 }
 
 void TreeNode::setSelectorState(const AIPtr& entity, int selected) {
-	entity->_selectorStates.put(getId(), selected);
+	entity->nodeState(_stateIndex).selector = selected;
 }
 
 int TreeNode::getLimitState(const AIPtr& entity) const {
-	auto i = entity->_limitStates.find(getId());
-	if (i == entity->_limitStates.end()) {
+	const AI::TreeNodeState* nodeState = entity->findNodeState(_stateIndex);
+	if (nodeState == nullptr) {
 		return 0;
 	}
-	return i->second;
+	return nodeState->limit;
 }
 
 void TreeNode::setLimitState(const AIPtr& entity, int amount) {
-	entity->_limitStates.put(getId(), amount);
+	entity->nodeState(_stateIndex).limit = amount;
+}
+
+int64_t TreeNode::getTimerMillis(const AIPtr& entity) const {
+	const AI::TreeNodeState* nodeState = entity->findNodeState(_stateIndex);
+	if (nodeState == nullptr) {
+		return AI::TreeNodeState::TimerNotStarted;
+	}
+	return nodeState->timerMillis;
+}
+
+void TreeNode::setTimerMillis(const AIPtr& entity, int64_t millis) {
+	entity->nodeState(_stateIndex).timerMillis = millis;
 }
 
 ai::TreeNodeStatus TreeNode::state(const AIPtr& entity, ai::TreeNodeStatus treeNodeState) {
 	if (!entity->_debuggingActive) {
 		return treeNodeState;
 	}
-	entity->_lastStatus.put(getId(), treeNodeState);
+	entity->nodeState(_stateIndex).status = treeNodeState;
 	return treeNodeState;
 }
 
@@ -110,22 +144,22 @@ int64_t TreeNode::getLastExecMillis(const AIPtr& entity) const {
 	if (!entity->_debuggingActive) {
 		return -1L;
 	}
-	auto i = entity->_lastExecMillis.find(getId());
-	if (i == entity->_lastExecMillis.end()) {
+	const AI::TreeNodeState* nodeState = entity->findNodeState(_stateIndex);
+	if (nodeState == nullptr) {
 		return -1L;
 	}
-	return i->second;
+	return nodeState->lastExecMillis;
 }
 
 ai::TreeNodeStatus TreeNode::getLastStatus(const AIPtr& entity) const {
 	if (!entity->_debuggingActive) {
 		return ai::TreeNodeStatus::UNKNOWN;
 	}
-	auto i = entity->_lastStatus.find(getId());
-	if (i == entity->_lastStatus.end()) {
+	const AI::TreeNodeState* nodeState = entity->findNodeState(_stateIndex);
+	if (nodeState == nullptr) {
 		return ai::TreeNodeStatus::UNKNOWN;
 	}
-	return i->second;
+	return nodeState->status;
 }
 
 TreeNodePtr TreeNode::getChild(int id) const {
@@ -59,6 +59,9 @@ public: \
  * connected @c AI instance. Don't store states on tree nodes, because they can
  * be reused for multiple @c AI instances. Always use the @c AI or @c ICharacter
  * to store your state!
+ *
+ * Each node of a behaviour tree gets a dense index (see @c indexNodes()) that is used to
+ * look up its state in the flat per @c AI state block.
  */
 class TreeNode : public MemObject {
 protected:
@@ -71,6 +74,10 @@ protected:
 	 * @brief Every node has an id to identify it. It's unique per type.
 	 */
 	int _id;
+	// index of the node state in the per ai state block - see indexNodes()
+	int _stateIndex = -1;
+	// the amount of nodes in this tree - only set for the root node
+	int _nodeCount = 0;
 	TreeNodes _children;
 	core::String _name;
 	core::String _type;
@@ -83,8 +90,11 @@ protected:
 	int getLimitState(const AIPtr& entity) const;
 	void setLimitState(const AIPtr& entity, int amount);
 	void setLastExecMillis(const AIPtr& entity);
+	int64_t getTimerMillis(const AIPtr& entity) const;
+	void setTimerMillis(const AIPtr& entity, int64_t millis);
 
 	TreeNodePtr getParent_r(const TreeNodePtr& parent, int id) const;
+	void indexNodes_r(int& index);
 
 public:
 	/**
@@ -104,6 +114,25 @@ public:
 	 */
 	int getId() const;
 
+	/**
+	 * @brief Assigns the dense state indices to all the nodes of the tree. This must be called on the
+	 * root node after the tree was built or modified.
+	 * @note The tree loaders and @c AI are doing this for you - but if you modify the tree structure
+	 * after the @c AI instances were created, you have to call this again.
+	 * @return The amount of nodes in the tree
+	 */
+	int indexNodes();
+	/**
+	 * @return The amount of nodes in the tree. Only valid for root nodes that were indexed already.
+	 * @sa indexNodes()
+	 */
+	int getNodeCount() const;
+	/**
+	 * @return The index of the node state in the per @c AI state block - or @c -1 if the tree
+	 * wasn't indexed yet.
+	 */
+	int getStateIndex() const;
+
 	/**
 	 * @brief Each node can have a user defines name that can be retrieved with this method.
 	 */
@@ -264,6 +264,10 @@ bool LUATreeLoader::init(const core::String& luaString) {
 	{
 		core::ScopedLock scopedLock(_lock);
 		empty = _treeMap.empty();
+		// the trees are complete now - assign the node state indices
+		for (auto i = _treeMap.begin(); i != _treeMap.end(); ++i) {
+			i->second->indexNodes();
+		}
 	}
 	if (empty) {
 		setError("No behaviour trees specified");
@@ -4,15 +4,28 @@
 
 #include "Zone.h"
 #include "core/Trace.h"
+#include "core/TimeProvider.h"
+#include "core/concurrent/Concurrency.h"
 #include "backend/entity/ai/tree/TreeNode.h"
+#include <algorithm>
 
 namespace backend {
 
+int Zone::workerThreads(int threadCount) {
+	if (threadCount >= 0) {
+		return threadCount;
+	}
+	return (int)core::cpus() - 1;
+}
+
 Zone::~Zone() {
 	_threadPool.shutdown();
-	for (const auto& e : _ais) {
-		e.second->setZone(nullptr);
-		_groupManager.removeFromAllGroups(e.second);
+	for (const AIPtr& ai : _aiList) {
+		if (!ai) {
+			continue;
+		}
+		ai->setZone(nullptr);
+		_groupManager.removeFromAllGroups(ai);
 	}
 	for (const auto& ai : _scheduledAdd) {
 		ai->setZone(nullptr);
@@ -21,22 +34,27 @@ Zone::~Zone() {
 	for (const auto& ai : _scheduledRemove) {
 		doRemoveAI(ai);
 	}
-	_ais.clear();
+	_aiIndices.clear();
+	_aiList.clear();
 }
 
 AIPtr Zone::getAI(ai::CharacterId id) const {
 	core::ScopedLock scopedLock(_lock);
-	auto i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return AIPtr();
 	}
-	const AIPtr& ai = i->second;
-	return ai;
+	return _aiList[i->second];
+}
+
+Zone::AIList Zone::snapshot() const {
+	core::ScopedLock scopedLock(_lock);
+	return _aiList;
 }
 
 size_t Zone::size() const {
 	core::ScopedLock scopedLock(_lock);
-	return _ais.size();
+	return _aiIndices.size();
 }
 
 bool Zone::doAddAI(const AIPtr& ai) {
@@ -44,34 +62,124 @@ bool Zone::doAddAI(const AIPtr& ai) {
 		return false;
 	}
 	const ai::CharacterId& id = ai->getCharacter()->getId();
-	if (_ais.find(id) != _ais.end()) {
+	if (_aiIndices.find(id) != _aiIndices.end()) {
 		return false;
 	}
-	_ais.insert(std::make_pair(id, ai));
+	_aiIndices.insert(std::make_pair(id, (int)_aiList.size()));
+	_aiList.push_back(ai);
+	_aiListDirty = true;
 	ai->setZone(this);
 	return true;
 }
 
 bool Zone::doRemoveAI(const ai::CharacterId& id) {
-	AIMapIter i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return false;
 	}
-	i->second->setZone(nullptr);
-	_groupManager.removeFromAllGroups(i->second);
-	_ais.erase(i);
+	AIPtr& ai = _aiList[i->second];
+	ai->setZone(nullptr);
+	_groupManager.removeFromAllGroups(ai);
+	// the slot is removed in rebuildAIList() - this keeps the indices of the other entries valid
+	ai = AIPtr();
+	_aiIndices.erase(i);
+	_aiListDirty = true;
 	return true;
 }
 
 bool Zone::doDestroyAI(const ai::CharacterId& id) {
-	AIMapIter i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return false;
 	}
-	_ais.erase(i);
+	_aiList[i->second] = AIPtr();
+	_aiIndices.erase(i);
+	_aiListDirty = true;
 	return true;
 }
 
+void Zone::rebuildAIList() {
+	core_trace_scoped(ZoneRebuildAIList);
+	_aiListDirty = false;
+	_aiList.erase(std::remove(_aiList.begin(), _aiList.end(), AIPtr()), _aiList.end());
+	// the order of additions is random - but the tick order of the ai instances should not change with every modification
+	std::sort(_aiList.begin(), _aiList.end(), [] (const AIPtr& a, const AIPtr& b) {
+		return a->getId() < b->getId();
+	});
+	for (int i = 0; i < (int)_aiList.size(); ++i) {
+		_aiIndices[_aiList[i]->getId()] = i;
+	}
+	_aiTicks.resize(_aiList.size());
+}
+
+void Zone::addDeferredCall(const AIPtr& ai, core::Task&& task) {
+	core::ScopedLock scopedLock(_deferredLock);
+	_deferredCalls.push_back(DeferredCall{ai->getId(), core::move(task)});
+}
+
+void Zone::executeDeferredCalls() {
+	std::vector<DeferredCall> calls;
+	{
+		core::ScopedLock scopedLock(_deferredLock);
+		calls.swap(_deferredCalls);
+	}
+	if (calls.empty()) {
+		return;
+	}
+	core_trace_scoped(ZoneExecuteDeferredCalls);
+	// the workers add the calls in random order - the calls of one ai instance keep their order
+	std::stable_sort(calls.begin(), calls.end(), [] (const DeferredCall& a, const DeferredCall& b) {
+		return a.id < b.id;
+	});
+	for (DeferredCall& call : calls) {
+		call.task();
+	}
+}
+
+void Zone::updateTickStats(uint64_t tickStart) {
+	const uint64_t resolution = core::TimeProvider::highResTimeResolution() / 1000000u;
+	const uint64_t resolutionDivisor = resolution > 0u ? resolution : 1u;
+	_tickStats.tickMicros = (uint32_t)((core::TimeProvider::highResTime() - tickStart) / resolutionDivisor);
+	_tickStats.ais = (int)_aiList.size();
+
+	// partial selection of the slowest entries - MaxSlowest is tiny, so this is linear in the amount of ai instances
+	int indices[TickStats::MaxSlowest];
+	int amount = 0;
+	for (int i = 0; i < (int)_aiTicks.size(); ++i) {
+		const uint32_t ticks = _aiTicks[i];
+		if (ticks == 0u) {
+			continue;
+		}
+		int pos = amount;
+		while (pos > 0 && _aiTicks[indices[pos - 1]] < ticks) {
+			--pos;
+		}
+		if (pos >= TickStats::MaxSlowest) {
+			continue;
+		}
+		const int last = amount < TickStats::MaxSlowest ? amount : TickStats::MaxSlowest - 1;
+		for (int j = last; j > pos; --j) {
+			indices[j] = indices[j - 1];
+		}
+		indices[pos] = i;
+		if (amount < TickStats::MaxSlowest) {
+			++amount;
+		}
+	}
+	_tickStats.slowestAmount = amount;
+	for (int i = 0; i < TickStats::MaxSlowest; ++i) {
+		TickStats::Entry& entry = _tickStats.slowest[i];
+		if (i >= amount) {
+			entry = TickStats::Entry();
+			continue;
+		}
+		const AIPtr& ai = _aiList[indices[i]];
+		entry.id = ai->getId();
+		entry.behaviour = ai->getBehaviour();
+		entry.micros = (uint32_t)(_aiTicks[indices[i]] / resolutionDivisor);
+	}
+}
+
 bool Zone::addAI(const AIPtr& ai) {
 	if (!ai) {
 		return false;
@@ -118,16 +226,29 @@ void Zone::update(int64_t dt) {
 			doDestroyAI(id);
 		}
 		scheduledDestroy.clear();
+		if (_aiListDirty) {
+			rebuildAIList();
+		}
 	}
 
-	auto func = [&] (const AIPtr& ai) {
-		if (ai->isPause()) {
-			return;
+	// the ai list is only modified by this method - no need to lock the zone while iterating it
+	const uint64_t tickStart = core::TimeProvider::highResTime();
+	_threadPool.parallelFor(0, (int)_aiList.size(), [this, dt] (int start, int end) {
+		core_trace_scoped(ZoneUpdateChunk);
+		for (int i = start; i < end; ++i) {
+			const AIPtr& ai = _aiList[i];
+			if (ai->isPause()) {
+				_aiTicks[i] = 0u;
+				continue;
+			}
+			const uint64_t begin = core::TimeProvider::highResTime();
+			ai->update(dt, _debug);
+			ai->getBehaviour()->execute(ai, dt);
+			_aiTicks[i] = (uint32_t)(core::TimeProvider::highResTime() - begin);
 		}
-		ai->update(dt, _debug);
-		ai->getBehaviour()->execute(ai, dt);
-	};
-	executeParallel(func);
+	}, MinAIsPerChunk);
+	updateTickStats(tickStart);
+	executeDeferredCalls();
 	_groupManager.update(dt);
 }
 
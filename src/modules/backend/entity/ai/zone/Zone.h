@@ -16,6 +16,7 @@
 #include "backend/entity/ai/ICharacter.h"
 #include "backend/entity/ai/group/GroupMgr.h"
 #include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Task.h"
 #include "core/concurrent/Lock.h"
 #include "core/Trace.h"
 #include "ai-shared/common/CharacterId.h"
@@ -40,21 +41,55 @@ typedef std::shared_ptr<AI> AIPtr;
  */
 class Zone {
 public:
-	typedef std::unordered_map<ai::CharacterId, AIPtr> AIMap;
+	typedef std::vector<AIPtr> AIList;
+	typedef std::unordered_map<ai::CharacterId, int> AIIndexMap;
 	typedef std::vector<AIPtr> AIScheduleList;
 	typedef std::vector<ai::CharacterId> CharacterIdList;
-	typedef AIMap::const_iterator AIMapConstIter;
-	typedef AIMap::iterator AIMapIter;
+
+	/**
+	 * @brief Timings of the last @c Zone::update call
+	 */
+	struct TickStats {
+		static constexpr int MaxSlowest = 3;
+		struct Entry {
+			ai::CharacterId id = -1;
+			TreeNodePtr behaviour;
+			uint32_t micros = 0u;
+		};
+		// the time that was spent to update and execute the behaviour trees of all ai instances
+		uint32_t tickMicros = 0u;
+		int ais = 0;
+		// the ai instances with the most expensive behaviour tree executions - sorted descending by time
+		int slowestAmount = 0;
+		Entry slowest[MaxSlowest];
+	};
 
 protected:
+	// the minimum amount of ai instances that are handed over to a worker
+	static constexpr int MinAIsPerChunk = 16;
 	const core::String _name;
-	AIMap _ais;
+	// dense list of the ai instances sorted by the character id - this is what the zone tick iterates
+	AIList _aiList;
+	// the index of the ai instances in the ai list
+	AIIndexMap _aiIndices;
+	// the high resolution execution time of each entry in the ai list of the last tick - indexed like _aiList
+	std::vector<uint32_t> _aiTicks;
+	// set if the ai list must be compacted and sorted because ai instances were added or removed
+	bool _aiListDirty = false;
+	TickStats _tickStats;
 	AIScheduleList _scheduledAdd;
 	CharacterIdList _scheduledRemove;
 	CharacterIdList _scheduledDestroy;
+	struct DeferredCall {
+		ai::CharacterId id;
+		core::Task task;
+	};
+	// the side effects of the behaviour tree nodes - executed after all ai instances were ticked
+	std::vector<DeferredCall> _deferredCalls;
 	bool _debug;
 	mutable core_trace_mutex(core::Lock, _lock, "AIZone");
 	core_trace_mutex(core::Lock, _scheduleLock, "AIScheduleZone");
+	core_trace_mutex(core::Lock, _deferredLock, "AIDeferredZone");
 	GroupMgr _groupManager;
 	mutable core::ThreadPool _threadPool;
 
@@ -77,10 +112,34 @@ protected:
 	 * @note This doesn't lock the zone - but because @c Zone::update already does it
 	 */
 	bool doDestroyAI(const ai::CharacterId& id);
+	/**
+	 * @brief Remove the released slots and sort the ai instances by their character id to get a stable update order
+	 * @note This doesn't lock the zone - but because @c Zone::update already does it
+	 */
+	void rebuildAIList();
+	void addDeferredCall(const AIPtr& ai, core::Task&& task);
+	/**
+	 * @brief Executes the functors of @c executeAfterTick() in the order of the character ids
+	 */
+	void executeDeferredCalls();
+	void updateTickStats(uint64_t tickStart);
+	/**
+	 * @return A copy of the dense ai list to execute functors without holding the zone lock
+	 * @note This locks the zone for reading
+	 */
+	AIList snapshot() const;
+
+	static int workerThreads(int threadCount);
 
 public:
-	Zone(const core::String& name, int threadCount = 1) :
-			_name(name), _debug(false), _threadPool(threadCount) {
+	/**
+	 * @param threadCount The amount of additional worker threads for the ai tick. A negative value means one
+	 * worker less than cpu cores are available - the thread that calls @c Zone::update() is working, too.
+	 * @note The behaviour tree nodes must not modify the map or other entities directly - see
+	 * @c executeAfterTick()
+	 */
+	Zone(const core::String& name, int threadCount = -1) :
+			_name(name), _debug(false), _threadPool(workerThreads(threadCount), "Zone") {
 		_threadPool.init();
 	}
 
@@ -241,6 +300,20 @@ public:
 		return execute(getAI(id), func);
 	}
 
+	/**
+	 * @brief Defers the given lambda or functor until all the @c AI instances of the current @c Zone::update()
+	 * call were ticked. The ai instances are ticked in parallel - behaviour tree nodes that modify the map or
+	 * other entities (e.g. spawning or attacking) must use this for their side effects.
+	 *
+	 * @note The functors are executed by the thread that calls @c Zone::update() - ordered by the character
+	 * id of the given @c AI instance, so the result doesn't depend on the amount of worker threads. Functors
+	 * that are added outside of the ai tick are executed after the next one.
+	 */
+	template<typename Func>
+	void executeAfterTick(const AIPtr& ai, Func&& func) {
+		addDeferredCall(ai, core::Task([ai, func = std::forward<Func>(func)] () { func(ai); }));
+	}
+
 	/**
 	 * @brief Executes a lambda or functor for all the @c AI instances in this zone
 	 * @note This is executed in a thread pool - so make sure to synchronize your lambda or functor.
@@ -251,17 +324,12 @@ public:
 	template<typename Func>
 	void executeParallel(Func& func) {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		const AIList& ais = snapshot();
+		_threadPool.parallelFor(0, (int)ais.size(), [&] (int start, int end) {
+			for (int i = start; i < end; ++i) {
+				func(ais[i]);
+			}
+		}, MinAIsPerChunk);
 	}
 
 	/**
@@ -274,17 +342,12 @@ public:
 	template<typename Func>
 	void executeParallel(const Func& func) const {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		const AIList& ais = snapshot();
+		_threadPool.parallelFor(0, (int)ais.size(), [&] (int start, int end) {
+			for (int i = start; i < end; ++i) {
+				func(ais[i]);
+			}
+		}, MinAIsPerChunk);
 	}
 
 	/**
@@ -296,11 +359,7 @@ public:
 	template<typename Func>
 	void execute(const Func& func) const {
 		core_trace_scoped(ZoneExecute);
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		for (const AIPtr& ai : snapshot()) {
 			func(ai);
 		}
 	}
@@ -314,15 +373,22 @@ public:
 	template<typename Func>
 	void execute(Func& func) {
 		core_trace_scoped(ZoneExecute);
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		for (const AIPtr& ai : snapshot()) {
 			func(ai);
 		}
 	}
 
+	/**
+	 * @return The timings of the last @c Zone::update() call
+	 * @note Only valid to call from the thread that calls @c Zone::update()
+	 */
+	const TickStats& tickStats() const;
+
+	/**
+	 * @return The amount of threads that are working on the ai tick
+	 */
+	int threads() const;
+
 	size_t size() const;
 };
 
@@ -338,6 +404,14 @@ inline const core::String& Zone::getName() const {
 	return _name;
 }
 
+inline const Zone::TickStats& Zone::tickStats() const {
+	return _tickStats;
+}
+
+inline int Zone::threads() const {
+	return (int)_threadPool.size() + 1;
+}
+
 inline GroupMgr& Zone::getGroupMgr() {
 	return _groupManager;
 }
@@ -25,6 +25,7 @@
 #include "backend/network/TriggerActionHandler.h"
 #include "backend/network/VarUpdateHandler.h"
 #include "backend/network/MoveHandler.h"
+#include "backend/network/EntitySnapshotAckHandler.h"
 #include "persistence/PersistenceMgr.h"
 #include "backend/world/World.h"
 #include "command/CommandHandler.h"
@@ -327,6 +328,7 @@ bool ServerLoop::init() {
 	regHandler(network::ClientMsgType::TriggerAction, TriggerActionHandler);
 	regHandler(network::ClientMsgType::Move, MoveHandler);
 	regHandler(network::ClientMsgType::VarUpdate, VarUpdateHandler);
+	regHandler(network::ClientMsgType::EntitySnapshotAck, EntitySnapshotAckHandler);
 
 	Log::info("Init material");
 	if (!voxel::initDefaultMaterialColors()) {
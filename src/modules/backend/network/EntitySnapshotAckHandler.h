@@ -0,0 +1,19 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "network/Network.h"
+#include "IUserProtocolHandler.h"
+
+namespace backend {
+
+/**
+ * @brief The client applied the given @c network::EntitySnapshot - it's used as baseline for the next snapshots
+ */
+USERPROTOHANDLERIMPL(EntitySnapshotAck) {
+	user->ackEntitySnapshot(message->sequence());
+}
+
+}
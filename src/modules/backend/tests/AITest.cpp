@@ -112,6 +112,8 @@ TEST_F(AITest, testActionSpawn) {
 	const TreeNodePtr& action = Spawn::getFactory().create(&ctx);
 	const int before = map->npcCount();
 	EXPECT_EQ(ai::TreeNodeStatus::FINISHED, action->execute(npc->ai(), 0L));
+	EXPECT_EQ(before, map->npcCount()) << "The spawn should be deferred until the ai tick is done";
+	map->zone()->update(0L);
 	const int after = map->npcCount();
 	EXPECT_EQ(before + 1, after) << "NPC wasn't spawned as expected";
 }
@@ -0,0 +1,158 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "backend/world/EntityGrid.h"
+#include "backend/world/Map.h"
+#include "attrib/ContainerProvider.h"
+#include <vector>
+
+namespace backend {
+
+class EntityGridTest: public testing::Test {
+protected:
+	EntityPtr create(EntityId id, const glm::vec3& pos) const {
+		const EntityPtr& entity = std::make_shared<Entity>(id, MapPtr(), network::ServerMessageSenderPtr(),
+				core::TimeProviderPtr(), attrib::ContainerProviderPtr());
+		entity->setPos(pos);
+		return entity;
+	}
+
+	std::vector<EntityId> ids(const VisibleEntities& visible) const {
+		std::vector<EntityId> result;
+		for (const VisibleEntity& e : visible) {
+			result.push_back(e.id);
+		}
+		return result;
+	}
+};
+
+TEST_F(EntityGridTest, testAddRemove) {
+	EntityGrid grid(32.0f);
+	const EntityPtr& e1 = create(1, glm::vec3(0.0f));
+	EXPECT_TRUE(grid.add(e1, 10.0f));
+	EXPECT_FALSE(grid.add(e1, 10.0f));
+	EXPECT_EQ(1, grid.size());
+	EXPECT_EQ(1, grid.cells());
+	EXPECT_TRUE(grid.remove(e1.get()));
+	EXPECT_FALSE(grid.remove(e1.get()));
+	EXPECT_EQ(0, grid.size());
+	EXPECT_EQ(0, grid.cells());
+}
+
+TEST_F(EntityGridTest, testVisibleSorted) {
+	EntityGrid grid(8.0f);
+	const EntityPtr& self = create(5, glm::vec3(0.0f));
+	const EntityPtr& far = create(1, glm::vec3(100.0f, 0.0f, 0.0f));
+	const EntityPtr& nearInOtherCell = create(3, glm::vec3(-9.0f, 0.0f, 9.0f));
+	const EntityPtr& nearInSameCell = create(2, glm::vec3(1.0f, 0.0f, 1.0f));
+	const EntityPtr& nearAtBorder = create(4, glm::vec3(10.4f, 0.0f, 0.0f));
+	for (const EntityPtr& e : {self, far, nearInOtherCell, nearInSameCell, nearAtBorder}) {
+		ASSERT_TRUE(grid.add(e, 10.0f));
+	}
+	VisibleEntities visible;
+	grid.visible(self.get(), visible);
+	// the view rect is intersected with the rect of the other entities - 10.4 is still inside
+	EXPECT_EQ(std::vector<EntityId>({2, 3, 4}), ids(visible));
+	grid.visible(far.get(), visible);
+	EXPECT_TRUE(visible.empty());
+}
+
+TEST_F(EntityGridTest, testVisibleManyCellsInRange) {
+	// the view rect covers a lot more cells than there are occupied cells
+	EntityGrid grid(1.0f);
+	const EntityPtr& self = create(1, glm::vec3(0.0f));
+	const EntityPtr& near = create(2, glm::vec3(-400.0f, 0.0f, 300.0f));
+	const EntityPtr& far = create(3, glm::vec3(600.0f, 0.0f, 0.0f));
+	for (const EntityPtr& e : {self, near, far}) {
+		ASSERT_TRUE(grid.add(e, 500.0f));
+	}
+	VisibleEntities visible;
+	grid.visible(self.get(), visible);
+	EXPECT_EQ(std::vector<EntityId>({2}), ids(visible));
+}
+
+TEST_F(EntityGridTest, testVisibleManyOccupiedCells) {
+	// more occupied cells than cells in the view rect
+	EntityGrid grid(4.0f);
+	const EntityPtr& self = create(1000, glm::vec3(0.0f));
+	ASSERT_TRUE(grid.add(self, 6.0f));
+	std::vector<EntityPtr> entities;
+	std::vector<EntityId> expected;
+	EntityId id = 1;
+	for (int x = -20; x <= 20; x += 4) {
+		for (int z = -20; z <= 20; z += 4) {
+			if (x == 0 && z == 0) {
+				continue;
+			}
+			const EntityPtr& e = create(id, glm::vec3((float)x, 0.0f, (float)z));
+			ASSERT_TRUE(grid.add(e, 6.0f));
+			entities.push_back(e);
+			if (glm::abs(x) < 6 && glm::abs(z) < 6) {
+				expected.push_back(id);
+			}
+			++id;
+		}
+	}
+	ASSERT_GT(grid.cells(), 16);
+	VisibleEntities visible;
+	grid.visible(self.get(), visible);
+	EXPECT_EQ(expected, ids(visible));
+}
+
+TEST_F(EntityGridTest, testMoveAcrossCells) {
+	EntityGrid grid(16.0f);
+	const EntityPtr& e1 = create(1, glm::vec3(1.0f));
+	const EntityPtr& e2 = create(2, glm::vec3(2.0f));
+	ASSERT_TRUE(grid.add(e1, 4.0f));
+	ASSERT_TRUE(grid.add(e2, 4.0f));
+	EXPECT_EQ(1, grid.cells());
+
+	e1->setPos(glm::vec3(3.0f));
+	EXPECT_FALSE(grid.update(e1.get(), 4.0f)) << "A move inside of the cell should not change the cell";
+
+	e1->setPos(glm::vec3(100.0f));
+	EXPECT_TRUE(grid.update(e1.get(), 4.0f));
+	EXPECT_EQ(2, grid.cells());
+	VisibleEntities visible;
+	grid.visible(e2.get(), visible);
+	EXPECT_TRUE(visible.empty());
+
+	e1->setPos(glm::vec3(4.0f));
+	EXPECT_TRUE(grid.update(e1.get(), 4.0f));
+	EXPECT_EQ(1, grid.cells());
+	grid.visible(e2.get(), visible);
+	EXPECT_EQ(std::vector<EntityId>({1}), ids(visible));
+}
+
+TEST_F(EntityGridTest, testEntityVisibleDelta) {
+	EntityGrid grid(16.0f);
+	const EntityPtr& self = create(1, glm::vec3(0.0f));
+	const EntityPtr& e2 = create(2, glm::vec3(2.0f));
+	const EntityPtr& e3 = create(3, glm::vec3(40.0f));
+	for (const EntityPtr& e : {self, e2, e3}) {
+		ASSERT_TRUE(grid.add(e, 8.0f));
+	}
+	VisibleEntities visible;
+	grid.visible(self.get(), visible);
+	self->updateVisible(visible);
+	EXPECT_EQ(1, self->visibleCount());
+
+	e2->setPos(glm::vec3(80.0f));
+	grid.update(e2.get(), 8.0f);
+	e3->setPos(glm::vec3(3.0f));
+	grid.update(e3.get(), 8.0f);
+	grid.visible(self.get(), visible);
+	self->updateVisible(visible);
+	EXPECT_EQ(1, self->visibleCount());
+	std::vector<EntityId> visibleIds;
+	self->visitVisible([&] (const EntityPtr& e) {
+		visibleIds.push_back(e->id());
+	});
+	EXPECT_EQ(std::vector<EntityId>({3}), visibleIds);
+	// the previously visible entities are handed back
+	EXPECT_EQ(std::vector<EntityId>({2}), ids(visible));
+}
+
+}
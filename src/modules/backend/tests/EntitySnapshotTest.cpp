@@ -0,0 +1,323 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "core/EventBus.h"
+#include "math/Random.h"
+#include "ClientMessages_generated.h"
+#include "ServerMessages_generated.h"
+#include "network/AbstractClientNetwork.h"
+#include "network/NetworkEvents.h"
+#include "network/ProtocolHandlerRegistry.h"
+#include "shared/EntitySnapshot.h"
+#include "backend/network/ServerNetwork.h"
+#include "backend/network/ServerMessageSender.h"
+#include <SDL_timer.h>
+#include <unordered_map>
+
+namespace backend {
+
+namespace {
+
+/**
+ * Counts the received messages and applies the snapshots like the client does
+ */
+class SnapshotClientNetwork : public network::AbstractClientNetwork {
+private:
+	using Super = network::AbstractClientNetwork;
+	shared::EntitySnapshotDecoder _decoder;
+	shared::EntityStates _changed;
+	flatbuffers::FlatBufferBuilder _ackFbb;
+public:
+	int packets = 0;
+	int bytes = 0;
+	std::unordered_map<int64_t, shared::EntityState> states;
+
+	SnapshotClientNetwork(const network::ProtocolHandlerRegistryPtr& protocolHandlerRegistry, const core::EventBusPtr& eventBus) :
+			Super(protocolHandlerRegistry, eventBus) {
+	}
+
+	ENetPeer* connect(uint16_t port, const core::String& hostname) {
+		ENetPeer* peer = Super::connect(port, hostname);
+		if (peer != nullptr) {
+			// don't let the bandwidth throttling of the modem defaults influence the measurement
+			enet_host_bandwidth_limit(_client, 0, 0);
+		}
+		return peer;
+	}
+
+	void sendAck(uint32_t sequence) {
+		auto msg = network::CreateClientMessage(_ackFbb, network::ClientMsgType::EntitySnapshotAck,
+				network::CreateEntitySnapshotAck(_ackFbb, sequence).Union());
+		network::FinishClientMessageBuffer(_ackFbb, msg);
+		sendMessage(enet_packet_create(_ackFbb.GetBufferPointer(), _ackFbb.GetSize(), 0u));
+		_ackFbb.Clear();
+	}
+
+	bool packetReceived(ENetEvent& event) override {
+		flatbuffers::Verifier v(event.packet->data, event.packet->dataLength);
+		if (!network::VerifyServerMessageBuffer(v)) {
+			return false;
+		}
+		++packets;
+		bytes += (int)event.packet->dataLength;
+		const network::ServerMessage *msg = network::GetServerMessage(event.packet->data);
+		if (msg->data_type() == network::ServerMsgType::EntityUpdate) {
+			const network::EntityUpdate* update = msg->data_as_EntityUpdate();
+			const network::Vec3* pos = update->pos();
+			states[update->id()] = shared::entityState(update->id(), glm::vec3(pos->x(), pos->y(), pos->z()),
+					update->rotation(), update->animation());
+			return true;
+		}
+		if (msg->data_type() != network::ServerMsgType::EntitySnapshot) {
+			return false;
+		}
+		const network::EntitySnapshot* snapshot = msg->data_as_EntitySnapshot();
+		if (!_decoder.decode(snapshot, _changed)) {
+			return true;
+		}
+		for (const shared::EntityState& state : _changed) {
+			states[state.id] = state;
+		}
+		sendAck(snapshot->sequence());
+		return true;
+	}
+};
+
+class AckHandler : public network::IProtocolHandler {
+private:
+	shared::EntitySnapshotEncoder& _encoder;
+public:
+	AckHandler(shared::EntitySnapshotEncoder& encoder) : _encoder(encoder) {
+	}
+
+	void execute(ENetPeer* peer, const void* message) override {
+		_encoder.ack(getMsg<network::EntitySnapshotAck>(message)->sequence());
+	}
+};
+
+}
+
+/**
+ * @brief Load test on the loopback device that compares one @c EntityUpdate message per visible entity with
+ * one @c EntitySnapshot per tick
+ */
+class EntitySnapshotTest:
+		public app::AbstractTest,
+		public core::IEventBusHandler<network::NewConnectionEvent> {
+private:
+	using Super = app::AbstractTest;
+protected:
+	static constexpr int Entities = 256;
+	static constexpr int Ticks = 30;
+
+	core::EventBusPtr _clientEventBus;
+	core::EventBusPtr _serverEventBus;
+	network::ProtocolHandlerRegistryPtr _clientRegistry;
+	network::ProtocolHandlerRegistryPtr _serverRegistry;
+	std::shared_ptr<SnapshotClientNetwork> _clientNetwork;
+	network::ServerNetworkPtr _serverNetwork;
+	network::ServerMessageSenderPtr _messageSender;
+	shared::EntitySnapshotEncoder _encoder;
+	ENetPeer* _serverPeer = nullptr;
+	uint16_t _port = 0u;
+
+	std::vector<glm::vec3> _positions;
+	std::vector<float> _orientations;
+	std::vector<network::Animation> _animations;
+public:
+	void SetUp() override {
+		_clientEventBus = std::make_shared<core::EventBus>();
+		_serverEventBus = std::make_shared<core::EventBus>();
+		_clientRegistry = std::make_shared<network::ProtocolHandlerRegistry>();
+		_serverRegistry = std::make_shared<network::ProtocolHandlerRegistry>();
+		_clientNetwork = std::make_shared<SnapshotClientNetwork>(_clientRegistry, _clientEventBus);
+		const metric::MetricPtr& metric = std::make_shared<metric::Metric>();
+		_serverNetwork = std::make_shared<network::ServerNetwork>(_serverRegistry, _serverEventBus, metric);
+		_messageSender = std::make_shared<network::ServerMessageSender>(_serverNetwork, metric);
+		_port = (uint16_t)((uint32_t)(intptr_t)this) + 1025;
+		Super::SetUp();
+	}
+
+	bool onInitApp() override {
+		_serverEventBus->subscribe<network::NewConnectionEvent>(*this);
+		_serverNetwork->init();
+		_serverRegistry->registerHandler(network::EnumNameClientMsgType(network::ClientMsgType::EntitySnapshotAck),
+				std::make_shared<AckHandler>(_encoder));
+		_clientNetwork->init();
+
+		math::Random random(1);
+		for (int i = 0; i < Entities; ++i) {
+			_positions.emplace_back(random.randomf(0.0f, 256.0f), 10.0f, random.randomf(0.0f, 256.0f));
+			_orientations.push_back(random.randomf(0.0f, 6.0f));
+			_animations.push_back(network::Animation::IDLE);
+		}
+		return true;
+	}
+
+	void onCleanupApp() override {
+		_serverEventBus->unsubscribe<network::NewConnectionEvent>(*this);
+		_clientNetwork->shutdown();
+		_serverNetwork->shutdown();
+	}
+
+	void onEvent(const network::NewConnectionEvent& event) override {
+		_serverPeer = event.get();
+	}
+
+	bool connect() {
+		if (!_serverNetwork->bind(_port, "127.0.0.1")) {
+			return false;
+		}
+		if (_clientNetwork->connect(_port, "127.0.0.1") == nullptr) {
+			return false;
+		}
+		for (int i = 0; i < 100 && (_serverPeer == nullptr || !_clientNetwork->isConnected()); ++i) {
+			update();
+			SDL_Delay(1);
+		}
+		return _serverPeer != nullptr;
+	}
+
+	void update() {
+		_serverNetwork->update();
+		_clientNetwork->update();
+		_serverNetwork->update();
+		_clientNetwork->update();
+	}
+
+	/**
+	 * @brief Every tick some of the entities are moving and turning - most of them are idle
+	 */
+	void tick(int tick) {
+		for (int i = tick % 8; i < Entities; i += 8) {
+			_positions[i].x += 0.25f;
+			_orientations[i] += 0.1f;
+			_animations[i] = network::Animation::RUN;
+		}
+		for (int i = (tick + 7) % 8; i < Entities; i += 8) {
+			_animations[i] = network::Animation::IDLE;
+		}
+	}
+
+	shared::EntityStates states() const {
+		shared::EntityStates states;
+		for (int i = 0; i < Entities; ++i) {
+			states.push_back(shared::entityState(i + 1, _positions[i], _orientations[i], _animations[i]));
+		}
+		return states;
+	}
+
+	void waitForPackets(int expected) {
+		for (int i = 0; i < 1000 && _clientNetwork->packets < expected; ++i) {
+			update();
+			SDL_Delay(1);
+		}
+	}
+
+	void report(const char *name) {
+		const double packetsPerTick = (double)_clientNetwork->packets / Ticks;
+		const double bytesPerTick = (double)_clientNetwork->bytes / Ticks;
+		Log::info("%s: %f packets and %f bytes per tick", name, packetsPerTick, bytesPerTick);
+		RecordProperty("packetsPerTick", (int)packetsPerTick);
+		RecordProperty("bytesPerTick", (int)bytesPerTick);
+	}
+
+	void expectClientStates() {
+		const shared::EntityStates& expected = states();
+		ASSERT_EQ(expected.size(), _clientNetwork->states.size());
+		for (const shared::EntityState& state : expected) {
+			EXPECT_EQ(state, _clientNetwork->states[state.id]) << "entity " << state.id;
+		}
+	}
+};
+
+TEST_F(EntitySnapshotTest, testEntityUpdatePerEntity) {
+	ASSERT_TRUE(connect()) << "Failed to connect to port " << _port;
+	flatbuffers::FlatBufferBuilder fbb;
+	int expected = 0;
+	for (int t = 0; t < Ticks; ++t) {
+		tick(t);
+		for (int i = 0; i < Entities; ++i) {
+			const network::Vec3 pos { _positions[i].x, _positions[i].y, _positions[i].z };
+			_messageSender->sendServerMessage(_serverPeer, fbb, network::ServerMsgType::EntityUpdate,
+					network::CreateEntityUpdate(fbb, i + 1, &pos, _orientations[i], _animations[i]).Union());
+		}
+		expected += Entities;
+		waitForPackets(expected);
+	}
+	report("EntityUpdate");
+	EXPECT_EQ(Entities * Ticks, _clientNetwork->packets);
+	expectClientStates();
+}
+
+TEST_F(EntitySnapshotTest, testEntitySnapshot) {
+	ASSERT_TRUE(connect()) << "Failed to connect to port " << _port;
+	flatbuffers::FlatBufferBuilder fbb;
+	int sent = 0;
+	for (int t = 0; t < Ticks; ++t) {
+		tick(t);
+		flatbuffers::Offset<network::EntitySnapshot> snapshot;
+		if (!_encoder.encode(fbb, states(), snapshot)) {
+			fbb.Clear();
+			continue;
+		}
+		_messageSender->sendServerMessage(_serverPeer, fbb, network::ServerMsgType::EntitySnapshot, snapshot.Union(), 0u);
+		++sent;
+		waitForPackets(sent);
+		// give the ack the chance to arrive
+		update();
+	}
+	report("EntitySnapshot");
+	EXPECT_LE(_clientNetwork->packets, Ticks);
+	EXPECT_GT(_encoder.acked(), 0u);
+	expectClientStates();
+
+	// nothing changed since the acknowledged snapshot
+	if (_encoder.acked() == (uint32_t)sent) {
+		flatbuffers::Offset<network::EntitySnapshot> snapshot;
+		EXPECT_FALSE(_encoder.encode(fbb, states(), snapshot));
+	}
+}
+
+TEST_F(EntitySnapshotTest, testDeltaAgainstBaseline) {
+	flatbuffers::FlatBufferBuilder fbb;
+	shared::EntitySnapshotDecoder decoder;
+	shared::EntityStates changed;
+
+	shared::EntityStates serverStates = states();
+	flatbuffers::Offset<network::EntitySnapshot> offset;
+	ASSERT_TRUE(_encoder.encode(fbb, serverStates, offset));
+	network::FinishServerMessageBuffer(fbb, network::CreateServerMessage(fbb, network::ServerMsgType::EntitySnapshot, offset.Union()));
+	const network::EntitySnapshot* snapshot = network::GetServerMessage(fbb.GetBufferPointer())->data_as_EntitySnapshot();
+	EXPECT_EQ(0u, snapshot->baseline());
+	ASSERT_TRUE(decoder.decode(snapshot, changed));
+	EXPECT_EQ((size_t)Entities, changed.size());
+	const uint32_t sequence = snapshot->sequence();
+	_encoder.ack(sequence);
+	const int fullSize = (int)fbb.GetSize();
+	fbb.Clear();
+
+	// only one entity changed - relative to the acknowledged baseline
+	_positions[3].z += 1.0f;
+	serverStates = states();
+	ASSERT_TRUE(_encoder.encode(fbb, serverStates, offset));
+	network::FinishServerMessageBuffer(fbb, network::CreateServerMessage(fbb, network::ServerMsgType::EntitySnapshot, offset.Union()));
+	snapshot = network::GetServerMessage(fbb.GetBufferPointer())->data_as_EntitySnapshot();
+	EXPECT_EQ(sequence, snapshot->baseline());
+	ASSERT_EQ(1u, snapshot->entities()->size());
+	const network::EntityDelta* delta = snapshot->entities()->Get(0);
+	EXPECT_EQ(network::EntityDeltaFlags::POSITION, delta->flags());
+	EXPECT_EQ((int)shared::PositionScale, delta->z());
+	EXPECT_LT((int)fbb.GetSize() * 10, fullSize);
+	ASSERT_TRUE(decoder.decode(snapshot, changed));
+	ASSERT_EQ(1u, changed.size());
+	EXPECT_EQ(serverStates[3], changed[0]);
+
+	// an old snapshot is not applied again
+	EXPECT_FALSE(decoder.decode(snapshot, changed));
+	fbb.Clear();
+}
+
+}
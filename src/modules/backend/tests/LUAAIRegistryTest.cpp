@@ -7,6 +7,8 @@
 #include "io/Filesystem.h"
 #include "backend/entity/ai/zone/Zone.h"
 #include "backend/entity/ai/condition/True.h"
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/ThreadPool.h"
 #include <fstream>
 #include <streambuf>
 
@@ -128,6 +130,46 @@ TEST_F(LUAAIRegistryTest, testLuaNode2_100) {
 	testNode("LuaTest2", ai::TreeNodeStatus::RUNNING, 100);
 }
 
+TEST_F(LUAAIRegistryTest, testLuaNodeThreads) {
+	const TreeNodeFactoryContext ctx = TreeNodeFactoryContext("TreeNodeName", "", True::get());
+	const TreeNodePtr& node = _registry.createNode("LuaTest2", ctx);
+	ASSERT_TRUE((bool)node);
+	const int n = 256;
+	std::vector<AIPtr> ais;
+	for (int i = 0; i < n; ++i) {
+		const AIPtr& ai = std::make_shared<AI>(node);
+		ai->setCharacter(core::make_shared<TestEntity>(i));
+		ais.push_back(ai);
+	}
+	core::ThreadPool pool(4, "LUATest");
+	pool.init();
+	core::AtomicInt running;
+	pool.parallelFor(0, n, [&] (int start, int end) {
+		for (int i = start; i < end; ++i) {
+			if (node->execute(ais[i], 1L) == ai::TreeNodeStatus::RUNNING) {
+				running.increment(1);
+			}
+		}
+	});
+	EXPECT_EQ(n, (int)running);
+
+	// scripts that are evaluated later on are also executed in the lua states of the workers
+	ASSERT_TRUE(_registry.evaluate("local n = REGISTRY.createNode(\"LuaThreadTest\")\n"
+			"function n:execute(ai, deltaMillis)\n  return FAILED\nend\n"));
+	const TreeNodePtr& laterNode = _registry.createNode("LuaThreadTest", ctx);
+	ASSERT_TRUE((bool)laterNode);
+	core::AtomicInt failed;
+	pool.parallelFor(0, n, [&] (int start, int end) {
+		for (int i = start; i < end; ++i) {
+			if (laterNode->execute(ais[i], 1L) == ai::TreeNodeStatus::FAILED) {
+				failed.increment(1);
+			}
+		}
+	});
+	EXPECT_EQ(n, (int)failed);
+	pool.shutdown();
+}
+
 TEST_F(LUAAIRegistryTest, testCreateInvalidNode) {
 	const TreeNodeFactoryContext ctx = TreeNodeFactoryContext("TreeNodeName", "", True::get());
 	const TreeNodePtr& node = _registry.createNode("ThisNameDoesNotExist", ctx);
@@ -85,6 +85,44 @@ TEST_F(NodeTest, testIdle) {
 	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, node->execute(entity, 1000));
 }
 
+TEST_F(NodeTest, testSharedTreeState) {
+	backend::Sequence::Factory f;
+	backend::TreeNodeFactoryContext ctx("testsequence", "", backend::True::get());
+	TreeNodePtr node = f.create(&ctx);
+
+	backend::Idle::Factory idleFac;
+	backend::TreeNodeFactoryContext idleCtx1("testidle", "2", backend::True::get());
+	TreeNodePtr idle1 = idleFac.create(&idleCtx1);
+	backend::TreeNodeFactoryContext idleCtx2("testidle2", "2", backend::True::get());
+	TreeNodePtr idle2 = idleFac.create(&idleCtx2);
+
+	node->addChild(idle1);
+	node->addChild(idle2);
+	ASSERT_EQ(3, node->indexNodes());
+	EXPECT_EQ(0, node->getStateIndex());
+	EXPECT_EQ(1, idle1->getStateIndex());
+	EXPECT_EQ(2, idle2->getStateIndex());
+
+	// both instances share the same tree - but the timers and the selector states are per ai
+	AIPtr ai1 = std::make_shared<AI>(node);
+	ai1->setCharacter(core::make_shared<ICharacter>(1));
+	AIPtr ai2 = std::make_shared<AI>(node);
+	ai2->setCharacter(core::make_shared<ICharacter>(2));
+
+	ai1->update(1, true);
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, node->execute(ai1, 1));
+	ai1->update(1, true);
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, node->execute(ai1, 2));
+	ASSERT_EQ(ai::TreeNodeStatus::FINISHED, idle1->getLastStatus(ai1));
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, idle2->getLastStatus(ai1));
+
+	ai2->update(1, true);
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, node->execute(ai2, 1));
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, idle1->getLastStatus(ai2));
+	ASSERT_EQ(ai::TreeNodeStatus::UNKNOWN, idle2->getLastStatus(ai2));
+	ASSERT_EQ(ai::TreeNodeStatus::RUNNING, idle2->getLastStatus(ai1));
+}
+
 TEST_F(NodeTest, testParallel) {
 	backend::Parallel::Factory f;
 	backend::TreeNodeFactoryContext ctx("testparallel", "", backend::True::get());
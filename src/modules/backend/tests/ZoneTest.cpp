@@ -4,12 +4,33 @@
 
 #include "TestShared.h"
 #include "backend/entity/ai/tree/PrioritySelector.h"
+#include "backend/entity/ai/tree/ITask.h"
 #include "backend/entity/ai/zone/Zone.h"
 #include "backend/entity/ai/condition/True.h"
+#include "core/concurrent/Atomic.h"
 
 namespace backend {
 
 class ZoneTest: public TestSuite {
+protected:
+	/**
+	 * @brief Records the character ids in the order the deferred calls are executed
+	 */
+	class RecordAfterTick: public ITask {
+	private:
+		std::vector<ai::CharacterId>& _order;
+	public:
+		RecordAfterTick(std::vector<ai::CharacterId>& order) :
+				ITask("RecordAfterTick", "", True::get()), _order(order) {
+		}
+
+		ai::TreeNodeStatus doAction(const AIPtr& entity, int64_t deltaMillis) override {
+			entity->getZone()->executeAfterTick(entity, [this] (const AIPtr& ai) {
+				_order.push_back(ai->getId());
+			});
+			return ai::TreeNodeStatus::FINISHED;
+		}
+	};
 };
 
 TEST_F(ZoneTest, testChanges) {
@@ -52,4 +73,64 @@ TEST_F(ZoneTest, testAdd100) {
 	ASSERT_EQ(n, (int)zone.size());
 }
 
+TEST_F(ZoneTest, testParallelUpdate) {
+	Zone zone("test1", 4);
+	TreeNodePtr root = std::make_shared<PrioritySelector>("test", "", True::get());
+	const int n = 1000;
+	// add them in reverse order - the tick order is sorted by the character id
+	for (int i = n - 1; i >= 0; --i) {
+		ICharacterPtr character = core::make_shared<TestEntity>(i);
+		AIPtr ai = std::make_shared<AI>(root);
+		ai->setCharacter(character);
+		ASSERT_TRUE(zone.addAI(ai)) << "Could not add ai to the zone";
+	}
+	zone.update(1);
+	ASSERT_EQ(n, (int)zone.size());
+
+	const Zone::TickStats& stats = zone.tickStats();
+	EXPECT_EQ(n, stats.ais);
+	EXPECT_LE(stats.slowestAmount, Zone::TickStats::MaxSlowest);
+	for (int i = 0; i < stats.slowestAmount; ++i) {
+		EXPECT_EQ(root, stats.slowest[i].behaviour);
+		if (i > 0) {
+			EXPECT_GE(stats.slowest[i - 1].micros, stats.slowest[i].micros);
+		}
+	}
+
+	core::AtomicInt executed;
+	zone.executeParallel([&executed] (const AIPtr& ai) {
+		executed.increment(1);
+	});
+	EXPECT_EQ(n, (int)executed);
+
+	ASSERT_TRUE(zone.removeAI(500));
+	zone.update(1);
+	ASSERT_EQ(n - 1, (int)zone.size());
+	ai::CharacterId lastId = -1;
+	zone.execute([&lastId] (const AIPtr& ai) {
+		EXPECT_LT(lastId, ai->getId());
+		EXPECT_NE(500, ai->getId());
+		lastId = ai->getId();
+	});
+}
+
+TEST_F(ZoneTest, testExecuteAfterTick) {
+	Zone zone("test1", 4);
+	std::vector<ai::CharacterId> order;
+	TreeNodePtr root = std::make_shared<RecordAfterTick>(order);
+	const int n = 1000;
+	for (int i = n - 1; i >= 0; --i) {
+		ICharacterPtr character = core::make_shared<TestEntity>(i);
+		AIPtr ai = std::make_shared<AI>(root);
+		ai->setCharacter(character);
+		ASSERT_TRUE(zone.addAI(ai)) << "Could not add ai to the zone";
+	}
+	zone.update(1);
+	// the deferred calls are executed by this thread - in the order of the character ids
+	ASSERT_EQ(n, (int)order.size());
+	for (int i = 0; i < n; ++i) {
+		ASSERT_EQ(i, order[i]);
+	}
+}
+
 }
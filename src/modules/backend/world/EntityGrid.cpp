@@ -0,0 +1,169 @@
+/**
+ * @file
+ */
+
+#include "EntityGrid.h"
+#include "core/Assert.h"
+#include "core/Trace.h"
+#include <glm/common.hpp>
+#include <algorithm>
+
+namespace backend {
+
+EntityGrid::EntityGrid(float cellSize) :
+		_cellSize(cellSize) {
+	core_assert_msg(cellSize > 0.0f, "Invalid cell size given: %f", cellSize);
+}
+
+glm::ivec2 EntityGrid::cell(const glm::vec2& pos) const {
+	return glm::ivec2(glm::floor(pos / _cellSize));
+}
+
+EntityGrid::CellEntry EntityGrid::entry(const Entity* entity, int32_t slotIndex) const {
+	const glm::vec3& pos = entity->pos();
+	return CellEntry{glm::vec2(pos.x, pos.z), entity->size() / 2.0f, entity->id(), slotIndex};
+}
+
+void EntityGrid::addToCell(int32_t slotIndex, const CellEntry& e) {
+	Slot& slot = _slots[slotIndex];
+	Cell& c = _cells[slot.cell];
+	slot.index = (int32_t)c.size();
+	c.push_back(e);
+}
+
+void EntityGrid::removeFromCell(const Slot& slot) {
+	auto i = _cells.find(slot.cell);
+	core_assert(i != _cells.end());
+	Cell& c = i->second;
+	core_assert(slot.index >= 0 && slot.index < (int32_t)c.size());
+	if (slot.index != (int32_t)c.size() - 1) {
+		c[slot.index] = c.back();
+		_slots[c[slot.index].slot].index = slot.index;
+	}
+	c.pop_back();
+	if (c.empty()) {
+		_cells.erase(i);
+	}
+}
+
+bool EntityGrid::add(const EntityPtr& entity, float viewDistance) {
+	auto i = _entitySlots.find(entity.get());
+	if (i != _entitySlots.end()) {
+		return false;
+	}
+	int32_t slotIndex;
+	if (_freeSlots.empty()) {
+		slotIndex = (int32_t)_slots.size();
+		_slots.emplace_back();
+	} else {
+		slotIndex = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+	const CellEntry& e = entry(entity.get(), slotIndex);
+	Slot& slot = _slots[slotIndex];
+	slot.entity = entity;
+	slot.cell = cell(e.pos);
+	slot.viewDistance = viewDistance;
+	_maxHalfSize = glm::max(_maxHalfSize, e.halfSize);
+	addToCell(slotIndex, e);
+	_entitySlots.insert(std::make_pair(entity.get(), slotIndex));
+	return true;
+}
+
+bool EntityGrid::remove(const Entity* entity) {
+	auto i = _entitySlots.find(entity);
+	if (i == _entitySlots.end()) {
+		return false;
+	}
+	Slot& slot = _slots[i->second];
+	removeFromCell(slot);
+	slot = Slot();
+	_freeSlots.push_back(i->second);
+	_entitySlots.erase(i);
+	return true;
+}
+
+bool EntityGrid::update(const Entity* entity, float viewDistance) {
+	auto i = _entitySlots.find(entity);
+	if (i == _entitySlots.end()) {
+		return false;
+	}
+	const int32_t slotIndex = i->second;
+	Slot& slot = _slots[slotIndex];
+	slot.viewDistance = viewDistance;
+	const CellEntry& e = entry(entity, slotIndex);
+	_maxHalfSize = glm::max(_maxHalfSize, e.halfSize);
+	const glm::ivec2& newCell = cell(e.pos);
+	if (newCell == slot.cell) {
+		_cells[slot.cell][slot.index] = e;
+		return false;
+	}
+	removeFromCell(slot);
+	slot.cell = newCell;
+	addToCell(slotIndex, e);
+	return true;
+}
+
+void EntityGrid::visible(const Entity* entity, VisibleEntities& result) const {
+	core_trace_scoped(EntityGridVisible);
+	result.clear();
+	auto i = _entitySlots.find(entity);
+	if (i == _entitySlots.end()) {
+		return;
+	}
+	const Slot& slot = _slots[i->second];
+	const glm::vec3& pos3 = entity->pos();
+	const glm::vec2 pos(pos3.x, pos3.z);
+	const float viewDistance = slot.viewDistance;
+	const float range = viewDistance + _maxHalfSize;
+	const glm::ivec2& mins = cell(pos - range);
+	const glm::ivec2& maxs = cell(pos + range);
+	const EntityId self = entity->id();
+	auto visitCell = [&] (const Cell& cell) {
+		for (const CellEntry& e : cell) {
+			if (e.id == self) {
+				continue;
+			}
+			// same as intersecting the view rect with the rect of the other entity
+			const glm::vec2& delta = glm::abs(e.pos - pos);
+			const float maxDelta = viewDistance + e.halfSize;
+			if (delta.x >= maxDelta || delta.y >= maxDelta) {
+				continue;
+			}
+			result.push_back(VisibleEntity{e.id, _slots[e.slot].entity});
+		}
+	};
+	const int64_t cellsInRange = (int64_t)(maxs.x - mins.x + 1) * (int64_t)(maxs.y - mins.y + 1);
+	if ((int64_t)_cells.size() < cellsInRange) {
+		// a big view distance covers a lot of (mostly empty) cells - it's cheaper to check the occupied cells
+		for (const auto& ci : _cells) {
+			const glm::ivec2& c = ci.first;
+			if (c.x < mins.x || c.x > maxs.x || c.y < mins.y || c.y > maxs.y) {
+				continue;
+			}
+			visitCell(ci.second);
+		}
+	} else {
+		glm::ivec2 c;
+		for (c.x = mins.x; c.x <= maxs.x; ++c.x) {
+			for (c.y = mins.y; c.y <= maxs.y; ++c.y) {
+				auto ci = _cells.find(c);
+				if (ci == _cells.end()) {
+					continue;
+				}
+				visitCell(ci->second);
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+}
+
+void EntityGrid::clear() {
+	_cells.clear();
+	_slots.clear();
+	_freeSlots.clear();
+	_entitySlots.clear();
+	_maxHalfSize = 0.0f;
+}
+
+}
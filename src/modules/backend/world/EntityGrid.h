@@ -0,0 +1,97 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "backend/entity/Entity.h"
+#include <glm/vec2.hpp>
+#include <glm/gtx/hash.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace backend {
+
+/**
+ * @brief Uniform spatial hash grid for the visibility calculation of the entities on a @c Map
+ *
+ * The entities are registered once with their view distance. On every update only the position
+ * is refreshed - the entity is only moved to another bucket if it crossed a cell border. The
+ * visibility query just visits the cells that are covered by the view rect of the entity - or
+ * the occupied cells if there are less of them than cells in the view rect.
+ */
+class EntityGrid {
+private:
+	struct CellEntry {
+		glm::vec2 pos;
+		float halfSize;
+		EntityId id;
+		int32_t slot;
+	};
+	using Cell = std::vector<CellEntry>;
+	using Cells = std::unordered_map<glm::ivec2, Cell, std::hash<glm::ivec2> >;
+
+	struct Slot {
+		EntityPtr entity;
+		glm::ivec2 cell { 0 };
+		// index in the cell entries
+		int32_t index = -1;
+		float viewDistance = 0.0f;
+	};
+
+	const float _cellSize;
+	Cells _cells;
+	std::vector<Slot> _slots;
+	std::vector<int32_t> _freeSlots;
+	std::unordered_map<const Entity*, int32_t> _entitySlots;
+	// the biggest half size of all registered entities - widens the cells that are checked in a query
+	float _maxHalfSize = 0.0f;
+
+	glm::ivec2 cell(const glm::vec2& pos) const;
+	void removeFromCell(const Slot& slot);
+	void addToCell(int32_t slotIndex, const CellEntry& entry);
+	CellEntry entry(const Entity* entity, int32_t slotIndex) const;
+public:
+	EntityGrid(float cellSize = 32.0f);
+
+	/**
+	 * @brief Registers the entity with its current position and the given view distance
+	 * @return @c false if the entity is already registered
+	 */
+	bool add(const EntityPtr& entity, float viewDistance);
+	bool remove(const Entity* entity);
+	/**
+	 * @brief Refreshes the position and the view distance of the given entity
+	 * @return @c true if the entity was moved into another cell
+	 */
+	bool update(const Entity* entity, float viewDistance);
+	/**
+	 * @brief Fills the entities that are visible for the given entity - sorted by their id.
+	 * The entity itself is not part of the result.
+	 * @note The given list is cleared before, but its memory is reused
+	 */
+	void visible(const Entity* entity, VisibleEntities& result) const;
+
+	void clear();
+
+	int size() const;
+	float cellSize() const;
+	/**
+	 * @return The amount of non empty cells
+	 */
+	int cells() const;
+};
+
+inline int EntityGrid::size() const {
+	return (int)_entitySlots.size();
+}
+
+inline float EntityGrid::cellSize() const {
+	return _cellSize;
+}
+
+inline int EntityGrid::cells() const {
+	return (int)_cells.size();
+}
+
+}
@@ -9,11 +9,11 @@
 #include "core/EventBus.h"
 #include "app/App.h"
 #include "core/Trace.h"
-#include "math/QuadTree.h"
 #include "io/Filesystem.h"
 #include "backend/entity/Npc.h"
 #include "backend/entity/User.h"
 #include "ai/zone/Zone.h"
+#include "backend/entity/ai/tree/TreeNode.h"
 #include "metric/MetricEvent.h"
 #include "backend/eventbus/Event.h"
 #include "backend/spawn/SpawnMgr.h"
@@ -22,14 +22,6 @@
 
 namespace backend {
 
-math::RectFloat Map::QuadTreeNode::getRect() const {
-	return entity->rect();
-}
-
-bool Map::QuadTreeNode::operator==(const QuadTreeNode& rhs) const {
-	return rhs.entity == entity;
-}
-
 Map::Map(MapId mapId,
 		const core::EventBusPtr& eventBus,
 		const core::TimeProviderPtr& timeProvider,
@@ -46,7 +38,7 @@ Map::Map(MapId mapId,
 		_eventBus(eventBus), _filesystem(filesystem), _persistenceMgr(persistenceMgr),
 		_volumeCache(volumeCache), _attackMgr(this), _poiProvider(timeProvider), _spawnMgr(this, filesystem, entityStorage, messageSender,
 			timeProvider, loader, containerProvider, cooldownProvider),
-		_quadTree(math::RectFloat::getMaxRect(), 100.0f), _chunkPersister(chunkPersister) {
+		_chunkPersister(chunkPersister) {
 }
 
 Map::~Map() {
@@ -57,32 +49,51 @@ bool Map::getDirtyModels(Models& models) {
 	return false;
 }
 
+void Map::addToGrid(const EntityPtr& entity) {
+	if (!_entityGrid.add(entity, (float)entity->current(attrib::Type::VIEWDISTANCE))) {
+		Log::warn("Entity " PRIEntId " is already part of the grid", entity->id());
+	}
+}
+
+void Map::removeFromGrid(const EntityPtr& entity) {
+	_entityGrid.remove(entity.get());
+}
+
 bool Map::updateEntity(const EntityPtr& entity, long dt) {
 	core_trace_scoped(EntityUpdate);
 	if (!entity->update(dt)) {
 		return false;
 	}
-	const math::RectFloat& rect = entity->viewRect();
-	// TODO: maybe move into the entity instance to reduce memory allocations.
-	math::QuadTree<QuadTreeNode, float>::Contents contents;
-	_quadTree.query(rect, contents);
-	EntitySet set;
-	set.reserve(contents.size());
-	for (const QuadTreeNode& node : contents) {
-		// TODO: check the distance - the rect might contain more than the circle would...
-		if (node.entity->id() != entity->id()) {
-			set.insert(node.entity);
-		}
-	}
-	entity->updateVisible(set);
+	_entityGrid.update(entity.get(), (float)entity->current(attrib::Type::VIEWDISTANCE));
+	// TODO: check the distance - the rect might contain more than the circle would...
+	_entityGrid.visible(entity.get(), _visibleScratch);
+	// the scratch buffer gets the previously visible entities back - clear it to not hold the references
+	entity->updateVisible(_visibleScratch);
+	_visibleScratch.clear();
 	return true;
 }
 
+void Map::reportZoneStats() {
+	const Zone::TickStats& stats = _zone->tickStats();
+	if (stats.ais <= 0) {
+		return;
+	}
+	const metric::TagMap tags {{"map", _mapIdStr}};
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::histogram("zone.ai.tick.micros", stats.tickMicros, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("zone.ai.count", stats.ais, tags)));
+	for (int i = 0; i < stats.slowestAmount; ++i) {
+		const Zone::TickStats::Entry& entry = stats.slowest[i];
+		const metric::TagMap treeTags {{"map", _mapIdStr}, {"tree", entry.behaviour->getName()}};
+		_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::histogram("zone.ai.slowest.micros", entry.micros, treeTags)));
+	}
+}
+
 void Map::update(long dt) {
 	core_trace_scoped(MapUpdate);
 	Log::trace("tick map %i", (int)_mapId);
 	_spawnMgr.update(dt);
 	_zone->update(dt);
+	reportZoneStats();
 	_attackMgr.update(dt);
 
 	for (auto i = _users.begin(); i != _users.end();) {
@@ -92,7 +103,7 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove user " PRIEntId, user->id());
-		_quadTree.remove(QuadTreeNode { user });
+		removeFromGrid(user);
 		i = _users.erase(i);
 		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(user->id(), user->entityType()));
 	}
@@ -103,11 +114,15 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove npc " PRIEntId, npc->id());
-		_quadTree.remove(QuadTreeNode { npc });
+		removeFromGrid(npc);
 		i = _npcs.erase(i);
 		_zone->removeAI(npc->id());
 		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(npc->id(), npc->entityType()));
 	}
+	// all entities are updated now - send the changes to the clients
+	for (auto i = _users.begin(); i != _users.end(); ++i) {
+		i->second->sendEntitySnapshot();
+	}
 }
 
 bool Map::init() {
@@ -159,7 +174,8 @@ void Map::shutdown() {
 	}
 	delete _zone;
 	_zone = nullptr;
-	_quadTree.clear();
+	_entityGrid.clear();
+	_visibleScratch.clear();
 	_npcs.clear();
 	_users.clear();
 	_persistenceMgr->unregisterSavable(FOURCC, this);
@@ -180,7 +196,7 @@ void Map::addUser(const UserPtr& user) {
 	}
 	const glm::vec3& pos = findStartPosition(user);
 	user->setMap(ptr(), pos);
-	_quadTree.insert(QuadTreeNode { user });
+	addToGrid(user);
 	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(user));
 	_poiProvider.add(pos, poi::Type::SPAWN);
 }
@@ -191,7 +207,7 @@ bool Map::removeUser(EntityId id) {
 		return false;
 	}
 	UserPtr user = i->second;
-	_quadTree.remove(QuadTreeNode { user });
+	removeFromGrid(user);
 	_users.erase(i);
 	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(user));
 	return true;
@@ -214,7 +230,7 @@ bool Map::addNpc(const NpcPtr& npc) {
 	const glm::vec3& pos = findStartPosition(npc);
 	npc->setMap(ptr(), pos);
 	_zone->addAI(npc->ai());
-	_quadTree.insert(QuadTreeNode { npc });
+	addToGrid(npc);
 	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(npc));
 	_poiProvider.add(pos, poi::Type::SPAWN);
 	return true;
@@ -226,7 +242,7 @@ bool Map::removeNpc(EntityId id) {
 		return false;
 	}
 	NpcPtr npc = i->second;
-	_quadTree.remove(QuadTreeNode { npc });
+	removeFromGrid(npc);
 	_npcs.erase(i);
 	_zone->removeAI(npc->id());
 	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(npc));
@@ -5,7 +5,6 @@
 #pragma once
 
 #include "backend/ForwardDecl.h"
-#include "math/QuadTree.h"
 #include "math/Rect.h"
 #include "core/Common.h"
 #include "core/FourCC.h"
@@ -19,6 +18,7 @@
 #include "backend/spawn/SpawnMgr.h"
 #include "voxel/Constants.h"
 #include "DBChunkPersister.h"
+#include "EntityGrid.h"
 #include "MapId.h"
 #include <memory>
 #include <unordered_map>
@@ -57,19 +57,21 @@ private:
 	poi::PoiProvider _poiProvider;
 	SpawnMgr _spawnMgr;
 
-	struct QuadTreeNode {
-		EntityPtr entity;
-
-		math::RectFloat getRect() const;
-		bool operator==(const QuadTreeNode& rhs) const;
-	};
-
-	math::QuadTree<QuadTreeNode, float> _quadTree;
+	EntityGrid _entityGrid;
+	// reused for the visibility updates of the entities to reduce memory allocations
+	VisibleEntities _visibleScratch;
 	DBChunkPersisterPtr _chunkPersister;
+
+	void addToGrid(const EntityPtr& entity);
+	void removeFromGrid(const EntityPtr& entity);
 	/**
 	 * @return @c false if the entity should be removed from the server.
 	 */
 	bool updateEntity(const EntityPtr& entity, long dt);
+	/**
+	 * @brief Publish the ai tick timings of the zone as metric events
+	 */
+	void reportZoneStats();
 
 	glm::vec3 findStartPosition(const EntityPtr& entity, poi::Type type = poi::Type::GENERIC) const;
 
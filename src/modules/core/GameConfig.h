@@ -63,6 +63,12 @@ constexpr const char *CorePath = "core_path";
 
 // The size of the chunk that is extracted with each step
 constexpr const char *VoxelMeshSize = "voxel_meshsize";
+// The amount of mesh sizes around the focus that are extracted with the full resolution
+constexpr const char *VoxelMeshLodDistance = "voxel_meshloddistance";
+// Cache the extracted meshes of the models on disk
+constexpr const char *VoxelMeshCacheDisk = "voxel_meshcachedisk";
+// The amount of mesh bytes that are uploaded per frame
+constexpr const char *VoxelMeshUploadBudget = "voxel_meshuploadbudget";
 
 constexpr const char *DatabaseName = "db_name";
 constexpr const char *DatabaseHost = "db_host";
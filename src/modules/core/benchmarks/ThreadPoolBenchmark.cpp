@@ -0,0 +1,72 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Atomic.h"
+#include <vector>
+
+class ThreadPoolBenchmark: public app::AbstractBenchmark {
+public:
+	static constexpr int Threads = 4;
+};
+
+// throughput of many short tasks with one future per task
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, EnqueueFutures) (benchmark::State& state) {
+	core::ThreadPool pool(Threads, "Bench");
+	pool.init();
+	const int n = (int)state.range(0);
+	std::vector<std::future<void> > futures;
+	futures.reserve(n);
+	core::AtomicInt count;
+	for (auto _ : state) {
+		for (int i = 0; i < n; ++i) {
+			futures.emplace_back(pool.enqueue([&count] () {
+				++count;
+			}));
+		}
+		for (std::future<void>& future : futures) {
+			future.wait();
+		}
+		futures.clear();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+// throughput of many short tasks with a task group
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, ScheduleTaskGroup) (benchmark::State& state) {
+	core::ThreadPool pool(Threads, "Bench");
+	pool.init();
+	const int n = (int)state.range(0);
+	core::AtomicInt count;
+	for (auto _ : state) {
+		core::TaskGroup group;
+		for (int i = 0; i < n; ++i) {
+			pool.schedule(group, [&count] () {
+				++count;
+			});
+		}
+		pool.wait(group);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, ParallelFor) (benchmark::State& state) {
+	core::ThreadPool pool(Threads, "Bench");
+	pool.init();
+	const int n = (int)state.range(0);
+	std::vector<int> values(n);
+	for (auto _ : state) {
+		pool.parallelFor(0, n, [&values] (int start, int end) {
+			for (int i = start; i < end; ++i) {
+				++values[i];
+			}
+		}, 64);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, EnqueueFutures)->Arg(1000)->Arg(10000);
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, ScheduleTaskGroup)->Arg(1000)->Arg(10000);
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, ParallelFor)->Arg(1000)->Arg(100000);
@@ -0,0 +1,138 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace core {
+
+/**
+ * @brief Move only type erased @c void() callable with inline storage.
+ *
+ * Lambdas that capture up to @c InlineSize bytes don't need a heap allocation. Bigger functors
+ * are moved to the heap.
+ */
+class Task {
+public:
+	static constexpr size_t InlineSize = 6 * sizeof(void*);
+private:
+	struct Ops {
+		void (*invoke)(void* storage);
+		// move constructs the functor at dst and destroys the one at src
+		void (*move)(void* dst, void* src);
+		void (*destroy)(void* storage);
+	};
+
+	template<class F>
+	struct InlineOps {
+		static void invoke(void* storage) {
+			(*(F*)storage)();
+		}
+		static void move(void* dst, void* src) {
+			new (dst) F(std::move(*(F*)src));
+			((F*)src)->~F();
+		}
+		static void destroy(void* storage) {
+			((F*)storage)->~F();
+		}
+		static constexpr Ops ops { invoke, move, destroy };
+	};
+
+	template<class F>
+	struct HeapOps {
+		static void invoke(void* storage) {
+			(**(F**)storage)();
+		}
+		static void move(void* dst, void* src) {
+			*(F**)dst = *(F**)src;
+			*(F**)src = nullptr;
+		}
+		static void destroy(void* storage) {
+			delete *(F**)storage;
+		}
+		static constexpr Ops ops { invoke, move, destroy };
+	};
+
+	alignas(std::max_align_t) uint8_t _storage[InlineSize];
+	const Ops* _ops = nullptr;
+
+	void reset() {
+		if (_ops != nullptr) {
+			_ops->destroy(_storage);
+			_ops = nullptr;
+		}
+	}
+
+public:
+	Task() {
+	}
+
+	template<class F, class FUNC = typename std::decay<F>::type,
+			class = typename std::enable_if<!std::is_same<FUNC, Task>::value>::type>
+	Task(F&& f) {
+		if constexpr (isInline<FUNC>()) {
+			new (_storage) FUNC(std::forward<F>(f));
+			_ops = &InlineOps<FUNC>::ops;
+		} else {
+			*(FUNC**)_storage = new FUNC(std::forward<F>(f));
+			_ops = &HeapOps<FUNC>::ops;
+		}
+	}
+
+	Task(Task&& other) noexcept : _ops(other._ops) {
+		if (_ops != nullptr) {
+			_ops->move(_storage, other._storage);
+			other._ops = nullptr;
+		}
+	}
+
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			reset();
+			_ops = other._ops;
+			if (_ops != nullptr) {
+				_ops->move(_storage, other._storage);
+				other._ops = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() {
+		reset();
+	}
+
+	/**
+	 * @return @c true if the functor doesn't need a heap allocation
+	 */
+	template<class F>
+	static constexpr bool isInline() {
+		using FUNC = typename std::decay<F>::type;
+		return sizeof(FUNC) <= InlineSize && alignof(FUNC) <= alignof(std::max_align_t)
+				&& std::is_nothrow_move_constructible<FUNC>::value;
+	}
+
+	inline bool valid() const {
+		return _ops != nullptr;
+	}
+
+	inline explicit operator bool() const {
+		return valid();
+	}
+
+	inline void operator()() {
+		_ops->invoke(_storage);
+	}
+};
+
+}
@@ -3,23 +3,184 @@
  */
 
 #include "ThreadPool.h"
+#include "core/Assert.h"
 #include "core/StringUtil.h"
 #include "core/Trace.h"
 #include "core/concurrent/Concurrency.h"
 
 namespace core {
 
+namespace {
+// the pool and the index of the worker that is executed by the current thread
+thread_local const ThreadPool* _currentPool = nullptr;
+thread_local int _currentWorker = -1;
+}
+
+TaskGroup::~TaskGroup() {
+	core_assert_msg(finished(), "Task group is destroyed with %i pending tasks", pending());
+}
+
+void TaskGroup::add() {
+	core::ScopedLock lock(_lock);
+	_pending.increment(1);
+}
+
+void TaskGroup::done() {
+	core::ScopedLock lock(_lock);
+	// the old value is returned
+	if (_pending.decrement(1) == 1) {
+		_condition.notify_all();
+	}
+}
+
 ThreadPool::ThreadPool(size_t threads, const char *name) :
 		_threads(threads), _name(name) {
 	if (_name == nullptr) {
 		_name = "ThreadPool";
 	}
+	_queues.reserve(_threads);
+	for (size_t i = 0; i < _threads; ++i) {
+		_queues.emplace_back(new Worker());
+	}
+}
+
+int ThreadPool::currentWorker() const {
+	if (_currentPool != this) {
+		return -1;
+	}
+	return _currentWorker;
+}
+
+bool ThreadPool::push(Job&& job) {
+	if (_stop) {
+		return false;
+	}
+	if (_queues.empty()) {
+		// no workers - execute it directly
+		execute(job);
+		return true;
+	}
+	const int queueIndex = currentWorker();
+	Worker& worker = queueIndex < 0 ? _injected : *_queues[queueIndex];
+	{
+		core::ScopedLock lock(worker.lock);
+		worker.jobs.emplace_back(core::move(job));
+	}
+	_pending.increment(1);
+	// only wake up a worker if there is one sleeping - see the worker loop for the other side of this
+	if ((int)_sleeping > 0) {
+		core::ScopedLock lock(_sleepMutex);
+		_sleepCondition.notify_one();
+	}
+	return true;
+}
+
+bool ThreadPool::pop(int workerIndex, Job& job) {
+	if ((int)_pending <= 0) {
+		return false;
+	}
+	const int n = (int)_queues.size();
+	if (workerIndex >= 0) {
+		// the own queue is used as a stack to keep the data of recently scheduled tasks in the cache
+		Worker& worker = *_queues[workerIndex];
+		core::ScopedLock lock(worker.lock);
+		if (!worker.jobs.empty()) {
+			job = core::move(worker.jobs.back());
+			worker.jobs.pop_back();
+			_pending.decrement(1);
+			return true;
+		}
+	}
+	{
+		// the tasks from outside of the pool are started in the order they were scheduled
+		core::ScopedLock lock(_injected.lock);
+		if (!_injected.jobs.empty()) {
+			job = core::move(_injected.jobs.front());
+			_injected.jobs.pop_front();
+			_pending.decrement(1);
+			return true;
+		}
+	}
+	// steal the oldest task from one of the other workers
+	const int offset = workerIndex >= 0 ? workerIndex + 1 : 0;
+	for (int i = 0; i < n; ++i) {
+		const int victimIndex = (offset + i) % n;
+		if (victimIndex == workerIndex) {
+			continue;
+		}
+		Worker& victim = *_queues[victimIndex];
+		core::ScopedLock lock(victim.lock);
+		if (victim.jobs.empty()) {
+			continue;
+		}
+		job = core::move(victim.jobs.front());
+		victim.jobs.pop_front();
+		_pending.decrement(1);
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::execute(Job& job) {
+	job.task();
+	job.task = Task();
+	if (job.group != nullptr) {
+		job.group->done();
+		job.group = nullptr;
+	}
+}
+
+void ThreadPool::discard(Job& job) {
+	job.task = Task();
+	if (job.group != nullptr) {
+		job.group->done();
+		job.group = nullptr;
+	}
+}
+
+bool ThreadPool::runPendingTask() {
+	Job job;
+	if (!pop(currentWorker(), job)) {
+		return false;
+	}
+	core_trace_scoped(ThreadPoolHelp);
+	execute(job);
+	return true;
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+	core_trace_scoped(ThreadPoolWait);
+	while (!group.finished()) {
+		if (runPendingTask()) {
+			continue;
+		}
+		core::ScopedLock lock(group._lock);
+		if ((int)group._pending <= 0) {
+			return;
+		}
+		// the timeout allows us to help with new tasks that were scheduled in the meantime
+		group._condition.waitTimeout(group._lock, 1);
+	}
+	// the task that finished the group might still hold the lock to notify us
+	core::ScopedLock lock(group._lock);
+}
+
+void ThreadPool::abort(Worker& worker) {
+	std::deque<Job> jobs;
+	{
+		core::ScopedLock lock(worker.lock);
+		jobs.swap(worker.jobs);
+	}
+	_pending.decrement((int)jobs.size());
+	for (Job& job : jobs) {
+		discard(job);
+	}
 }
 
 void ThreadPool::abort() {
-	std::unique_lock lock(_queueMutex);
-	while (!_tasks.empty()) {
-		_tasks.pop();
+	abort(_injected);
+	for (const std::unique_ptr<Worker>& worker : _queues) {
+		abort(*worker);
 	}
 }
 
@@ -34,43 +195,45 @@ void ThreadPool::init() {
 				Log::error("Failed to set thread name for pool thread %i", (int)i);
 			}
 			core_trace_thread(n.c_str());
+			_currentPool = this;
+			_currentWorker = (int)i;
 			for (;;) {
-				std::function<void()> task;
-				{
-					core::ScopedLock lock(this->_queueMutex);
-					if (!this->_stop) {
-						this->_queueCondition.wait(this->_queueMutex, [this] {
-							// predicate must return false if the waiting should continue
-							if (this->_stop) {
-								return true;
-							}
-							if (!this->_tasks.empty()) {
-								return true;
-							}
-							return false;
-						});
-					}
-					if (this->_stop && (this->_force || this->_tasks.empty())) {
-						Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
+				if (this->_stop && this->_force) {
+					break;
+				}
+				Job job;
+				if (!this->pop((int)i, job)) {
+					if (this->_stop) {
 						break;
 					}
-					task = core::move(this->_tasks.front());
-					this->_tasks.pop();
+					core::ScopedLock lock(this->_sleepMutex);
+					this->_sleeping.increment(1);
+					this->_sleepCondition.wait(this->_sleepMutex, [this] {
+						// predicate must return false if the waiting should continue
+						return this->_stop || (int)this->_pending > 0;
+					});
+					this->_sleeping.decrement(1);
+					continue;
 				}
 
 				core_trace_begin_frame(n.c_str());
 				core_trace_scoped(ThreadPoolWorker);
 				Log::debug(logid, "Execute task in %i", (int)getThreadId());
-				task();
+				this->execute(job);
 				Log::debug(logid, "End of task in %i", (int)getThreadId());
 				core_trace_end_frame(n.c_str());
 			}
+			Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
+			_currentPool = nullptr;
+			_currentWorker = -1;
 		});
 	}
 }
 
 ThreadPool::~ThreadPool() {
 	shutdown();
+	// make sure that nobody waits for tasks that will never be executed
+	abort();
 }
 
 void ThreadPool::shutdown(bool wait) {
@@ -78,8 +241,11 @@ void ThreadPool::shutdown(bool wait) {
 		return;
 	}
 	_force = !wait;
-	_stop = true;
-	_queueCondition.notify_all();
+	{
+		core::ScopedLock lock(_sleepMutex);
+		_stop = true;
+	}
+	_sleepCondition.notify_all();
 	for (std::thread &worker : _workers) {
 		worker.join();
 	}
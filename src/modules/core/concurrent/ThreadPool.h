@@ -28,7 +28,7 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <memory>
 #include <thread>
 #include <future>
@@ -36,24 +36,119 @@
 #include "core/concurrent/Atomic.h"
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/Task.h"
 #include "core/Trace.h"
 #include "core/Log.h"
 
 namespace core {
 
+/**
+ * @brief Latch for a set of tasks that were scheduled via @c ThreadPool::schedule()
+ *
+ * Use @c ThreadPool::wait() to block until all tasks of the group are finished. This
+ * replaces the need for one @c std::future per task.
+ */
+class TaskGroup {
+	friend class ThreadPool;
+private:
+	// only modified while the lock is held - the waiting thread decides about the completion under
+	// the lock, too. This way it can't return before the last task released the group.
+	core::AtomicInt _pending { 0 };
+	core_trace_mutex(core::Lock, _lock, "TaskGroup");
+	core::ConditionVariable _condition;
+
+	void add();
+	void done();
+public:
+	TaskGroup() {}
+	~TaskGroup();
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	/**
+	 * @return @c true if all scheduled tasks of this group were executed (or aborted)
+	 */
+	bool finished() const;
+	int pending() const;
+};
+
+inline bool TaskGroup::finished() const {
+	return (int)_pending <= 0;
+}
+
+inline int TaskGroup::pending() const {
+	return (int)_pending;
+}
+
+/**
+ * @brief Work stealing thread pool.
+ *
+ * Task order:
+ * - Tasks that are scheduled from other threads are put into a shared injection queue and are
+ *   started in FIFO order - callers like the @c PagedVolume prefetching rely on this to get
+ *   the nearest chunks first.
+ * - Every worker has its own task deque. Tasks that are scheduled from inside a worker are put
+ *   into the deque of that worker and executed in LIFO order to keep their data in the cache.
+ *   Other workers steal the oldest task from the front of the deque if they run out of work.
+ *
+ * A worker picks the tasks from its own deque first, then from the injection queue and only then
+ * steals from the other workers.
+ *
+ * @c schedule() doesn't allocate for small lambdas (see @c Task) - use a @c TaskGroup to wait for
+ * a set of tasks. @c enqueue() is still available for the callers that need a @c std::future.
+ */
 class ThreadPool final {
 private:
 	static constexpr auto logid = Log::logid("ThreadPool");
+
+	struct Job {
+		Task task;
+		TaskGroup* group = nullptr;
+	};
+
+	struct Worker {
+		core_trace_mutex(core::Lock, lock, "ThreadPoolWorker");
+		std::deque<Job> jobs;
+	};
 public:
 	explicit ThreadPool(size_t, const char *name = nullptr);
 	~ThreadPool();
 
 	/**
 	 * Enqueue functors or lambdas into the thread pool
+	 * @note This allocates the shared state of the future - use @c schedule() for many small tasks
 	 */
 	template<class F, class ... Args>
 	auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
 
+	/**
+	 * @brief Schedule a task without a way to wait for it
+	 * @return @c false if the pool was already shut down
+	 */
+	template<class F>
+	bool schedule(F&& f);
+
+	/**
+	 * @brief Schedule a task for the given group. Use @c wait() to wait for all tasks of the group.
+	 * @return @c false if the pool was already shut down
+	 */
+	template<class F>
+	bool schedule(TaskGroup& group, F&& f);
+
+	/**
+	 * @brief Blocks until all tasks of the given group are executed. The calling thread helps
+	 * to execute pending tasks - so it's safe to call this from inside of a task.
+	 */
+	void wait(TaskGroup& group);
+
+	/**
+	 * @brief Split the range [start, end) into chunks of at least @c grainSize elements and execute the
+	 * given function with @c func(chunkStart, chunkEnd) for each of them in parallel.
+	 * @note Blocks until all chunks were processed - the calling thread is processing chunks, too.
+	 */
+	template<class F>
+	void parallelFor(int start, int end, F&& func, int grainSize = 1);
+
 	size_t size() const;
 	void init();
 	/**
@@ -67,14 +162,41 @@ private:
 	const char *_name;
 	// need to keep track of threads so we can join them
 	std::vector<std::thread> _workers;
-	// the task queue
-	std::queue<std::function<void()> > _tasks;
+	// one task deque per worker
+	std::vector<std::unique_ptr<Worker> > _queues;
+	// the tasks that are scheduled from outside of the pool - executed in FIFO order
+	Worker _injected;
+	// amount of queued but not yet started tasks
+	core::AtomicInt _pending { 0 };
+	// amount of workers that are waiting for new tasks
+	core::AtomicInt _sleeping { 0 };
 
 	// synchronization
-	core_trace_mutex(core::Lock, _queueMutex, "ThreadPoolQueue");
-	core::ConditionVariable _queueCondition;
+	core_trace_mutex(core::Lock, _sleepMutex, "ThreadPoolSleep");
+	core::ConditionVariable _sleepCondition;
 	core::AtomicBool _stop { false };
 	core::AtomicBool _force { false };
+
+	bool push(Job&& job);
+	/**
+	 * @brief Pops a task from the own deque of the given worker, from the injection queue or steals one
+	 * from the other workers
+	 * @param[in] workerIndex The index of the worker that looks for a task, or @c -1 if the calling
+	 * thread is not a worker of this pool
+	 */
+	bool pop(int workerIndex, Job& job);
+	void execute(Job& job);
+	/**
+	 * @brief Execute one pending task on the calling thread
+	 * @return @c false if there was no pending task
+	 */
+	bool runPendingTask();
+	/**
+	 * @return The worker index of the calling thread or @c -1 if the calling thread is not part of this pool
+	 */
+	int currentWorker() const;
+	void discard(Job& job);
+	void abort(Worker& worker);
 };
 
 // add new work item to the pool
@@ -89,17 +211,59 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
 	auto task = std::make_shared<std::packaged_task<return_type()> >(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
 
 	std::future<return_type> res = task->get_future();
-	{
-		std::unique_lock lock(_queueMutex);
-		if (_stop) {
-			return std::future<return_type>();
-		}
-		_tasks.emplace([task]() {(*task)();});
+	if (!push(Job{Task([task]() {(*task)();}), nullptr})) {
+		return std::future<return_type>();
 	}
-	_queueCondition.notify_one();
 	return res;
 }
 
+template<class F>
+bool ThreadPool::schedule(F&& f) {
+	return push(Job{Task(std::forward<F>(f)), nullptr});
+}
+
+template<class F>
+bool ThreadPool::schedule(TaskGroup& group, F&& f) {
+	group.add();
+	if (!push(Job{Task(std::forward<F>(f)), &group})) {
+		group.done();
+		return false;
+	}
+	return true;
+}
+
+template<class F>
+void ThreadPool::parallelFor(int start, int end, F&& func, int grainSize) {
+	const int n = end - start;
+	if (n <= 0) {
+		return;
+	}
+	if (grainSize < 1) {
+		grainSize = 1;
+	}
+	// a few more chunks than threads to balance uneven workloads
+	const int maxChunks = (int)(_threads + 1) * 4;
+	int chunks = (n + grainSize - 1) / grainSize;
+	if (chunks > maxChunks) {
+		chunks = maxChunks;
+	}
+	if (chunks <= 1 || _threads == 0u || _stop) {
+		func(start, end);
+		return;
+	}
+	const int chunkSize = (n + chunks - 1) / chunks;
+	TaskGroup group;
+	// the first chunk is executed by the calling thread
+	for (int chunkStart = start + chunkSize; chunkStart < end; chunkStart += chunkSize) {
+		const int chunkEnd = chunkStart + chunkSize < end ? chunkStart + chunkSize : end;
+		if (!schedule(group, [&func, chunkStart, chunkEnd] () { func(chunkStart, chunkEnd); })) {
+			func(chunkStart, chunkEnd);
+		}
+	}
+	func(start, start + chunkSize);
+	wait(group);
+}
+
 inline size_t ThreadPool::size() const {
 	return _threads;
 }
@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 #include "core/concurrent/ThreadPool.h"
 #include "core/concurrent/Atomic.h"
+#include <vector>
 
 namespace core {
 
@@ -42,4 +43,141 @@ TEST_F(ThreadPoolTest, testMultiplePush) {
 	ASSERT_EQ(x, _count) << "Not all threads were executed";
 }
 
+TEST_F(ThreadPoolTest, testTaskInlineStorage) {
+	int value = 0;
+	auto small = [&value] () { ++value; };
+	EXPECT_TRUE(core::Task::isInline<decltype(small)>());
+	core::Task task(small);
+	core::Task moved(core::move(task));
+	EXPECT_FALSE(task.valid());
+	ASSERT_TRUE(moved.valid());
+	moved();
+	EXPECT_EQ(1, value);
+
+	struct Big {
+		char data[256] {};
+	};
+	Big big;
+	big.data[0] = 42;
+	auto large = [big, &value] () { value += big.data[0]; };
+	EXPECT_FALSE(core::Task::isInline<decltype(large)>());
+	core::Task heapTask(large);
+	heapTask();
+	EXPECT_EQ(43, value);
+}
+
+TEST_F(ThreadPoolTest, testTaskGroup) {
+	const int x = 1000;
+	core::ThreadPool pool(4);
+	pool.init();
+	core::TaskGroup group;
+	for (int i = 0; i < x; ++i) {
+		ASSERT_TRUE(pool.schedule(group, [this] () {
+			++_count;
+		}));
+	}
+	pool.wait(group);
+	EXPECT_TRUE(group.finished());
+	ASSERT_EQ(x, _count) << "Not all tasks of the group were executed";
+}
+
+TEST_F(ThreadPoolTest, testTaskGroupReuse) {
+	core::ThreadPool pool(4);
+	pool.init();
+	core::TaskGroup group;
+	for (int round = 1; round <= 500; ++round) {
+		// the group drops to zero pending tasks while new ones are still added
+		for (int i = 0; i < 4; ++i) {
+			ASSERT_TRUE(pool.schedule(group, [this] () {
+				++_count;
+			}));
+		}
+		pool.wait(group);
+		ASSERT_TRUE(group.finished());
+		ASSERT_EQ(round * 4, _count) << "wait() returned before all tasks of the group were executed";
+	}
+}
+
+TEST_F(ThreadPoolTest, testNestedTaskGroup) {
+	core::ThreadPool pool(2);
+	pool.init();
+	core::TaskGroup outer;
+	for (int i = 0; i < 8; ++i) {
+		pool.schedule(outer, [this, &pool] () {
+			// waiting inside of a worker must not deadlock - the worker helps to execute the tasks
+			core::TaskGroup inner;
+			for (int j = 0; j < 16; ++j) {
+				pool.schedule(inner, [this] () {
+					++_count;
+				});
+			}
+			pool.wait(inner);
+		});
+	}
+	pool.wait(outer);
+	ASSERT_EQ(8 * 16, _count);
+}
+
+TEST_F(ThreadPoolTest, testExternalTasksAreStartedInOrder) {
+	core::ThreadPool pool(1);
+	std::vector<int> order;
+	// scheduled before the worker is started - a stack would execute them in reverse order
+	for (int i = 0; i < 16; ++i) {
+		pool.schedule([&order, i] () {
+			order.push_back(i);
+		});
+	}
+	auto future = pool.enqueue([] () {});
+	pool.init();
+	// don't use a task group here - the waiting thread would help to execute the tasks
+	future.get();
+	ASSERT_EQ(16u, order.size());
+	for (int i = 0; i < 16; ++i) {
+		ASSERT_EQ(i, order[i]) << "Tasks from outside of the pool must be executed in FIFO order";
+	}
+}
+
+TEST_F(ThreadPoolTest, testParallelFor) {
+	const int n = 10000;
+	core::ThreadPool pool(4);
+	pool.init();
+	std::vector<int> values(n, 0);
+	pool.parallelFor(0, n, [&values] (int start, int end) {
+		for (int i = start; i < end; ++i) {
+			values[i] += i;
+		}
+	}, 64);
+	for (int i = 0; i < n; ++i) {
+		ASSERT_EQ(i, values[i]) << "Element " << i << " was not processed exactly once";
+	}
+}
+
+TEST_F(ThreadPoolTest, testParallelForWithoutWorkers) {
+	core::ThreadPool pool(2);
+	// not initialized - the calling thread executes all chunks
+	int sum = 0;
+	pool.parallelFor(0, 100, [&sum] (int start, int end) {
+		for (int i = start; i < end; ++i) {
+			sum += i;
+		}
+	});
+	ASSERT_EQ(4950, sum);
+}
+
+TEST_F(ThreadPoolTest, testAbort) {
+	core::ThreadPool pool(1);
+	core::TaskGroup group;
+	for (int i = 0; i < 10; ++i) {
+		pool.schedule(group, [this] () {
+			++_count;
+		});
+	}
+	EXPECT_EQ(10, group.pending());
+	pool.abort();
+	EXPECT_TRUE(group.finished()) << "Aborted tasks must release their group";
+	pool.init();
+	pool.wait(group);
+	ASSERT_EQ(0, _count);
+}
+
 }
@@ -17,6 +17,92 @@ namespace math {
 
 extern math::AABB<int> computeAABB(const Frustum& area, const glm::vec3& gridSize);
 
+/**
+ * @brief Splits the given area into the eight octants - the index of the octants is shown here:
+ * @code
+ * +Y                        +Z
+ * |                         /
+ * |                        /
+ * |                       /
+ * |                      /
+ * |       O---------------O---------------O
+ * |      /               /               /|
+ * |     /       3       /       7       / |
+ * |    /               /               /  |
+ * |   O---------------O---------------O   |
+ * |  /               /               /|   |
+ * | /       2       /       6       / | 7 |
+ * |/               /               /  |   O
+ * O---------------O---------------O   |  /|
+ * |               |               |   | / |
+ * |               |               | 6 |/  |
+ * |               |               |   O   |
+ * |       2       |       6       |  /|   |
+ * |               |               | / | 5 |
+ * |               |               |/  |   O
+ * O---------------O---------------O   |  /
+ * |               |               |   | /
+ * |               |               | 4 |/
+ * |               |               |   O
+ * |       0       |       4       |  /
+ * |               |               | /
+ * |               |               |/
+ * O---------------O---------------O------------------+X
+ * @endcode
+ */
+template<typename TYPE>
+void splitOctreeArea(const AABB<TYPE>& aabb, AABB<TYPE> (&result)[8]) {
+	const glm::tvec3<TYPE>& center = aabb.getCenter();
+	result[0] = AABB<TYPE>(aabb.mins(), center);
+
+	glm::tvec3<TYPE> mins1(aabb.getLowerX(), aabb.getLowerY(), center.z);
+	glm::tvec3<TYPE> maxs1(center.x, center.y, aabb.getUpperZ());
+	result[1] = AABB<TYPE>(mins1, maxs1);
+
+	glm::tvec3<TYPE> mins2(aabb.getLowerX(), center.y, aabb.getLowerZ());
+	glm::tvec3<TYPE> maxs2(center.x, aabb.getUpperY(), center.z);
+	result[2] = AABB<TYPE>(mins2, maxs2);
+
+	glm::tvec3<TYPE> mins3(aabb.getLowerX(), center.y, center.z);
+	glm::tvec3<TYPE> maxs3(center.x, aabb.getUpperY(), aabb.getUpperZ());
+	result[3] = AABB<TYPE>(mins3, maxs3);
+
+	glm::tvec3<TYPE> mins4(center.x, aabb.getLowerY(), aabb.getLowerZ());
+	glm::tvec3<TYPE> maxs4(aabb.getUpperX(), center.y, center.z);
+	result[4] = AABB<TYPE>(mins4, maxs4);
+
+	glm::tvec3<TYPE> mins5(center.x, aabb.getLowerY(), center.z);
+	glm::tvec3<TYPE> maxs5(aabb.getUpperX(), center.y, aabb.getUpperZ());
+	result[5] = AABB<TYPE>(mins5, maxs5);
+
+	glm::tvec3<TYPE> mins6(center.x, center.y, aabb.getLowerZ());
+	glm::tvec3<TYPE> maxs6(aabb.getUpperX(), aabb.getUpperY(), center.z);
+	result[6] = AABB<TYPE>(mins6, maxs6);
+
+	glm::tvec3<TYPE> mins7(center.x, center.y, center.z);
+	glm::tvec3<TYPE> maxs7(aabb.getUpperX(), aabb.getUpperY(), aabb.getUpperZ());
+	result[7] = AABB<TYPE>(mins7, maxs7);
+}
+
+/**
+ * @brief Calls the visitor for all cells of the given size in the given area - the visitor returns @c false
+ * to skip the remaining cells of the current column
+ */
+template<typename TYPE, class VISITOR>
+void visitGrid(const glm::vec<3, TYPE>& mins, const glm::vec<3, TYPE>& maxs, VISITOR&& visitor, const glm::vec<3, TYPE>& minSize) {
+	glm::tvec3<TYPE> qmins;
+	for (qmins.x = mins.x; qmins.x < maxs.x; qmins.x += minSize.x) {
+		for (qmins.y = mins.y; qmins.y < maxs.y; qmins.y += minSize.y) {
+			for (qmins.z = mins.z; qmins.z < maxs.z; qmins.z += minSize.z) {
+				const glm::tvec3<TYPE> qmaxs(qmins + minSize);
+				if (!visitor(qmins, qmaxs)) {
+					break;
+				}
+			}
+		}
+	}
+}
+
 /**
  * @note Given NODE type must implement @c aabb() and return math::AABB<TYPE>
  */
@@ -34,67 +120,8 @@ public:
 	class OctreeNode {
 		friend class Octree;
 	private:
-		/*
-		 * +Y                        +Z
-		 * |                         /
-		 * |                        /
-		 * |                       /
-		 * |                      /
-		 * |       O---------------O---------------O
-		 * |      /               /               /|
-		 * |     /       3       /       7       / |
-		 * |    /               /               /  |
-		 * |   O---------------O---------------O   |
-		 * |  /               /               /|   |
-		 * | /       2       /       6       / | 7 |
-		 * |/               /               /  |   O
-		 * O---------------O---------------O   |  /|
-		 * |               |               |   | / |
-		 * |               |               | 6 |/  |
-		 * |               |               |   O   |
-		 * |       2       |       6       |  /|   |
-		 * |               |               | / | 5 |
-		 * |               |               |/  |   O
-		 * O---------------O---------------O   |  /
-		 * |               |               |   | /
-		 * |               |               | 4 |/
-		 * |               |               |   O
-		 * |       0       |       4       |  /
-		 * |               |               | /
-		 * |               |               |/
-		 * O---------------O---------------O------------------+X
-		 */
-		static void split(const AABB<TYPE>& aabb, AABB<TYPE> (&result)[8]) {
-			const glm::tvec3<TYPE>& center = aabb.getCenter();
-			result[0] = AABB<TYPE>(aabb.mins(), center);
-
-			glm::tvec3<TYPE> mins1(aabb.getLowerX(), aabb.getLowerY(), center.z);
-			glm::tvec3<TYPE> maxs1(center.x, center.y, aabb.getUpperZ());
-			result[1] = AABB<TYPE>(mins1, maxs1);
-
-			glm::tvec3<TYPE> mins2(aabb.getLowerX(), center.y, aabb.getLowerZ());
-			glm::tvec3<TYPE> maxs2(center.x, aabb.getUpperY(), center.z);
-			result[2] = AABB<TYPE>(mins2, maxs2);
-
-			glm::tvec3<TYPE> mins3(aabb.getLowerX(), center.y, center.z);
-			glm::tvec3<TYPE> maxs3(center.x, aabb.getUpperY(), aabb.getUpperZ());
-			result[3] = AABB<TYPE>(mins3, maxs3);
-
-			glm::tvec3<TYPE> mins4(center.x, aabb.getLowerY(), aabb.getLowerZ());
-			glm::tvec3<TYPE> maxs4(aabb.getUpperX(), center.y, center.z);
-			result[4] = AABB<TYPE>(mins4, maxs4);
-
-			glm::tvec3<TYPE> mins5(center.x, aabb.getLowerY(), center.z);
-			glm::tvec3<TYPE> maxs5(aabb.getUpperX(), center.y, aabb.getUpperZ());
-			result[5] = AABB<TYPE>(mins5, maxs5);
-
-			glm::tvec3<TYPE> mins6(center.x, center.y, aabb.getLowerZ());
-			glm::tvec3<TYPE> maxs6(aabb.getUpperX(), aabb.getUpperY(), center.z);
-			result[6] = AABB<TYPE>(mins6, maxs6);
-
-			glm::tvec3<TYPE> mins7(center.x, center.y, center.z);
-			glm::tvec3<TYPE> maxs7(aabb.getUpperX(), aabb.getUpperY(), aabb.getUpperZ());
-			result[7] = AABB<TYPE>(mins7, maxs7);
+		static inline void split(const AABB<TYPE>& aabb, AABB<TYPE> (&result)[8]) {
+			splitOctreeArea(aabb, result);
 		}
 
 		int _maxDepth;
@@ -396,18 +423,7 @@ public:
 	template<class VISITOR>
 	inline void visit(const glm::vec<3, TYPE>& mins, const glm::vec<3, TYPE>& maxs, VISITOR&& visitor, const glm::vec<3, TYPE>& minSize) {
 		core_trace_scoped(OctreeVisit);
-		const math::AABB<TYPE> aabb(mins, maxs);
-		glm::tvec3<TYPE> qmins;
-		for (qmins.x = mins.x; qmins.x < maxs.x; qmins.x += minSize.x) {
-			for (qmins.y = mins.y; qmins.y < maxs.y; qmins.y += minSize.y) {
-				for (qmins.z = mins.z; qmins.z < maxs.z; qmins.z += minSize.z) {
-					const glm::tvec3<TYPE> qmaxs(qmins + minSize);
-					if (!visitor(qmins, qmaxs)) {
-						break;
-					}
-				}
-			}
-		}
+		visitGrid(mins, maxs, visitor, minSize);
 	}
 
 	void setListener(const IOctreeListener* func) {
@@ -0,0 +1,92 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "PooledTree.h"
+#include "Octree.h"
+
+namespace math {
+
+template<class NODE, typename TYPE>
+struct OctreeTraits {
+	using Area = AABB<TYPE>;
+	static constexpr int Children = 8;
+
+	static inline void split(const Area& area, Area (&result)[Children]) {
+		splitOctreeArea(area, result);
+	}
+
+	static inline bool canSplit(const Area& area) {
+		const glm::tvec3<TYPE>& size = area.getWidth();
+		return size.x > (TYPE)1 || size.y > (TYPE)1 || size.z > (TYPE)1;
+	}
+
+	static inline bool contains(const Area& outer, const Area& inner) {
+		return outer.containsAABB(inner);
+	}
+
+	static inline bool intersects(const Area& a, const Area& b) {
+		return math::intersects(a, b);
+	}
+
+	static inline Area area(const typename std::remove_pointer<NODE>::type* item) {
+		return item->aabb();
+	}
+
+	static inline Area area(const typename std::remove_pointer<NODE>::type& item) {
+		return item.aabb();
+	}
+};
+
+/**
+ * @brief Pooled version of @c Octree - see @c PooledTree
+ * @note Given NODE type must implement @c aabb() and return math::AABB<TYPE>
+ */
+template<class NODE, typename TYPE = int>
+class PooledOctree : public PooledTree<NODE, OctreeTraits<NODE, TYPE> > {
+private:
+	using Super = PooledTree<NODE, OctreeTraits<NODE, TYPE> >;
+public:
+	using typename Super::Contents;
+
+	PooledOctree(const AABB<TYPE>& aabb, int maxDepth = 10) :
+			Super(aabb, maxDepth) {
+	}
+
+	inline const AABB<TYPE>& aabb() const {
+		return this->area();
+	}
+
+	using Super::query;
+
+	/**
+	 * @brief Appends the items that are visible in the given frustum to the given buffer
+	 */
+	inline void query(const Frustum& frustum, Contents& results) const {
+		core_trace_scoped(PooledOctreeQueryFrustum);
+		this->queryOverlapping([&frustum] (const AABB<TYPE>& area) {
+			switch (frustum.test(area.mins(), area.maxs())) {
+			case FrustumResult::Inside:
+				return TreeOverlap::Inside;
+			case FrustumResult::Intersect:
+				return TreeOverlap::Intersect;
+			default:
+				return TreeOverlap::Outside;
+			}
+		}, results);
+	}
+
+	/**
+	 * @brief Executes the given visitor for all cells of the given size in the given area
+	 * @sa Octree::visit()
+	 */
+	template<class VISITOR>
+	inline void visit(const glm::vec<3, TYPE>& mins, const glm::vec<3, TYPE>& maxs, VISITOR&& visitor, const glm::vec<3, TYPE>& minSize) const {
+		core_trace_scoped(PooledOctreeVisit);
+		visitGrid(mins, maxs, visitor, minSize);
+	}
+};
+
+}
@@ -0,0 +1,61 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "PooledTree.h"
+#include "QuadTree.h"
+
+namespace math {
+
+template<class NODE, typename TYPE>
+struct QuadTreeTraits {
+	using Area = Rect<TYPE>;
+	static constexpr int Children = 4;
+
+	static inline void split(const Area& area, Area (&result)[Children]) {
+		splitQuadTreeArea(area, result);
+	}
+
+	static inline bool canSplit(const Area& area) {
+		const glm::tvec2<TYPE>& size = area.size();
+		return size.x > (TYPE)1 || size.y > (TYPE)1;
+	}
+
+	static inline bool contains(const Area& outer, const Area& inner) {
+		return outer.contains(inner);
+	}
+
+	static inline bool intersects(const Area& a, const Area& b) {
+		return a.intersectsWith(b);
+	}
+
+	static inline Area area(const typename std::remove_pointer<NODE>::type* item) {
+		return item->getRect();
+	}
+
+	static inline Area area(const typename std::remove_pointer<NODE>::type& item) {
+		return item.getRect();
+	}
+};
+
+/**
+ * @brief Pooled version of @c QuadTree - see @c PooledTree
+ * @note Given NODE type must implement @c getRect() and return math::Rect<TYPE>
+ */
+template<class NODE, typename TYPE>
+class PooledQuadTree : public PooledTree<NODE, QuadTreeTraits<NODE, TYPE> > {
+private:
+	using Super = PooledTree<NODE, QuadTreeTraits<NODE, TYPE> >;
+public:
+	PooledQuadTree(const Rect<TYPE>& rect, int maxDepth = 10) :
+			Super(rect, maxDepth) {
+	}
+
+	inline const Rect<TYPE>& getRect() const {
+		return this->area();
+	}
+};
+
+}
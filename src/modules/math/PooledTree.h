@@ -0,0 +1,435 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/Assert.h"
+#include "core/Trace.h"
+#include <stdint.h>
+#include <vector>
+
+namespace math {
+
+enum class TreeOverlap : uint8_t {
+	Outside, Intersect, Inside
+};
+
+/**
+ * @brief Spatial tree that keeps its nodes and items in contiguous pools instead of allocating them one by one.
+ *
+ * The children of a node are stored next to each other in the node pool. Every node has a small inline array
+ * of item ids - only nodes with more items than that allocate. The items remember the node they are stored in,
+ * so removing or moving an item by its id doesn't have to search the tree. The nodes are only released by
+ * @c clear().
+ *
+ * The TRAITS define the geometry of the tree - see @c PooledOctree and @c PooledQuadTree
+ * @li @c Area The area type of the nodes and items
+ * @li @c Children The amount of children a node is split into
+ * @li @c split(area, children) Splits the area into the child areas
+ * @li @c canSplit(area) Whether the area is large enough to get split
+ * @li @c contains(outer, inner) and @c intersects(a, b)
+ * @li @c area(item) The current area of an item
+ */
+template<class NODE, class TRAITS, int INLINEITEMS = 4>
+class PooledTree {
+public:
+	using Area = typename TRAITS::Area;
+	typedef std::vector<NODE> Contents;
+	typedef int32_t ItemId;
+	static constexpr ItemId InvalidItem = -1;
+	static constexpr int Children = TRAITS::Children;
+
+protected:
+	struct Item {
+		NODE value {};
+		// the area of the item at the time it was inserted or moved
+		Area area;
+		// the tree node the item is stored in or -1 if the item slot is free
+		int32_t node = -1;
+		// the index in the item array of the tree node
+		int32_t index = -1;
+	};
+
+	struct TreeNode {
+		Area area;
+		int32_t parent = -1;
+		// the children are next to each other in the node pool - or -1 if the node wasn't split yet
+		int32_t firstChild = -1;
+		int32_t depth = 0;
+		// the amount of items in this node and all of its children
+		int32_t total = 0;
+		int32_t itemCount = 0;
+		ItemId items[INLINEITEMS];
+		// the items that don't fit into the inline array
+		std::vector<ItemId> overflow;
+
+		inline ItemId item(int32_t index) const {
+			return index < INLINEITEMS ? items[index] : overflow[index - INLINEITEMS];
+		}
+
+		inline ItemId& item(int32_t index) {
+			return index < INLINEITEMS ? items[index] : overflow[index - INLINEITEMS];
+		}
+	};
+
+	std::vector<TreeNode> _nodes;
+	std::vector<Item> _items;
+	std::vector<ItemId> _freeItems;
+	const int _maxDepth;
+	// dirty flag can be used for query caches
+	bool _dirty = false;
+
+	int32_t createChildren(int32_t nodeIdx, const Area (&subareas)[Children]) {
+		core_trace_scoped(PooledTreeCreateChildren);
+		const int32_t firstChild = (int32_t)_nodes.size();
+		const int32_t depth = _nodes[nodeIdx].depth + 1;
+		for (int i = 0; i < Children; ++i) {
+			_nodes.emplace_back();
+			TreeNode& child = _nodes.back();
+			child.area = subareas[i];
+			child.parent = nodeIdx;
+			child.depth = depth;
+		}
+		_nodes[nodeIdx].firstChild = firstChild;
+		return firstChild;
+	}
+
+	/**
+	 * @brief Looks up the deepest node below the given node that fully contains the given area.
+	 * @param create Split the nodes on the way down if needed
+	 * @note The given node must contain the area
+	 */
+	int32_t findNode(int32_t nodeIdx, const Area& area, bool create) {
+		for (;;) {
+			const TreeNode& node = _nodes[nodeIdx];
+			if (node.depth >= _maxDepth) {
+				return nodeIdx;
+			}
+			if (node.firstChild != -1) {
+				int32_t childIdx = -1;
+				for (int i = 0; i < Children; ++i) {
+					if (TRAITS::contains(_nodes[node.firstChild + i].area, area)) {
+						childIdx = node.firstChild + i;
+						break;
+					}
+				}
+				if (childIdx == -1) {
+					return nodeIdx;
+				}
+				nodeIdx = childIdx;
+				continue;
+			}
+			if (!create || !TRAITS::canSplit(node.area)) {
+				return nodeIdx;
+			}
+			// only split the node if the item fits into one of the children
+			Area subareas[Children];
+			TRAITS::split(node.area, subareas);
+			int child = -1;
+			for (int i = 0; i < Children; ++i) {
+				if (TRAITS::contains(subareas[i], area)) {
+					child = i;
+					break;
+				}
+			}
+			if (child == -1) {
+				return nodeIdx;
+			}
+			nodeIdx = createChildren(nodeIdx, subareas) + child;
+		}
+	}
+
+	void link(ItemId id, int32_t nodeIdx) {
+		TreeNode& node = _nodes[nodeIdx];
+		const int32_t index = node.itemCount++;
+		if (index < INLINEITEMS) {
+			node.items[index] = id;
+		} else {
+			node.overflow.push_back(id);
+		}
+		Item& item = _items[id];
+		item.node = nodeIdx;
+		item.index = index;
+		for (int32_t n = nodeIdx; n != -1; n = _nodes[n].parent) {
+			++_nodes[n].total;
+		}
+	}
+
+	void unlink(ItemId id) {
+		Item& item = _items[id];
+		TreeNode& node = _nodes[item.node];
+		// the last item of the node takes the place of the removed one
+		const int32_t last = --node.itemCount;
+		const ItemId lastId = node.item(last);
+		node.item(item.index) = lastId;
+		_items[lastId].index = item.index;
+		if (last >= INLINEITEMS) {
+			node.overflow.pop_back();
+		}
+		for (int32_t n = item.node; n != -1; n = _nodes[n].parent) {
+			--_nodes[n].total;
+		}
+		item.node = -1;
+		item.index = -1;
+	}
+
+	template<class FUNC>
+	void visitAll(int32_t nodeIdx, FUNC&& func) const {
+		const TreeNode& node = _nodes[nodeIdx];
+		for (int32_t i = 0; i < node.itemCount; ++i) {
+			func(_items[node.item(i)].value);
+		}
+		if (node.firstChild == -1) {
+			return;
+		}
+		for (int i = 0; i < Children; ++i) {
+			const int32_t childIdx = node.firstChild + i;
+			if (_nodes[childIdx].total > 0) {
+				visitAll(childIdx, func);
+			}
+		}
+	}
+
+	/**
+	 * @param overlap Classifies an area against the query - see @c TreeOverlap
+	 */
+	template<class OVERLAP, class FUNC>
+	void visitOverlapping(int32_t nodeIdx, OVERLAP&& overlap, FUNC&& func) const {
+		const TreeNode& node = _nodes[nodeIdx];
+		for (int32_t i = 0; i < node.itemCount; ++i) {
+			const Item& item = _items[node.item(i)];
+			if (overlap(item.area) != TreeOverlap::Outside) {
+				func(item.value);
+			}
+		}
+		if (node.firstChild == -1) {
+			return;
+		}
+		for (int i = 0; i < Children; ++i) {
+			const int32_t childIdx = node.firstChild + i;
+			const TreeNode& child = _nodes[childIdx];
+			if (child.total <= 0) {
+				continue;
+			}
+			const TreeOverlap result = overlap(child.area);
+			if (result == TreeOverlap::Inside) {
+				// the whole node content is part of the query
+				visitAll(childIdx, func);
+			} else if (result == TreeOverlap::Intersect) {
+				visitOverlapping(childIdx, overlap, func);
+			}
+		}
+	}
+
+	template<class OVERLAP>
+	inline void queryOverlapping(OVERLAP&& overlap, Contents& results) const {
+		visitOverlapping(0, overlap, [&results] (const NODE& item) {
+			results.push_back(item);
+		});
+	}
+
+	static TreeOverlap overlap(const Area& queryArea, const Area& area) {
+		if (TRAITS::contains(queryArea, area)) {
+			return TreeOverlap::Inside;
+		}
+		if (TRAITS::intersects(queryArea, area)) {
+			return TreeOverlap::Intersect;
+		}
+		return TreeOverlap::Outside;
+	}
+
+public:
+	PooledTree(const Area& area, int maxDepth = 10) :
+			_maxDepth(maxDepth) {
+		_nodes.emplace_back();
+		_nodes.back().area = area;
+	}
+
+	inline const Area& area() const {
+		return _nodes[0].area;
+	}
+
+	/**
+	 * @return The amount of items in the tree
+	 */
+	inline int count() const {
+		return _nodes[0].total;
+	}
+
+	/**
+	 * @return The id of the item that can be used for @c move() and @c removeItem() or @c InvalidItem
+	 * if the item is not inside the area of the tree
+	 */
+	ItemId add(const NODE& value) {
+		core_trace_scoped(PooledTreeAdd);
+		const Area& itemArea = TRAITS::area(value);
+		if (!TRAITS::contains(area(), itemArea)) {
+			return InvalidItem;
+		}
+		const int32_t nodeIdx = findNode(0, itemArea, true);
+		ItemId id;
+		if (_freeItems.empty()) {
+			id = (ItemId)_items.size();
+			_items.emplace_back();
+		} else {
+			id = _freeItems.back();
+			_freeItems.pop_back();
+		}
+		Item& item = _items[id];
+		item.value = value;
+		item.area = itemArea;
+		link(id, nodeIdx);
+		_dirty = true;
+		return id;
+	}
+
+	inline bool insert(const NODE& value) {
+		return add(value) != InvalidItem;
+	}
+
+	bool removeItem(ItemId id) {
+		core_trace_scoped(PooledTreeRemoveItem);
+		if (id < 0 || id >= (ItemId)_items.size() || _items[id].node == -1) {
+			return false;
+		}
+		unlink(id);
+		_items[id].value = NODE();
+		_freeItems.push_back(id);
+		_dirty = true;
+		return true;
+	}
+
+	/**
+	 * @brief Removes the given item by looking it up at its current area
+	 * @note Prefer @c removeItem() - this doesn't find items that changed their area without calling @c move()
+	 */
+	bool remove(const NODE& value) {
+		core_trace_scoped(PooledTreeRemove);
+		const Area& itemArea = TRAITS::area(value);
+		if (!TRAITS::contains(area(), itemArea)) {
+			return false;
+		}
+		int32_t nodeIdx = 0;
+		for (;;) {
+			const TreeNode& node = _nodes[nodeIdx];
+			for (int32_t i = 0; i < node.itemCount; ++i) {
+				const ItemId id = node.item(i);
+				if (_items[id].value == value) {
+					return removeItem(id);
+				}
+			}
+			if (node.firstChild == -1) {
+				return false;
+			}
+			int32_t childIdx = -1;
+			for (int i = 0; i < Children; ++i) {
+				if (TRAITS::contains(_nodes[node.firstChild + i].area, itemArea)) {
+					childIdx = node.firstChild + i;
+					break;
+				}
+			}
+			if (childIdx == -1) {
+				return false;
+			}
+			nodeIdx = childIdx;
+		}
+	}
+
+	/**
+	 * @brief Updates the position of the item in the tree after its area changed. If the item still belongs
+	 * to the same node, only the stored area is updated.
+	 * @return @c false if the item is no longer inside the area of the tree - it is removed in that case
+	 */
+	bool move(ItemId id) {
+		core_trace_scoped(PooledTreeMove);
+		if (id < 0 || id >= (ItemId)_items.size() || _items[id].node == -1) {
+			return false;
+		}
+		const Area itemArea = TRAITS::area(_items[id].value);
+		int32_t nodeIdx = _items[id].node;
+		while (!TRAITS::contains(_nodes[nodeIdx].area, itemArea)) {
+			nodeIdx = _nodes[nodeIdx].parent;
+			if (nodeIdx == -1) {
+				removeItem(id);
+				return false;
+			}
+		}
+		const int32_t targetIdx = findNode(nodeIdx, itemArea, true);
+		_items[id].area = itemArea;
+		_dirty = true;
+		if (targetIdx == _items[id].node) {
+			return true;
+		}
+		unlink(id);
+		link(id, targetIdx);
+		return true;
+	}
+
+	inline const NODE& value(ItemId id) const {
+		core_assert(id >= 0 && id < (ItemId)_items.size() && _items[id].node != -1);
+		return _items[id].value;
+	}
+
+	/**
+	 * @brief Appends the items that intersect the given area to the given buffer
+	 * @note The buffer is not cleared - this allows to reuse it for several queries
+	 */
+	inline void query(const Area& queryArea, Contents& results) const {
+		core_trace_scoped(PooledTreeQuery);
+		queryOverlapping([&queryArea] (const Area& area) {
+			return overlap(queryArea, area);
+		}, results);
+	}
+
+	/**
+	 * @brief Calls the given function for every item that intersects the given area
+	 */
+	template<class FUNC>
+	inline void visitContents(const Area& queryArea, FUNC&& func) const {
+		core_trace_scoped(PooledTreeVisitContents);
+		visitOverlapping(0, [&queryArea] (const Area& area) {
+			return overlap(queryArea, area);
+		}, func);
+	}
+
+	/**
+	 * @brief Removes all items - the memory of the pools is kept
+	 */
+	void clear() {
+		_dirty = true;
+		_nodes.erase(_nodes.begin() + 1, _nodes.end());
+		TreeNode& root = _nodes[0];
+		root.firstChild = -1;
+		root.total = 0;
+		root.itemCount = 0;
+		root.overflow.clear();
+		_items.clear();
+		_freeItems.clear();
+	}
+
+	inline void markAsClean() {
+		_dirty = false;
+	}
+
+	inline bool isDirty() const {
+		return _dirty;
+	}
+
+	inline void getContents(Contents& results) const {
+		results.clear();
+		results.reserve(count());
+		visitAll(0, [&results] (const NODE& item) {
+			results.push_back(item);
+		});
+	}
+
+	/**
+	 * @return The amount of nodes in the node pool
+	 */
+	inline int nodes() const {
+		return (int)_nodes.size();
+	}
+};
+
+}
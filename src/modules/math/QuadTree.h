@@ -15,6 +15,38 @@
 
 namespace math {
 
+/**
+ * @brief Splits the given area into the four quadrants
+ */
+template<typename TYPE>
+void splitQuadTreeArea(const Rect<TYPE>& rect, Rect<TYPE> (&result)[4]) {
+	if (Rect<TYPE>::getMaxRect() == rect) {
+		// special case because the length would exceed the max possible value of TYPE
+		if (std::numeric_limits<TYPE>::is_signed) {
+			static const Rect<TYPE> maxSplit[4] = {
+				Rect<TYPE>(rect.getMinX(), rect.getMinZ(), 0, 0),
+				Rect<TYPE>(0, rect.getMinZ(), rect.getMaxX(), 0),
+				Rect<TYPE>(rect.getMinX(), 0, 0, rect.getMaxX()),
+				Rect<TYPE>(0, 0, rect.getMaxX(), rect.getMaxX())
+			};
+			result[0] = maxSplit[0];
+			result[1] = maxSplit[1];
+			result[2] = maxSplit[2];
+			result[3] = maxSplit[3];
+			return;
+		}
+	}
+
+	const TYPE lengthX = rect.getMaxX() - rect.getMinX();
+	const TYPE halfX = lengthX / (TYPE)2;
+	const TYPE lengthY = rect.getMaxZ() - rect.getMinZ();
+	const TYPE halfY = lengthY / (TYPE)2;
+	result[0] = Rect<TYPE>(rect.getMinX(), rect.getMinZ(), rect.getMinX() + halfX, rect.getMinZ() + halfY);
+	result[1] = Rect<TYPE>(rect.getMinX() + halfX, rect.getMinZ(), rect.getMaxX(), rect.getMinZ() + halfY);
+	result[2] = Rect<TYPE>(rect.getMinX(), rect.getMinZ() + halfY, rect.getMinX() + halfX, rect.getMaxZ());
+	result[3] = Rect<TYPE>(rect.getMinX() + halfX, rect.getMinZ() + halfY, rect.getMaxX(), rect.getMaxZ());
+}
+
 template<class NODE, typename TYPE>
 class QuadTree {
 public:
@@ -53,32 +85,8 @@ private:
 		}
 
 	private:
-		static void split(const Rect<TYPE>& rect, Rect<TYPE> (&result)[4]) {
-			if (Rect<TYPE>::getMaxRect() == rect) {
-				// special case because the length would exceed the max possible value of TYPE
-				if (std::numeric_limits<TYPE>::is_signed) {
-					static const Rect<TYPE> maxSplit[4] = {
-						Rect<TYPE>(rect.getMinX(), rect.getMinZ(), 0, 0),
-						Rect<TYPE>(0, rect.getMinZ(), rect.getMaxX(), 0),
-						Rect<TYPE>(rect.getMinX(), 0, 0, rect.getMaxX()),
-						Rect<TYPE>(0, 0, rect.getMaxX(), rect.getMaxX())
-					};
-					result[0] = maxSplit[0];
-					result[1] = maxSplit[1];
-					result[2] = maxSplit[2];
-					result[3] = maxSplit[3];
-					return;
-				}
-			}
-
-			const TYPE lengthX = rect.getMaxX() - rect.getMinX();
-			const TYPE halfX = lengthX / (TYPE)2;
-			const TYPE lengthY = rect.getMaxZ() - rect.getMinZ();
-			const TYPE halfY = lengthY / (TYPE)2;
-			result[0] = Rect<TYPE>(rect.getMinX(), rect.getMinZ(), rect.getMinX() + halfX, rect.getMinZ() + halfY);
-			result[1] = Rect<TYPE>(rect.getMinX() + halfX, rect.getMinZ(), rect.getMaxX(), rect.getMinZ() + halfY);
-			result[2] = Rect<TYPE>(rect.getMinX(), rect.getMinZ() + halfY, rect.getMinX() + halfX, rect.getMaxZ());
-			result[3] = Rect<TYPE>(rect.getMinX() + halfX, rect.getMinZ() + halfY, rect.getMaxX(), rect.getMaxZ());
+		static inline void split(const Rect<TYPE>& rect, Rect<TYPE> (&result)[4]) {
+			splitQuadTreeArea(rect, result);
 		}
 
 		void createNodes() {
@@ -0,0 +1,195 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "math/Octree.h"
+#include "math/PooledOctree.h"
+#include "math/QuadTree.h"
+#include "math/PooledQuadTree.h"
+#include "math/Random.h"
+#include <vector>
+
+class SpatialTreeBenchmark : public app::AbstractBenchmark {
+public:
+	// an entity that moves a little bit every tick
+	struct Entity {
+		glm::vec2 pos { 0.0f };
+		int id = -1;
+
+		math::RectFloat getRect() const {
+			return math::RectFloat(pos.x - 1.0f, pos.y - 1.0f, pos.x + 1.0f, pos.y + 1.0f);
+		}
+
+		bool operator==(const Entity& rhs) const {
+			return id == rhs.id;
+		}
+	};
+
+	struct Chunk {
+		math::AABB<int> bounds;
+
+		const math::AABB<int>& aabb() const {
+			return bounds;
+		}
+
+		bool operator==(const Chunk& rhs) const {
+			return bounds == rhs.bounds;
+		}
+	};
+
+	static constexpr float WorldSize = 1024.0f;
+	static constexpr float ViewDistance = 32.0f;
+	static constexpr int ChunkSize = 32;
+
+	std::vector<Entity> createEntities(int n) const {
+		math::Random random(1);
+		std::vector<Entity> entities(n);
+		for (int i = 0; i < n; ++i) {
+			entities[i].pos = glm::vec2(random.randomf(0.0f, WorldSize), random.randomf(0.0f, WorldSize));
+			entities[i].id = i;
+		}
+		return entities;
+	}
+
+	static void moveEntities(std::vector<Entity>& entities, int tick) {
+		const float delta = (tick & 1) ? 0.5f : -0.5f;
+		for (Entity& entity : entities) {
+			entity.pos.x += delta;
+		}
+	}
+
+	static math::RectFloat viewRect(const Entity& entity) {
+		return math::RectFloat(entity.pos.x - ViewDistance, entity.pos.y - ViewDistance, entity.pos.x + ViewDistance, entity.pos.y + ViewDistance);
+	}
+
+	std::vector<Chunk> createChunks() const {
+		std::vector<Chunk> chunks;
+		const int chunksPerAxis = (int)WorldSize / ChunkSize;
+		for (int x = 0; x < chunksPerAxis; ++x) {
+			for (int z = 0; z < chunksPerAxis; ++z) {
+				const glm::ivec3 mins(x * ChunkSize, 0, z * ChunkSize);
+				chunks.push_back(Chunk{math::AABB<int>(mins, mins + ChunkSize)});
+			}
+		}
+		return chunks;
+	}
+
+	static math::AABB<int> cullArea(int tick) {
+		const glm::ivec3 mins((tick * 7) % 512, 0, (tick * 13) % 512);
+		return math::AABB<int>(mins, mins + glm::ivec3(512, ChunkSize, 512));
+	}
+};
+
+BENCHMARK_DEFINE_F(SpatialTreeBenchmark, QuadTreeEntityTick) (benchmark::State& state) {
+	std::vector<Entity> entities = createEntities((int)state.range(0));
+	math::QuadTree<Entity, float> quadTree(math::RectFloat::getMaxRect(), 100);
+	for (const Entity& entity : entities) {
+		quadTree.insert(entity);
+	}
+	int tick = 0;
+	for (auto _ : state) {
+		// the old tree doesn't know the old position - remove and insert again
+		for (const Entity& entity : entities) {
+			quadTree.remove(entity);
+		}
+		moveEntities(entities, tick++);
+		for (const Entity& entity : entities) {
+			quadTree.insert(entity);
+		}
+		size_t visible = 0u;
+		for (const Entity& entity : entities) {
+			math::QuadTree<Entity, float>::Contents contents;
+			quadTree.query(viewRect(entity), contents);
+			visible += contents.size();
+		}
+		benchmark::DoNotOptimize(visible);
+	}
+}
+
+BENCHMARK_DEFINE_F(SpatialTreeBenchmark, PooledQuadTreeEntityTick) (benchmark::State& state) {
+	std::vector<Entity> entities = createEntities((int)state.range(0));
+	math::PooledQuadTree<Entity*, float> quadTree(math::RectFloat::getMaxRect(), 100);
+	std::vector<math::PooledQuadTree<Entity*, float>::ItemId> itemIds;
+	for (Entity& entity : entities) {
+		itemIds.push_back(quadTree.add(&entity));
+	}
+	int tick = 0;
+	for (auto _ : state) {
+		moveEntities(entities, tick++);
+		for (math::PooledQuadTree<Entity*, float>::ItemId id : itemIds) {
+			quadTree.move(id);
+		}
+		size_t visible = 0u;
+		for (const Entity& entity : entities) {
+			quadTree.visitContents(viewRect(entity), [&] (const Entity* other) {
+				++visible;
+			});
+		}
+		benchmark::DoNotOptimize(visible);
+	}
+}
+
+BENCHMARK_DEFINE_F(SpatialTreeBenchmark, OctreeCull) (benchmark::State& state) {
+	math::Octree<Chunk> octree({}, 30);
+	for (const Chunk& chunk : createChunks()) {
+		octree.insert(chunk);
+	}
+	int tick = 0;
+	math::Octree<Chunk>::Contents contents;
+	for (auto _ : state) {
+		contents.clear();
+		octree.query(cullArea(tick++), contents);
+		benchmark::DoNotOptimize(contents.size());
+	}
+}
+
+BENCHMARK_DEFINE_F(SpatialTreeBenchmark, PooledOctreeCull) (benchmark::State& state) {
+	math::PooledOctree<Chunk> octree({}, 30);
+	for (const Chunk& chunk : createChunks()) {
+		octree.insert(chunk);
+	}
+	int tick = 0;
+	math::PooledOctree<Chunk>::Contents contents;
+	for (auto _ : state) {
+		contents.clear();
+		octree.query(cullArea(tick++), contents);
+		benchmark::DoNotOptimize(contents.size());
+	}
+}
+
+BENCHMARK_DEFINE_F(SpatialTreeBenchmark, OctreeInsertRemove) (benchmark::State& state) {
+	const std::vector<Chunk>& chunks = createChunks();
+	math::Octree<Chunk> octree({}, 30);
+	for (auto _ : state) {
+		for (const Chunk& chunk : chunks) {
+			octree.insert(chunk);
+		}
+		for (const Chunk& chunk : chunks) {
+			octree.remove(chunk);
+		}
+	}
+}
+
+BENCHMARK_DEFINE_F(SpatialTreeBenchmark, PooledOctreeInsertRemove) (benchmark::State& state) {
+	const std::vector<Chunk>& chunks = createChunks();
+	math::PooledOctree<Chunk> octree({}, 30);
+	std::vector<math::PooledOctree<Chunk>::ItemId> itemIds(chunks.size());
+	for (auto _ : state) {
+		for (size_t i = 0; i < chunks.size(); ++i) {
+			itemIds[i] = octree.add(chunks[i]);
+		}
+		for (math::PooledOctree<Chunk>::ItemId id : itemIds) {
+			octree.removeItem(id);
+		}
+	}
+}
+
+BENCHMARK_REGISTER_F(SpatialTreeBenchmark, QuadTreeEntityTick)->RangeMultiplier(4)->Range(64, 1024);
+BENCHMARK_REGISTER_F(SpatialTreeBenchmark, PooledQuadTreeEntityTick)->RangeMultiplier(4)->Range(64, 1024);
+BENCHMARK_REGISTER_F(SpatialTreeBenchmark, OctreeCull);
+BENCHMARK_REGISTER_F(SpatialTreeBenchmark, PooledOctreeCull);
+BENCHMARK_REGISTER_F(SpatialTreeBenchmark, OctreeInsertRemove);
+BENCHMARK_REGISTER_F(SpatialTreeBenchmark, PooledOctreeInsertRemove);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,210 @@
+/**
+ * @file
+ */
+
+#include <gtest/gtest.h>
+#include "math/PooledOctree.h"
+#include "math/PooledQuadTree.h"
+#include "math/Random.h"
+#include <algorithm>
+
+namespace math {
+
+namespace pooled {
+class Item {
+private:
+	AABB<int> _bounds;
+	int _id = -1;
+public:
+	Item() {
+	}
+
+	Item(const AABB<int>& bounds, int id) :
+			_bounds(bounds), _id(id) {
+	}
+
+	const AABB<int>& aabb() const {
+		return _bounds;
+	}
+
+	void setAABB(const AABB<int>& bounds) {
+		_bounds = bounds;
+	}
+
+	int id() const {
+		return _id;
+	}
+
+	bool operator==(const Item& rhs) const {
+		return rhs._id == _id;
+	}
+};
+
+class QuadItem {
+private:
+	RectFloat _bounds;
+	int _id = -1;
+public:
+	QuadItem() {
+	}
+
+	QuadItem(const RectFloat& rect, int id) :
+			_bounds(rect), _id(id) {
+	}
+
+	RectFloat getRect() const {
+		return _bounds;
+	}
+
+	int id() const {
+		return _id;
+	}
+
+	bool operator==(const QuadItem& rhs) const {
+		return rhs._id == _id;
+	}
+};
+
+template<class CONTENTS>
+std::vector<int> ids(const CONTENTS& contents) {
+	std::vector<int> result;
+	for (const auto& item : contents) {
+		result.push_back(item.id());
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+AABB<int> randomAABB(Random& random, int maxPos, int maxSize) {
+	const glm::ivec3 mins(random.random(0, maxPos), random.random(0, maxPos), random.random(0, maxPos));
+	const glm::ivec3 size(random.random(1, maxSize), random.random(1, maxSize), random.random(1, maxSize));
+	return AABB<int>(mins, mins + size);
+}
+}
+
+TEST(PooledTreeTest, testAddRemove) {
+	PooledOctree<pooled::Item> octree(AABB<int>(glm::ivec3(0), glm::ivec3(256)));
+	EXPECT_EQ(0, octree.count());
+	const pooled::Item item1(AABB<int>(glm::ivec3(10), glm::ivec3(12)), 1);
+	const pooled::Item item2(AABB<int>(glm::ivec3(100), glm::ivec3(200)), 2);
+	const pooled::Item outside(AABB<int>(glm::ivec3(200), glm::ivec3(300)), 3);
+	EXPECT_TRUE(octree.insert(item1));
+	const PooledOctree<pooled::Item>::ItemId id2 = octree.add(item2);
+	EXPECT_NE(PooledOctree<pooled::Item>::InvalidItem, id2);
+	EXPECT_FALSE(octree.insert(outside));
+	EXPECT_EQ(2, octree.count());
+
+	EXPECT_TRUE(octree.remove(item1));
+	EXPECT_FALSE(octree.remove(item1));
+	EXPECT_EQ(1, octree.count());
+	EXPECT_TRUE(octree.removeItem(id2));
+	EXPECT_FALSE(octree.removeItem(id2));
+	EXPECT_EQ(0, octree.count());
+}
+
+TEST(PooledTreeTest, testManyItemsInOneNode) {
+	PooledOctree<pooled::Item> octree(AABB<int>(glm::ivec3(0), glm::ivec3(256)));
+	// all of these items are stored in the root node - more than fit into the inline array
+	std::vector<PooledOctree<pooled::Item>::ItemId> itemIds;
+	for (int i = 0; i < 20; ++i) {
+		itemIds.push_back(octree.add(pooled::Item(AABB<int>(glm::ivec3(100 + i), glm::ivec3(200)), i)));
+	}
+	EXPECT_EQ(20, octree.count());
+	EXPECT_EQ(1, octree.nodes());
+	for (int i = 0; i < 20; i += 2) {
+		EXPECT_TRUE(octree.removeItem(itemIds[i]));
+	}
+	PooledOctree<pooled::Item>::Contents contents;
+	octree.getContents(contents);
+	std::vector<int> expected;
+	for (int i = 1; i < 20; i += 2) {
+		expected.push_back(i);
+		EXPECT_EQ(i, octree.value(itemIds[i]).id());
+	}
+	EXPECT_EQ(expected, pooled::ids(contents));
+}
+
+TEST(PooledTreeTest, testQueryMatchesOctree) {
+	const AABB<int> area(glm::ivec3(0), glm::ivec3(1024));
+	Octree<pooled::Item> octree(area);
+	PooledOctree<pooled::Item> pooledOctree(area);
+	Random random(42);
+	for (int i = 0; i < 500; ++i) {
+		const pooled::Item item(pooled::randomAABB(random, 900, 100), i);
+		ASSERT_TRUE(octree.insert(item));
+		ASSERT_TRUE(pooledOctree.insert(item));
+	}
+	EXPECT_EQ(octree.count(), pooledOctree.count());
+	for (int i = 0; i < 50; ++i) {
+		const AABB<int>& queryArea = pooled::randomAABB(random, 800, 400);
+		Octree<pooled::Item>::Contents expected;
+		octree.query(queryArea, expected);
+		PooledOctree<pooled::Item>::Contents contents;
+		pooledOctree.query(queryArea, contents);
+		EXPECT_EQ(pooled::ids(expected), pooled::ids(contents));
+
+		int visited = 0;
+		pooledOctree.visitContents(queryArea, [&] (const pooled::Item& item) {
+			++visited;
+		});
+		EXPECT_EQ((int)contents.size(), visited);
+	}
+}
+
+TEST(PooledTreeTest, testMove) {
+	PooledOctree<pooled::Item*> octree(AABB<int>(glm::ivec3(0), glm::ivec3(256)));
+	pooled::Item item(AABB<int>(glm::ivec3(9), glm::ivec3(13)), 1);
+	const PooledOctree<pooled::Item*>::ItemId id = octree.add(&item);
+	ASSERT_NE(PooledOctree<pooled::Item*>::InvalidItem, id);
+	const int nodes = octree.nodes();
+
+	// a small move inside of the same node only updates the item
+	item.setAABB(AABB<int>(glm::ivec3(10), glm::ivec3(14)));
+	EXPECT_TRUE(octree.move(id));
+	EXPECT_EQ(nodes, octree.nodes());
+
+	item.setAABB(AABB<int>(glm::ivec3(200), glm::ivec3(202)));
+	EXPECT_TRUE(octree.move(id));
+	EXPECT_EQ(1, octree.count());
+	PooledOctree<pooled::Item*>::Contents contents;
+	octree.query(AABB<int>(glm::ivec3(0), glm::ivec3(100)), contents);
+	EXPECT_TRUE(contents.empty()) << "The item should not be found at the old position";
+	octree.query(AABB<int>(glm::ivec3(190), glm::ivec3(210)), contents);
+	ASSERT_EQ(1u, contents.size());
+	EXPECT_EQ(&item, contents.front());
+
+	// moving out of the tree removes the item
+	item.setAABB(AABB<int>(glm::ivec3(250), glm::ivec3(260)));
+	EXPECT_FALSE(octree.move(id));
+	EXPECT_EQ(0, octree.count());
+}
+
+TEST(PooledTreeTest, testClear) {
+	PooledOctree<pooled::Item> octree(AABB<int>(glm::ivec3(0), glm::ivec3(256)));
+	EXPECT_TRUE(octree.insert(pooled::Item(AABB<int>(glm::ivec3(10), glm::ivec3(12)), 1)));
+	EXPECT_GT(octree.nodes(), 1);
+	octree.clear();
+	EXPECT_EQ(0, octree.count());
+	EXPECT_EQ(1, octree.nodes());
+	EXPECT_TRUE(octree.insert(pooled::Item(AABB<int>(glm::ivec3(10), glm::ivec3(12)), 1)));
+	EXPECT_EQ(1, octree.count());
+}
+
+TEST(PooledTreeTest, testQuadTreeQuery) {
+	PooledQuadTree<pooled::QuadItem, float> quadTree(RectFloat::getMaxRect(), 100);
+	EXPECT_TRUE(quadTree.insert(pooled::QuadItem(RectFloat(51, 51, 53, 53), 1)));
+	EXPECT_TRUE(quadTree.insert(pooled::QuadItem(RectFloat(15, 15, 18, 18), 2)));
+	EXPECT_TRUE(quadTree.insert(pooled::QuadItem(RectFloat(-30, -30, -28, -28), 3)));
+	EXPECT_EQ(3, quadTree.count());
+
+	PooledQuadTree<pooled::QuadItem, float>::Contents contents;
+	quadTree.query(RectFloat(10, 10, 60, 60), contents);
+	EXPECT_EQ(std::vector<int>({1, 2}), pooled::ids(contents));
+	contents.clear();
+	quadTree.query(RectFloat(-100, -100, 16, 16), contents);
+	EXPECT_EQ(std::vector<int>({2, 3}), pooled::ids(contents));
+	EXPECT_TRUE(quadTree.remove(pooled::QuadItem(RectFloat(15, 15, 18, 18), 2)));
+	EXPECT_EQ(2, quadTree.count());
+}
+
+}
@@ -0,0 +1,319 @@
+/**
+ * @file
+ */
+
+#include "BatchNoise.h"
+#include "BatchNoiseKernel.h"
+#include "Simplex.h"
+#include "core/Assert.h"
+#include "core/Common.h"
+#include "core/Trace.h"
+#include "core/concurrent/Atomic.h"
+#include <SDL_cpuinfo.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace noise {
+
+namespace details {
+
+struct ScalarOps {
+	typedef float Float;
+	typedef int32_t Int;
+	static constexpr int Width = 1;
+
+	static inline Float load(const float* p) { return *p; }
+	static inline void store(float* p, Float v) { *p = v; }
+	static inline Float set(float v) { return v; }
+	static inline Int seti(int32_t v) { return v; }
+	static inline Float add(Float a, Float b) { return a + b; }
+	static inline Float sub(Float a, Float b) { return a - b; }
+	static inline Float mul(Float a, Float b) { return a * b; }
+	static inline Float abs(Float a) { return fabsf(a); }
+	static inline Int floor(Float v) { const Int t = (Int)v; return v > 0.0f ? t : t - 1; }
+	static inline Float tofloat(Int v) { return (Float)v; }
+	static inline Int addi(Int a, Int b) { return a + b; }
+	static inline Int andi(Int a, Int b) { return a & b; }
+	static inline Int ori(Int a, Int b) { return a | b; }
+	static inline Int andnoti(Int a, Int b) { return ~a & b; }
+	static inline Int sub1(Int a) { return 1 - a; }
+	static inline Int cmplti(Int a, Int b) { return a < b ? -1 : 0; }
+	static inline Int cmpeqi(Int a, Int b) { return a == b ? -1 : 0; }
+	static inline Int cmpgtf(Float a, Float b) { return a > b ? -1 : 0; }
+	static inline Int cmpgef(Float a, Float b) { return a >= b ? -1 : 0; }
+	static inline Int bit(Int h, int32_t bit) { return (h & bit) ? -1 : 0; }
+	static inline Float select(Int mask, Float a, Float b) { return mask ? a : b; }
+	static inline Float negate(Int mask, Float v) { return mask ? -v : v; }
+	static inline Int gather(const int32_t* perm, Int idx) { return perm[idx]; }
+};
+
+void batchNoise2DScalar(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	batchNoise<ScalarOps, 2>(params, x, y, z, out, n);
+}
+
+void batchNoise3DScalar(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	batchNoise<ScalarOps, 3>(params, x, y, z, out, n);
+}
+
+#ifdef NOISE_SSE2
+struct SSE2Ops {
+	typedef __m128 Float;
+	typedef __m128i Int;
+	static constexpr int Width = 4;
+
+	static inline Float load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void store(float* p, Float v) { _mm_storeu_ps(p, v); }
+	static inline Float set(float v) { return _mm_set1_ps(v); }
+	static inline Int seti(int32_t v) { return _mm_set1_epi32(v); }
+	static inline Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static inline Float abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static inline Int floor(Float v) {
+		const Int t = _mm_cvttps_epi32(v);
+		const Int positive = _mm_castps_si128(_mm_cmpgt_ps(v, _mm_setzero_ps()));
+		return _mm_add_epi32(t, _mm_andnot_si128(positive, _mm_set1_epi32(-1)));
+	}
+	static inline Float tofloat(Int v) { return _mm_cvtepi32_ps(v); }
+	static inline Int addi(Int a, Int b) { return _mm_add_epi32(a, b); }
+	static inline Int andi(Int a, Int b) { return _mm_and_si128(a, b); }
+	static inline Int ori(Int a, Int b) { return _mm_or_si128(a, b); }
+	static inline Int andnoti(Int a, Int b) { return _mm_andnot_si128(a, b); }
+	static inline Int sub1(Int a) { return _mm_sub_epi32(_mm_set1_epi32(1), a); }
+	static inline Int cmplti(Int a, Int b) { return _mm_cmplt_epi32(a, b); }
+	static inline Int cmpeqi(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+	static inline Int cmpgtf(Float a, Float b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+	static inline Int cmpgef(Float a, Float b) { return _mm_castps_si128(_mm_cmpge_ps(a, b)); }
+	static inline Int bit(Int h, int32_t bit) {
+		const Int b = _mm_set1_epi32(bit);
+		return _mm_cmpeq_epi32(_mm_and_si128(h, b), b);
+	}
+	static inline Float select(Int mask, Float a, Float b) {
+		const Float m = _mm_castsi128_ps(mask);
+		return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+	}
+	static inline Float negate(Int mask, Float v) {
+		return _mm_xor_ps(v, _mm_and_ps(_mm_castsi128_ps(mask), _mm_set1_ps(-0.0f)));
+	}
+	static inline Int gather(const int32_t* perm, Int idx) {
+		alignas(16) int32_t i[4];
+		_mm_store_si128((Int*)i, idx);
+		return _mm_setr_epi32(perm[i[0]], perm[i[1]], perm[i[2]], perm[i[3]]);
+	}
+};
+
+void batchNoise2DSSE2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	batchNoise<SSE2Ops, 2>(params, x, y, z, out, n);
+}
+
+void batchNoise3DSSE2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	batchNoise<SSE2Ops, 3>(params, x, y, z, out, n);
+}
+#endif
+
+/**
+ * @brief The permutation table of @c Simplex.h widened to 32 bit - which allows to use it for the gather instructions
+ */
+static const int32_t* permTable() {
+	static const struct PermTable {
+		int32_t values[512];
+		PermTable() {
+			for (int i = 0; i < 512; ++i) {
+				values[i] = perm[i];
+			}
+		}
+	} table;
+	return table.values;
+}
+
+static SimdLevel detect() {
+#ifdef NOISE_AVX2
+	if (SDL_HasAVX2()) {
+		return SimdLevel::AVX2;
+	}
+#endif
+#ifdef NOISE_SSE2
+	if (SDL_HasSSE2()) {
+		return SimdLevel::SSE2;
+	}
+#endif
+	return SimdLevel::Scalar;
+}
+
+static core::AtomicInt& activeLevel() {
+	static core::AtomicInt level((int)detectSimdLevel());
+	return level;
+}
+
+static BatchKernel kernel(int dims) {
+	switch ((SimdLevel)(int)activeLevel()) {
+#ifdef NOISE_AVX2
+	case SimdLevel::AVX2:
+		return dims == 2 ? batchNoise2DAVX2 : batchNoise3DAVX2;
+#endif
+#ifdef NOISE_SSE2
+	case SimdLevel::SSE2:
+		return dims == 2 ? batchNoise2DSSE2 : batchNoise3DSSE2;
+#endif
+	default:
+		break;
+	}
+	return dims == 2 ? batchNoise2DScalar : batchNoise3DScalar;
+}
+
+static BatchParams params(BatchNoiseType type, uint8_t octaves = 1, float lacunarity = 2.0f, float gain = 0.5f, float ridgeOffset = 1.0f) {
+	BatchParams p;
+	p.type = type;
+	p.octaves = octaves;
+	p.lacunarity = lacunarity;
+	p.gain = gain;
+	p.ridgeOffset = ridgeOffset;
+	p.perm = permTable();
+	return p;
+}
+
+static void evaluate(const BatchParams& p, const float* x, const float* y, float* out, size_t n) {
+	core_trace_scoped(BatchNoise2D);
+	kernel(2)(p, x, y, nullptr, out, n);
+}
+
+static void evaluate(const BatchParams& p, const float* x, const float* y, const float* z, float* out, size_t n) {
+	core_trace_scoped(BatchNoise3D);
+	kernel(3)(p, x, y, z, out, n);
+}
+
+/**
+ * @brief The amount of grid positions that are evaluated with one kernel call
+ */
+static constexpr int GridBlockSize = 256;
+
+static void evaluateGrid(const BatchParams& p, const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out) {
+	core_assert_msg(size.x >= 0 && size.y >= 0, "Invalid grid size %i:%i", size.x, size.y);
+	float xs[GridBlockSize];
+	float ys[GridBlockSize];
+	for (int y = 0; y < size.y; ++y) {
+		const float py = origin.y + (float)y * step.y;
+		for (int x = 0; x < size.x; x += GridBlockSize) {
+			const int n = core_min(GridBlockSize, size.x - x);
+			for (int i = 0; i < n; ++i) {
+				xs[i] = origin.x + (float)(x + i) * step.x;
+				ys[i] = py;
+			}
+			evaluate(p, xs, ys, out, n);
+			out += n;
+		}
+	}
+}
+
+static void evaluateGrid(const BatchParams& p, const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out) {
+	core_assert_msg(size.x >= 0 && size.y >= 0 && size.z >= 0, "Invalid grid size %i:%i:%i", size.x, size.y, size.z);
+	float xs[GridBlockSize];
+	float ys[GridBlockSize];
+	float zs[GridBlockSize];
+	for (int z = 0; z < size.z; ++z) {
+		const float pz = origin.z + (float)z * step.z;
+		for (int y = 0; y < size.y; ++y) {
+			const float py = origin.y + (float)y * step.y;
+			for (int x = 0; x < size.x; x += GridBlockSize) {
+				const int n = core_min(GridBlockSize, size.x - x);
+				for (int i = 0; i < n; ++i) {
+					xs[i] = origin.x + (float)(x + i) * step.x;
+					ys[i] = py;
+					zs[i] = pz;
+				}
+				evaluate(p, xs, ys, zs, out, n);
+				out += n;
+			}
+		}
+	}
+}
+
+}
+
+const char* simdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::Scalar:
+		return "scalar";
+	case SimdLevel::SSE2:
+		return "sse2";
+	case SimdLevel::AVX2:
+		return "avx2";
+	case SimdLevel::Max:
+		break;
+	}
+	return "unknown";
+}
+
+SimdLevel detectSimdLevel() {
+	static const SimdLevel level = details::detect();
+	return level;
+}
+
+SimdLevel simdLevel() {
+	return (SimdLevel)(int)details::activeLevel();
+}
+
+SimdLevel setSimdLevel(SimdLevel level) {
+	const SimdLevel detected = detectSimdLevel();
+	if (level > detected) {
+		level = detected;
+	}
+	details::activeLevel() = (int)level;
+	return level;
+}
+
+void noise(const float* x, const float* y, float* out, size_t n) {
+	details::evaluate(details::params(details::BatchNoiseType::Simplex), x, y, out, n);
+}
+
+void noise(const float* x, const float* y, const float* z, float* out, size_t n) {
+	details::evaluate(details::params(details::BatchNoiseType::Simplex), x, y, z, out, n);
+}
+
+void fBm(const float* x, const float* y, float* out, size_t n, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluate(details::params(details::BatchNoiseType::FBm, octaves, lacunarity, gain), x, y, out, n);
+}
+
+void fBm(const float* x, const float* y, const float* z, float* out, size_t n, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluate(details::params(details::BatchNoiseType::FBm, octaves, lacunarity, gain), x, y, z, out, n);
+}
+
+void ridgedMF(const float* x, const float* y, float* out, size_t n, float ridgeOffset, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluate(details::params(details::BatchNoiseType::RidgedMF, octaves, lacunarity, gain, ridgeOffset), x, y, out, n);
+}
+
+void ridgedMF(const float* x, const float* y, const float* z, float* out, size_t n, float ridgeOffset, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluate(details::params(details::BatchNoiseType::RidgedMF, octaves, lacunarity, gain, ridgeOffset), x, y, z, out, n);
+}
+
+void noiseGrid(const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out) {
+	details::evaluateGrid(details::params(details::BatchNoiseType::Simplex), origin, step, size, out);
+}
+
+void noiseGrid(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out) {
+	details::evaluateGrid(details::params(details::BatchNoiseType::Simplex), origin, step, size, out);
+}
+
+void fBmGrid(const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluateGrid(details::params(details::BatchNoiseType::FBm, octaves, lacunarity, gain), origin, step, size, out);
+}
+
+void fBmGrid(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluateGrid(details::params(details::BatchNoiseType::FBm, octaves, lacunarity, gain), origin, step, size, out);
+}
+
+void ridgedMFGrid(const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out, float ridgeOffset, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluateGrid(details::params(details::BatchNoiseType::RidgedMF, octaves, lacunarity, gain, ridgeOffset), origin, step, size, out);
+}
+
+void ridgedMFGrid(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out, float ridgeOffset, uint8_t octaves, float lacunarity, float gain) {
+	details::evaluateGrid(details::params(details::BatchNoiseType::RidgedMF, octaves, lacunarity, gain, ridgeOffset), origin, step, size, out);
+}
+
+}
@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Batched simplex noise functions that evaluate whole arrays or grids of positions per call
+ */
+
+#pragma once
+
+#include <glm/fwd.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace noise {
+
+/**
+ * @brief The instruction sets the batched noise functions can use
+ */
+enum class SimdLevel : uint8_t {
+	Scalar,
+	SSE2,
+	AVX2,
+
+	Max
+};
+
+const char* simdLevelName(SimdLevel level);
+
+/**
+ * @return The best @c SimdLevel that is supported by the compiler and the cpu
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @return The @c SimdLevel that is used by the batched noise functions
+ */
+SimdLevel simdLevel();
+
+/**
+ * @brief Overrides the @c SimdLevel that is used by the batched noise functions - this is mainly useful
+ * for tests and benchmarks.
+ * @note The level is clamped to the one returned by @c detectSimdLevel()
+ * @return The level that is used now
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+/**
+ * The batched functions are the counterparts of the functions with the same name in @c Simplex.h.
+ * The positions are given as separate coordinate arrays with @c n elements each.
+ *
+ * All @c SimdLevel implementations produce bit identical results - independent of the batch size or the
+ * position of a value in the batch. This is needed to keep generated worlds deterministic for a seed on
+ * all machines. The values differ from the scalar functions in @c Simplex.h by a small epsilon only,
+ * because the skew factors are applied in single instead of double precision.
+ *
+ * @note The default permutation table is used - @c noise::seed() doesn't have any effect here.
+ */
+void noise(const float* x, const float* y, float* out, size_t n);
+void noise(const float* x, const float* y, const float* z, float* out, size_t n);
+
+void fBm(const float* x, const float* y, float* out, size_t n, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+void fBm(const float* x, const float* y, const float* z, float* out, size_t n, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+
+void ridgedMF(const float* x, const float* y, float* out, size_t n, float ridgeOffset = 1.0f, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+void ridgedMF(const float* x, const float* y, const float* z, float* out, size_t n, float ridgeOffset = 1.0f, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+
+/**
+ * The grid functions evaluate the noise at @code origin + step * index @endcode for all indices in @c size.
+ * The values are stored in x, then y (then z) order - @c out must have room for all of them.
+ */
+void noiseGrid(const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out);
+void noiseGrid(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out);
+
+void fBmGrid(const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+void fBmGrid(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+
+void ridgedMFGrid(const glm::vec2& origin, const glm::vec2& step, const glm::ivec2& size, float* out, float ridgeOffset = 1.0f, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+void ridgedMFGrid(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& size, float* out, float ridgeOffset = 1.0f, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+
+}
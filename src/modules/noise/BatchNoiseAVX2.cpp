@@ -0,0 +1,63 @@
+/**
+ * @file
+ * @brief AVX2 implementation of the batched noise functions - this translation unit is compiled with the AVX2
+ * instruction set enabled and may only be called if the cpu supports it.
+ * @note Don't include any headers with inline functions in here - the linker could pick the AVX2 version of them
+ * for the other translation units, too.
+ */
+
+#include "BatchNoiseKernel.h"
+#include <immintrin.h>
+
+namespace noise {
+namespace details {
+
+struct AVX2Ops {
+	typedef __m256 Float;
+	typedef __m256i Int;
+	static constexpr int Width = 8;
+
+	static inline Float load(const float* p) { return _mm256_loadu_ps(p); }
+	static inline void store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+	static inline Float set(float v) { return _mm256_set1_ps(v); }
+	static inline Int seti(int32_t v) { return _mm256_set1_epi32(v); }
+	static inline Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static inline Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static inline Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static inline Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static inline Int floor(Float v) {
+		const Int t = _mm256_cvttps_epi32(v);
+		const Int positive = _mm256_castps_si256(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ));
+		return _mm256_add_epi32(t, _mm256_andnot_si256(positive, _mm256_set1_epi32(-1)));
+	}
+	static inline Float tofloat(Int v) { return _mm256_cvtepi32_ps(v); }
+	static inline Int addi(Int a, Int b) { return _mm256_add_epi32(a, b); }
+	static inline Int andi(Int a, Int b) { return _mm256_and_si256(a, b); }
+	static inline Int ori(Int a, Int b) { return _mm256_or_si256(a, b); }
+	static inline Int andnoti(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+	static inline Int sub1(Int a) { return _mm256_sub_epi32(_mm256_set1_epi32(1), a); }
+	static inline Int cmplti(Int a, Int b) { return _mm256_cmpgt_epi32(b, a); }
+	static inline Int cmpeqi(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+	static inline Int cmpgtf(Float a, Float b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+	static inline Int cmpgef(Float a, Float b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GE_OQ)); }
+	static inline Int bit(Int h, int32_t bit) {
+		const Int b = _mm256_set1_epi32(bit);
+		return _mm256_cmpeq_epi32(_mm256_and_si256(h, b), b);
+	}
+	static inline Float select(Int mask, Float a, Float b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+	static inline Float negate(Int mask, Float v) {
+		return _mm256_xor_ps(v, _mm256_and_ps(_mm256_castsi256_ps(mask), _mm256_set1_ps(-0.0f)));
+	}
+	static inline Int gather(const int32_t* perm, Int idx) { return _mm256_i32gather_epi32((const int*)perm, idx, 4); }
+};
+
+void batchNoise2DAVX2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	batchNoise<AVX2Ops, 2>(params, x, y, z, out, n);
+}
+
+void batchNoise3DAVX2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	batchNoise<AVX2Ops, 3>(params, x, y, z, out, n);
+}
+
+}
+}
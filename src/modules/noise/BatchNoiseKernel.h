@@ -0,0 +1,246 @@
+/**
+ * @file
+ * @brief Internal header for the batched noise functions - the simplex noise algorithm is implemented once on top
+ * of a set of vector operations that are provided by the instruction set specific traits.
+ *
+ * All operations are done in single precision and in the same order for all traits - this is what makes the
+ * results bit identical for all @c SimdLevel values. Only templates are allowed in here, because this header is
+ * included in translation units that are compiled with different instruction set flags.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace noise {
+namespace details {
+
+enum class BatchNoiseType : uint8_t {
+	Simplex,
+	FBm,
+	RidgedMF
+};
+
+struct BatchParams {
+	BatchNoiseType type = BatchNoiseType::Simplex;
+	uint8_t octaves = 4;
+	float lacunarity = 2.0f;
+	float gain = 0.5f;
+	float ridgeOffset = 1.0f;
+	/**
+	 * @brief The permutation table with 512 entries
+	 */
+	const int32_t* perm = nullptr;
+};
+
+/**
+ * @brief Evaluates the noise for @c n positions - @c z is ignored for 2D noise
+ */
+typedef void (*BatchKernel)(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+
+extern void batchNoise2DScalar(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+extern void batchNoise3DScalar(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+extern void batchNoise2DSSE2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+extern void batchNoise3DSSE2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+extern void batchNoise2DAVX2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+extern void batchNoise3DAVX2(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n);
+
+// the skew factors of Simplex.h in single precision
+static constexpr float BatchF2 = 0.366025403f;
+static constexpr float BatchG2 = 0.211324865f;
+static constexpr float BatchF3 = 0.333333333f;
+static constexpr float BatchG3 = 0.166666667f;
+
+template<class S>
+inline typename S::Float batchGrad2(typename S::Int hash, typename S::Float x, typename S::Float y) {
+	const typename S::Int h = S::andi(hash, S::seti(7));
+	const typename S::Int lower = S::cmplti(h, S::seti(4));
+	const typename S::Float u = S::select(lower, x, y);
+	const typename S::Float v = S::select(lower, y, x);
+	const typename S::Float v2 = S::mul(v, S::set(2.0f));
+	return S::add(S::negate(S::bit(h, 1), u), S::negate(S::bit(h, 2), v2));
+}
+
+template<class S>
+inline typename S::Float batchGrad3(typename S::Int hash, typename S::Float x, typename S::Float y, typename S::Float z) {
+	const typename S::Int h = S::andi(hash, S::seti(15));
+	const typename S::Float u = S::select(S::cmplti(h, S::seti(8)), x, y);
+	// fix repeats at h = 12 to 15
+	const typename S::Int repeat = S::ori(S::cmpeqi(h, S::seti(12)), S::cmpeqi(h, S::seti(14)));
+	const typename S::Float v = S::select(S::cmplti(h, S::seti(4)), y, S::select(repeat, x, z));
+	return S::add(S::negate(S::bit(h, 1), u), S::negate(S::bit(h, 2), v));
+}
+
+/**
+ * @brief The contribution of one simplex corner - zero if the corner is too far away
+ */
+template<class S>
+inline typename S::Float batchCorner(typename S::Float t, typename S::Float grad) {
+	const typename S::Float t2 = S::mul(t, t);
+	const typename S::Float n = S::mul(S::mul(t2, t2), grad);
+	return S::select(S::cmpgef(t, S::set(0.0f)), n, S::set(0.0f));
+}
+
+template<class S>
+typename S::Float batchSimplex2(const int32_t* perm, typename S::Float x, typename S::Float y) {
+	typedef typename S::Float Float;
+	typedef typename S::Int Int;
+
+	// skew the input space to determine which simplex cell we're in
+	const Float s = S::mul(S::add(x, y), S::set(BatchF2));
+	const Int i = S::floor(S::add(x, s));
+	const Int j = S::floor(S::add(y, s));
+
+	const Float t = S::mul(S::tofloat(S::addi(i, j)), S::set(BatchG2));
+	const Float x0 = S::sub(x, S::sub(S::tofloat(i), t));
+	const Float y0 = S::sub(y, S::sub(S::tofloat(j), t));
+
+	// lower triangle (x0 > y0): (0,0)->(1,0)->(1,1), upper triangle: (0,0)->(0,1)->(1,1)
+	const Int lower = S::cmpgtf(x0, y0);
+	const Int i1 = S::andi(lower, S::seti(1));
+	const Int j1 = S::sub1(i1);
+
+	const Float x1 = S::add(S::sub(x0, S::tofloat(i1)), S::set(BatchG2));
+	const Float y1 = S::add(S::sub(y0, S::tofloat(j1)), S::set(BatchG2));
+	const Float x2 = S::add(S::sub(x0, S::set(1.0f)), S::set(2.0f * BatchG2));
+	const Float y2 = S::add(S::sub(y0, S::set(1.0f)), S::set(2.0f * BatchG2));
+
+	const Int ii = S::andi(i, S::seti(0xff));
+	const Int jj = S::andi(j, S::seti(0xff));
+	const Int one = S::seti(1);
+	const Int gi0 = S::gather(perm, S::addi(ii, S::gather(perm, jj)));
+	const Int gi1 = S::gather(perm, S::addi(S::addi(ii, i1), S::gather(perm, S::addi(jj, j1))));
+	const Int gi2 = S::gather(perm, S::addi(S::addi(ii, one), S::gather(perm, S::addi(jj, one))));
+
+	const Float half = S::set(0.5f);
+	const Float n0 = batchCorner<S>(S::sub(S::sub(half, S::mul(x0, x0)), S::mul(y0, y0)), batchGrad2<S>(gi0, x0, y0));
+	const Float n1 = batchCorner<S>(S::sub(S::sub(half, S::mul(x1, x1)), S::mul(y1, y1)), batchGrad2<S>(gi1, x1, y1));
+	const Float n2 = batchCorner<S>(S::sub(S::sub(half, S::mul(x2, x2)), S::mul(y2, y2)), batchGrad2<S>(gi2, x2, y2));
+	return S::mul(S::set(40.0f), S::add(S::add(n0, n1), n2));
+}
+
+template<class S>
+typename S::Float batchSimplex3(const int32_t* perm, typename S::Float x, typename S::Float y, typename S::Float z) {
+	typedef typename S::Float Float;
+	typedef typename S::Int Int;
+
+	// skew the input space to determine which simplex cell we're in
+	const Float s = S::mul(S::add(S::add(x, y), z), S::set(BatchF3));
+	const Int i = S::floor(S::add(x, s));
+	const Int j = S::floor(S::add(y, s));
+	const Int k = S::floor(S::add(z, s));
+
+	const Float t = S::mul(S::tofloat(S::addi(S::addi(i, j), k)), S::set(BatchG3));
+	const Float x0 = S::sub(x, S::sub(S::tofloat(i), t));
+	const Float y0 = S::sub(y, S::sub(S::tofloat(j), t));
+	const Float z0 = S::sub(z, S::sub(S::tofloat(k), t));
+
+	// the branchless version of the corner order selection in noise::noise(const glm::vec3&)
+	const Int xy = S::cmpgef(x0, y0);
+	const Int yz = S::cmpgef(y0, z0);
+	const Int xz = S::cmpgef(x0, z0);
+	const Int one = S::seti(1);
+	const Int i1 = S::andi(S::andi(xy, xz), one);
+	const Int j1 = S::andi(S::andnoti(xy, yz), one);
+	const Int k1 = S::andnoti(S::ori(xz, yz), one);
+	const Int i2 = S::andi(S::ori(xy, xz), one);
+	const Int j2 = S::sub1(S::andi(S::andnoti(yz, xy), one));
+	const Int k2 = S::sub1(S::andi(S::andi(yz, xz), one));
+
+	const Float x1 = S::add(S::sub(x0, S::tofloat(i1)), S::set(BatchG3));
+	const Float y1 = S::add(S::sub(y0, S::tofloat(j1)), S::set(BatchG3));
+	const Float z1 = S::add(S::sub(z0, S::tofloat(k1)), S::set(BatchG3));
+	const Float x2 = S::add(S::sub(x0, S::tofloat(i2)), S::set(2.0f * BatchG3));
+	const Float y2 = S::add(S::sub(y0, S::tofloat(j2)), S::set(2.0f * BatchG3));
+	const Float z2 = S::add(S::sub(z0, S::tofloat(k2)), S::set(2.0f * BatchG3));
+	const Float x3 = S::add(S::sub(x0, S::set(1.0f)), S::set(3.0f * BatchG3));
+	const Float y3 = S::add(S::sub(y0, S::set(1.0f)), S::set(3.0f * BatchG3));
+	const Float z3 = S::add(S::sub(z0, S::set(1.0f)), S::set(3.0f * BatchG3));
+
+	const Int ii = S::andi(i, S::seti(0xff));
+	const Int jj = S::andi(j, S::seti(0xff));
+	const Int kk = S::andi(k, S::seti(0xff));
+	const Int gi0 = S::gather(perm, S::addi(ii, S::gather(perm, S::addi(jj, S::gather(perm, kk)))));
+	const Int gi1 = S::gather(perm, S::addi(S::addi(ii, i1), S::gather(perm, S::addi(S::addi(jj, j1), S::gather(perm, S::addi(kk, k1))))));
+	const Int gi2 = S::gather(perm, S::addi(S::addi(ii, i2), S::gather(perm, S::addi(S::addi(jj, j2), S::gather(perm, S::addi(kk, k2))))));
+	const Int gi3 = S::gather(perm, S::addi(S::addi(ii, one), S::gather(perm, S::addi(S::addi(jj, one), S::gather(perm, S::addi(kk, one))))));
+
+	const Float r = S::set(0.6f);
+	const Float n0 = batchCorner<S>(S::sub(S::sub(S::sub(r, S::mul(x0, x0)), S::mul(y0, y0)), S::mul(z0, z0)), batchGrad3<S>(gi0, x0, y0, z0));
+	const Float n1 = batchCorner<S>(S::sub(S::sub(S::sub(r, S::mul(x1, x1)), S::mul(y1, y1)), S::mul(z1, z1)), batchGrad3<S>(gi1, x1, y1, z1));
+	const Float n2 = batchCorner<S>(S::sub(S::sub(S::sub(r, S::mul(x2, x2)), S::mul(y2, y2)), S::mul(z2, z2)), batchGrad3<S>(gi2, x2, y2, z2));
+	const Float n3 = batchCorner<S>(S::sub(S::sub(S::sub(r, S::mul(x3, x3)), S::mul(y3, y3)), S::mul(z3, z3)), batchGrad3<S>(gi3, x3, y3, z3));
+	return S::mul(S::set(32.0f), S::add(S::add(S::add(n0, n1), n2), n3));
+}
+
+template<class S, int Dims>
+inline typename S::Float batchSimplex(const int32_t* perm, typename S::Float x, typename S::Float y, typename S::Float z) {
+	if (Dims == 2) {
+		return batchSimplex2<S>(perm, x, y);
+	}
+	return batchSimplex3<S>(perm, x, y, z);
+}
+
+template<class S, int Dims>
+typename S::Float batchEvaluate(const BatchParams& params, typename S::Float x, typename S::Float y, typename S::Float z) {
+	typedef typename S::Float Float;
+	if (params.type == BatchNoiseType::Simplex) {
+		return batchSimplex<S, Dims>(params.perm, x, y, z);
+	}
+	Float sum = S::set(0.0f);
+	Float prev = S::set(1.0f);
+	float freq = 1.0f;
+	float amp = 0.5f;
+	for (uint8_t i = 0; i < params.octaves; ++i) {
+		const Float f = S::set(freq);
+		const Float n = batchSimplex<S, Dims>(params.perm, S::mul(x, f), S::mul(y, f), S::mul(z, f));
+		if (params.type == BatchNoiseType::FBm) {
+			sum = S::add(sum, S::mul(n, S::set(amp)));
+		} else {
+			const Float h = S::sub(S::set(params.ridgeOffset), S::abs(n));
+			const Float ridge = S::mul(h, h);
+			sum = S::add(sum, S::mul(S::mul(ridge, S::set(amp)), prev));
+			prev = ridge;
+		}
+		freq *= params.lacunarity;
+		amp *= params.gain;
+	}
+	if (params.type == BatchNoiseType::FBm) {
+		return sum;
+	}
+	return S::sub(S::mul(sum, S::set(2.0f)), S::set(0.5f));
+}
+
+/**
+ * @brief Processes the positions in blocks of @c S::Width - the last incomplete block is padded, which
+ * makes the values independent of the position in the batch.
+ */
+template<class S, int Dims>
+void batchNoise(const BatchParams& params, const float* x, const float* y, const float* z, float* out, size_t n) {
+	const size_t width = (size_t)S::Width;
+	size_t i = 0u;
+	for (; i + width <= n; i += width) {
+		const typename S::Float vz = Dims == 3 ? S::load(z + i) : S::set(0.0f);
+		S::store(out + i, batchEvaluate<S, Dims>(params, S::load(x + i), S::load(y + i), vz));
+	}
+	if (i == n) {
+		return;
+	}
+	float px[S::Width] = {}, py[S::Width] = {}, pz[S::Width] = {}, po[S::Width];
+	const size_t remaining = n - i;
+	for (size_t j = 0u; j < remaining; ++j) {
+		px[j] = x[i + j];
+		py[j] = y[i + j];
+		if (Dims == 3) {
+			pz[j] = z[i + j];
+		}
+	}
+	S::store(po, batchEvaluate<S, Dims>(params, S::load(px), S::load(py), S::load(pz)));
+	for (size_t j = 0u; j < remaining; ++j) {
+		out[i + j] = po[j];
+	}
+}
+
+}
+}
@@ -0,0 +1,136 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "noise/BatchNoise.h"
+#include "noise/Simplex.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+/**
+ * @brief The first argument is the amount of dimensions, the second one the @c noise::SimdLevel - or @c -1 for
+ * calling the scalar functions of @c Simplex.h for every point.
+ */
+class BatchNoiseBenchmark : public app::AbstractBenchmark {
+protected:
+	static constexpr int Size2D = 256;
+	static constexpr int Size3D = 32;
+	static constexpr uint8_t Octaves = 4;
+	std::vector<float> _out;
+
+public:
+	void SetUp(benchmark::State& state) override {
+		app::AbstractBenchmark::SetUp(state);
+		_out.resize((size_t)Size2D * Size2D);
+	}
+
+	bool setLevel(benchmark::State& state) {
+		const int level = (int)state.range(1);
+		if (level < 0) {
+			state.SetLabel("simplex.h");
+			return true;
+		}
+		if (noise::setSimdLevel((noise::SimdLevel)level) != (noise::SimdLevel)level) {
+			state.SkipWithError("Simd level is not supported");
+			return false;
+		}
+		state.SetLabel(noise::simdLevelName((noise::SimdLevel)level));
+		return true;
+	}
+
+	void TearDown(benchmark::State& state) override {
+		noise::setSimdLevel(noise::detectSimdLevel());
+		app::AbstractBenchmark::TearDown(state);
+	}
+};
+
+BENCHMARK_DEFINE_F(BatchNoiseBenchmark, fBm)(benchmark::State& state) {
+	if (!setLevel(state)) {
+		return;
+	}
+	const bool batched = state.range(1) >= 0;
+	const float frequency = 0.01f;
+	size_t points = 0u;
+	if (state.range(0) == 2) {
+		const glm::ivec2 size(Size2D);
+		for (auto _ : state) {
+			if (batched) {
+				noise::fBmGrid(glm::vec2(0.0f), glm::vec2(frequency), size, _out.data(), Octaves);
+			} else {
+				float* out = _out.data();
+				for (int y = 0; y < size.y; ++y) {
+					for (int x = 0; x < size.x; ++x) {
+						*out++ = noise::fBm(glm::vec2((float)x, (float)y) * frequency, Octaves);
+					}
+				}
+			}
+			benchmark::DoNotOptimize(_out.data());
+			points += (size_t)size.x * size.y;
+		}
+	} else {
+		const glm::ivec3 size(Size3D);
+		for (auto _ : state) {
+			if (batched) {
+				noise::fBmGrid(glm::vec3(0.0f), glm::vec3(frequency), size, _out.data(), Octaves);
+			} else {
+				float* out = _out.data();
+				for (int z = 0; z < size.z; ++z) {
+					for (int y = 0; y < size.y; ++y) {
+						for (int x = 0; x < size.x; ++x) {
+							*out++ = noise::fBm(glm::vec3((float)x, (float)y, (float)z) * frequency, Octaves);
+						}
+					}
+				}
+			}
+			benchmark::DoNotOptimize(_out.data());
+			points += (size_t)size.x * size.y * size.z;
+		}
+	}
+	state.SetItemsProcessed((int64_t)points);
+}
+
+BENCHMARK_DEFINE_F(BatchNoiseBenchmark, ridgedMF)(benchmark::State& state) {
+	if (!setLevel(state)) {
+		return;
+	}
+	const bool batched = state.range(1) >= 0;
+	const float frequency = 0.01f;
+	const glm::ivec2 size(Size2D);
+	size_t points = 0u;
+	for (auto _ : state) {
+		if (batched) {
+			noise::ridgedMFGrid(glm::vec2(0.0f), glm::vec2(frequency), size, _out.data(), 1.0f, Octaves);
+		} else {
+			float* out = _out.data();
+			for (int y = 0; y < size.y; ++y) {
+				for (int x = 0; x < size.x; ++x) {
+					*out++ = noise::ridgedMF(glm::vec2((float)x, (float)y) * frequency, 1.0f, Octaves);
+				}
+			}
+		}
+		benchmark::DoNotOptimize(_out.data());
+		points += (size_t)size.x * size.y;
+	}
+	state.SetItemsProcessed((int64_t)points);
+}
+
+static void LevelArguments(benchmark::internal::Benchmark* b) {
+	for (int dims : {2, 3}) {
+		for (int level = -1; level < (int)noise::SimdLevel::Max; ++level) {
+			b->Args({dims, level});
+		}
+	}
+}
+
+static void LevelArguments2D(benchmark::internal::Benchmark* b) {
+	for (int level = -1; level < (int)noise::SimdLevel::Max; ++level) {
+		b->Args({2, level});
+	}
+}
+
+BENCHMARK_REGISTER_F(BatchNoiseBenchmark, fBm)->Apply(LevelArguments)->Unit(benchmark::kMicrosecond);
+BENCHMARK_REGISTER_F(BatchNoiseBenchmark, ridgedMF)->Apply(LevelArguments2D)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,147 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "noise/BatchNoise.h"
+#include "noise/Simplex.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace noise {
+
+class BatchNoiseTest: public app::AbstractTest {
+protected:
+	// not a multiple of any simd width to also test the padding of the last block
+	static constexpr size_t Count = 1001;
+	std::vector<float> _x, _y, _z;
+
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		_x.resize(Count);
+		_y.resize(Count);
+		_z.resize(Count);
+		uint32_t state = 1337u;
+		auto next = [&state] () {
+			state = state * 1664525u + 1013904223u;
+			return (float)(state >> 8) / (float)(1u << 24);
+		};
+		for (size_t i = 0u; i < Count; ++i) {
+			_x[i] = next() * 200.0f - 100.0f;
+			_y[i] = next() * 200.0f - 100.0f;
+			_z[i] = next() * 200.0f - 100.0f;
+		}
+	}
+
+	void TearDown() override {
+		setSimdLevel(detectSimdLevel());
+		app::AbstractTest::TearDown();
+	}
+
+	/**
+	 * @brief Evaluates the batched noise with all supported simd levels
+	 */
+	template<class FUNC>
+	std::vector<std::vector<float>> evaluate(FUNC&& func) const {
+		std::vector<std::vector<float>> results;
+		for (int level = 0; level <= (int)detectSimdLevel(); ++level) {
+			EXPECT_EQ((SimdLevel)level, setSimdLevel((SimdLevel)level));
+			std::vector<float> out(Count);
+			func(out.data());
+			results.push_back(out);
+		}
+		return results;
+	}
+};
+
+TEST_F(BatchNoiseTest, testMatchesScalarNoise2D) {
+	for (const std::vector<float>& out : evaluate([&] (float* out) { noise(_x.data(), _y.data(), out, Count); })) {
+		for (size_t i = 0u; i < Count; ++i) {
+			ASSERT_NEAR(noise(glm::vec2(_x[i], _y[i])), out[i], 0.0001f) << "index " << i;
+		}
+	}
+}
+
+TEST_F(BatchNoiseTest, testMatchesScalarNoise3D) {
+	for (const std::vector<float>& out : evaluate([&] (float* out) { noise(_x.data(), _y.data(), _z.data(), out, Count); })) {
+		for (size_t i = 0u; i < Count; ++i) {
+			ASSERT_NEAR(noise(glm::vec3(_x[i], _y[i], _z[i])), out[i], 0.0001f) << "index " << i;
+		}
+	}
+}
+
+TEST_F(BatchNoiseTest, testMatchesScalarFBm) {
+	for (const std::vector<float>& out : evaluate([&] (float* out) { fBm(_x.data(), _y.data(), out, Count, 5, 2.1f, 0.6f); })) {
+		for (size_t i = 0u; i < Count; ++i) {
+			ASSERT_NEAR(fBm(glm::vec2(_x[i], _y[i]), 5, 2.1f, 0.6f), out[i], 0.0001f) << "index " << i;
+		}
+	}
+	for (const std::vector<float>& out : evaluate([&] (float* out) { fBm(_x.data(), _y.data(), _z.data(), out, Count, 3); })) {
+		for (size_t i = 0u; i < Count; ++i) {
+			ASSERT_NEAR(fBm(glm::vec3(_x[i], _y[i], _z[i]), 3), out[i], 0.0001f) << "index " << i;
+		}
+	}
+}
+
+// the ridges amplify the precision differences of the higher octaves
+TEST_F(BatchNoiseTest, testMatchesScalarRidgedMF) {
+	for (const std::vector<float>& out : evaluate([&] (float* out) { ridgedMF(_x.data(), _y.data(), out, Count, 0.8f, 4); })) {
+		for (size_t i = 0u; i < Count; ++i) {
+			ASSERT_NEAR(ridgedMF(glm::vec2(_x[i], _y[i]), 0.8f, 4), out[i], 0.001f) << "index " << i;
+		}
+	}
+	for (const std::vector<float>& out : evaluate([&] (float* out) { ridgedMF(_x.data(), _y.data(), _z.data(), out, Count); })) {
+		for (size_t i = 0u; i < Count; ++i) {
+			ASSERT_NEAR(ridgedMF(glm::vec3(_x[i], _y[i], _z[i])), out[i], 0.001f) << "index " << i;
+		}
+	}
+}
+
+TEST_F(BatchNoiseTest, testSimdLevelsAreBitIdentical) {
+	const std::vector<std::vector<float>>& results2d = evaluate([&] (float* out) { fBm(_x.data(), _y.data(), out, Count); });
+	const std::vector<std::vector<float>>& results3d = evaluate([&] (float* out) { ridgedMF(_x.data(), _y.data(), _z.data(), out, Count); });
+	for (size_t level = 1u; level < results2d.size(); ++level) {
+		EXPECT_EQ(results2d[0], results2d[level]) << simdLevelName((SimdLevel)level);
+		EXPECT_EQ(results3d[0], results3d[level]) << simdLevelName((SimdLevel)level);
+	}
+}
+
+TEST_F(BatchNoiseTest, testIndependentOfTheBatchSize) {
+	std::vector<float> batch(Count);
+	fBm(_x.data(), _y.data(), _z.data(), batch.data(), Count);
+	for (size_t i = 0u; i < Count; ++i) {
+		float single;
+		fBm(&_x[i], &_y[i], &_z[i], &single, 1);
+		ASSERT_EQ(batch[i], single) << "index " << i;
+	}
+}
+
+TEST_F(BatchNoiseTest, testGrid) {
+	const glm::vec3 origin(-10.0f, 3.0f, 7.5f);
+	const glm::vec3 step(0.25f, 0.5f, 1.0f);
+	const glm::ivec3 size(300, 3, 2);
+	std::vector<float> grid((size_t)size.x * size.y * size.z);
+	fBmGrid(origin, step, size, grid.data());
+	std::vector<float> grid2d((size_t)size.x * size.y);
+	noiseGrid(glm::vec2(origin), glm::vec2(step), glm::ivec2(size), grid2d.data());
+	size_t i = 0u;
+	for (int z = 0; z < size.z; ++z) {
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x, ++i) {
+				const float px = origin.x + (float)x * step.x;
+				const float py = origin.y + (float)y * step.y;
+				const float pz = origin.z + (float)z * step.z;
+				float expected;
+				fBm(&px, &py, &pz, &expected, 1);
+				ASSERT_EQ(expected, grid[i]) << x << ":" << y << ":" << z;
+				if (z == 0) {
+					noise(&px, &py, &expected, 1);
+					ASSERT_EQ(expected, grid2d[i]) << x << ":" << y;
+				}
+			}
+		}
+	}
+}
+
+}
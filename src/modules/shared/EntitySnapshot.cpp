@@ -0,0 +1,205 @@
+/**
+ * @file
+ */
+
+#include "EntitySnapshot.h"
+#include "core/Assert.h"
+#include <glm/common.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+
+namespace shared {
+
+namespace {
+// 0 is used for "no baseline" - sequences are compared with the wrap around in mind
+inline bool newerSequence(uint32_t sequence, uint32_t other) {
+	return (int32_t)(sequence - other) > 0;
+}
+
+inline bool hasFlag(network::EntityDeltaFlags flags, network::EntityDeltaFlags flag) {
+	return (flags & flag) == flag;
+}
+}
+
+glm::ivec3 quantizePosition(const glm::vec3& pos) {
+	return glm::ivec3(glm::round(pos * PositionScale));
+}
+
+glm::vec3 dequantizePosition(const glm::ivec3& pos) {
+	return glm::vec3(pos) / PositionScale;
+}
+
+uint16_t quantizeOrientation(float orientation) {
+	const float turns = orientation / glm::two_pi<float>();
+	const float fraction = turns - glm::floor(turns);
+	return (uint16_t)((uint32_t)glm::round(fraction * 65536.0f) & 0xFFFFu);
+}
+
+float dequantizeOrientation(uint16_t orientation) {
+	return (float)orientation / 65536.0f * glm::two_pi<float>();
+}
+
+EntityState entityState(int64_t id, const glm::vec3& pos, float orientation, network::Animation animation) {
+	EntityState state;
+	state.id = id;
+	state.pos = quantizePosition(pos);
+	state.orientation = quantizeOrientation(orientation);
+	state.animation = animation;
+	return state;
+}
+
+const EntityStates* EntitySnapshotHistory::find(uint32_t sequence) const {
+	if (sequence == 0u) {
+		return nullptr;
+	}
+	const Entry& entry = _entries[sequence % Size];
+	if (entry.sequence != sequence) {
+		return nullptr;
+	}
+	return &entry.states;
+}
+
+EntityStates& EntitySnapshotHistory::add(uint32_t sequence) {
+	core_assert_msg(sequence != 0u, "The sequence 0 is reserved");
+	Entry& entry = _entries[sequence % Size];
+	entry.sequence = sequence;
+	entry.states.clear();
+	return entry.states;
+}
+
+void EntitySnapshotHistory::clear() {
+	for (Entry& entry : _entries) {
+		entry.sequence = 0u;
+		entry.states.clear();
+	}
+}
+
+bool EntitySnapshotEncoder::encode(flatbuffers::FlatBufferBuilder& fbb, const EntityStates& states, flatbuffers::Offset<network::EntitySnapshot>& snapshot) {
+	uint32_t baselineSequence = acked();
+	const EntityStates* baseline = _history.find(baselineSequence);
+	if (baseline == nullptr) {
+		baselineSequence = 0u;
+	}
+	_deltas.clear();
+	size_t baseIndex = 0u;
+	for (const EntityState& state : states) {
+		const EntityState* base = nullptr;
+		if (baseline != nullptr) {
+			// both lists are sorted by the entity id
+			while (baseIndex < baseline->size() && (*baseline)[baseIndex].id < state.id) {
+				++baseIndex;
+			}
+			if (baseIndex < baseline->size() && (*baseline)[baseIndex].id == state.id) {
+				base = &(*baseline)[baseIndex];
+			}
+		}
+		if (base == nullptr) {
+			const network::EntityDeltaFlags flags = network::EntityDeltaFlags::POSITION | network::EntityDeltaFlags::ORIENTATION
+					| network::EntityDeltaFlags::ANIMATION | network::EntityDeltaFlags::ABSOLUTE;
+			_deltas.push_back(network::CreateEntityDelta(fbb, state.id, flags, state.pos.x, state.pos.y, state.pos.z,
+					state.orientation, state.animation));
+			continue;
+		}
+		if (*base == state) {
+			continue;
+		}
+		network::EntityDeltaFlags flags = network::EntityDeltaFlags::NONE;
+		const glm::ivec3 delta = state.pos - base->pos;
+		if (delta != glm::ivec3(0)) {
+			flags |= network::EntityDeltaFlags::POSITION;
+		}
+		if (state.orientation != base->orientation) {
+			flags |= network::EntityDeltaFlags::ORIENTATION;
+		}
+		if (state.animation != base->animation) {
+			flags |= network::EntityDeltaFlags::ANIMATION;
+		}
+		_deltas.push_back(network::CreateEntityDelta(fbb, state.id, flags, delta.x, delta.y, delta.z,
+				state.orientation, state.animation));
+	}
+	if (_deltas.empty()) {
+		return false;
+	}
+	if (++_sequence == 0u) {
+		_sequence = 1u;
+	}
+	// the client ends up with the same states for these entities after applying the deltas
+	EntityStates& entry = _history.add(_sequence);
+	entry.assign(states.begin(), states.end());
+	snapshot = network::CreateEntitySnapshot(fbb, _sequence, baselineSequence, fbb.CreateVector(_deltas));
+	return true;
+}
+
+void EntitySnapshotEncoder::ack(uint32_t sequence) {
+	const uint32_t current = acked();
+	if (current != 0u && !newerSequence(sequence, current)) {
+		return;
+	}
+	_acked = (int)sequence;
+}
+
+void EntitySnapshotEncoder::reset() {
+	_history.clear();
+	_sequence = 0u;
+	_acked = 0;
+}
+
+bool EntitySnapshotDecoder::decode(const network::EntitySnapshot* snapshot, EntityStates& changed) {
+	changed.clear();
+	const uint32_t sequence = snapshot->sequence();
+	if (sequence == 0u || (_lastSequence != 0u && !newerSequence(sequence, _lastSequence))) {
+		return false;
+	}
+	EntityStates states;
+	const uint32_t baselineSequence = snapshot->baseline();
+	if (baselineSequence != 0u) {
+		const EntityStates* baseline = _history.find(baselineSequence);
+		if (baseline == nullptr) {
+			return false;
+		}
+		states = *baseline;
+	}
+	const flatbuffers::Vector<flatbuffers::Offset<network::EntityDelta> >* deltas = snapshot->entities();
+	changed.reserve(deltas->size());
+	for (const network::EntityDelta* delta : *deltas) {
+		const network::EntityDeltaFlags flags = delta->flags();
+		EntityState state;
+		state.id = delta->id();
+		auto i = std::lower_bound(states.begin(), states.end(), state);
+		const bool known = i != states.end() && i->id == state.id;
+		if (hasFlag(flags, network::EntityDeltaFlags::ABSOLUTE)) {
+			state.pos = glm::ivec3(delta->x(), delta->y(), delta->z());
+		} else if (!known) {
+			// the server assumed a baseline state that we don't know
+			changed.clear();
+			return false;
+		} else {
+			state = *i;
+			if (hasFlag(flags, network::EntityDeltaFlags::POSITION)) {
+				state.pos += glm::ivec3(delta->x(), delta->y(), delta->z());
+			}
+		}
+		if (hasFlag(flags, network::EntityDeltaFlags::ORIENTATION)) {
+			state.orientation = delta->orientation();
+		}
+		if (hasFlag(flags, network::EntityDeltaFlags::ANIMATION)) {
+			state.animation = delta->animation();
+		}
+		if (known) {
+			*i = state;
+		} else {
+			states.insert(i, state);
+		}
+		changed.push_back(state);
+	}
+	_history.add(sequence).swap(states);
+	_lastSequence = sequence;
+	return true;
+}
+
+void EntitySnapshotDecoder::reset() {
+	_history.clear();
+	_lastSequence = 0u;
+}
+
+}
@@ -0,0 +1,141 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "ServerMessages_generated.h"
+#include "core/concurrent/Atomic.h"
+#include <glm/vec3.hpp>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Shared between client and server
+ */
+namespace shared {
+
+/**
+ * @brief The quantized network state of one entity
+ */
+struct EntityState {
+	int64_t id = 0;
+	glm::ivec3 pos { 0 };
+	uint16_t orientation = 0u;
+	network::Animation animation = network::Animation::IDLE;
+
+	inline bool operator<(const EntityState& rhs) const {
+		return id < rhs.id;
+	}
+
+	inline bool operator==(const EntityState& rhs) const {
+		return id == rhs.id && pos == rhs.pos && orientation == rhs.orientation && animation == rhs.animation;
+	}
+
+	inline bool operator!=(const EntityState& rhs) const {
+		return !(*this == rhs);
+	}
+};
+
+/**
+ * @brief Entity states sorted by their id
+ */
+typedef std::vector<EntityState> EntityStates;
+
+/**
+ * @brief Positions are quantized to 1/PositionScale of a voxel
+ */
+constexpr float PositionScale = 16.0f;
+
+glm::ivec3 quantizePosition(const glm::vec3& pos);
+glm::vec3 dequantizePosition(const glm::ivec3& pos);
+uint16_t quantizeOrientation(float orientation);
+float dequantizeOrientation(uint16_t orientation);
+EntityState entityState(int64_t id, const glm::vec3& pos, float orientation, network::Animation animation);
+
+/**
+ * @brief Ring buffer of the last snapshots - used as baselines for the delta encoding
+ */
+class EntitySnapshotHistory {
+public:
+	/**
+	 * @brief The amount of snapshots that are kept. If the acknowledged snapshot is older, the
+	 * full states are sent again.
+	 */
+	static constexpr int Size = 32;
+private:
+	struct Entry {
+		uint32_t sequence = 0u;
+		EntityStates states;
+	};
+	Entry _entries[Size];
+public:
+	/**
+	 * @return @c nullptr if the snapshot with the given sequence is not (or no longer) available
+	 */
+	const EntityStates* find(uint32_t sequence) const;
+	/**
+	 * @brief Replaces the oldest snapshot
+	 * @return The states of the new snapshot
+	 */
+	EntityStates& add(uint32_t sequence);
+	void clear();
+};
+
+/**
+ * @brief Server side of the snapshots - one instance per client.
+ *
+ * Encodes the changed entity states relative to the last snapshot that the client acknowledged.
+ */
+class EntitySnapshotEncoder {
+private:
+	EntitySnapshotHistory _history;
+	uint32_t _sequence = 0u;
+	// written by the network handler - see ack()
+	core::AtomicInt _acked { 0 };
+	std::vector<flatbuffers::Offset<network::EntityDelta> > _deltas;
+public:
+	/**
+	 * @brief Build the snapshot message for the given states.
+	 * @param[in] states The current entity states - sorted by their id
+	 * @param[out] snapshot The offset of the @c network::EntitySnapshot
+	 * @return @c false if no entity changed since the baseline - nothing was written to the builder then
+	 */
+	bool encode(flatbuffers::FlatBufferBuilder& fbb, const EntityStates& states, flatbuffers::Offset<network::EntitySnapshot>& snapshot);
+	/**
+	 * @brief The client acknowledged the given snapshot
+	 */
+	void ack(uint32_t sequence);
+	uint32_t acked() const;
+	/**
+	 * @brief Forget all baselines - e.g. on a reconnect of the client
+	 */
+	void reset();
+};
+
+/**
+ * @brief Client side of the snapshots.
+ *
+ * Applies the received deltas to the baseline that the server used and remembers the result as a
+ * baseline for the following snapshots.
+ */
+class EntitySnapshotDecoder {
+private:
+	EntitySnapshotHistory _history;
+	uint32_t _lastSequence = 0u;
+public:
+	/**
+	 * @param[in] snapshot The received snapshot message
+	 * @param[out] changed The full states of the entities that changed
+	 * @return @c false if the snapshot is outdated or its baseline is unknown - the snapshot must not
+	 * be acknowledged in this case.
+	 */
+	bool decode(const network::EntitySnapshot* snapshot, EntityStates& changed);
+	void reset();
+};
+
+inline uint32_t EntitySnapshotEncoder::acked() const {
+	return (uint32_t)(int)_acked;
+}
+
+}
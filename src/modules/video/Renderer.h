@@ -358,6 +358,10 @@ inline void drawElements(Primitive mode, size_t numIndices, size_t indexSize, vo
 	drawElements(mode, numIndices, mapIndexTypeBySize(indexSize), offset);
 }
 
+inline void drawElementsBaseVertex(Primitive mode, size_t numIndices, size_t indexSize, int baseIndex, int baseVertex) {
+	drawElementsBaseVertex(mode, numIndices, mapIndexTypeBySize(indexSize), indexSize, baseIndex, baseVertex);
+}
+
 template<class IndexType>
 inline void drawElementsIndirect(Primitive mode, void* offset) {
 	drawElementsIndirect(mode, mapType<IndexType>(), offset);
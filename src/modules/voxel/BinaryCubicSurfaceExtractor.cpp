@@ -0,0 +1,323 @@
+/**
+ * @file
+ */
+
+#include "BinaryCubicSurfaceExtractor.h"
+#include "core/Common.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace voxel {
+
+static constexpr int BitsPerWord = 64;
+
+static inline int countTrailingZeros(uint64_t word) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+static inline int wordCount(int bits) {
+	return (bits + BitsPerWord - 1) / BitsPerWord;
+}
+
+/**
+ * @return The bits [from, to) of the word with the given index
+ */
+static inline uint64_t rangeMask(int word, int from, int to) {
+	const int start = core_max(from - word * BitsPerWord, 0);
+	const int end = core_min(to - word * BitsPerWord, BitsPerWord);
+	if (start >= end) {
+		return 0u;
+	}
+	const uint64_t upperMask = end == BitsPerWord ? ~(uint64_t)0u : (((uint64_t)1u << end) - 1u);
+	return upperMask & ~(((uint64_t)1u << start) - 1u);
+}
+
+static inline bool isRangeSet(const uint64_t* row, int from, int to) {
+	for (int w = from / BitsPerWord; w <= (to - 1) / BitsPerWord; ++w) {
+		const uint64_t mask = rangeMask(w, from, to);
+		if ((row[w] & mask) != mask) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static inline void clearRange(uint64_t* row, int from, int to) {
+	for (int w = from / BitsPerWord; w <= (to - 1) / BitsPerWord; ++w) {
+		row[w] &= ~rangeMask(w, from, to);
+	}
+}
+
+/**
+ * @brief We are checking the voxels in front of the face. There are four possible ambient occlusion values
+ * for a vertex - see @c addVertex()
+ */
+static inline uint8_t vertexAmbientOcclusion(bool side1, bool side2, bool corner) {
+	if (side1 && side2) {
+		return 0;
+	}
+	return 3 - (side1 + side2 + corner);
+}
+
+/**
+ * @brief Describes how the plane of a face is mapped onto the volume axes and in which order the quad
+ * vertices are emitted to get the same winding as @c extractCubicMesh()
+ */
+struct FaceDescription {
+	/** the axis the face normal points to - the other two are the row and the bit axis of the face masks */
+	int planeAxis;
+	int rowAxis;
+	int bitAxis;
+	/** the owner of a negative face is the voxel behind the plane, for a positive face it's the voxel in front */
+	bool negative;
+	/** the corners of the quad in emit order as offsets on the row and bit axis */
+	uint8_t corners[4][2];
+};
+
+static const FaceDescription FaceDescriptions[] = {
+	{0, 1, 2, true,  {{0, 0}, {0, 1}, {1, 1}, {1, 0}}}, // NegativeX
+	{0, 1, 2, false, {{0, 0}, {1, 0}, {1, 1}, {0, 1}}}, // PositiveX
+	{1, 0, 2, true,  {{0, 0}, {1, 0}, {1, 1}, {0, 1}}}, // NegativeY
+	{1, 0, 2, false, {{0, 0}, {0, 1}, {1, 1}, {1, 0}}}, // PositiveY
+	{2, 1, 0, true,  {{0, 0}, {1, 0}, {1, 1}, {0, 1}}}, // NegativeZ
+	{2, 1, 0, false, {{0, 0}, {0, 1}, {1, 1}, {1, 0}}}  // PositiveZ
+};
+
+/**
+ * @brief The key of a face is the color index and the ambient occlusion values of the four corners.
+ * Only faces with the same key are merged.
+ */
+static inline uint32_t faceKey(uint8_t color, const uint8_t ao[4]) {
+	return (uint32_t)color | ((uint32_t)ao[0] << 8) | ((uint32_t)ao[1] << 10) | ((uint32_t)ao[2] << 12) | ((uint32_t)ao[3] << 14);
+}
+
+static inline uint8_t faceKeyColor(uint32_t key) {
+	return (uint8_t)(key & 0xFF);
+}
+
+static inline uint8_t faceKeyAmbientOcclusion(uint32_t key, int corner) {
+	return (uint8_t)((key >> (8 + corner * 2)) & 3);
+}
+
+void extractBinaryCubicMesh(ExtractionContext& ctx, const glm::ivec3& size, const bool* opaque, Mesh* result,
+		const glm::ivec3& translate, bool mergeQuads, bool reuseVertices, bool ambientOcclusion) {
+	core_trace_scoped(ExtractBinaryCubicMeshMasks);
+	const glm::ivec3 padded = size + 2;
+	const int strides[] = {1, padded.x, padded.x * padded.y};
+
+	// the occupancy of the voxels - one bit per voxel of the region along the z axis (indexed by padded x and y)
+	// and along the x axis (indexed by padded y and z). The neighbouring planes along the other two axes are
+	// padded - this is what the faces on the lower and upper border are compared against.
+	const int wordsZ = wordCount(size.z);
+	const int wordsX = wordCount(size.x);
+	const Voxel* voxels = ctx.voxels.data();
+	std::vector<uint64_t>& occupancyZ = ctx.occupancyZ;
+	std::vector<uint64_t>& occupancyX = ctx.occupancyX;
+	occupancyZ.assign((size_t)padded.x * padded.y * wordsZ, 0u);
+	occupancyX.assign((size_t)padded.y * padded.z * wordsX, 0u);
+	// voxels that are counted as solid for the ambient occlusion
+	std::vector<uint8_t>& solid = ctx.solid;
+	solid.resize((size_t)padded.x * padded.y * padded.z);
+	{
+		core_trace_scoped(BuildOccupancy);
+		size_t index = 0u;
+		for (int z = 0; z < padded.z; ++z) {
+			const int bitZ = z - 1;
+			for (int y = 0; y < padded.y; ++y) {
+				uint64_t* rowX = &occupancyX[((size_t)z * padded.y + y) * wordsX];
+				for (int x = 0; x < padded.x; ++x, ++index) {
+					const VoxelType material = voxels[index].getMaterial();
+					solid[index] = !isAir(material) && !isWater(material);
+					if (!opaque[core::enumVal(material)]) {
+						continue;
+					}
+					const int bitX = x - 1;
+					if (bitX >= 0 && bitX < size.x) {
+						rowX[bitX / BitsPerWord] |= (uint64_t)1u << (bitX % BitsPerWord);
+					}
+					if (bitZ >= 0 && bitZ < size.z) {
+						occupancyZ[((size_t)y * padded.x + x) * wordsZ + bitZ / BitsPerWord] |= (uint64_t)1u << (bitZ % BitsPerWord);
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<uint64_t>& faceMask = ctx.faceMask;
+	std::vector<uint32_t>& keys = ctx.keys;
+	// the last vertex that was added for a corner position of the current plane
+	std::vector<IndexType>& cornerVertices = ctx.cornerVertices;
+	constexpr IndexType NoVertex = (IndexType)-1;
+
+	for (const FaceDescription& desc : FaceDescriptions) {
+		core_trace_scoped(GenerateFaces);
+		const int planes = size[desc.planeAxis];
+		const int rows = size[desc.rowAxis];
+		const int bits = size[desc.bitAxis];
+		const int words = wordCount(bits);
+		const int planeStride = strides[desc.planeAxis];
+		const int rowStride = strides[desc.rowAxis];
+		const int bitStride = strides[desc.bitAxis];
+		faceMask.resize((size_t)rows * words);
+		keys.resize((size_t)rows * bits);
+		if (reuseVertices) {
+			cornerVertices.resize((size_t)(rows + 1) * (bits + 1));
+		}
+
+		for (int plane = 0; plane < planes; ++plane) {
+			// padded plane coordinates of the voxel the face belongs to and of the voxel in front of it
+			const int ownerPlane = desc.negative ? plane + 1 : plane;
+			const int frontPlane = desc.negative ? plane : plane + 1;
+
+			bool anyFace = false;
+			for (int row = 0; row < rows; ++row) {
+				const uint64_t* owner;
+				const uint64_t* front;
+				if (desc.planeAxis == 0) {
+					// x faces - rows along y, bits along z
+					owner = &occupancyZ[((size_t)(row + 1) * padded.x + ownerPlane) * wordsZ];
+					front = &occupancyZ[((size_t)(row + 1) * padded.x + frontPlane) * wordsZ];
+				} else if (desc.planeAxis == 1) {
+					// y faces - rows along x, bits along z
+					owner = &occupancyZ[((size_t)ownerPlane * padded.x + row + 1) * wordsZ];
+					front = &occupancyZ[((size_t)frontPlane * padded.x + row + 1) * wordsZ];
+				} else {
+					// z faces - rows along y, bits along x
+					owner = &occupancyX[((size_t)ownerPlane * padded.y + row + 1) * wordsX];
+					front = &occupancyX[((size_t)frontPlane * padded.y + row + 1) * wordsX];
+				}
+				uint64_t* mask = &faceMask[(size_t)row * words];
+				for (int w = 0; w < words; ++w) {
+					mask[w] = owner[w] & ~front[w];
+					anyFace |= mask[w] != 0u;
+				}
+			}
+			if (!anyFace) {
+				continue;
+			}
+			if (reuseVertices) {
+				std::fill(cornerVertices.begin(), cornerVertices.end(), NoVertex);
+			}
+
+			// the color and ambient occlusion of every face in this plane
+			for (int row = 0; row < rows; ++row) {
+				const uint64_t* mask = &faceMask[(size_t)row * words];
+				for (int w = 0; w < words; ++w) {
+					uint64_t word = mask[w];
+					while (word != 0u) {
+						const int bit = w * BitsPerWord + countTrailingZeros(word);
+						word &= word - 1u;
+						const int frontIndex = frontPlane * planeStride + (row + 1) * rowStride + (bit + 1) * bitStride;
+						const int ownerIndex = frontIndex + (desc.negative ? planeStride : -planeStride);
+						uint8_t ao[4];
+						for (int corner = 0; corner < 4; ++corner) {
+							const int rowDelta = desc.corners[corner][0] ? rowStride : -rowStride;
+							const int bitDelta = desc.corners[corner][1] ? bitStride : -bitStride;
+							ao[corner] = vertexAmbientOcclusion(solid[frontIndex + rowDelta], solid[frontIndex + bitDelta],
+									solid[frontIndex + rowDelta + bitDelta]);
+						}
+						keys[(size_t)row * bits + bit] = faceKey(voxels[ownerIndex].getColor(), ao);
+					}
+				}
+			}
+
+			// greedy merge of the faces with the same key - first along the bit axis, then along the row axis
+			const uint32_t keyMask = ambientOcclusion ? ~0u : 0xFFu;
+			for (int row = 0; row < rows; ++row) {
+				uint64_t* mask = &faceMask[(size_t)row * words];
+				for (int w = 0; w < words; ++w) {
+					while (mask[w] != 0u) {
+						const int bitStart = w * BitsPerWord + countTrailingZeros(mask[w]);
+						const uint32_t key = keys[(size_t)row * bits + bitStart];
+						int bitEnd = bitStart + 1;
+						int rowEnd = row + 1;
+						if (mergeQuads) {
+							while (bitEnd < bits && (mask[bitEnd / BitsPerWord] & ((uint64_t)1u << (bitEnd % BitsPerWord))) != 0u
+									&& ((keys[(size_t)row * bits + bitEnd] ^ key) & keyMask) == 0u) {
+								++bitEnd;
+							}
+							for (; rowEnd < rows; ++rowEnd) {
+								if (!isRangeSet(&faceMask[(size_t)rowEnd * words], bitStart, bitEnd)) {
+									break;
+								}
+								const uint32_t* rowKeys = &keys[(size_t)rowEnd * bits];
+								bool sameKey = true;
+								for (int bit = bitStart; bit < bitEnd; ++bit) {
+									if (((rowKeys[bit] ^ key) & keyMask) != 0u) {
+										sameKey = false;
+										break;
+									}
+								}
+								if (!sameKey) {
+									break;
+								}
+							}
+						}
+						for (int r = row; r < rowEnd; ++r) {
+							clearRange(&faceMask[(size_t)r * words], bitStart, bitEnd);
+						}
+
+						uint8_t ao[4];
+						int cornerRows[4];
+						int cornerBits[4];
+						for (int corner = 0; corner < 4; ++corner) {
+							const bool rowUpper = desc.corners[corner][0] != 0;
+							const bool bitUpper = desc.corners[corner][1] != 0;
+							// the ambient occlusion of the merged corner is the one of the face in that corner
+							const uint32_t cornerKey = keys[(size_t)(rowUpper ? rowEnd - 1 : row) * bits + (bitUpper ? bitEnd - 1 : bitStart)];
+							ao[corner] = faceKeyAmbientOcclusion(cornerKey, corner);
+							cornerRows[corner] = rowUpper ? rowEnd : row;
+							cornerBits[corner] = bitUpper ? bitEnd : bitStart;
+						}
+
+						// same triangulation rule as isQuadFlipped() in the CubicSurfaceExtractor - a flipped quad just
+						// starts at the second corner. This way the triangles are always (0, 1, 2) and (0, 2, 3) and
+						// the indices of a mesh without shared vertices are implicit (see Mesh::compressIndices())
+						const int firstCorner = ao[3] + ao[1] > ao[0] + ao[2] ? 1 : 0;
+						IndexType indices[4];
+						for (int i = 0; i < 4; ++i) {
+							const int corner = (firstCorner + i) & 3;
+							const int cornerRow = cornerRows[corner];
+							const int cornerBit = cornerBits[corner];
+							VoxelVertex vertex;
+							vertex.colorIndex = faceKeyColor(key);
+							vertex.ambientOcclusion = ao[corner];
+							IndexType* existing = nullptr;
+							if (reuseVertices) {
+								existing = &cornerVertices[(size_t)cornerRow * (bits + 1) + cornerBit];
+								if (*existing != NoVertex) {
+									const VoxelVertex& v = result->getVertex(*existing);
+									if (v.colorIndex == vertex.colorIndex && v.ambientOcclusion == vertex.ambientOcclusion) {
+										indices[i] = *existing;
+										continue;
+									}
+								}
+							}
+							glm::ivec3 position;
+							position[desc.planeAxis] = plane;
+							position[desc.rowAxis] = cornerRow;
+							position[desc.bitAxis] = cornerBit;
+							vertex.position = position + translate;
+							indices[i] = result->addVertex(vertex);
+							if (existing != nullptr) {
+								*existing = indices[i];
+							}
+						}
+						result->addTriangle(indices[0], indices[1], indices[2]);
+						result->addTriangle(indices[0], indices[2], indices[3]);
+					}
+				}
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "CubicSurfaceExtractor.h"
+#include "Mesh.h"
+#include "Voxel.h"
+#include "Region.h"
+#include "Face.h"
+#include "core/Assert.h"
+#include "core/Enum.h"
+#include "core/Trace.h"
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace voxel {
+
+/**
+ * @brief Builds the mesh from the voxels of the extraction region that were copied into @c ExtractionContext::voxels
+ *
+ * @param size The size of the region in voxels - the voxels have a border of one voxel on each side and
+ * are stored in linear (x, then y, then z) order.
+ * @param opaque Lookup table for all @c VoxelType values - faces are generated between opaque and non opaque voxels.
+ */
+extern void extractBinaryCubicMesh(ExtractionContext& ctx, const glm::ivec3& size, const bool* opaque, Mesh* result,
+		const glm::ivec3& translate, bool mergeQuads, bool reuseVertices, bool ambientOcclusion);
+
+/**
+ * @brief Alternative to @c extractCubicMesh() that works on occupancy bitmasks instead of testing every voxel pair.
+ *
+ * The voxels of the region (and their direct neighbours) are copied into a flat array once. From that the
+ * occupancy of each voxel is stored as bits in 64 bit words along the z and the x axis. The faces of a whole
+ * plane are then found by and-not-ing the occupancy words of two neighbouring planes - and the quads are
+ * greedily merged on these face masks. The vertices and indices are written into the mesh directly, there
+ * are no per-quad allocations.
+ *
+ * The output is a drop-in replacement for the output of @c extractCubicMesh(): the vertices have the same
+ * positions, colors and ambient occlusion values and the quads are triangulated with the same rule. The
+ * differences are that vertices are only shared between the quads of the same plane and that the merged
+ * quads might be split differently.
+ *
+ * @note The given @c IsQuadNeeded functor must be of the form @code opaque(back) && !opaque(front) @endcode
+ * (which is true for @c IsQuadNeeded) - it is only evaluated once per voxel type to build the opaque lookup table.
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+void extractBinaryCubicMesh(ExtractionContext& ctx, VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+	core_trace_scoped(ExtractBinaryCubicMesh);
+
+	result->clear();
+	const glm::ivec3& offset = region.getLowerCorner();
+	const glm::ivec3& upper = region.getUpperCorner();
+	result->setOffset(offset);
+
+	constexpr int materials = core::enumVal(VoxelType::Max);
+	bool opaque[materials];
+	for (int i = 0; i < materials; ++i) {
+		opaque[i] = isQuadNeeded((VoxelType)i, VoxelType::Air, FaceNames::NegativeX);
+	}
+	for (int back = 0; back < materials; ++back) {
+		for (int front = 0; front < materials; ++front) {
+			core_assert_msg(isQuadNeeded((VoxelType)back, (VoxelType)front, FaceNames::PositiveY) == (opaque[back] && !opaque[front]),
+					"The quad criterion can't be expressed as opaque(back) && !opaque(front)");
+		}
+	}
+
+	// the neighbours of the region are needed for the faces on the lower border and the ambient occlusion
+	Voxel uniformVoxel;
+	if (isUniformRegion(volData, Region(offset - 1, upper + 1), uniformVoxel)) {
+		// a uniform region can't have any opaque/non opaque boundary
+		return;
+	}
+
+	const glm::ivec3 size = upper - offset + 1;
+	std::vector<Voxel>& voxels = ctx.voxels;
+	voxels.resize((size_t)(size.x + 2) * (size.y + 2) * (size.z + 2));
+	{
+		core_trace_scoped(CopyVoxels);
+		Voxel* target = voxels.data();
+		typename VolumeType::Sampler volumeSampler(volData);
+		for (int32_t z = offset.z - 1; z <= upper.z + 1; ++z) {
+			for (int32_t y = offset.y - 1; y <= upper.y + 1; ++y) {
+				volumeSampler.setPosition(offset.x - 1, y, z);
+				for (int32_t x = offset.x - 1; x <= upper.x + 1; ++x) {
+					*target++ = volumeSampler.voxel();
+					volumeSampler.movePositiveX();
+				}
+			}
+		}
+	}
+
+	extractBinaryCubicMesh(ctx, size, opaque, result, translate, mergeQuads, reuseVertices, ambientOcclusion);
+}
+
+template<typename VolumeType, typename IsQuadNeeded>
+void extractBinaryCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+	ExtractionContext ctx;
+	extractBinaryCubicMesh(ctx, volData, region, result, isQuadNeeded, translate, mergeQuads, reuseVertices, ambientOcclusion);
+}
+
+}
@@ -4,6 +4,7 @@
 
 #include "CubicSurfaceExtractor.h"
 #include "core/Common.h"
+#include <algorithm>
 
 namespace voxel {
 
@@ -67,7 +68,7 @@ static bool mergeQuads(Quad& q1, Quad& q2, Mesh* meshCurrent, FUNC&& equal) {
 	return false;
 }
 
-static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent, bool ambientOcclusion) {
+static bool performQuadMerging(QuadVector& quads, Mesh* meshCurrent, bool ambientOcclusion) {
 	core_trace_scoped(PerformQuadMerging);
 	bool didMerge = false;
 
@@ -76,24 +77,30 @@ static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent, bool ambientO
 		equal = isSameColor;
 	}
 
-	for (QuadList::iterator outerIter = quads.begin(); outerIter != quads.end(); ++outerIter) {
-		QuadList::iterator innerIter = outerIter;
-		++innerIter;
-		while (innerIter != quads.end()) {
-			Quad& q1 = *outerIter;
-			Quad& q2 = *innerIter;
-
-			const bool result = mergeQuads(q1, q2, meshCurrent, equal);
-
-			if (result) {
+	const size_t n = quads.size();
+	for (size_t outer = 0; outer < n; ++outer) {
+		Quad& q1 = quads[outer];
+		if (q1.vertices[0] == QuadRemoved) {
+			continue;
+		}
+		for (size_t inner = outer + 1; inner < n; ++inner) {
+			Quad& q2 = quads[inner];
+			if (q2.vertices[0] == QuadRemoved) {
+				continue;
+			}
+			if (mergeQuads(q1, q2, meshCurrent, equal)) {
 				didMerge = true;
-				innerIter = quads.erase(innerIter);
-			} else {
-				++innerIter;
+				q2.vertices[0] = QuadRemoved;
 			}
 		}
 	}
 
+	if (didMerge) {
+		quads.erase(std::remove_if(quads.begin(), quads.end(), [] (const Quad& q) {
+			return q.vertices[0] == QuadRemoved;
+		}), quads.end());
+	}
+
 	return didMerge;
 }
 
@@ -118,9 +125,9 @@ SDL_FORCE_INLINE bool isQuadFlipped(const VoxelVertex& v00, const VoxelVertex& v
 	return v00.ambientOcclusion + v11.ambientOcclusion > v01.ambientOcclusion + v10.ambientOcclusion;
 }
 
-void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads) {
+void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadVectors& vecListQuads) {
 	core_trace_scoped(GenerateMeshify);
-	for (QuadList& listQuads : vecListQuads) {
+	for (QuadVector& listQuads : vecListQuads) {
 		if (mergeQuads) {
 			core_trace_scoped(MergeQuads);
 			// Repeatedly call this function until it returns
@@ -158,8 +165,9 @@ IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, cons
 		!isAir(face2) && !isWater(face2),
 		!isAir(corner) && !isWater(corner));
 
+	VertexData* slots = existingVertices.slots(x, y);
 	for (uint32_t ct = 0; ct < MaxVerticesPerPosition; ++ct) {
-		VertexData& entry = existingVertices(x, y, ct);
+		VertexData& entry = slots[ct];
 
 		if (entry.index == 0) {
 			// No vertices matched and we've now hit an empty space. Fill it by creating a vertex.
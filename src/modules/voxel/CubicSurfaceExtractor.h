@@ -17,7 +17,6 @@
 #include "Face.h"
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
-#include <list>
 #include <vector>
 
 namespace voxel {
@@ -54,42 +53,127 @@ struct VertexData {
 };
 static_assert(sizeof(VertexData) == 8, "Unexpected size of VertexData");
 
+/**
+ * @brief The vertices that were already added for the positions of a slice. The slots of a position are
+ * invalidated lazily on the first access after @c clear() - so neither clearing nor reusing the array for
+ * the next extraction touches the whole memory or allocates anything.
+ */
 class Array : public core::NonCopyable {
 private:
-	uint32_t _width;
-	uint32_t _height;
-	uint32_t _depth;
-	VertexData* _elements;
+	uint32_t _width = 0u;
+	uint32_t _height = 0u;
+	uint32_t _depth = 0u;
+	uint32_t _capacity = 0u;
+	uint32_t _positionCapacity = 0u;
+	VertexData* _elements = nullptr;
+	// the slots of a position are only valid if the generation of the position matches the current one
+	uint32_t* _generations = nullptr;
+	uint32_t _generation = 1u;
 public:
-	Array(uint32_t width, uint32_t height, uint32_t depth) :
-			_width(width), _height(height), _depth(depth) {
-		_elements = (VertexData*)core_malloc(width * height * depth * sizeof(VertexData));
-		clear();
+	Array() {
+	}
+
+	Array(uint32_t width, uint32_t height, uint32_t depth) {
+		resize(width, height, depth);
 	}
 
 	~Array() {
 		core_free(_elements);
+		core_free(_generations);
+	}
+
+	/**
+	 * @brief Changes the dimensions and clears the array. Memory is only allocated if the new
+	 * dimensions need more than what was allocated before.
+	 */
+	void resize(uint32_t width, uint32_t height, uint32_t depth) {
+		_width = width;
+		_height = height;
+		_depth = depth;
+		const uint32_t positions = width * height;
+		if (positions > _positionCapacity) {
+			core_free(_generations);
+			_generations = (uint32_t*)core_malloc(positions * sizeof(uint32_t));
+			_positionCapacity = positions;
+		}
+		if (positions * depth > _capacity) {
+			core_free(_elements);
+			_elements = (VertexData*)core_malloc(positions * depth * sizeof(VertexData));
+			_capacity = positions * depth;
+		}
+		core_memset(_generations, 0x0, positions * sizeof(uint32_t));
+		_generation = 1u;
 	}
 
 	void clear() {
-		core_memset(_elements, 0x0, _width * _height * _depth * sizeof(VertexData));
+		if (++_generation == 0u) {
+			core_memset(_generations, 0x0, _width * _height * sizeof(uint32_t));
+			_generation = 1u;
+		}
+	}
+
+	/**
+	 * @return The @c depth slots of the given position
+	 */
+	inline VertexData* slots(uint32_t x, uint32_t y) {
+		core_assert_msg(x < _width && y < _height, "Array access is out-of-range.");
+		const uint32_t position = y * _width + x;
+		VertexData* slots = &_elements[position * _depth];
+		if (_generations[position] != _generation) {
+			_generations[position] = _generation;
+			for (uint32_t i = 0u; i < _depth; ++i) {
+				slots[i].index = 0;
+			}
+		}
+		return slots;
 	}
 
 	inline VertexData& operator()(uint32_t x, uint32_t y, uint32_t z) {
-		core_assert_msg(x < _width && y < _height && z < _depth, "Array access is out-of-range.");
-		return _elements[z * _width * _height + y * _width + x];
+		core_assert_msg(z < _depth, "Array access is out-of-range.");
+		return slots(x, y)[z];
 	}
 
 	void swap(Array& other) {
+		core::exchange(_width, other._width);
+		core::exchange(_height, other._height);
+		core::exchange(_depth, other._depth);
+		core::exchange(_capacity, other._capacity);
+		core::exchange(_positionCapacity, other._positionCapacity);
 		core::exchange(_elements, other._elements);
+		core::exchange(_generations, other._generations);
+		core::exchange(_generation, other._generation);
 	}
 };
 
 /**
- * @brief Should be a list because random inserts which we need in @c performQuadMerging are O(1)
+ * @brief The quads of one plane. Merged quads are not erased but flagged (see @c QuadRemoved) and compacted
+ * after each merge pass to keep the order stable.
  */
-typedef std::list<Quad> QuadList;
-typedef std::vector<QuadList> QuadListVector;
+typedef std::vector<Quad> QuadVector;
+typedef std::vector<QuadVector> QuadVectors;
+constexpr IndexType QuadRemoved = (IndexType)-1;
+
+/**
+ * @brief The buffers that are needed during the extraction. Keep one instance per thread and hand it to
+ * the extraction functions to reuse the memory of the previous extraction - re-extracting a region of the
+ * same size doesn't allocate anything then.
+ */
+struct ExtractionContext : public core::NonCopyable {
+	// extractCubicMesh()
+	Array previousSliceVertices;
+	Array currentSliceVertices;
+	QuadVectors quads[core::enumVal(FaceNames::Max)];
+	IndexArray vertexRemap;
+
+	// extractBinaryCubicMesh()
+	std::vector<Voxel> voxels;
+	std::vector<uint64_t> occupancyZ;
+	std::vector<uint64_t> occupancyX;
+	std::vector<uint8_t> solid;
+	std::vector<uint64_t> faceMask;
+	std::vector<uint32_t> keys;
+	std::vector<IndexType> cornerVertices;
+};
 
 /**
  * @section Surface extraction
@@ -98,7 +182,16 @@ typedef std::vector<QuadList> QuadListVector;
 extern IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
 		Mesh* meshCurrent, const VoxelType face1, const VoxelType face2, const VoxelType corner, const glm::ivec3& offset);
 
-extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads);
+extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadVectors& vecListQuads);
+
+/**
+ * @brief Volumes that know about regions where all voxels have the same value provide an overload of this
+ * function (found via ADL) to let the extractor skip those regions.
+ */
+template<typename VolumeType>
+inline bool isUniformRegion(const VolumeType*, const Region&, Voxel&) {
+	return false;
+}
 
 /**
  * The CubicSurfaceExtractor creates a mesh in which each voxel appears to be rendered as a cube
@@ -187,7 +280,7 @@ extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadLi
  * @li The user could provide a custom mesh class, e.g a thin wrapper around an openGL VBO to allow direct writing into this structure.
  */
 template<typename VolumeType, typename IsQuadNeeded>
-void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+void extractCubicMesh(ExtractionContext& ctx, VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
 	core_trace_scoped(ExtractCubicMesh);
 
 	result->clear();
@@ -195,27 +288,42 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 	const glm::ivec3& upper = region.getUpperCorner();
 	result->setOffset(offset);
 
+	// the sampler also looks at the neighbours of the region
+	Voxel uniformVoxel;
+	if (isUniformRegion(volData, Region(offset - 1, upper + 1), uniformVoxel)) {
+		const VoxelType material = uniformVoxel.getMaterial();
+		bool quadNeeded = false;
+		for (int i = 0; i < core::enumVal(FaceNames::Max); ++i) {
+			quadNeeded |= isQuadNeeded(material, material, (FaceNames)i);
+		}
+		if (!quadNeeded) {
+			return;
+		}
+	}
+
 	// Used to avoid creating duplicate vertices.
 	const int widthInCells = upper.x - offset.x;
 	const int heightInCells = upper.y - offset.y;
-	Array previousSliceVertices(widthInCells + 2, heightInCells + 2, MaxVerticesPerPosition);
-	Array currentSliceVertices(widthInCells + 2, heightInCells + 2, MaxVerticesPerPosition);
+	Array& previousSliceVertices = ctx.previousSliceVertices;
+	Array& currentSliceVertices = ctx.currentSliceVertices;
+	previousSliceVertices.resize(widthInCells + 2, heightInCells + 2, MaxVerticesPerPosition);
+	currentSliceVertices.resize(widthInCells + 2, heightInCells + 2, MaxVerticesPerPosition);
 
 	// During extraction we create a number of different lists of quads. All the
 	// quads in a given list are in the same plane and facing in the same direction.
-	QuadListVector vecQuads[core::enumVal(FaceNames::Max)];
+	QuadVectors* vecQuads = ctx.quads;
 
 	const int xSize = upper.x - offset.x + 2;
 	const int ySize = upper.y - offset.y + 2;
 	const int zSize = upper.z - offset.z + 2;
-	vecQuads[core::enumVal(FaceNames::NegativeX)].resize(xSize);
-	vecQuads[core::enumVal(FaceNames::PositiveX)].resize(xSize);
-
-	vecQuads[core::enumVal(FaceNames::NegativeY)].resize(ySize);
-	vecQuads[core::enumVal(FaceNames::PositiveY)].resize(ySize);
-
-	vecQuads[core::enumVal(FaceNames::NegativeZ)].resize(zSize);
-	vecQuads[core::enumVal(FaceNames::PositiveZ)].resize(zSize);
+	const int planes[] = {xSize, ySize, zSize, xSize, ySize, zSize};
+	static_assert(core::enumVal(FaceNames::PositiveX) == 0 && core::enumVal(FaceNames::NegativeX) == 3, "Unexpected face order");
+	for (int i = 0; i < core::enumVal(FaceNames::Max); ++i) {
+		vecQuads[i].resize(planes[i]);
+		for (QuadVector& quads : vecQuads[i]) {
+			quads.clear();
+		}
+	}
 
 	typename VolumeType::Sampler volumeSampler(volData);
 
@@ -378,7 +486,7 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 
 				// Z [F] BEHIND
 				if (isQuadNeeded(voxelBeforeMaterial, voxelCurrentMaterial, FaceNames::PositiveZ)) {
-					const VoxelType _voxelRightBehind      = volumeSampler.peekVoxel1px0py1pz().getMaterial();
+					const VoxelType _voxelRightBehind      = volumeSampler.peekVoxel1px0py0pz().getMaterial();
 					const VoxelType _voxelAboveBehind      = volumeSampler.peekVoxel0px1py0pz().getMaterial();
 					const VoxelType _voxelAboveRightBehind = volumeSampler.peekVoxel1px1py0pz().getMaterial();
 					const VoxelType _voxelBelowRightBehind = volumeSampler.peekVoxel1px1ny0pz().getMaterial();
@@ -407,13 +515,18 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 
 	{
 		core_trace_scoped(GenerateMesh);
-		for (QuadListVector& vecListQuads : vecQuads) {
-			meshify(result, mergeQuads, ambientOcclusion, vecListQuads);
+		for (int i = 0; i < core::enumVal(FaceNames::Max); ++i) {
+			meshify(result, mergeQuads, ambientOcclusion, vecQuads[i]);
 		}
 	}
 
-	result->removeUnusedVertices();
-	result->compressIndices();
+	result->removeUnusedVertices(ctx.vertexRemap);
+}
+
+template<typename VolumeType, typename IsQuadNeeded>
+void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+	ExtractionContext ctx;
+	extractCubicMesh(ctx, volData, region, result, isQuadNeeded, translate, mergeQuads, reuseVertices, ambientOcclusion);
 }
 
 }
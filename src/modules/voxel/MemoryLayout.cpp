@@ -0,0 +1,123 @@
+/**
+ * @file
+ */
+
+#include "MemoryLayout.h"
+#include "Morton.h"
+#include "core/Assert.h"
+#include "core/ArrayLength.h"
+#include "core/Log.h"
+#include "math/Functions.h"
+
+namespace voxel {
+
+static const char* MemoryLayoutStr[] = {
+	"Linear",
+	"Morton",
+	"Brick"
+};
+static_assert(lengthof(MemoryLayoutStr) == (int)MemoryLayout::Max, "Array sizes don't match Max");
+
+const char* toString(MemoryLayout layout) {
+	return MemoryLayoutStr[(int)layout];
+}
+
+static inline int32_t mortonOffset(const uint32_t* table, int32_t i) {
+	return (int32_t)(table[i & 0xFF] | (table[(i >> 8) & 0xFF] << 24));
+}
+
+/**
+ * @return @c true if the z-order curve doesn't leave any holes for the given dimensions. This is e.g. the case for
+ * cubes with a power of two side length. For other dimensions the index range is padded up to the next power of two
+ * of the largest side - which would waste a lot of memory for non-cubic regions.
+ */
+static bool mortonWithoutPadding(int32_t width, int32_t height, int32_t depth) {
+	if (width > 1024 || height > 1024 || depth > 1024) {
+		return false;
+	}
+	const size_t size = (size_t)mortonOffset(morton256_x, width - 1) + mortonOffset(morton256_y, height - 1)
+			+ mortonOffset(morton256_z, depth - 1) + 1u;
+	return size == (size_t)width * height * depth;
+}
+
+VoxelLayout::VoxelLayout(MemoryLayout layout, int32_t width, int32_t height, int32_t depth) :
+		_layout(layout) {
+	core_assert_msg(width > 0 && height > 0 && depth > 0, "Invalid dimensions: %i:%i:%i", width, height, depth);
+	if (_layout == MemoryLayout::Morton && !mortonWithoutPadding(width, height, depth)) {
+		Log::debug("Morton layout would need padding for %i:%i:%i - fall back to the linear layout", width, height, depth);
+		_layout = MemoryLayout::Linear;
+	}
+	const int32_t dimensions[] = {width, height, depth};
+	for (int axis = 0; axis < 3; ++axis) {
+		_offsets[axis].resize(dimensions[axis]);
+		_deltas[axis].resize(dimensions[axis]);
+	}
+
+	switch (_layout) {
+	case MemoryLayout::Morton: {
+		const uint32_t* tables[] = {morton256_x, morton256_y, morton256_z};
+		for (int axis = 0; axis < 3; ++axis) {
+			for (int32_t i = 0; i < dimensions[axis]; ++i) {
+				_offsets[axis][i] = mortonOffset(tables[axis], i);
+			}
+		}
+		_size = (size_t)_offsets[0][width - 1] + _offsets[1][height - 1] + _offsets[2][depth - 1] + 1u;
+		break;
+	}
+	case MemoryLayout::Brick: {
+		constexpr int32_t brickVoxels = BrickSideLength * BrickSideLength * BrickSideLength;
+		const int32_t bricks[] = {
+			(width + BrickSideLength - 1) / BrickSideLength,
+			(height + BrickSideLength - 1) / BrickSideLength,
+			(depth + BrickSideLength - 1) / BrickSideLength
+		};
+		const int32_t brickStrides[] = {brickVoxels, brickVoxels * bricks[0], brickVoxels * bricks[0] * bricks[1]};
+		const int32_t voxelStrides[] = {1, BrickSideLength, BrickSideLength * BrickSideLength};
+		for (int axis = 0; axis < 3; ++axis) {
+			for (int32_t i = 0; i < dimensions[axis]; ++i) {
+				_offsets[axis][i] = (i % BrickSideLength) * voxelStrides[axis] + (i / BrickSideLength) * brickStrides[axis];
+			}
+		}
+		_size = (size_t)brickVoxels * bricks[0] * bricks[1] * bricks[2];
+		break;
+	}
+	case MemoryLayout::Linear:
+	default: {
+		const int32_t strides[] = {1, width, width * height};
+		for (int axis = 0; axis < 3; ++axis) {
+			for (int32_t i = 0; i < dimensions[axis]; ++i) {
+				_offsets[axis][i] = i * strides[axis];
+			}
+		}
+		_size = (size_t)width * height * depth;
+		break;
+	}
+	}
+
+	for (int axis = 0; axis < 3; ++axis) {
+		for (int32_t i = 0; i < dimensions[axis] - 1; ++i) {
+			_deltas[axis][i] = _offsets[axis][i + 1] - _offsets[axis][i];
+		}
+		// there is no voxel behind the last one
+		_deltas[axis][dimensions[axis] - 1] = 0;
+	}
+}
+
+const VoxelLayout& VoxelLayout::chunkLayout(MemoryLayout layout, uint16_t sideLength) {
+	core_assert_msg(sideLength > 0 && sideLength <= 256, "Chunk side length must be in the range [1,256]");
+	// all layouts for all valid chunk side lengths (1 - 256) are built once
+	static const std::vector<VoxelLayout> layouts = [] () {
+		std::vector<VoxelLayout> l;
+		l.reserve((int)MemoryLayout::Max * 9);
+		for (int i = 0; i < (int)MemoryLayout::Max; ++i) {
+			for (int power = 0; power < 9; ++power) {
+				const int32_t side = 1 << power;
+				l.emplace_back((MemoryLayout)i, side, side, side);
+			}
+		}
+		return l;
+	}();
+	return layouts[(int)layout * 9 + math::logBase2(sideLength)];
+}
+
+}
@@ -0,0 +1,107 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace voxel {
+
+/**
+ * @brief The order in which the voxels of a chunk or a volume are stored in memory
+ */
+enum class MemoryLayout : uint8_t {
+	/** x, then y, then z - the rows along the x axis are continuous in memory */
+	Linear,
+	/**
+	 * z-order curve - the neighbours in all three directions are likely to be in the same cache line.
+	 * Only used if the dimensions don't need any padding (e.g. cubes with a power of two side length) - the
+	 * linear layout is used otherwise.
+	 */
+	Morton,
+	/** 4x4x4 voxel bricks that are stored in linear order - each brick fills two cache lines */
+	Brick,
+
+	Max
+};
+
+// The chunk layout of the PagedVolume can be selected at compile time - see the voxel CMakeLists.txt
+#ifndef VOXEL_CHUNK_MEMORY_LAYOUT
+#define VOXEL_CHUNK_MEMORY_LAYOUT Morton
+#endif
+
+constexpr MemoryLayout DefaultChunkMemoryLayout = MemoryLayout::VOXEL_CHUNK_MEMORY_LAYOUT;
+
+extern const char* toString(MemoryLayout layout);
+
+/**
+ * @brief Maps the local voxel coordinates to the index in the voxel data for a given @c MemoryLayout
+ *
+ * The index of a voxel is the sum of the per-axis offsets of its coordinates. The deltas are the difference
+ * of the index when moving a sampler by one voxel along an axis - this is what the samplers use to move
+ * their voxel pointer and to peek at the neighbours.
+ */
+class VoxelLayout {
+private:
+	MemoryLayout _layout;
+	std::vector<int32_t> _offsets[3];
+	std::vector<int32_t> _deltas[3];
+	size_t _size = 0u;
+
+public:
+	static constexpr int32_t BrickSideLength = 4;
+
+	VoxelLayout(MemoryLayout layout, int32_t width, int32_t height, int32_t depth);
+
+	/**
+	 * @brief The shared layout for the chunks with the given side length
+	 */
+	static const VoxelLayout& chunkLayout(MemoryLayout layout, uint16_t sideLength);
+
+	MemoryLayout layout() const;
+
+	/**
+	 * @return The amount of voxels that must be allocated. This might be more than width * height * depth
+	 * if the dimensions don't match the layout (e.g. no multiple of the brick size).
+	 */
+	size_t size() const;
+
+	int32_t index(int32_t x, int32_t y, int32_t z) const;
+
+	/**
+	 * @return The delta tables for the x, y and z axis. The value at position @c i is the difference of the
+	 * index from @c i to @c i+1
+	 */
+	const int32_t* deltaX() const;
+	const int32_t* deltaY() const;
+	const int32_t* deltaZ() const;
+};
+
+inline MemoryLayout VoxelLayout::layout() const {
+	return _layout;
+}
+
+inline size_t VoxelLayout::size() const {
+	return _size;
+}
+
+inline int32_t VoxelLayout::index(int32_t x, int32_t y, int32_t z) const {
+	return _offsets[0][x] + _offsets[1][y] + _offsets[2][z];
+}
+
+inline const int32_t* VoxelLayout::deltaX() const {
+	return _deltas[0].data();
+}
+
+inline const int32_t* VoxelLayout::deltaY() const {
+	return _deltas[1].data();
+}
+
+inline const int32_t* VoxelLayout::deltaZ() const {
+	return _deltas[2].data();
+}
+
+}
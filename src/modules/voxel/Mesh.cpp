@@ -7,7 +7,7 @@
 #include "core/Common.h"
 #include "core/Trace.h"
 #include "core/Assert.h"
-#include "util/BufferUtil.h"
+#include "core/Log.h"
 #include <glm/vector_relational.hpp>
 #include <glm/common.hpp>
 
@@ -25,10 +25,11 @@ Mesh::Mesh(int vertices, int indices, bool mayGetResized) : _mayGetResized(mayGe
 Mesh::Mesh(Mesh&& other) noexcept {
 	_vecIndices = std::move(other._vecIndices);
 	_vecVertices = std::move(other._vecVertices);
-	_compressedIndices = other._compressedIndices;
-	other._compressedIndices = nullptr;
-	_compressedIndexSize = other._compressedIndexSize;
-	other._compressedIndexSize = 0u;
+	_compressedIndices = std::move(other._compressedIndices);
+	_subMeshes = std::move(other._subMeshes);
+	_compressedNumIndices = other._compressedNumIndices;
+	_compressed = other._compressed;
+	_quadIndices = other._quadIndices;
 	_offset = other._offset;
 	_mayGetResized = other._mayGetResized;
 }
@@ -36,13 +37,11 @@ Mesh::Mesh(Mesh&& other) noexcept {
 Mesh::Mesh(const Mesh& other) {
 	_vecIndices = other._vecIndices;
 	_vecVertices = other._vecVertices;
-	_compressedIndexSize = other._compressedIndexSize;
-	if (other._compressedIndices != nullptr) {
-		_compressedIndices = (uint8_t*)core_malloc(_vecIndices.size() * _compressedIndexSize);
-		core_memcpy(_compressedIndices, other._compressedIndices, _vecIndices.size() * _compressedIndexSize);
-	} else {
-		_compressedIndices = nullptr;
-	}
+	_compressedIndices = other._compressedIndices;
+	_subMeshes = other._subMeshes;
+	_compressedNumIndices = other._compressedNumIndices;
+	_compressed = other._compressed;
+	_quadIndices = other._quadIndices;
 	_offset = other._offset;
 	_mayGetResized = other._mayGetResized;
 }
@@ -53,14 +52,11 @@ Mesh& Mesh::operator=(const Mesh& other) {
 	}
 	_vecIndices = other._vecIndices;
 	_vecVertices = other._vecVertices;
-	_compressedIndexSize = other._compressedIndexSize;
-	core_free(_compressedIndices);
-	if (other._compressedIndices != nullptr) {
-		_compressedIndices = (uint8_t*)core_malloc(_vecIndices.size() * _compressedIndexSize);
-		core_memcpy(_compressedIndices, other._compressedIndices, _vecIndices.size() * _compressedIndexSize);
-	} else {
-		_compressedIndices = nullptr;
-	}
+	_compressedIndices = other._compressedIndices;
+	_subMeshes = other._subMeshes;
+	_compressedNumIndices = other._compressedNumIndices;
+	_compressed = other._compressed;
+	_quadIndices = other._quadIndices;
 	_offset = other._offset;
 	_mayGetResized = other._mayGetResized;
 	return *this;
@@ -69,21 +65,21 @@ Mesh& Mesh::operator=(const Mesh& other) {
 Mesh& Mesh::operator=(Mesh&& other) noexcept {
 	_vecIndices = std::move(other._vecIndices);
 	_vecVertices = std::move(other._vecVertices);
-	core_free(_compressedIndices);
-	_compressedIndices = other._compressedIndices;
-	other._compressedIndices = nullptr;
-	_compressedIndexSize = other._compressedIndexSize;
-	other._compressedIndexSize = 4u;
+	_compressedIndices = std::move(other._compressedIndices);
+	_subMeshes = std::move(other._subMeshes);
+	_compressedNumIndices = other._compressedNumIndices;
+	_compressed = other._compressed;
+	_quadIndices = other._quadIndices;
 	_offset = other._offset;
 	_mayGetResized = other._mayGetResized;
 	return *this;
 }
 
 Mesh::~Mesh() {
-	core_free(_compressedIndices);
 }
 
 const IndexArray& Mesh::getIndexVector() const {
+	core_assert_msg(!_compressed, "The indices of the mesh were compressed");
 	return _vecIndices;
 }
 
@@ -92,6 +88,7 @@ const VertexArray& Mesh::getVertexVector() const {
 }
 
 IndexArray& Mesh::getIndexVector() {
+	core_assert_msg(!_compressed, "The indices of the mesh were compressed");
 	return _vecIndices;
 }
 
@@ -112,14 +109,31 @@ const VoxelVertex* Mesh::getRawVertexData() const {
 }
 
 size_t Mesh::getNoOfIndices() const {
+	if (_compressed) {
+		return _compressedNumIndices;
+	}
 	return _vecIndices.size();
 }
 
 IndexType Mesh::getIndex(IndexType index) const {
-	return _vecIndices[index];
+	if (!_compressed) {
+		return _vecIndices[index];
+	}
+	if (_quadIndices) {
+		static const IndexType quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+		return index / 6u * 4u + quadIndices[index % 6u];
+	}
+	for (const SubMesh& subMesh : _subMeshes) {
+		if (index < subMesh.firstIndex + subMesh.numIndices) {
+			return subMesh.baseVertex + _compressedIndices[index];
+		}
+	}
+	core_assert_msg(false, "Index %u is out of range", index);
+	return 0u;
 }
 
 const IndexType* Mesh::getRawIndexData() const {
+	core_assert_msg(!_compressed, "The indices of the mesh were compressed");
 	return _vecIndices.data();
 }
 
@@ -134,6 +148,11 @@ void Mesh::setOffset(const glm::ivec3& offset) {
 void Mesh::clear() {
 	_vecVertices.clear();
 	_vecIndices.clear();
+	_compressedIndices.clear();
+	_subMeshes.clear();
+	_compressedNumIndices = 0u;
+	_compressed = false;
+	_quadIndices = false;
 	_offset = glm::ivec3(0);
 }
 
@@ -146,6 +165,7 @@ void Mesh::addTriangle(IndexType index0, IndexType index1, IndexType index2) {
 	core_assert_msg(index0 < _vecVertices.size(), "Index points at an invalid vertex.");
 	core_assert_msg(index1 < _vecVertices.size(), "Index points at an invalid vertex.");
 	core_assert_msg(index2 < _vecVertices.size(), "Index points at an invalid vertex.");
+	core_assert_msg(!_compressed, "Can't add triangles to a mesh with compressed indices");
 	if (!_mayGetResized) {
 		core_assert_msg(_vecIndices.size() + 3 < _vecIndices.capacity(), "addTriangle() call exceeds the capacity of the indices vector and will trigger a realloc (%i vs %i)", (int)_vecIndices.size(), (int)_vecIndices.capacity());
 	}
@@ -168,27 +188,35 @@ IndexType Mesh::addVertex(const VoxelVertex& vertex) {
 
 size_t Mesh::size() {
 	constexpr size_t classSize = sizeof(*this);
-	const size_t indicesSize = _vecIndices.size() * sizeof(IndexType);
+	const size_t indicesSize = _vecIndices.size() * sizeof(IndexType) + _compressedIndices.size() * sizeof(CompactIndexType);
 	const size_t verticesSize = _vecVertices.size() * sizeof(VoxelVertex);
 	const size_t contentSize = indicesSize + verticesSize;
 	return classSize + contentSize;
 }
 
 void Mesh::removeUnusedVertices() {
+	IndexArray newPos;
+	removeUnusedVertices(newPos);
+}
+
+void Mesh::removeUnusedVertices(IndexArray& newPos) {
+	core_assert_msg(!_compressed, "The indices of the mesh were compressed");
 	const size_t vertices = _vecVertices.size();
 	const size_t indices = _vecIndices.size();
-	std::vector<bool> isVertexUsed(vertices);
-	std::fill(isVertexUsed.begin(), isVertexUsed.end(), false);
+	constexpr IndexType unused = (std::numeric_limits<IndexType>::max)();
+	newPos.clear();
+	newPos.reserve(vertices);
+	for (size_t vertCt = 0u; vertCt < vertices; ++vertCt) {
+		newPos.push_back(unused);
+	}
 
 	for (size_t triCt = 0u; triCt < indices; ++triCt) {
-		IndexType v = _vecIndices[triCt];
-		isVertexUsed[v] = true;
+		newPos[_vecIndices[triCt]] = 0;
 	}
 
 	int noOfUsedVertices = 0;
-	IndexArray newPos(vertices);
 	for (size_t vertCt = 0u; vertCt < vertices; ++vertCt) {
-		if (!isVertexUsed[vertCt]) {
+		if (newPos[vertCt] == unused) {
 			continue;
 		}
 		const VoxelVertex& v = _vecVertices[vertCt];
@@ -202,20 +230,84 @@ void Mesh::removeUnusedVertices() {
 	for (size_t triCt = 0u; triCt < indices; ++triCt) {
 		_vecIndices[triCt] = newPos[_vecIndices[triCt]];
 	}
-	_vecIndices.resize(indices);
 }
 
-void Mesh::compressIndices() {
-	if (_vecIndices.empty()) {
-		core_free(_compressedIndices);
-		_compressedIndices = nullptr;
-		_compressedIndexSize = 0;
-		return;
+void Mesh::fillQuadIndices(CompactIndexType* indices, size_t quads) {
+	for (size_t i = 0u; i < quads; ++i) {
+		const CompactIndexType v = (CompactIndexType)(i * 4u);
+		*indices++ = v + 0;
+		*indices++ = v + 1;
+		*indices++ = v + 2;
+		*indices++ = v + 0;
+		*indices++ = v + 2;
+		*indices++ = v + 3;
+	}
+}
+
+static bool isImplicitQuadIndices(const IndexArray& indices, size_t vertices) {
+	if (indices.size() % 6u != 0u || indices.size() / 6u * 4u != vertices) {
+		return false;
+	}
+	const IndexType* idx = indices.data();
+	for (size_t v = 0u; v < vertices; v += 4u, idx += 6) {
+		if (idx[0] != v || idx[1] != v + 1 || idx[2] != v + 2 || idx[3] != v || idx[4] != v + 2 || idx[5] != v + 3) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Mesh::compressIndices() {
+	core_trace_scoped(MeshCompressIndices);
+	if (_compressed) {
+		return true;
+	}
+	_compressedIndices.clear();
+	_subMeshes.clear();
+	const size_t indices = _vecIndices.size();
+	if (isImplicitQuadIndices(_vecIndices, _vecVertices.size())) {
+		constexpr size_t maxQuads = MaxSubMeshVertices / 4u;
+		const size_t quads = indices / 6u;
+		for (size_t quad = 0u; quad < quads; quad += maxQuads) {
+			const size_t n = core_min(maxQuads, quads - quad);
+			_subMeshes.push_back(SubMesh{(uint32_t)(quad * 4u), 0u, (uint32_t)(n * 6u)});
+		}
+		_quadIndices = true;
+	} else {
+		_compressedIndices.reserve(indices);
+		constexpr IndexType maxRange = (std::numeric_limits<CompactIndexType>::max)();
+		IndexType baseVertex = 0u;
+		uint32_t firstIndex = 0u;
+		for (size_t i = 0u; i < indices; i += 3u) {
+			const IndexType* triangle = &_vecIndices[i];
+			const IndexType lower = core_min(triangle[0], core_min(triangle[1], triangle[2]));
+			const IndexType upper = core_max(triangle[0], core_max(triangle[1], triangle[2]));
+			if (upper - lower > maxRange) {
+				Log::debug("Triangle spans %u vertices - can't compress the indices", upper - lower);
+				_compressedIndices.release();
+				_subMeshes.clear();
+				return false;
+			}
+			if (lower < baseVertex || upper - baseVertex > maxRange) {
+				// start a new sub mesh
+				if (i > firstIndex) {
+					_subMeshes.push_back(SubMesh{baseVertex, firstIndex, (uint32_t)i - firstIndex});
+				}
+				baseVertex = lower;
+				firstIndex = (uint32_t)i;
+			}
+			for (int j = 0; j < 3; ++j) {
+				_compressedIndices.push_back((CompactIndexType)(triangle[j] - baseVertex));
+			}
+		}
+		if (firstIndex < indices) {
+			_subMeshes.push_back(SubMesh{baseVertex, firstIndex, (uint32_t)indices - firstIndex});
+		}
 	}
-	const size_t maxSize = _vecIndices.size() * sizeof(voxel::IndexType);
-	core_free(_compressedIndices);
-	_compressedIndices = (uint8_t*)core_malloc(maxSize);
-	util::indexCompress(&_vecIndices.front(), maxSize, _compressedIndexSize, _compressedIndices, maxSize);
+	_compressedNumIndices = indices;
+	_compressed = true;
+	_vecIndices.release();
+	return true;
 }
 
 bool Mesh::operator<(const Mesh& rhs) const {
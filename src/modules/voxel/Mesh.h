@@ -6,11 +6,25 @@
 
 #include "VoxelVertex.h"
 #include "core/collection/DynamicArray.h"
+#include <limits>
 
 namespace voxel {
 
 using VertexArray = core::DynamicArray<voxel::VoxelVertex>;
 using IndexArray = core::DynamicArray<voxel::IndexType>;
+using CompactIndexArray = core::DynamicArray<voxel::CompactIndexType>;
+
+/**
+ * @brief A range of the compressed indices that is rendered with its own base vertex
+ */
+struct SubMesh {
+	/** The vertex index that is added to every index of this sub mesh */
+	uint32_t baseVertex;
+	/** The offset into the compressed indices - always @c 0 for implicit quad indices */
+	uint32_t firstIndex;
+	uint32_t numIndices;
+};
+using SubMeshArray = core::DynamicArray<voxel::SubMesh>;
 
 /**
  * @brief A simple and general-purpose mesh class to represent the data returned by the surface extraction functions.
@@ -53,27 +67,72 @@ public:
 	void clear();
 	bool isEmpty() const;
 	void removeUnusedVertices();
-	void compressIndices();
+	/**
+	 * @param[in,out] newPos Scratch buffer for the vertex remapping - reuse it to avoid allocations
+	 */
+	void removeUnusedVertices(IndexArray& newPos);
+	/**
+	 * @brief Converts the indices into @c CompactIndexType indices and releases the @c IndexType indices.
+	 *
+	 * Meshes with more vertices than the compact index type can address are split into several sub meshes
+	 * with their own base vertex. If every quad of the mesh has its own four consecutive vertices that are
+	 * triangulated as (0, 1, 2) and (0, 2, 3) (e.g. the output of @c extractBinaryCubicMesh() without vertex
+	 * reuse), no indices are stored at all - see @c hasImplicitQuadIndices() and @c fillQuadIndices().
+	 *
+	 * @return @c false if a triangle spans more vertices than the compact index type can address - the
+	 * mesh keeps its uncompressed indices in that case.
+	 * @note The raw index data is no longer available after the compression - but @c getIndex() still works.
+	 */
+	bool compressIndices();
+	bool isCompressed() const;
+	bool hasImplicitQuadIndices() const;
 
-	const uint8_t* compressedIndices() const;
-	size_t compressedIndexSize() const;
+	/**
+	 * @return The compressed indices relative to the base vertex of their sub mesh or @c nullptr for implicit quad indices
+	 */
+	const CompactIndexType* compressedIndices() const;
+	const SubMeshArray& subMeshes() const;
+
+	/**
+	 * @brief Writes the implicit indices of the given amount of quads
+	 * @param[out] indices Buffer for 6 indices per quad
+	 */
+	static void fillQuadIndices(CompactIndexType* indices, size_t quads);
+	/**
+	 * @brief The max amount of vertices a sub mesh of a compressed mesh can address
+	 */
+	static constexpr size_t MaxSubMeshVertices = (size_t)(std::numeric_limits<CompactIndexType>::max)() + 1u;
 
 	bool operator<(const Mesh& rhs) const;
 private:
 	alignas(16) IndexArray _vecIndices;
 	alignas(16) VertexArray _vecVertices;
-	uint8_t *_compressedIndices = nullptr;
-	size_t _compressedIndexSize = 0u;
+	alignas(16) CompactIndexArray _compressedIndices;
+	SubMeshArray _subMeshes;
+	size_t _compressedNumIndices = 0u;
+	bool _compressed = false;
+	bool _quadIndices = false;
 	glm::ivec3 _offset { 0 };
 	bool _mayGetResized;
 };
 
-inline const uint8_t* Mesh::compressedIndices() const {
-	return _compressedIndices;
+inline bool Mesh::isCompressed() const {
+	return _compressed;
+}
+
+inline bool Mesh::hasImplicitQuadIndices() const {
+	return _quadIndices;
+}
+
+inline const CompactIndexType* Mesh::compressedIndices() const {
+	if (_quadIndices) {
+		return nullptr;
+	}
+	return _compressedIndices.data();
 }
 
-inline size_t Mesh::compressedIndexSize() const {
-	return _compressedIndexSize;
+inline const SubMeshArray& Mesh::subMeshes() const {
+	return _subMeshes;
 }
 
 }
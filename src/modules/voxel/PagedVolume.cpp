@@ -3,16 +3,37 @@
  */
 
 #include "PagedVolume.h"
-#include "Morton.h"
 #include "core/Log.h"
 #include "core/Common.h"
 #include "core/Trace.h"
+#include "core/concurrent/ThreadPool.h"
 #include "math/Functions.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/round.hpp>
+#include <vector>
+#include <algorithm>
 
 namespace voxel {
 
+namespace {
+
+/**
+ * @brief The last chunk a thread accessed. The reference keeps the chunk alive if it is evicted concurrently - the
+ * generation of the volume is only used to detect that the chunk might not be part of the volume anymore.
+ */
+struct LastAccessedChunk {
+	int volumeId = -1;
+	int generation = -1;
+	glm::ivec3 pos { 0 };
+	PagedVolume::ChunkPtr chunk;
+};
+
+thread_local LastAccessedChunk lastAccessedChunk;
+
+core::AtomicInt nextVolumeId { 0 };
+
+}
+
 /**
  * This constructor creates a volume with a fixed size which is specified as a parameter. By default this constructor will not enable paging
  * but you can override this if desired. If you do wish to enable
@@ -21,9 +42,14 @@ namespace voxel {
  * @param targetMemoryUsageInBytes The upper limit to how much memory this PagedVolume should aim to use.
  * @param chunkSideLength The size of the chunks making up the volume. Small chunks will compress/decompress faster, but there will also be
  * more of them meaning voxel access could be slower.
+ * @param compressedMemoryUsageInBytes The upper limit of memory that is used to keep evicted chunks in a compressed form. A chunk that is
+ * accessed again is then just decompressed instead of going through the pager again. @c 0 disables the compressed tier.
+ * @param chunkMemoryLayout The order in which the voxels of the chunks are stored in memory. The default can be changed at compile time.
  */
-PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength) :
-		_chunkSideLength(chunkSideLength), _pager(pager), _region(0, 0, 0, -1, -1, -1) {
+PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength, uint32_t compressedMemoryUsageInBytes,
+		MemoryLayout chunkMemoryLayout) :
+		_volumeId(nextVolumeId.increment(1)), _compressedMemoryUsageInBytes(compressedMemoryUsageInBytes),
+		_chunkSideLength(chunkSideLength), _chunkMemoryLayout(chunkMemoryLayout), _pager(pager), _region(0, 0, 0, -1, -1, -1) {
 	// Validation of parameters
 	core_assert_msg(_pager, "You must provide a valid pager when constructing a PagedVolume");
 	core_assert_msg(targetMemoryUsageInBytes >= 1 * 1024 * 1024, "Target memory usage is too small to be practical");
@@ -47,10 +73,69 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
 				targetMemoryUsageInBytes / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
 	}
 	_chunkCountLimit = core_max(_chunkCountLimit, minPracticalNoOfChunks);
+	setEvictionLowWaterMark(90);
+
+	_prefetchState = core::make_shared<PrefetchState>();
+	_prefetchState->volume = this;
 
 	// Inform the user about the chosen memory configuration.
 	Log::info("Memory usage limit for volume now set to %uMb (%u chunks of %uKb each).",
 			(_chunkCountLimit * chunkSizeInBytes) / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+	if (_compressedMemoryUsageInBytes > 0u) {
+		Log::info("Memory usage limit for compressed chunks set to %uMb", _compressedMemoryUsageInBytes / (1024 * 1024));
+	}
+}
+
+PagedVolume::Statistics PagedVolume::statistics() const {
+	Statistics stats;
+	for (int i = 0; i < ChunkShardCount; ++i) {
+		ChunkShard& shard = _shards[i];
+		core::ScopedLock lock(shard.lock);
+		stats.uncompressedHits += shard.hits;
+		for (const auto& e : shard.chunks) {
+			if (e.second->isUniform()) {
+				++stats.uniformChunks;
+			} else {
+				stats.uncompressedBytes += e.second->dataSizeInBytes();
+			}
+		}
+	}
+	stats.uncompressedMisses = _uncompressedMisses;
+	stats.compressedHits = _compressedHits;
+	stats.compressedMisses = stats.uncompressedMisses - stats.compressedHits;
+	core::ScopedLock pageInLock(_pageInLock);
+	stats.compressedChunks = (int)_compressedChunks.size();
+	stats.compressedBytes = _compressedBytes;
+	return stats;
+}
+
+bool PagedVolume::isUniform(const Region& region, Voxel& voxel) const {
+	const glm::ivec3& mins = chunkPos(region.getLowerX(), region.getLowerY(), region.getLowerZ());
+	const glm::ivec3& maxs = chunkPos(region.getUpperX(), region.getUpperY(), region.getUpperZ());
+	bool first = true;
+	for (int32_t z = mins.z; z <= maxs.z; ++z) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t x = mins.x; x <= maxs.x; ++x) {
+				const ChunkPtr& c = chunk(x, y, z);
+				if (!c->isUniform()) {
+					return false;
+				}
+				if (first) {
+					voxel = c->uniformVoxel();
+					first = false;
+				} else if (!voxel.isSame(c->uniformVoxel())) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void PagedVolume::setEvictionLowWaterMark(uint8_t percent) {
+	core_assert_msg(percent <= 100, "The low water mark is given in percent of the chunk count limit");
+	// at least one chunk must get evicted to make room for the new one
+	_chunkCountLowWaterMark = core_min(_chunkCountLimit * percent / 100u, _chunkCountLimit - 1u);
 }
 
 /**
@@ -58,6 +143,14 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
  * data via the dataOverflowHandler() if desired.
  */
 PagedVolume::~PagedVolume() {
+	// queued prefetch tasks are skipped from now on - but we have to wait for the running ones
+	{
+		core::ScopedLock lock(_prefetchState->lock);
+		_prefetchState->volume = nullptr;
+		_prefetchState->condition.wait(_prefetchState->lock, [this] {
+			return _prefetchState->running == 0;
+		});
+	}
 	flushAll();
 }
 
@@ -87,10 +180,13 @@ PagedVolume::ChunkPtr PagedVolume::chunk(const glm::ivec3& pos) const {
  * @return The voxel value
  */
 const Voxel& PagedVolume::voxel(const glm::ivec3& v3dPos) const {
+	const int32_t chunkX = v3dPos.x >> _chunkSideLengthPower;
+	const int32_t chunkY = v3dPos.y >> _chunkSideLengthPower;
+	const int32_t chunkZ = v3dPos.z >> _chunkSideLengthPower;
 	const uint32_t xOffset = static_cast<uint32_t>(v3dPos.x & _chunkMask);
 	const uint32_t yOffset = static_cast<uint32_t>(v3dPos.y & _chunkMask);
 	const uint32_t zOffset = static_cast<uint32_t>(v3dPos.z & _chunkMask);
-	return chunk(v3dPos)->voxel(xOffset, yOffset, zOffset);
+	return cachedChunk(chunkX, chunkY, chunkZ)->voxel(xOffset, yOffset, zOffset);
 }
 
 /**
@@ -169,32 +265,159 @@ void PagedVolume::setVoxels(int32_t uXPos, int32_t uYPos, int32_t uZPos, int nx,
  * Removes all voxels from memory by removing all chunks. The application has the chance to persist the data via @c Pager::pageOut
  */
 void PagedVolume::flushAll() {
-	core::ScopedWriteLock writeLock(_volumeLock);
-	_chunks.clear();
+	// the chunks are paged out here - don't do this concurrently to the page-out of the evicted chunks
+	core::ScopedLock pageOutLock(_pageOutLock);
+	core::ScopedLock pageInLock(_pageInLock);
+	for (int i = 0; i < ChunkShardCount; ++i) {
+		ChunkMap chunks;
+		{
+			ChunkShard& shard = _shards[i];
+			core::ScopedLock lock(shard.lock);
+			shard.chunks.swap(chunks);
+			_generation.increment(1);
+		}
+		_chunkCount.decrement((int)chunks.size());
+		// the chunks are destroyed outside of the shard lock
+		pageOutModifiedChunks(chunks);
+	}
+	_clockHand = nullptr;
+	pageOutModifiedChunks(_pagingOut);
+	_pagingOut.clear();
+	_compressedChunks.clear();
+	_compressedLRU.clear();
+	_compressedBytes = 0u;
 }
 
 /**
- * As we have added a chunk we may have exceeded our target chunk limit. Search through the array to
- * determine how many chunks we have, as well as finding the oldest timestamp. Note that this is potentially
- * wasteful and we may instead wish to track how many chunks we have and/or delete a chunk at random (or
- * just check e.g. 10 and delete the oldest of those) but we'll see if this is a bottleneck first. Paging
- * the data in is probably more expensive.
+ * The chunks might still be referenced (e.g. by the per-thread chunk cache) when the volume and the pager are already
+ * gone - so they are paged out here instead of on destruction.
  */
-void PagedVolume::deleteOldestChunkIfNeeded() const {
-	core_trace_scoped(DeleteOldestChunk);
-	ChunkMap::iterator oldestChunk = _chunks.end();
-	uint32_t oldestChunkTimestamp = _timestamper;
-	for (ChunkMap::iterator i = _chunks.begin(); i != _chunks.end(); ++i) {
-		const ChunkPtr& chunk = i->second;
-		if (chunk->_chunkLastAccessed < oldestChunkTimestamp) {
-			oldestChunkTimestamp = chunk->_chunkLastAccessed;
-			oldestChunk = i;
+void PagedVolume::pageOutModifiedChunks(const ChunkMap& chunks) const {
+	for (const auto& e : chunks) {
+		Chunk* chunk = e.second.get();
+		if (chunk->_dataModified) {
+			_pager->pageOut(chunk);
+			chunk->_dataModified = false;
 		}
 	}
-	if (oldestChunk != _chunks.end()) {
-		Log::debug("delete oldest chunk - reached %u", _chunkCountLimit);
-		_chunks.erase(oldestChunk);
+}
+
+/**
+ * Keeps the voxels of an evicted chunk in the compressed tier. The chunk is still paged out when it gets destroyed, so the
+ * compressed copy doesn't have to be persisted again - it can just be dropped once the compressed memory budget is exhausted.
+ * @param data The run-length encoded voxels of the chunk - see @c pageOutEvictedChunks()
+ * @note Must be called with the page-in lock held
+ */
+void PagedVolume::addCompressedChunk(const glm::ivec3& pos, CompressedChunk&& data) const {
+	auto existing = _compressedChunks.find(pos);
+	if (existing != _compressedChunks.end()) {
+		_compressedBytes -= existing->second.data.sizeInBytes();
+		_compressedLRU.erase(existing->second.lruIter);
+		_compressedChunks.erase(existing);
 	}
+	CompressedEntry& entry = _compressedChunks[pos];
+	entry.data = core::move(data);
+	_compressedBytes += entry.data.sizeInBytes();
+	_compressedLRU.push_front(pos);
+	entry.lruIter = _compressedLRU.begin();
+
+	while (_compressedBytes > _compressedMemoryUsageInBytes && !_compressedLRU.empty()) {
+		auto i = _compressedChunks.find(_compressedLRU.back());
+		core_assert(i != _compressedChunks.end());
+		_compressedBytes -= i->second.data.sizeInBytes();
+		_compressedChunks.erase(i);
+		_compressedLRU.pop_back();
+	}
+}
+
+/**
+ * @return A new chunk with the voxels from the compressed tier, or an empty pointer if the chunk isn't there
+ * @note Must be called with the page-in lock held
+ */
+PagedVolume::ChunkPtr PagedVolume::decompressChunk(const glm::ivec3& pos) const {
+	auto i = _compressedChunks.find(pos);
+	if (i == _compressedChunks.end()) {
+		return ChunkPtr();
+	}
+	core_trace_scoped(PagedVolumeDecompressChunk);
+	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager, _chunkMemoryLayout);
+	const CompressedEntry& entry = i->second;
+	if (!chunk->decompress(entry.data)) {
+		Log::error("Failed to decompress chunk at %i:%i:%i", pos.x, pos.y, pos.z);
+		chunk = ChunkPtr();
+	}
+	_compressedBytes -= entry.data.sizeInBytes();
+	_compressedLRU.erase(entry.lruIter);
+	_compressedChunks.erase(i);
+	return chunk;
+}
+
+void PagedVolume::linkChunk(Chunk* chunk) const {
+	if (_clockHand == nullptr) {
+		chunk->_clockPrev = chunk->_clockNext = chunk;
+		_clockHand = chunk;
+		return;
+	}
+	// insert right behind the clock hand - this is the last chunk the hand will visit
+	chunk->_clockNext = _clockHand;
+	chunk->_clockPrev = _clockHand->_clockPrev;
+	_clockHand->_clockPrev->_clockNext = chunk;
+	_clockHand->_clockPrev = chunk;
+}
+
+void PagedVolume::unlinkChunk(Chunk* chunk) const {
+	if (chunk->_clockNext == chunk) {
+		_clockHand = nullptr;
+	} else {
+		chunk->_clockPrev->_clockNext = chunk->_clockNext;
+		chunk->_clockNext->_clockPrev = chunk->_clockPrev;
+		if (_clockHand == chunk) {
+			_clockHand = chunk->_clockNext;
+		}
+	}
+	chunk->_clockPrev = chunk->_clockNext = nullptr;
+}
+
+/**
+ * Before we add a chunk we may exceed our target chunk limit. Chunks are evicted with the CLOCK (second-chance)
+ * algorithm: the clock hand walks the ring of chunks and clears the referenced flag of every chunk it passes. A
+ * chunk that is found without the flag wasn't accessed for a whole turn of the hand and is removed. Once the limit
+ * is reached we evict down to the low water mark to not pay the price for every new chunk. The evicted chunks are
+ * handed over to the pager in @c pageOutEvictedChunks().
+ * @note Must be called with the page-in lock held
+ */
+void PagedVolume::evictChunksIfNeeded() const {
+	if ((uint32_t)(_chunkCount + 1) < _chunkCountLimit) {
+		return;
+	}
+	core_trace_scoped(EvictChunks);
+	Log::debug("evict chunks - reached %u", _chunkCountLimit);
+	int evictedNow = 0;
+	while (_clockHand != nullptr && (uint32_t)(int)_chunkCount > _chunkCountLowWaterMark) {
+		Chunk* candidate = _clockHand;
+		if (candidate->_referenced) {
+			candidate->_referenced = false;
+			_clockHand = candidate->_clockNext;
+			continue;
+		}
+		unlinkChunk(candidate);
+		const glm::ivec3& pos = candidate->chunkPos();
+		ChunkShard& shard = _shards[shardIndex(pos)];
+		{
+			core::ScopedLock lock(shard.lock);
+			auto i = shard.chunks.find(pos);
+			core_assert(i != shard.chunks.end());
+			// the position can't be pending - page-ins of pending positions drain them first
+			_pagingOut.emplace(pos, core::move(i->second));
+			shard.chunks.erase(i);
+			_generation.increment(1);
+		}
+		_chunkCount.decrement(1);
+		++evictedNow;
+	}
+	const int evictedChunks = _evictedChunks.increment(evictedNow) + evictedNow;
+	core_trace_plot("PagedVolumeEvictedChunks", (int64_t)evictedChunks);
+	core_trace_plot("PagedVolumeChunks", (int64_t)(int)_chunkCount);
 }
 
 PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
@@ -202,8 +425,7 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	// The chunk was not found so we will create a new one.
 	glm::ivec3 pos(chunkX, chunkY, chunkZ);
 	Log::debug("create new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
-	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
-	chunk->_chunkLastAccessed = ++_timestamper; // Important, as we may soon delete the oldest chunk
+	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager, _chunkMemoryLayout);
 
 	// Pass the chunk to the Pager to give it a chance to initialise it with any data
 	// From the coordinates of the chunk we deduce the coordinates of the contained voxels.
@@ -216,28 +438,249 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	// Page the data in
 	// We'll use this later to decide if data needs to be paged out again.
 	chunk->_dataModified = _pager->pageIn(pctx);
+	// chunks that are completely empty or solid don't need any voxel data
+	chunk->compact();
 	Log::debug("finished creating new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
 
 	return chunk;
 }
 
+PagedVolume::ChunkPtr PagedVolume::findChunk(const glm::ivec3& pos) const {
+	ChunkShard& shard = _shards[shardIndex(pos)];
+	core::ScopedLock lock(shard.lock);
+	auto i = shard.chunks.find(pos);
+	if (i == shard.chunks.end()) {
+		return ChunkPtr();
+	}
+	return i->second;
+}
+
+/**
+ * @note Must be called with the page-in lock held
+ */
+void PagedVolume::insertChunk(const ChunkPtr& chunk) const {
+	// make room before the new chunk is added - it must not be the one that gets evicted
+	evictChunksIfNeeded();
+	const glm::ivec3& pos = chunk->chunkPos();
+	{
+		ChunkShard& shard = _shards[shardIndex(pos)];
+		core::ScopedLock lock(shard.lock);
+		shard.chunks.emplace(pos, chunk);
+	}
+	linkChunk(chunk.get());
+	_chunkCount.increment(1);
+}
+
+/**
+ * Hands the evicted chunks over to the pager. The positions are only released after the pager is done with
+ * them - see @c pageInChunk(). Once this returns, all the chunks that were evicted before the call are paged out.
+ */
+void PagedVolume::pageOutEvictedChunks() const {
+	{
+		// the positions are only removed once they are paged out - nothing to wait for if there are none
+		core::ScopedLock pageInLock(_pageInLock);
+		if (_pagingOut.empty()) {
+			return;
+		}
+	}
+	core::ScopedLock pageOutLock(_pageOutLock);
+	std::vector<ChunkPtr> chunks;
+	{
+		core::ScopedLock pageInLock(_pageInLock);
+		if (_pagingOut.empty()) {
+			return;
+		}
+		chunks.reserve(_pagingOut.size());
+		for (const auto& e : _pagingOut) {
+			chunks.push_back(e.second);
+		}
+	}
+	core_trace_scoped(PagedVolumePageOut);
+	std::vector<CompressedChunk> compressed(_compressedMemoryUsageInBytes > 0u ? chunks.size() : 0u);
+	for (size_t i = 0u; i < chunks.size(); ++i) {
+		const ChunkPtr& chunk = chunks[i];
+		if (chunk->_dataModified) {
+			_pager->pageOut(chunk.get());
+			// don't page it out again when the last reference is gone
+			chunk->_dataModified = false;
+		}
+		if (!compressed.empty()) {
+			// the encoding doesn't need the page-in lock - the position stays pending until the result is added
+			core_trace_scoped(PagedVolumeCompressChunk);
+			chunk->compress(compressed[i]);
+		}
+	}
+	core::ScopedLock pageInLock(_pageInLock);
+	for (size_t i = 0u; i < chunks.size(); ++i) {
+		const glm::ivec3& pos = chunks[i]->chunkPos();
+		if (!compressed.empty()) {
+			addCompressedChunk(pos, core::move(compressed[i]));
+		}
+		_pagingOut.erase(pos);
+	}
+}
+
+PagedVolume::ChunkPtr PagedVolume::pageInChunk(const glm::ivec3& pos) const {
+	core_trace_scoped(PagedVolumePageIn);
+	ChunkPtr chunk;
+	for (;;) {
+		{
+			core::ScopedLock pageInLock(_pageInLock);
+			// another thread is paging in the same chunk - wait for it instead of calling the pager twice
+			while (_pagingIn.find(pos) != _pagingIn.end()) {
+				_pagingInCondition.wait(_pageInLock);
+			}
+			chunk = findChunk(pos);
+			if (chunk) {
+				break;
+			}
+			if (_pagingOut.find(pos) == _pagingOut.end()) {
+				_uncompressedMisses.increment(1);
+				chunk = decompressChunk(pos);
+				if (chunk) {
+					_compressedHits.increment(1);
+					insertChunk(chunk);
+				} else {
+					_pagingIn.insert(pos);
+				}
+				break;
+			}
+		}
+		// the evicted chunk must reach the pager before the pager is asked for it again
+		pageOutEvictedChunks();
+	}
+	if (!chunk) {
+		// the page-in lock is not held while the pager is working - other threads are still able to access
+		// and page in the other chunks while we are waiting for the pager
+		chunk = createNewChunk(pos.x, pos.y, pos.z);
+		core::ScopedLock pageInLock(_pageInLock);
+		insertChunk(chunk);
+		_pagingIn.erase(pos);
+		_pagingInCondition.notify_all();
+	}
+	pageOutEvictedChunks();
+	return chunk;
+}
+
+PagedVolume::ChunkPtr PagedVolume::tryChunk(const glm::ivec3& pos) const {
+	const ChunkPtr& c = findChunk(chunkPos(pos));
+	if (c && !c->_referenced) {
+		c->_referenced = true;
+	}
+	return c;
+}
+
+PagedVolume::ChunkState PagedVolume::chunkState(const glm::ivec3& pos) const {
+	const glm::ivec3& p = chunkPos(pos);
+	if (findChunk(p)) {
+		return ChunkState::Ready;
+	}
+	core::ScopedLock lock(_prefetchState->lock);
+	if (_prefetchState->queued.find(p) != _prefetchState->queued.end()) {
+		return ChunkState::Queued;
+	}
+	return ChunkState::Missing;
+}
+
+int PagedVolume::prefetch(const Region& region, core::ThreadPool& threadPool) const {
+	return prefetch(region, region.getCenter(), threadPool);
+}
+
+int PagedVolume::prefetch(const glm::ivec3& pos, const glm::ivec3& movement, const glm::ivec3& extent, core::ThreadPool& threadPool) const {
+	const glm::ivec3 target = pos + movement;
+	const Region region(glm::min(pos, target) - extent, glm::max(pos, target) + extent);
+	return prefetch(region, target, threadPool);
+}
+
+int PagedVolume::prefetch(const Region& region, const glm::ivec3& sortPos, core::ThreadPool& threadPool) const {
+	core_trace_scoped(PagedVolumePrefetch);
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	std::vector<glm::ivec3> positions;
+	for (int x = mins.x; x <= maxs.x; ++x) {
+		for (int y = mins.y; y <= maxs.y; ++y) {
+			for (int z = mins.z; z <= maxs.z; ++z) {
+				const glm::ivec3 pos(x, y, z);
+				if (!findChunk(pos)) {
+					positions.push_back(pos);
+				}
+			}
+		}
+	}
+	// the thread pool executes the tasks in the order they were added
+	const glm::ivec3& sortChunkPos = chunkPos(sortPos);
+	std::sort(positions.begin(), positions.end(), [&] (const glm::ivec3& lhs, const glm::ivec3& rhs) {
+		const glm::ivec3& dl = lhs - sortChunkPos;
+		const glm::ivec3& dr = rhs - sortChunkPos;
+		return dl.x * dl.x + dl.y * dl.y + dl.z * dl.z < dr.x * dr.x + dr.y * dr.y + dr.z * dr.z;
+	});
+
+	const core::SharedPtr<PrefetchState> state = _prefetchState;
+	int queued = 0;
+	for (const glm::ivec3& pos : positions) {
+		{
+			core::ScopedLock lock(state->lock);
+			if (!state->queued.insert(pos).second) {
+				continue;
+			}
+		}
+		threadPool.enqueue([state, pos] () {
+			const PagedVolume* volume;
+			{
+				core::ScopedLock lock(state->lock);
+				volume = state->volume;
+				if (volume == nullptr) {
+					state->queued.erase(pos);
+					return;
+				}
+				++state->running;
+			}
+			volume->chunk(pos.x, pos.y, pos.z);
+			core::ScopedLock lock(state->lock);
+			state->queued.erase(pos);
+			--state->running;
+			state->condition.notify_all();
+		});
+		++queued;
+	}
+	return queued;
+}
+
 PagedVolume::ChunkPtr PagedVolume::chunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
 	core_trace_scoped(PagedVolumeChunk);
-	core::ScopedWriteLock chunkWriteLock(_volumeLock);
 	const glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	auto i = _chunks.find(pos);
-	if (i == _chunks.end()) {
-		const ChunkPtr& chunk = createNewChunk(chunkX, chunkY, chunkZ);
-		_chunks.put(pos, chunk);
-		const size_t chunkCount = _chunks.size();
-		if (chunkCount >= _chunkCountLimit) {
-			deleteOldestChunkIfNeeded();
-		}
-		return chunk;
-	}
-	const ChunkPtr& chunk = i->second;
-	chunk->_chunkLastAccessed = ++_timestamper;
-	return chunk;
+	ChunkShard& shard = _shards[shardIndex(pos)];
+	{
+		core::ScopedLock lock(shard.lock);
+		auto i = shard.chunks.find(pos);
+		if (i != shard.chunks.end()) {
+			++shard.hits;
+			const ChunkPtr& chunk = i->second;
+			if (!chunk->_referenced) {
+				chunk->_referenced = true;
+			}
+			return chunk;
+		}
+	}
+	return pageInChunk(pos);
+}
+
+const PagedVolume::Chunk* PagedVolume::cachedChunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
+	LastAccessedChunk& last = lastAccessedChunk;
+	// fetch the generation before the lookup - if a chunk is removed after this point, the cache entry is
+	// already outdated and won't be used.
+	const int generation = _generation;
+	if (last.volumeId == _volumeId && last.generation == generation && last.pos.x == chunkX && last.pos.y == chunkY && last.pos.z == chunkZ) {
+		if (!last.chunk->_referenced) {
+			last.chunk->_referenced = true;
+		}
+		return last.chunk.get();
+	}
+	last.chunk = chunk(chunkX, chunkY, chunkZ);
+	last.volumeId = _volumeId;
+	last.generation = generation;
+	last.pos = glm::ivec3(chunkX, chunkY, chunkZ);
+	return last.chunk.get();
 }
 
 }
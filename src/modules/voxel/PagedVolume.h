@@ -6,13 +6,23 @@
 
 #include "Voxel.h"
 #include "Region.h"
+#include "MemoryLayout.h"
 #include "core/NonCopyable.h"
 #include "core/GLM.h"
 #include "core/Assert.h"
-#include "core/concurrent/ReadWriteLock.h"
+#include "core/concurrent/Lock.h"
 #include "core/concurrent/Atomic.h"
-#include "core/collection/Map.h"
+#include "core/concurrent/ConditionVariable.h"
 #include "core/SharedPtr.h"
+#include "core/Trace.h"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <unordered_set>
+
+namespace core {
+class ThreadPool;
+}
 
 namespace voxel {
 
@@ -36,17 +46,27 @@ public:
 	class Chunk;
 	/// The Pager class is responsible for the loading and unloading of Chunks, and can be subclassed by the user.
 	class Pager;
+	/// Run-length encoded voxel data of a chunk that was evicted from memory, but is still kept in the compressed tier.
+	struct CompressedChunk;
 
 	class Chunk {
 		friend class PagedVolume;
 		friend class PagedVolumeWrapper;
 
 	public:
-		Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pager);
+		Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pager, MemoryLayout layout = DefaultChunkMemoryLayout);
 		~Chunk();
 
 		bool setData(const Voxel* voxels, size_t sizeInBytes);
-		Voxel* data() const;
+		/**
+		 * @note If the chunk is uniform, this allocates the voxel data - readers should use @c allocatedData()
+		 */
+		Voxel* data();
+		/**
+		 * @return The voxel data or @c nullptr if the chunk is uniform. This never allocates, so concurrent
+		 * readers of the chunk don't modify it.
+		 */
+		const Voxel* allocatedData() const;
 		uint32_t dataSizeInBytes() const;
 		uint32_t voxels() const;
 
@@ -60,14 +80,55 @@ public:
 
 		const glm::ivec3& chunkPos() const;
 		int16_t sideLength() const;
+		/**
+		 * @brief Maps the local voxel coordinates to the index in the data returned by @c data()
+		 */
+		const VoxelLayout& layout() const;
+
+		/**
+		 * @brief A uniform chunk doesn't allocate any voxel data - all voxels have the same value. The data is
+		 * allocated with the first @c setVoxel() call that sets a different voxel (copy-on-write).
+		 */
+		bool isUniform() const;
+		/**
+		 * @return The value of all voxels of a uniform chunk
+		 */
+		const Voxel& uniformVoxel() const;
+		/**
+		 * @brief Releases the voxel data if all voxels have the same value
+		 * @return @c true if the chunk is uniform
+		 */
+		bool compact();
+
+		/**
+		 * @brief Run-length encodes the voxels of this chunk
+		 */
+		void compress(CompressedChunk& out) const;
+		/**
+		 * @brief Restores the voxels from the given run-length encoded data
+		 * @return @c false if the data doesn't match the size of this chunk
+		 */
+		bool decompress(const CompressedChunk& in);
 
 	private:
-		// This is updated by the PagedVolume and used to discard the least recently used chunks.
-		uint32_t _chunkLastAccessed = 0u;
+		// Set by the PagedVolume on every access and cleared by the clock hand - chunks that weren't referenced
+		// for a whole turn of the clock hand are discarded. New chunks start unreferenced - otherwise a burst of
+		// new chunks would force the clock hand to clear every flag before it is able to evict anything
+		mutable core::AtomicBool _referenced { false };
+		// The ring of chunks the clock hand walks over - guarded by the page-in lock of the PagedVolume
+		Chunk* _clockPrev = nullptr;
+		Chunk* _clockNext = nullptr;
 
 		static uint32_t calculateSizeInBytes(uint32_t sideLength);
 
+		// allocates the voxel data for a uniform chunk
+		void expand();
+
+		// this is null as long as the chunk is uniform
 		Voxel* _data = nullptr;
+		// maps the voxel positions to the index in the voxel data
+		const VoxelLayout* _layout;
+		Voxel _uniformVoxel;
 		uint16_t _sideLength = 0u;
 
 		// This is so we can tell whether a uncompressed chunk has to be recompressed and whether
@@ -82,6 +143,47 @@ public:
 	};
 	typedef core::SharedPtr<Chunk> ChunkPtr;
 
+	struct CompressedChunk {
+		struct Run {
+			uint16_t length;
+			Voxel voxel;
+		};
+		std::vector<Run> runs;
+
+		inline uint32_t sizeInBytes() const {
+			return (uint32_t)(runs.size() * sizeof(Run));
+		}
+	};
+
+	/**
+	 * @brief The state of a chunk for the non-blocking access functions
+	 */
+	enum class ChunkState {
+		/** The chunk is not in memory and no page-in was requested */
+		Missing,
+		/** The page-in was requested via @c prefetch() but isn't done yet */
+		Queued,
+		/** The chunk is in memory - accessing it won't block */
+		Ready
+	};
+
+	/**
+	 * @brief Hit and miss counters of the uncompressed and the compressed chunk tier. A miss in the
+	 * compressed tier means that the chunk had to go through the Pager.
+	 */
+	struct Statistics {
+		int uncompressedHits = 0;
+		int uncompressedMisses = 0;
+		int compressedHits = 0;
+		int compressedMisses = 0;
+		int compressedChunks = 0;
+		uint32_t compressedBytes = 0u;
+		/** the amount of chunks in memory that don't have any voxel data allocated */
+		int uniformChunks = 0;
+		/** the memory that is allocated for the voxel data of the chunks in memory */
+		uint64_t uncompressedBytes = 0u;
+	};
+
 	struct PagerContext {
 		Region region;
 		ChunkPtr chunk;
@@ -104,6 +206,8 @@ public:
 
 		/**
 		 * @return @c true if the chunk was modified (created), @c false if it was just loaded
+		 * @note This is called concurrently for different chunks - but never twice at the same time for
+		 * the same chunk
 		 */
 		virtual bool pageIn(PagerContext& ctx) = 0;
 		virtual void pageOut(Chunk* chunk) = 0;
@@ -198,8 +302,19 @@ public:
 		int32_t _yPosInVolume = 0;
 		int32_t _zPosInVolume = 0;
 
+		/**
+		 * @brief Updates the voxel pointer to the current position in the current chunk
+		 */
+		void updateCurrentVoxel();
+
 		//Other current position information
 		Voxel* _currentVoxel = nullptr;
+		// zero for uniform chunks - the voxel pointer doesn't move inside those chunks
+		int32_t _deltaMask = ~0;
+		// the offsets to move the voxel pointer by one voxel - depends on the memory layout of the chunks
+		const int32_t* _deltaX;
+		const int32_t* _deltaY;
+		const int32_t* _deltaZ;
 		ChunkPtr _currentChunk;
 		mutable ChunkPtr _cachedChunk;
 
@@ -216,7 +331,8 @@ public:
 
 public:
 	/** @brief Constructor for creating a fixed size volume. */
-	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32);
+	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32, uint32_t compressedMemoryUsageInBytes = 0u,
+			MemoryLayout chunkMemoryLayout = DefaultChunkMemoryLayout);
 	~PagedVolume();
 
 	/** @brief Gets a voxel at the position given by <tt>x,y,z</tt> coordinates */
@@ -237,18 +353,85 @@ public:
 	/** @brief Removes all voxels from memory */
 	void flushAll();
 
+	/**
+	 * @brief Blocking access to the chunk at the given world position - if the chunk isn't in memory
+	 * yet, it is paged in by the calling thread.
+	 */
 	ChunkPtr chunk(const glm::ivec3& pos) const;
 
+	/**
+	 * @brief Non-blocking access to the chunk at the given world position
+	 * @return An empty pointer if the chunk isn't in memory yet
+	 * @sa prefetch()
+	 */
+	ChunkPtr tryChunk(const glm::ivec3& pos) const;
+
+	/**
+	 * @brief Non-blocking check whether the chunk at the given world position can be accessed without paging it in
+	 */
+	ChunkState chunkState(const glm::ivec3& pos) const;
+
+	/**
+	 * @brief Queues the page-in of all chunks that intersect the given world region. The chunks that are closest
+	 * to the center of the region are queued first.
+	 * @return The amount of chunks that were queued - chunks that are already in memory or queued are skipped.
+	 */
+	int prefetch(const Region& region, core::ThreadPool& threadPool) const;
+
+	/**
+	 * @brief Queues the page-in of the chunks around the given world position and along the movement vector.
+	 * @param[in] pos The current world position - e.g. of the player
+	 * @param[in] movement The world position delta that is expected in the near future
+	 * @param[in] extent The half size of the area around the current and the expected position in world units
+	 * @return The amount of chunks that were queued
+	 */
+	int prefetch(const glm::ivec3& pos, const glm::ivec3& movement, const glm::ivec3& extent, core::ThreadPool& threadPool) const;
+
+	/**
+	 * @brief Checks whether all chunks that intersect the given region are uniform chunks with the same voxel value
+	 * @note This pages in the chunks if needed
+	 */
+	bool isUniform(const Region& region, Voxel& voxel) const;
+
 	glm::ivec3 chunkPos(int x, int y, int z) const;
 
 	inline glm::ivec3 chunkPos(const glm::ivec3& worldPos) const {
 		return chunkPos(worldPos.x, worldPos.y, worldPos.z);
 	}
 
+	inline MemoryLayout chunkMemoryLayout() const {
+		return _chunkMemoryLayout;
+	}
+
 	inline uint16_t chunkSideLength() const {
 		return _chunkSideLength;
 	}
 
+	/**
+	 * @return The amount of chunks that are currently paged in
+	 */
+	inline int chunkCount() const {
+		return _chunkCount;
+	}
+
+	/**
+	 * @return The amount of chunks that were removed from the volume because the chunk count limit was reached
+	 */
+	inline int evictedChunks() const {
+		return _evictedChunks;
+	}
+
+	/**
+	 * @brief Once the chunk count limit is reached, chunks are evicted in one batch until only the given
+	 * percentage of the limit is left. This avoids running the eviction for every new chunk.
+	 */
+	void setEvictionLowWaterMark(uint8_t percent);
+
+	/**
+	 * @brief Hit and miss counters for the chunk tiers
+	 */
+	Statistics statistics() const;
+
 protected:
 	/// Copy constructor
 	PagedVolume(const PagedVolume& rhs);
@@ -258,18 +441,85 @@ protected:
 
 private:
 	ChunkPtr chunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
+	/**
+	 * @brief Lookup of the chunk that doesn't go through the shard locks if the calling thread accessed
+	 * the same chunk of this volume the last time and no chunk was removed from the volume in the meantime.
+	 * The returned chunk is kept alive until the calling thread accesses another chunk.
+	 */
+	const Chunk* cachedChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
+	ChunkPtr pageInChunk(const glm::ivec3& pos) const;
+	ChunkPtr findChunk(const glm::ivec3& pos) const;
+	void insertChunk(const ChunkPtr& chunk) const;
+	int prefetch(const Region& region, const glm::ivec3& sortPos, core::ThreadPool& threadPool) const;
 	ChunkPtr createNewChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	void deleteOldestChunkIfNeeded() const;
+	void evictChunksIfNeeded() const;
+	void pageOutEvictedChunks() const;
+	void linkChunk(Chunk* chunk) const;
+	void unlinkChunk(Chunk* chunk) const;
+	void addCompressedChunk(const glm::ivec3& pos, CompressedChunk&& data) const;
+	ChunkPtr decompressChunk(const glm::ivec3& pos) const;
 
-	mutable int32_t _timestamper = 0;
+	/**
+	 * Increased whenever a chunk is removed from the volume - invalidates the per-thread chunk caches
+	 */
+	mutable core::AtomicInt _generation { 0 };
+	mutable core::AtomicInt _chunkCount { 0 };
+	mutable core::AtomicInt _evictedChunks { 0 };
+	const int _volumeId;
 
 	uint32_t _chunkCountLimit = 0u;
+	uint32_t _chunkCountLowWaterMark = 0u;
 
-	typedef core::Map<glm::ivec3, ChunkPtr, 64, glm::hash<glm::ivec3>> ChunkMap;
-	mutable ChunkMap _chunks;
+	/**
+	 * The next chunk that is checked for eviction (CLOCK/second-chance) - guarded by the page-in lock
+	 */
+	mutable Chunk* _clockHand = nullptr;
+
+	typedef std::unordered_map<glm::ivec3, ChunkPtr, glm::hash<glm::ivec3>> ChunkMap;
+	void pageOutModifiedChunks(const ChunkMap& chunks) const;
+	/**
+	 * @brief The chunks are distributed over several independently locked maps. A lookup of an already
+	 * existing chunk only locks the shard the chunk belongs to.
+	 */
+	struct ChunkShard {
+		core_trace_mutex(core::Lock, lock, "PagedVolumeShard");
+		ChunkMap chunks;
+		// counted per shard to not add another contended cache line to the lookup
+		int hits = 0;
+	};
+	static constexpr int ChunkShardCount = 16;
+	static_assert((ChunkShardCount & (ChunkShardCount - 1)) == 0, "ChunkShardCount must be a power of two");
+	mutable ChunkShard _shards[ChunkShardCount];
+
+	static inline int shardIndex(const glm::ivec3& pos) {
+		const uint32_t h = ((uint32_t)pos.x * 73856093u) ^ ((uint32_t)pos.y * 19349663u) ^ ((uint32_t)pos.z * 83492791u);
+		return (int)(h & (ChunkShardCount - 1));
+	}
+
+	/**
+	 * @brief The compressed tier - evicted chunks are kept here until the compressed memory budget is
+	 * exhausted. The least recently compressed chunks are dropped first. Guarded by the page-in lock.
+	 */
+	struct CompressedEntry {
+		CompressedChunk data;
+		std::list<glm::ivec3>::iterator lruIter;
+	};
+	mutable std::unordered_map<glm::ivec3, CompressedEntry, glm::hash<glm::ivec3>> _compressedChunks;
+	mutable std::list<glm::ivec3> _compressedLRU;
+	mutable uint32_t _compressedBytes = 0u;
+	const uint32_t _compressedMemoryUsageInBytes;
+	/**
+	 * @brief Evicted chunks that weren't handed over to the pager (and the compressed tier) yet. A position
+	 * in here must not be paged in again before the chunk was paged out - otherwise the pager would return
+	 * outdated data. Guarded by the page-in lock, but only processed with the page-out lock held.
+	 */
+	mutable ChunkMap _pagingOut;
+	mutable core::AtomicInt _uncompressedMisses { 0 };
+	mutable core::AtomicInt _compressedHits { 0 };
 
 	// The size of the chunks
 	uint16_t _chunkSideLength;
+	MemoryLayout _chunkMemoryLayout;
 	uint8_t _chunkSideLengthPower;
 	int32_t _chunkMask;
 
@@ -277,7 +527,38 @@ private:
 
 	Region _region;
 
-	mutable core::ReadWriteLock _volumeLock{"pagedvolume"};
+	/**
+	 * Only held while a chunk is added to or removed from the volume - not while the pager is loading or
+	 * generating the chunk data.
+	 */
+	mutable core_trace_mutex(core::Lock, _pageInLock, "PagedVolumePageIn");
+	/**
+	 * The positions that are handed to the pager right now. Other threads that need one of these chunks
+	 * wait for the page-in instead of calling the pager again. Guarded by the page-in lock.
+	 */
+	mutable std::unordered_set<glm::ivec3, glm::hash<glm::ivec3>> _pagingIn;
+	// signaled whenever a position was removed from _pagingIn
+	mutable core::ConditionVariable _pagingInCondition;
+	/**
+	 * Serializes the page-out of the evicted chunks. This is recursive so the pager is able to access other
+	 * chunks of the volume while paging out.
+	 */
+	core_trace_mutex(core::Lock, _pageOutLock, "PagedVolumePageOut");
+
+	/**
+	 * @brief Shared with the queued prefetch tasks, as they might outlive the volume
+	 */
+	struct PrefetchState {
+		core_trace_mutex(core::Lock, lock, "PagedVolumePrefetch");
+		// reset to null once the volume is destroyed
+		const PagedVolume* volume = nullptr;
+		// the amount of tasks that are currently paging in a chunk
+		int running = 0;
+		// signaled whenever a running task is done
+		core::ConditionVariable condition;
+		std::unordered_set<glm::ivec3, glm::hash<glm::ivec3>> queued;
+	};
+	core::SharedPtr<PrefetchState> _prefetchState;
 };
 
 inline const Voxel& PagedVolume::Sampler::voxel() const {
@@ -292,28 +573,6 @@ inline glm::ivec3 PagedVolume::Sampler::position() const {
 	return glm::ivec3(_xPosInVolume, _yPosInVolume, _zPosInVolume);
 }
 
-// These precomputed offset are used to determine how much we move our pointer by to move a single voxel in the x, y, or z direction given an x, y, or z starting position inside a chunk.
-// More information in this discussion: https://bitbucket.org/volumesoffun/polyvox/issue/61/experiment-with-morton-ordering-of-voxel
-static const int32_t deltaX[256] = { 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 28087, 1, 7, 1, 55, 1, 7,
-		1, 439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 224695, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1,
-		439, 1, 7, 1, 55, 1, 7, 1, 28087, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 1797559, 1, 7, 1, 55, 1, 7, 1,
-		439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 28087, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439,
-		1, 7, 1, 55, 1, 7, 1, 224695, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1, 28087, 1, 7, 1, 55, 1, 7, 1, 439, 1,
-		7, 1, 55, 1, 7, 1, 3511, 1, 7, 1, 55, 1, 7, 1, 439, 1, 7, 1, 55, 1, 7, 1 };
-static const int32_t deltaY[256] = { 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 56174, 2, 14,
-		2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 449390, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2,
-		7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 56174, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2,
-		110, 2, 14, 2, 3595118, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 56174, 2, 14, 2, 110, 2, 14, 2,
-		878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 449390, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2,
-		110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 56174, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2, 7022, 2, 14, 2, 110, 2, 14, 2, 878, 2, 14, 2, 110, 2, 14, 2 };
-static const int32_t deltaZ[256] = { 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 112348, 4,
-		28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 898780, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4,
-		28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 112348, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756,
-		4, 28, 4, 220, 4, 28, 4, 7190236, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 112348, 4, 28, 4,
-		220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 898780, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4,
-		14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 112348, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28,
-		4, 220, 4, 28, 4 };
-
 #define CAN_GO_NEG_X(val) ((val) > 0)
 #define CAN_GO_POS_X(val)  ((val) < this->_chunkSideLengthMinusOne)
 #define CAN_GO_NEG_Y(val) ((val) > 0)
@@ -321,12 +580,12 @@ static const int32_t deltaZ[256] = { 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 22
 #define CAN_GO_NEG_Z(val) ((val) > 0)
 #define CAN_GO_POS_Z(val)  ((val) < this->_chunkSideLengthMinusOne)
 
-#define NEG_X_DELTA (-(deltaX[this->_xPosInChunk-1]))
-#define POS_X_DELTA (deltaX[this->_xPosInChunk])
-#define NEG_Y_DELTA (-(deltaY[this->_yPosInChunk-1]))
-#define POS_Y_DELTA (deltaY[this->_yPosInChunk])
-#define NEG_Z_DELTA (-(deltaZ[this->_zPosInChunk-1]))
-#define POS_Z_DELTA (deltaZ[this->_zPosInChunk])
+#define NEG_X_DELTA (-(this->_deltaX[this->_xPosInChunk-1] & this->_deltaMask))
+#define POS_X_DELTA (this->_deltaX[this->_xPosInChunk] & this->_deltaMask)
+#define NEG_Y_DELTA (-(this->_deltaY[this->_yPosInChunk-1] & this->_deltaMask))
+#define POS_Y_DELTA (this->_deltaY[this->_yPosInChunk] & this->_deltaMask)
+#define NEG_Z_DELTA (-(this->_deltaZ[this->_zPosInChunk-1] & this->_deltaMask))
+#define POS_Z_DELTA (this->_deltaZ[this->_zPosInChunk] & this->_deltaMask)
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
@@ -532,4 +791,19 @@ inline const Region& PagedVolume::region() const {
 	return _region;
 }
 
+inline bool PagedVolume::Chunk::isUniform() const {
+	return _data == nullptr;
+}
+
+inline const Voxel& PagedVolume::Chunk::uniformVoxel() const {
+	return _uniformVoxel;
+}
+
+/**
+ * @brief Allows the surface extractors to skip regions that only consist of uniform chunks
+ */
+inline bool isUniformRegion(const PagedVolume* volume, const Region& region, Voxel& voxel) {
+	return volume->isUniform(region, voxel);
+}
+
 }
@@ -3,15 +3,15 @@
  */
 
 #include "PagedVolume.h"
-#include "Morton.h"
 #include "math/Functions.h"
 #include "core/Common.h"
 #include "core/StandardLib.h"
+#include <algorithm>
 
 namespace voxel {
 
-PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pager) :
-		_pager(pager), _chunkSpacePosition(pos) {
+PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pager, MemoryLayout layout) :
+		_layout(&VoxelLayout::chunkLayout(layout, sideLength)), _pager(pager), _chunkSpacePosition(pos) {
 	core_assert_msg(_pager, "No valid pager supplied to chunk constructor.");
 	core_assert_msg(sideLength <= 256, "Chunk side length cannot be greater than 256.");
 
@@ -19,10 +19,7 @@ PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pag
 	_sideLength = sideLength;
 	_sideLengthPower = math::logBase2(sideLength);
 
-	// Allocate the data
-	const uint32_t uNoOfVoxels = _sideLength * _sideLength * _sideLength;
-	_data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
-	core_memset(_data, 0, uNoOfVoxels * sizeof(Voxel));
+	// The data is only allocated once the chunk gets voxels that differ from the uniform voxel
 }
 
 PagedVolume::Chunk::~Chunk() {
@@ -39,20 +36,55 @@ bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
 		return false;
 	}
 	_dataModified = true;
+	expand();
 	core_memcpy((uint8_t*)_data, (const uint8_t*)voxels, sizeInBytes);
 	return true;
 }
 
-Voxel* PagedVolume::Chunk::data() const {
+Voxel* PagedVolume::Chunk::data() {
+	expand();
 	return _data;
 }
 
+const Voxel* PagedVolume::Chunk::allocatedData() const {
+	return _data;
+}
+
+void PagedVolume::Chunk::expand() {
+	if (_data != nullptr) {
+		return;
+	}
+	const uint32_t n = voxels();
+	Voxel* data = (Voxel*)core_malloc(n * sizeof(Voxel));
+	for (uint32_t i = 0u; i < n; ++i) {
+		data[i] = _uniformVoxel;
+	}
+	_data = data;
+}
+
+bool PagedVolume::Chunk::compact() {
+	if (_data == nullptr) {
+		return true;
+	}
+	const uint32_t n = voxels();
+	const Voxel value = _data[0];
+	for (uint32_t i = 1u; i < n; ++i) {
+		if (!_data[i].isSame(value)) {
+			return false;
+		}
+	}
+	_uniformVoxel = value;
+	core_free(_data);
+	_data = nullptr;
+	return true;
+}
+
 uint32_t PagedVolume::Chunk::dataSizeInBytes() const {
 	return voxels() * sizeof(Voxel);
 }
 
 uint32_t PagedVolume::Chunk::voxels() const {
-	return _sideLength * _sideLength * _sideLength;
+	return (uint32_t)_layout->size();
 }
 
 const Voxel& PagedVolume::Chunk::voxel(uint32_t x, uint32_t y, uint32_t z) const {
@@ -61,9 +93,11 @@ const Voxel& PagedVolume::Chunk::voxel(uint32_t x, uint32_t y, uint32_t z) const
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", x, _sideLength);
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", y, _sideLength);
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", z, _sideLength);
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
+	if (_data == nullptr) {
+		return _uniformVoxel;
+	}
 
-	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
+	const int32_t index = _layout->index(x, y, z);
 	return _data[index];
 }
 
@@ -77,11 +111,16 @@ void PagedVolume::Chunk::setVoxel(uint32_t x, uint32_t y, uint32_t z, const Voxe
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
+	_dataModified = true;
+	if (_data == nullptr) {
+		if (_uniformVoxel.isSame(value)) {
+			return;
+		}
+		expand();
+	}
 
-	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
+	const int32_t index = _layout->index(x, y, z);
 	_data[index] = value;
-	_dataModified = true;
 }
 
 void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t z, const Voxel* values, int amount) {
@@ -95,19 +134,32 @@ void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t y, uint32_t z, const Vox
 	core_assert_msg(x < _sideLength, "Supplied x position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied y position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied z position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
+	_dataModified = true;
+	if (_data == nullptr) {
+		int i = y;
+		while (i < amount && _uniformVoxel.isSame(values[i])) {
+			++i;
+		}
+		if (i >= amount) {
+			return;
+		}
+		expand();
+	}
 
 	for (int i = y; i < amount; ++i) {
-		const uint32_t index = morton256_x[x] | morton256_y[i] | morton256_z[z];
+		const int32_t index = _layout->index(x, i, z);
 		_data[index] = values[i];
 	}
-	_dataModified = true;
 }
 
 int16_t PagedVolume::Chunk::sideLength() const {
 	return _sideLength;
 }
 
+const VoxelLayout& PagedVolume::Chunk::layout() const {
+	return *_layout;
+}
+
 const glm::ivec3& PagedVolume::Chunk::chunkPos() const {
 	return _chunkSpacePosition;
 }
@@ -116,6 +168,64 @@ void PagedVolume::Chunk::setVoxel(const glm::i16vec3& pos, const Voxel& value) {
 	setVoxel(pos.x, pos.y, pos.z, value);
 }
 
+void PagedVolume::Chunk::compress(CompressedChunk& out) const {
+	out.runs.clear();
+	const uint32_t n = voxels();
+	if (_data == nullptr) {
+		for (uint32_t i = 0u; i < n; i += 0xFFFFu) {
+			out.runs.push_back({(uint16_t)core_min(n - i, 0xFFFFu), _uniformVoxel});
+		}
+		out.runs.shrink_to_fit();
+		return;
+	}
+	uint32_t i = 0u;
+	while (i < n) {
+		const Voxel& value = _data[i];
+		uint32_t length = 1u;
+		while (i + length < n && length < 0xFFFFu && _data[i + length].isSame(value)) {
+			++length;
+		}
+		out.runs.push_back({(uint16_t)length, value});
+		i += length;
+	}
+	out.runs.shrink_to_fit();
+}
+
+bool PagedVolume::Chunk::decompress(const CompressedChunk& in) {
+	const uint32_t n = voxels();
+	if (in.runs.empty()) {
+		return false;
+	}
+	const Voxel& first = in.runs.front().voxel;
+	const bool uniform = std::all_of(in.runs.begin(), in.runs.end(), [&] (const CompressedChunk::Run& run) {
+		return run.voxel.isSame(first);
+	});
+	if (uniform) {
+		uint32_t total = 0u;
+		for (const CompressedChunk::Run& run : in.runs) {
+			total += run.length;
+		}
+		if (total != n) {
+			return false;
+		}
+		core_free(_data);
+		_data = nullptr;
+		_uniformVoxel = first;
+		return true;
+	}
+	expand();
+	uint32_t i = 0u;
+	for (const CompressedChunk::Run& run : in.runs) {
+		if (i + run.length > n) {
+			return false;
+		}
+		for (uint32_t end = i + run.length; i < end; ++i) {
+			_data[i] = run.voxel;
+		}
+	}
+	return i == n;
+}
+
 uint32_t PagedVolume::Chunk::calculateSizeInBytes(uint32_t sideLength) {
 	// Note: We disregard the size of the other class members as they are likely to be very small compared to the size of the
 	// allocated voxel data. This also keeps the reported size as a power of two, which makes other memory calculations easier.
@@ -3,7 +3,6 @@
  */
 
 #include "PagedVolume.h"
-#include "Morton.h"
 #include "core/Common.h"
 #include "core/Trace.h"
 
@@ -16,19 +15,27 @@ namespace voxel {
 #define CAN_GO_NEG_Z(val) ((val) > 0)
 #define CAN_GO_POS_Z(val) ((val) < this->_chunkSideLengthMinusOne)
 
-#define NEG_X_DELTA (-(deltaX[this->_xPosInChunk-1]))
-#define POS_X_DELTA (deltaX[this->_xPosInChunk])
-#define NEG_Y_DELTA (-(deltaY[this->_yPosInChunk-1]))
-#define POS_Y_DELTA (deltaY[this->_yPosInChunk])
-#define NEG_Z_DELTA (-(deltaZ[this->_zPosInChunk-1]))
-#define POS_Z_DELTA (deltaZ[this->_zPosInChunk])
+#define NEG_X_DELTA (-(this->_deltaX[this->_xPosInChunk-1] & this->_deltaMask))
+#define POS_X_DELTA (this->_deltaX[this->_xPosInChunk] & this->_deltaMask)
+#define NEG_Y_DELTA (-(this->_deltaY[this->_yPosInChunk-1] & this->_deltaMask))
+#define POS_Y_DELTA (this->_deltaY[this->_yPosInChunk] & this->_deltaMask)
+#define NEG_Z_DELTA (-(this->_deltaZ[this->_zPosInChunk-1] & this->_deltaMask))
+#define POS_Z_DELTA (this->_deltaZ[this->_zPosInChunk] & this->_deltaMask)
 
 PagedVolume::Sampler::Sampler(const PagedVolume* volume) :
 		_volume(volume), _chunkSideLengthMinusOne(volume->_chunkSideLength - 1) {
+	const VoxelLayout& layout = VoxelLayout::chunkLayout(volume->_chunkMemoryLayout, volume->_chunkSideLength);
+	_deltaX = layout.deltaX();
+	_deltaY = layout.deltaY();
+	_deltaZ = layout.deltaZ();
 }
 
 PagedVolume::Sampler::Sampler(const PagedVolume& volume) :
 		_volume(&volume), _chunkSideLengthMinusOne(volume._chunkSideLength - 1) {
+	const VoxelLayout& layout = VoxelLayout::chunkLayout(volume._chunkMemoryLayout, volume._chunkSideLength);
+	_deltaX = layout.deltaX();
+	_deltaY = layout.deltaY();
+	_deltaZ = layout.deltaZ();
 }
 
 PagedVolume::Sampler::~Sampler() {
@@ -85,14 +92,33 @@ void PagedVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos)
 	_yPosInChunk = static_cast<uint32_t>(yPos & _volume->_chunkMask);
 	_zPosInChunk = static_cast<uint32_t>(zPos & _volume->_chunkMask);
 
-	const uint32_t voxelIndexInChunk = morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk];
+	updateCurrentVoxel();
+}
+
+void PagedVolume::Sampler::updateCurrentVoxel() {
+	if (_currentChunk->isUniform()) {
+		// all voxels of the chunk are the same - moving inside the chunk doesn't touch any voxel data
+		_currentVoxel = &_currentChunk->_uniformVoxel;
+		_deltaMask = 0;
+		return;
+	}
+	const int32_t voxelIndexInChunk = _currentChunk->_layout->index(_xPosInChunk, _yPosInChunk, _zPosInChunk);
 	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
+	_deltaMask = ~0;
 }
 
 bool PagedVolume::Sampler::setVoxel(const Voxel& voxel) {
 	if (_currentVoxel == nullptr) {
 		return false;
 	}
+	if (_currentChunk->isUniform()) {
+		if (_currentVoxel->isSame(voxel)) {
+			return true;
+		}
+		// copy-on-write - allocate the voxel data of the chunk
+		_currentChunk->data();
+		updateCurrentVoxel();
+	}
 	//Need to think what effect this has on any existing iterators.
 	//core_assert_msg(false, "This function cannot be used on PagedVolume samplers.");
 	//TODO: the region is not updated properly - but we might not need this for paged volumes.
@@ -14,16 +14,21 @@ static const uint8_t SAMPLER_INVALIDX = 1 << 0;
 static const uint8_t SAMPLER_INVALIDY = 1 << 1;
 static const uint8_t SAMPLER_INVALIDZ = 1 << 2;
 
-RawVolume::RawVolume(const Region& regValid) :
-		_region(regValid), _mins((std::numeric_limits<int>::max)()), _maxs((std::numeric_limits<int>::min)()), _boundsValid(false) {
+static inline VoxelLayout createLayout(MemoryLayout layout, const Region& region) {
+	return VoxelLayout(layout, region.getWidthInVoxels(), region.getHeightInVoxels(), region.getDepthInVoxels());
+}
+
+RawVolume::RawVolume(const Region& regValid, MemoryLayout layout) :
+		_region(regValid), _layout(createLayout(layout, regValid)), _mins((std::numeric_limits<int>::max)()),
+		_maxs((std::numeric_limits<int>::min)()), _boundsValid(false) {
 	//Create a volume of the right size.
 	initialise(regValid);
 }
 
 RawVolume::RawVolume(const RawVolume* copy) :
-		_region(copy->region()) {
+		_region(copy->region()), _layout(copy->_layout) {
 	setBorderValue(copy->borderValue());
-	const size_t size = width() * height() * depth() * sizeof(Voxel);
+	const size_t size = _layout.size() * sizeof(Voxel);
 	_data = (Voxel*)core_malloc(size);
 	_mins = copy->_mins;
 	_maxs = copy->_maxs;
@@ -32,9 +37,9 @@ RawVolume::RawVolume(const RawVolume* copy) :
 }
 
 RawVolume::RawVolume(const RawVolume& copy) :
-		_region(copy.region()) {
+		_region(copy.region()), _layout(copy._layout) {
 	setBorderValue(copy.borderValue());
-	const size_t size = width() * height() * depth() * sizeof(Voxel);
+	const size_t size = _layout.size() * sizeof(Voxel);
 	_data = (Voxel*)core_malloc(size);
 	_mins = copy._mins;
 	_maxs = copy._maxs;
@@ -42,7 +47,48 @@ RawVolume::RawVolume(const RawVolume& copy) :
 	core_memcpy((void*)_data, (void*)copy._data, size);
 }
 
-RawVolume::RawVolume(RawVolume&& move) noexcept {
+static inline Region cropTo(Region region, const Region& other) {
+	region.cropTo(other);
+	return region;
+}
+
+RawVolume::RawVolume(const RawVolume* copy, const Region& region) :
+		_region(cropTo(region, copy->region())), _layout(createLayout(copy->memoryLayout(), _region)) {
+	core_assert_msg(_region.isValid(), "The region doesn't intersect the volume");
+	setBorderValue(copy->borderValue());
+	_data = (Voxel*)core_malloc(_layout.size() * sizeof(Voxel));
+	const glm::ivec3& offset = _region.getLowerCorner() - copy->region().getLowerCorner();
+	const int32_t w = width();
+	const int32_t h = height();
+	const int32_t d = depth();
+	if (memoryLayout() == MemoryLayout::Linear && copy->memoryLayout() == MemoryLayout::Linear) {
+		// the rows along the x axis are continuous in memory
+		for (int32_t z = 0; z < d; ++z) {
+			for (int32_t y = 0; y < h; ++y) {
+				const Voxel* src = copy->_data + copy->_layout.index(offset.x, offset.y + y, offset.z + z);
+				core_memcpy((void*)(_data + _layout.index(0, y, z)), (const void*)src, w * sizeof(Voxel));
+			}
+		}
+	} else {
+		for (int32_t z = 0; z < d; ++z) {
+			for (int32_t y = 0; y < h; ++y) {
+				for (int32_t x = 0; x < w; ++x) {
+					_data[_layout.index(x, y, z)] = copy->_data[copy->_layout.index(offset.x + x, offset.y + y, offset.z + z)];
+				}
+			}
+		}
+	}
+	_boundsValid = copy->_boundsValid;
+	_mins = copy->_mins;
+	_maxs = copy->_maxs;
+	if (_boundsValid) {
+		_mins = (glm::max)(_mins, _region.getLowerCorner());
+		_maxs = (glm::min)(_maxs, _region.getUpperCorner());
+	}
+}
+
+RawVolume::RawVolume(RawVolume&& move) noexcept :
+		_layout(std::move(move._layout)) {
 	_data = move._data;
 	move._data = nullptr;
 	_mins = move._mins;
@@ -51,14 +97,15 @@ RawVolume::RawVolume(RawVolume&& move) noexcept {
 	_boundsValid = move._boundsValid;
 }
 
-RawVolume::RawVolume(const Voxel* data, const voxel::Region& region) {
+RawVolume::RawVolume(const Voxel* data, const voxel::Region& region) :
+		_layout(createLayout(MemoryLayout::Linear, region)) {
 	initialise(region);
 	const size_t size = width() * height() * depth() * sizeof(Voxel);
 	core_memcpy((void*)_data, (void*)data, size);
 }
 
 RawVolume::RawVolume(Voxel* data, const voxel::Region& region) :
-		_region(region), _data(data) {
+		_region(region), _layout(createLayout(MemoryLayout::Linear, region)), _data(data) {
 	_boundsValid = false;
 	_mins = _maxs = glm::ivec3();
 	core_assert_msg(width() > 0, "Volume width must be greater than zero.");
@@ -72,7 +119,7 @@ RawVolume::~RawVolume() {
 }
 
 Voxel* RawVolume::copyVoxels() const {
-	const size_t size = width() * height() * depth() * sizeof(Voxel);
+	const size_t size = _layout.size() * sizeof(Voxel);
 	Voxel* rawCopy = (Voxel*)core_malloc(size);
 	core_memcpy((void*)rawCopy, (void*)_data, size);
 	return rawCopy;
@@ -93,7 +140,7 @@ const Voxel& RawVolume::voxel(int32_t uXPos, int32_t uYPos, int32_t uZPos) const
 		const int32_t iLocalYPos = uYPos - regValidRegion.getLowerY();
 		const int32_t iLocalZPos = uZPos - regValidRegion.getLowerZ();
 
-		return _data[iLocalXPos + iLocalYPos * width() + iLocalZPos * width() * height()];
+		return _data[_layout.index(iLocalXPos, iLocalYPos, iLocalZPos)];
 	}
 	return _borderVoxel;
 }
@@ -133,7 +180,7 @@ bool RawVolume::setVoxel(const glm::ivec3& pos, const Voxel& voxel) {
 	const int32_t localXPos = pos.x - lowerCorner.x;
 	const int32_t localYPos = pos.y - lowerCorner.y;
 	const int32_t iLocalZPos = pos.z - lowerCorner.z;
-	const int index = localXPos + localYPos * width() + iLocalZPos * width() * height();
+	const int index = _layout.index(localXPos, localYPos, iLocalZPos);
 	if (_data[index].isSame(voxel)) {
 		return false;
 	}
@@ -155,7 +202,7 @@ void RawVolume::initialise(const Region& regValidRegion) {
 	core_assert_msg(depth() > 0, "Volume depth must be greater than zero.");
 
 	//Create the data
-	const size_t size = width() * height() * depth() * sizeof(Voxel);
+	const size_t size = _layout.size() * sizeof(Voxel);
 	_data = (Voxel*)core_malloc(size);
 
 	// Clear to zeros
@@ -163,7 +210,7 @@ void RawVolume::initialise(const Region& regValidRegion) {
 }
 
 void RawVolume::clear() {
-	const size_t size = width() * height() * depth() * sizeof(Voxel);
+	const size_t size = _layout.size() * sizeof(Voxel);
 	core_memset(_data, 0, size);
 	_mins = glm::ivec3((std::numeric_limits<int>::max)() / 2);
 	_maxs = glm::ivec3((std::numeric_limits<int>::min)() / 2);
@@ -171,11 +218,11 @@ void RawVolume::clear() {
 }
 
 RawVolume::Sampler::Sampler(const RawVolume* volume) :
-		_volume(const_cast<RawVolume*>(volume)) {
+		_volume(const_cast<RawVolume*>(volume)), _linear(volume->memoryLayout() == MemoryLayout::Linear) {
 }
 
 RawVolume::Sampler::Sampler(const RawVolume& volume) :
-		_volume(const_cast<RawVolume*>(&volume)) {
+		_volume(const_cast<RawVolume*>(&volume)), _linear(volume.memoryLayout() == MemoryLayout::Linear) {
 }
 
 RawVolume::Sampler::~Sampler() {
@@ -215,9 +262,23 @@ bool RawVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos) {
 		const int32_t iLocalXPos = xPos - v3dLowerCorner.x;
 		const int32_t iLocalYPos = yPos - v3dLowerCorner.y;
 		const int32_t iLocalZPos = zPos - v3dLowerCorner.z;
-		const int32_t uVoxelIndex = iLocalXPos + iLocalYPos * _volume->width() + iLocalZPos * _volume->width() * _volume->height();
+		const int32_t uVoxelIndex = _volume->_layout.index(iLocalXPos, iLocalYPos, iLocalZPos);
 
 		_currentVoxel = _volume->_data + uVoxelIndex;
+		if (_linear) {
+			const int32_t w = _volume->width();
+			const int32_t stride = w * _volume->height();
+			_deltaNegX = -1;
+			_deltaPosX = 1;
+			_deltaNegY = -w;
+			_deltaPosY = w;
+			_deltaNegZ = -stride;
+			_deltaPosZ = stride;
+		} else {
+			updateDeltaX();
+			updateDeltaY();
+			updateDeltaZ();
+		}
 		return true;
 	}
 	_currentVoxel = nullptr;
@@ -239,7 +300,10 @@ void RawVolume::Sampler::movePositiveX() {
 	if (!bIsOldPositionValid) {
 		setPosition(_posInVolume);
 	} else if (currentPositionValid()) {
-		++_currentVoxel;
+		_currentVoxel += _deltaPosX;
+		if (!_linear) {
+			updateDeltaX();
+		}
 	} else {
 		_currentVoxel = nullptr;
 	}
@@ -260,7 +324,10 @@ void RawVolume::Sampler::movePositiveY() {
 	if (!bIsOldPositionValid) {
 		setPosition(_posInVolume);
 	} else if (currentPositionValid()) {
-		_currentVoxel += _volume->width();
+		_currentVoxel += _deltaPosY;
+		if (!_linear) {
+			updateDeltaY();
+		}
 	} else {
 		_currentVoxel = nullptr;
 	}
@@ -281,7 +348,10 @@ void RawVolume::Sampler::movePositiveZ() {
 	if (!bIsOldPositionValid) {
 		setPosition(_posInVolume);
 	} else if (currentPositionValid()) {
-		_currentVoxel += _volume->width() * _volume->height();
+		_currentVoxel += _deltaPosZ;
+		if (!_linear) {
+			updateDeltaZ();
+		}
 	} else {
 		_currentVoxel = nullptr;
 	}
@@ -302,7 +372,10 @@ void RawVolume::Sampler::moveNegativeX() {
 	if (!bIsOldPositionValid) {
 		setPosition(_posInVolume);
 	} else if (currentPositionValid()) {
-		--_currentVoxel;
+		_currentVoxel += _deltaNegX;
+		if (!_linear) {
+			updateDeltaX();
+		}
 	} else {
 		_currentVoxel = nullptr;
 	}
@@ -323,7 +396,10 @@ void RawVolume::Sampler::moveNegativeY() {
 	if (!bIsOldPositionValid) {
 		setPosition(_posInVolume);
 	} else if (currentPositionValid()) {
-		_currentVoxel -= _volume->width();
+		_currentVoxel += _deltaNegY;
+		if (!_linear) {
+			updateDeltaY();
+		}
 	} else {
 		_currentVoxel = nullptr;
 	}
@@ -344,7 +420,10 @@ void RawVolume::Sampler::moveNegativeZ() {
 	if (!bIsOldPositionValid) {
 		setPosition(_posInVolume);
 	} else if (currentPositionValid()) {
-		_currentVoxel -= _volume->width() * _volume->height();
+		_currentVoxel += _deltaNegZ;
+		if (!_linear) {
+			updateDeltaZ();
+		}
 	} else {
 		_currentVoxel = nullptr;
 	}
@@ -6,6 +6,7 @@
 
 #include "Voxel.h"
 #include "Region.h"
+#include "MemoryLayout.h"
 #include <glm/vec3.hpp>
 
 namespace voxel {
@@ -80,6 +81,25 @@ public:
 		/** Other current position information */
 		Voxel* _currentVoxel = nullptr;
 
+		/**
+		 * The offsets of the voxel pointer to the neighbours of the current voxel - they depend on the
+		 * memory layout of the volume and are only valid if the neighbour is inside the volume. For the
+		 * @c MemoryLayout::Linear layout they are constant and are not updated while moving the sampler.
+		 */
+		int32_t _deltaNegX = 0;
+		int32_t _deltaPosX = 0;
+		int32_t _deltaNegY = 0;
+		int32_t _deltaPosY = 0;
+		int32_t _deltaNegZ = 0;
+		int32_t _deltaPosZ = 0;
+
+		void updateDeltaX();
+		void updateDeltaY();
+		void updateDeltaZ();
+
+		/** The volume is using the @c MemoryLayout::Linear layout */
+		bool _linear;
+
 		/** Whether the current position is inside the volume */
 		uint8_t _currentPositionInvalid = 0u;
 	};
@@ -89,9 +109,18 @@ public:
 
 public:
 	/// Constructor for creating a fixed size volume.
-	RawVolume(const Region& region);
+	/// @note Only the @c MemoryLayout::Linear layout is usable for code that works with the raw voxel data (see @c data())
+	RawVolume(const Region& region, MemoryLayout layout = MemoryLayout::Linear);
 	RawVolume(const RawVolume* copy);
 	RawVolume(const RawVolume& copy);
+	/**
+	 * @brief Copies only the voxels of the given region - e.g. to hand out a snapshot of the parts of the
+	 * volume that a background task is going to read. The copy has the same border value and memory layout - as
+	 * long as the layout supports the dimensions of the copied region (see @c MemoryLayout::Morton).
+	 * @note The region is clipped against the region of the given volume. Positions outside of the copied
+	 * region return the border value - even if they are part of the source volume.
+	 */
+	RawVolume(const RawVolume* copy, const Region& region);
 	RawVolume(RawVolume&& move) noexcept;
 
 	static RawVolume* createRaw(const Voxel* data, const voxel::Region& region) {
@@ -111,6 +140,8 @@ public:
 	const Voxel& borderValue() const;
 	/// Gets a Region representing the extents of the Volume.
 	const Region& region() const;
+	/// The order in which the voxels are stored in memory
+	MemoryLayout memoryLayout() const;
 
 	/// Gets the width of the volume in voxels.
 	int32_t width() const;
@@ -140,6 +171,9 @@ public:
 
 	void clear();
 
+	/**
+	 * @return The voxel data in the memory layout of this volume
+	 */
 	inline const uint8_t* data() const {
 		return (const uint8_t*)_data;
 	}
@@ -159,6 +193,9 @@ private:
 	/** The size of the volume */
 	Region _region;
 
+	/** Maps the voxel positions to the index in the voxel data */
+	VoxelLayout _layout;
+
 	/** The border value */
 	Voxel _borderVoxel;
 
@@ -177,6 +214,10 @@ inline const Region& RawVolume::region() const {
 	return _region;
 }
 
+inline MemoryLayout RawVolume::memoryLayout() const {
+	return _layout.layout();
+}
+
 /**
  * The border value is returned whenever an attempt is made to read a voxel which
  * is outside the extents of the volume.
@@ -260,10 +301,31 @@ inline bool RawVolume::Sampler::setPosition(const glm::ivec3& v3dNewPos) {
 	return setPosition(v3dNewPos.x, v3dNewPos.y, v3dNewPos.z);
 }
 
+inline void RawVolume::Sampler::updateDeltaX() {
+	const int32_t local = _posInVolume.x - _volume->region().getLowerX();
+	const int32_t* delta = _volume->_layout.deltaX();
+	_deltaNegX = local > 0 ? -delta[local - 1] : 0;
+	_deltaPosX = delta[local];
+}
+
+inline void RawVolume::Sampler::updateDeltaY() {
+	const int32_t local = _posInVolume.y - _volume->region().getLowerY();
+	const int32_t* delta = _volume->_layout.deltaY();
+	_deltaNegY = local > 0 ? -delta[local - 1] : 0;
+	_deltaPosY = delta[local];
+}
+
+inline void RawVolume::Sampler::updateDeltaZ() {
+	const int32_t local = _posInVolume.z - _volume->region().getLowerZ();
+	const int32_t* delta = _volume->_layout.deltaZ();
+	_deltaNegZ = local > 0 ? -delta[local - 1] : 0;
+	_deltaPosZ = delta[local];
+}
+
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 - region.getWidthInVoxels() - region.stride());
+		return *(_currentVoxel + _deltaNegX + _deltaNegY + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
 }
@@ -271,7 +333,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel - 1 - region.getWidthInVoxels());
+		return *(_currentVoxel + _deltaNegX + _deltaNegY);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z);
 }
@@ -279,7 +341,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 - region.getWidthInVoxels() + region.stride());
+		return *(_currentVoxel + _deltaNegX + _deltaNegY + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
 }
@@ -287,7 +349,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 - region.stride());
+		return *(_currentVoxel + _deltaNegX + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z - 1);
 }
@@ -295,7 +357,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x)) {
-		return *(_currentVoxel - 1);
+		return *(_currentVoxel + _deltaNegX);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z);
 }
@@ -303,7 +365,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 + region.stride());
+		return *(_currentVoxel + _deltaNegX + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z + 1);
 }
@@ -311,7 +373,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 + region.getWidthInVoxels() - region.stride());
+		return *(_currentVoxel + _deltaNegX + _deltaPosY + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
 }
@@ -319,7 +381,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel - 1 + region.getWidthInVoxels());
+		return *(_currentVoxel + _deltaNegX + _deltaPosY);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z);
 }
@@ -327,7 +389,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 + region.getWidthInVoxels() + region.stride());
+		return *(_currentVoxel + _deltaNegX + _deltaPosY + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
 }
@@ -335,7 +397,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - region.getWidthInVoxels() - region.stride());
+		return *(_currentVoxel + _deltaNegY + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
 }
@@ -343,7 +405,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel - region.getWidthInVoxels());
+		return *(_currentVoxel + _deltaNegY);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z);
 }
@@ -351,7 +413,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - region.getWidthInVoxels() + region.stride());
+		return *(_currentVoxel + _deltaNegY + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
 }
@@ -359,7 +421,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px0py1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - region.stride());
+		return *(_currentVoxel + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z - 1);
 }
@@ -374,7 +436,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px0py0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px0py1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + region.stride());
+		return *(_currentVoxel + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z + 1);
 }
@@ -382,7 +444,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px0py1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1py1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + region.getWidthInVoxels() - region.stride());
+		return *(_currentVoxel + _deltaPosY + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
 }
@@ -390,7 +452,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px1py1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1py0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel + region.getWidthInVoxels());
+		return *(_currentVoxel + _deltaPosY);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z);
 }
@@ -398,7 +460,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px1py0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1py1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + region.getWidthInVoxels() + region.stride());
+		return *(_currentVoxel + _deltaPosY + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
 }
@@ -406,7 +468,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel0px1py1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 - region.getWidthInVoxels() - region.stride());
+		return *(_currentVoxel + _deltaPosX + _deltaNegY + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
 }
@@ -414,7 +476,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel + 1 - region.getWidthInVoxels());
+		return *(_currentVoxel + _deltaPosX + _deltaNegY);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z);
 }
@@ -422,7 +484,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 - region.getWidthInVoxels() + region.stride());
+		return *(_currentVoxel + _deltaPosX + _deltaNegY + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
 }
@@ -430,7 +492,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px0py1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 - region.stride());
+		return *(_currentVoxel + _deltaPosX + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z - 1);
 }
@@ -438,7 +500,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px0py1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px0py0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x)) {
-		return *(_currentVoxel + 1);
+		return *(_currentVoxel + _deltaPosX);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z);
 }
@@ -446,7 +508,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px0py0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px0py1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 + region.stride());
+		return *(_currentVoxel + _deltaPosX + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z + 1);
 }
@@ -454,7 +516,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px0py1pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1py1nz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 + region.getWidthInVoxels() - region.stride());
+		return *(_currentVoxel + _deltaPosX + _deltaPosY + _deltaNegZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
 }
@@ -462,7 +524,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px1py1nz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1py0pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel + 1 + region.getWidthInVoxels());
+		return *(_currentVoxel + _deltaPosX + _deltaPosY);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z);
 }
@@ -470,7 +532,7 @@ inline const Voxel& RawVolume::Sampler::peekVoxel1px1py0pz() const {
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1py1pz() const {
 	const Region& region = this->_volume->region();
 	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 + region.getWidthInVoxels() + region.stride());
+		return *(_currentVoxel + _deltaPosX + _deltaPosY + _deltaPosZ);
 	}
 	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
 }
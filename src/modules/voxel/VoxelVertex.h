@@ -21,7 +21,11 @@ struct VoxelVertex {
 };
 static_assert(sizeof(VoxelVertex) == 8, "Unexpected size of the vertex struct");
 
-// TODO: maybe reduce to uint16_t and use glDrawElementsBaseVertex
 typedef uint32_t IndexType;
+/**
+ * @brief The index type of the compressed meshes - see @c Mesh::compressIndices()
+ * Bigger meshes are split into sub meshes that are rendered with a base vertex.
+ */
+typedef uint16_t CompactIndexType;
 
 }
@@ -4,6 +4,7 @@
 
 #include "app/benchmark/AbstractBenchmark.h"
 #include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
 #include "voxel/IsQuadNeeded.h"
 #include "voxel/MaterialColor.h"
 #include "voxel/Constants.h"
@@ -30,6 +31,28 @@ public:
 		}
 	}
 
+	/**
+	 * @brief Hilly terrain with some holes - to get surfaces in all directions
+	 */
+	static bool isSolid(int x, int y, int z) {
+		const int height = 8 + (x * 3 + z * 5) % 13 + (x / 7 + z / 5) % 9;
+		return y <= height && (x * 7 + y * 11 + z * 13) % 17 != 0;
+	}
+
+	template<class Volume>
+	void fillTerrain(const voxel::Region& region, Volume* v) const {
+		const voxel::Voxel voxel = voxel::createColorVoxel(voxel::VoxelType::Generic, 1);
+		for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+					if (isSolid(x, y, z)) {
+						v->setVoxel(x, y, z, voxel);
+					}
+				}
+			}
+		}
+	}
+
 	class BenchmarkPager: public voxel::PagedVolume::Pager {
 	public:
 		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
@@ -59,6 +82,18 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedy)(bench
 	}
 }
 
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyContext)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	voxel::ExtractionContext ctx;
+	for (auto _ : state) {
+		voxel::extractCubicMesh(ctx, &volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+}
+
 BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)(benchmark::State &state) {
 	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
 	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
@@ -132,7 +167,194 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)(benc
 	}
 }
 
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeBinaryExtractGreedy)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeBinaryExtract)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), false, false);
+	}
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeBinaryExtractGreedy)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fill(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+}
+
+/**
+ * @brief Compares the CubicSurfaceExtractor (0) with the binary mask extractor (1) on the same terrain
+ */
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractTerrain)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	const bool binary = state.range(1) != 0;
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(size - 1, core_min(size, meshSize) - 1, size - 1));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		if (binary) {
+			voxel::extractBinaryCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+		} else {
+			voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+		}
+	}
+	state.SetLabel(binary ? "binary" : "cubic");
+	state.SetItemsProcessed(state.iterations() * region.voxels());
+	state.counters["vertices"] = (double)mesh.getNoOfVertices();
+	state.counters["indices"] = (double)mesh.getNoOfIndices();
+}
+
+/**
+ * @brief Memory and throughput of the mesh index formats: 32 bit indices (0), compressed 16 bit indices (1)
+ * and implicit quad indices without vertex reuse (2)
+ */
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractCompact)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	const int format = (int)state.range(1);
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(size - 1, core_min(size, meshSize) - 1, size - 1));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, 256);
+	fillTerrain(region, &volume);
+	voxel::ExtractionContext ctx;
+	size_t vertices = 0u;
+	size_t indices = 0u;
+	size_t bytes = 0u;
+	for (auto _ : state) {
+		// like the WorldMeshExtractor a new mesh per extraction - the compression releases the 32 bit indices
+		voxel::Mesh mesh(1024 * 1024, 1024 * 1024, true);
+		voxel::extractBinaryCubicMesh(ctx, &volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, format != 2);
+		vertices = mesh.getNoOfVertices();
+		indices = mesh.getNoOfIndices();
+		bytes = vertices * sizeof(voxel::VoxelVertex);
+		if (format == 0) {
+			bytes += indices * sizeof(voxel::IndexType);
+		} else {
+			mesh.compressIndices();
+			if (!mesh.hasImplicitQuadIndices()) {
+				bytes += indices * sizeof(voxel::CompactIndexType);
+			}
+		}
+	}
+	static const char *formats[] = { "32 bit", "16 bit", "implicit quads" };
+	state.SetLabel(formats[format]);
+	state.SetItemsProcessed(state.iterations() * region.voxels());
+	state.counters["vertices"] = (double)vertices;
+	state.counters["indices"] = (double)indices;
+	state.counters["bytes"] = (double)bytes;
+	state.counters["bytesPerQuad"] = (double)bytes / (double)(indices / 6u);
+}
+
+/**
+ * @brief Extraction of a whole chunk with the given side length in the given memory layout
+ */
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractLayout)(benchmark::State &state) {
+	const int chunkSize = (int)state.range(0);
+	const voxel::MemoryLayout layout = (voxel::MemoryLayout)state.range(1);
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(chunkSize - 1, core_min(chunkSize, meshSize) - 1, chunkSize - 1));
+	BenchmarkPager pager;
+	voxel::PagedVolume volume(&pager, 1024 * 1024 * 1024, chunkSize, 0u, layout);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+	state.SetLabel(voxel::toString(layout));
+	state.SetItemsProcessed(state.iterations() * region.voxels());
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractLayout)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	const voxel::MemoryLayout layout = (voxel::MemoryLayout)state.range(1);
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(size - 1, core_min(size, meshSize) - 1, size - 1));
+	voxel::RawVolume volume(region, layout);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true);
+	}
+	// the morton layout falls back to the linear layout for regions that aren't cubic
+	state.SetLabel(voxel::toString(volume.memoryLayout()));
+	state.SetItemsProcessed(state.iterations() * region.voxels());
+}
+
+/**
+ * @brief Walks a sampler over the whole volume in the given memory layout and peeks at the face neighbours
+ */
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeSamplerLayout)(benchmark::State &state) {
+	const int size = (int)state.range(0);
+	const voxel::MemoryLayout layout = (voxel::MemoryLayout)state.range(1);
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(size - 1, core_min(size, meshSize) - 1, size - 1));
+	voxel::RawVolume volume(region, layout);
+	fillTerrain(region, &volume);
+	for (auto _ : state) {
+		voxel::RawVolume::Sampler sampler(&volume);
+		int solid = 0;
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				sampler.setPosition(region.getLowerX(), y, z);
+				for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					solid += !voxel::isAir(sampler.voxel().getMaterial());
+					solid += !voxel::isAir(sampler.peekVoxel1nx0py0pz().getMaterial());
+					solid += !voxel::isAir(sampler.peekVoxel1px0py0pz().getMaterial());
+					solid += !voxel::isAir(sampler.peekVoxel0px1ny0pz().getMaterial());
+					solid += !voxel::isAir(sampler.peekVoxel0px1py0pz().getMaterial());
+					solid += !voxel::isAir(sampler.peekVoxel0px0py1nz().getMaterial());
+					solid += !voxel::isAir(sampler.peekVoxel0px0py1pz().getMaterial());
+					sampler.movePositiveX();
+				}
+			}
+		}
+		benchmark::DoNotOptimize(solid);
+	}
+	state.SetLabel(voxel::toString(volume.memoryLayout()));
+	state.SetItemsProcessed(state.iterations() * region.voxels());
+}
+
+static void CompactArguments(benchmark::internal::Benchmark* b) {
+	for (int size : {32, 64}) {
+		for (int format = 0; format < 3; ++format) {
+			b->Args({size, format});
+		}
+	}
+}
+
+static void LayoutArguments(benchmark::internal::Benchmark* b) {
+	for (int size : {32, 64, 256}) {
+		for (int layout = 0; layout < (int)voxel::MemoryLayout::Max; ++layout) {
+			b->Args({size, layout});
+		}
+	}
+}
+
+static void ExtractorArguments(benchmark::internal::Benchmark* b) {
+	for (int size : {32, 64, 256}) {
+		b->Args({size, 0});
+		b->Args({size, 1});
+	}
+}
+
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyContext)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
@@ -142,4 +364,14 @@ BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtract)->RangeM
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeBinaryExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeBinaryExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeBinaryExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractTerrain)->Apply(ExtractorArguments)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractCompact)->Apply(CompactArguments)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractLayout)->Apply(LayoutArguments)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractLayout)->Apply(LayoutArguments)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeSamplerLayout)->Apply(LayoutArguments)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "voxel/MaterialColor.h"
+#include "voxel/PagedVolume.h"
+#include <thread>
+#include <vector>
+
+static constexpr int VOLUME_CHUNK_SIZE = 32;
+static constexpr int VOLUME_CHUNKS_PER_AXIS = 8;
+static constexpr int VOLUME_SIZE = VOLUME_CHUNK_SIZE * VOLUME_CHUNKS_PER_AXIS;
+static constexpr int READS_PER_THREAD = 1 << 16;
+
+class PagedVolumeBenchmark : public app::AbstractBenchmark {
+public:
+	class BenchmarkPager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			const voxel::Voxel voxel = voxel::createColorVoxel(voxel::VoxelType::Generic, 1);
+			const int size = ctx.chunk->sideLength();
+			for (int x = 0; x < size; x += 2) {
+				for (int z = 0; z < size; z += 2) {
+					ctx.chunk->setVoxel(x, 0, z, voxel);
+				}
+			}
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	bool onInitApp() override {
+		return voxel::initDefaultMaterialColors();
+	}
+
+	/**
+	 * @brief Cheap linear congruential generator - we don't want to measure the random number generation
+	 */
+	static inline uint32_t next(uint32_t& state) {
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	}
+
+	static void read(const voxel::PagedVolume* volume, uint32_t seed, int reads) {
+		uint32_t state = seed;
+		for (int i = 0; i < reads; ++i) {
+			const int x = (int)(next(state) % VOLUME_SIZE);
+			const int y = (int)(next(state) % VOLUME_SIZE);
+			const int z = (int)(next(state) % VOLUME_SIZE);
+			benchmark::DoNotOptimize(volume->voxel(x, y, z));
+		}
+	}
+
+	/**
+	 * @brief Reads are mostly done in the same chunk before moving on - like e.g. the mesh extraction or a floor trace
+	 */
+	static void readLocal(const voxel::PagedVolume* volume, uint32_t seed, int reads) {
+		uint32_t state = seed;
+		int baseX = 0, baseY = 0, baseZ = 0;
+		for (int i = 0; i < reads; ++i) {
+			if ((i % 64) == 0) {
+				baseX = (int)(next(state) % VOLUME_CHUNKS_PER_AXIS) * VOLUME_CHUNK_SIZE;
+				baseY = (int)(next(state) % VOLUME_CHUNKS_PER_AXIS) * VOLUME_CHUNK_SIZE;
+				baseZ = (int)(next(state) % VOLUME_CHUNKS_PER_AXIS) * VOLUME_CHUNK_SIZE;
+			}
+			const int x = baseX + (int)(next(state) % VOLUME_CHUNK_SIZE);
+			const int y = baseY + (int)(next(state) % VOLUME_CHUNK_SIZE);
+			const int z = baseZ + (int)(next(state) % VOLUME_CHUNK_SIZE);
+			benchmark::DoNotOptimize(volume->voxel(x, y, z));
+		}
+	}
+
+	template<class FUNC>
+	void run(benchmark::State &state, FUNC&& func) {
+		BenchmarkPager pager;
+		voxel::PagedVolume volume(&pager, 512 * 1024 * 1024, VOLUME_CHUNK_SIZE);
+		// page in all chunks before we start to measure
+		for (int x = 0; x < VOLUME_SIZE; x += VOLUME_CHUNK_SIZE) {
+			for (int y = 0; y < VOLUME_SIZE; y += VOLUME_CHUNK_SIZE) {
+				for (int z = 0; z < VOLUME_SIZE; z += VOLUME_CHUNK_SIZE) {
+					volume.voxel(x, y, z);
+				}
+			}
+		}
+		const int threadCount = (int)state.range(0);
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (auto _ : state) {
+			for (int i = 0; i < threadCount; ++i) {
+				threads.emplace_back(func, &volume, (uint32_t)(i + 1), READS_PER_THREAD);
+			}
+			for (std::thread& t : threads) {
+				t.join();
+			}
+			threads.clear();
+		}
+		state.SetItemsProcessed(state.iterations() * threadCount * READS_PER_THREAD);
+	}
+};
+
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, RandomVoxelReads)(benchmark::State &state) {
+	run(state, read);
+}
+
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, LocalVoxelReads)(benchmark::State &state) {
+	run(state, readLocal);
+}
+
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, RandomVoxelReads)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, LocalVoxelReads)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
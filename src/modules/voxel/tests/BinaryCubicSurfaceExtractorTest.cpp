@@ -0,0 +1,130 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace voxel {
+
+class BinaryCubicSurfaceExtractorTest: public app::AbstractTest {
+protected:
+	// x, y, z, ambient occlusion and color of the three vertices
+	using Triangle = std::vector<int>;
+
+	static Voxel voxelAt(int x, int y, int z) {
+		const int n = (x * 7 + y * 13 + z * 5) % 11;
+		if (y > 10 + (x + z) % 5 || n == 0) {
+			return createVoxel(VoxelType::Air, 0);
+		}
+		if (n == 1) {
+			return createVoxel(VoxelType::Water, 0);
+		}
+		// big areas with the same color to have something to merge
+		return createVoxel(VoxelType::Grass, (uint8_t)(1 + (x / 4 + z / 6) % 3));
+	}
+
+	void fill(RawVolume& volume) const {
+		const Region& region = volume.region();
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					volume.setVoxel(x, y, z, voxelAt(x, y, z));
+				}
+			}
+		}
+	}
+
+	static std::vector<Triangle> triangles(const Mesh& mesh) {
+		std::vector<Triangle> t;
+		for (size_t i = 0; i < mesh.getNoOfIndices(); i += 3) {
+			Triangle triangle;
+			for (size_t j = 0; j < 3; ++j) {
+				const VoxelVertex& v = mesh.getVertex(mesh.getIndex(i + j));
+				triangle.insert(triangle.end(), {v.position.x, v.position.y, v.position.z, v.ambientOcclusion, v.colorIndex});
+			}
+			t.push_back(triangle);
+		}
+		std::sort(t.begin(), t.end());
+		return t;
+	}
+
+	/**
+	 * @return The covered area per normal direction and color index
+	 */
+	static std::map<std::tuple<int, int, int, int>, float> area(const Mesh& mesh) {
+		std::map<std::tuple<int, int, int, int>, float> a;
+		for (size_t i = 0; i < mesh.getNoOfIndices(); i += 3) {
+			const VoxelVertex& v0 = mesh.getVertex(mesh.getIndex(i + 0));
+			const VoxelVertex& v1 = mesh.getVertex(mesh.getIndex(i + 1));
+			const VoxelVertex& v2 = mesh.getVertex(mesh.getIndex(i + 2));
+			const glm::vec3 cross = glm::cross(glm::vec3(v1.position - v0.position), glm::vec3(v2.position - v0.position));
+			const glm::ivec3 normal(glm::sign(cross));
+			a[std::make_tuple(normal.x, normal.y, normal.z, (int)v0.colorIndex)] += glm::length(cross) * 0.5f;
+		}
+		return a;
+	}
+};
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testSameTrianglesWithoutMerging) {
+	// more than 64 voxels on the z axis to cover the multi-word masks
+	RawVolume volume(Region(glm::ivec3(-3, 1, 2), glm::ivec3(20, 18, 75)));
+	fill(volume);
+	const Region regions[] = {
+		Region(glm::ivec3(-2, 2, 3), glm::ivec3(19, 17, 74)),
+		// touching the volume border
+		volume.region(),
+		Region(glm::ivec3(5, 4, 6), glm::ivec3(5, 9, 6))
+	};
+	for (const Region& region : regions) {
+		Mesh mesh(128 * 1024, 128 * 1024, true);
+		Mesh binaryMesh(128 * 1024, 128 * 1024, true);
+		extractCubicMesh(&volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner(), false);
+		extractBinaryCubicMesh(&volume, region, &binaryMesh, IsQuadNeeded(), region.getLowerCorner(), false);
+		EXPECT_EQ(mesh.getOffset(), binaryMesh.getOffset());
+		ASSERT_EQ(mesh.getNoOfIndices(), binaryMesh.getNoOfIndices()) << region.toString().c_str();
+		ASSERT_EQ(triangles(mesh), triangles(binaryMesh)) << region.toString().c_str();
+	}
+}
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testMergedQuadsCoverTheSameArea) {
+	RawVolume volume(Region(glm::ivec3(0), glm::ivec3(17, 20, 25)));
+	fill(volume);
+	const Region region(glm::ivec3(1), glm::ivec3(16, 19, 24));
+	for (int ambientOcclusion = 0; ambientOcclusion <= 1; ++ambientOcclusion) {
+		Mesh mesh(128 * 1024, 128 * 1024, true);
+		Mesh unmerged(128 * 1024, 128 * 1024, true);
+		Mesh merged(128 * 1024, 128 * 1024, true);
+		extractCubicMesh(&volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner(), true, true, ambientOcclusion != 0);
+		extractBinaryCubicMesh(&volume, region, &unmerged, IsQuadNeeded(), region.getLowerCorner(), false, true, ambientOcclusion != 0);
+		extractBinaryCubicMesh(&volume, region, &merged, IsQuadNeeded(), region.getLowerCorner(), true, true, ambientOcclusion != 0);
+		EXPECT_LT(merged.getNoOfIndices(), unmerged.getNoOfIndices());
+		EXPECT_EQ(area(mesh), area(merged));
+		EXPECT_EQ(area(unmerged), area(merged));
+	}
+}
+
+TEST_F(BinaryCubicSurfaceExtractorTest, testUniformRegion) {
+	RawVolume volume(Region(0, 15));
+	Mesh mesh(128, 128, true);
+	extractBinaryCubicMesh(&volume, Region(2, 10), &mesh, IsQuadNeeded(), glm::ivec3(0));
+	EXPECT_TRUE(mesh.isEmpty());
+	volume.setVoxel(5, 5, 5, createVoxel(VoxelType::Grass, 1));
+	extractBinaryCubicMesh(&volume, Region(2, 10), &mesh, IsQuadNeeded(), glm::ivec3(0));
+	// one cube - six quads
+	EXPECT_EQ(6u * 6u, mesh.getNoOfIndices());
+	EXPECT_EQ(6u * 4u, mesh.getNoOfVertices());
+	extractBinaryCubicMesh(&volume, Region(2, 10), &mesh, IsQuadNeeded(), glm::ivec3(0), true, false);
+	EXPECT_EQ(6u * 6u, mesh.getNoOfIndices());
+	EXPECT_EQ(6u * 4u, mesh.getNoOfVertices());
+}
+
+}
@@ -0,0 +1,88 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+
+namespace voxel {
+
+class ExtractionContextTest: public app::AbstractTest {
+protected:
+	RawVolume _volume { Region(0, 31) };
+
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		const Region& region = _volume.region();
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				const int height = 4 + (x * 3 + z * 5) % 9;
+				for (int32_t y = region.getLowerY(); y <= height; ++y) {
+					_volume.setVoxel(x, y, z, createVoxel(VoxelType::Grass, (uint8_t)(1 + (x / 5 + z / 3) % 4)));
+				}
+			}
+		}
+	}
+
+	static void expectEqual(const Mesh& expected, const Mesh& mesh) {
+		ASSERT_EQ(expected.getNoOfVertices(), mesh.getNoOfVertices());
+		ASSERT_EQ(expected.getNoOfIndices(), mesh.getNoOfIndices());
+		for (size_t i = 0; i < expected.getNoOfIndices(); ++i) {
+			ASSERT_EQ(expected.getIndex(i), mesh.getIndex(i));
+		}
+		for (size_t i = 0; i < expected.getNoOfVertices(); ++i) {
+			ASSERT_EQ(expected.getVertex(i).position, mesh.getVertex(i).position);
+			ASSERT_EQ(expected.getVertex(i).colorIndex, mesh.getVertex(i).colorIndex);
+			ASSERT_EQ(expected.getVertex(i).ambientOcclusion, mesh.getVertex(i).ambientOcclusion);
+		}
+	}
+};
+
+TEST_F(ExtractionContextTest, testReusedContext) {
+	const Region regions[] = { Region(1, 30), Region(4, 9), Region(1, 30) };
+	ExtractionContext ctx;
+	for (const Region& region : regions) {
+		Mesh expected(128, 128, true);
+		Mesh mesh(128, 128, true);
+		extractCubicMesh(&_volume, region, &expected, IsQuadNeeded(), region.getLowerCorner());
+		extractCubicMesh(ctx, &_volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+		expectEqual(expected, mesh);
+	}
+}
+
+TEST_F(ExtractionContextTest, testReusedContextBinary) {
+	const Region regions[] = { Region(1, 30), Region(4, 9), Region(1, 30) };
+	ExtractionContext ctx;
+	for (const Region& region : regions) {
+		Mesh expected(128, 128, true);
+		Mesh mesh(128, 128, true);
+		extractBinaryCubicMesh(&_volume, region, &expected, IsQuadNeeded(), region.getLowerCorner());
+		extractBinaryCubicMesh(ctx, &_volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+		expectEqual(expected, mesh);
+	}
+}
+
+TEST_F(ExtractionContextTest, testNoReallocationOnReExtraction) {
+	const Region region(1, 30);
+	ExtractionContext ctx;
+	Mesh mesh(128, 128, true);
+	extractCubicMesh(ctx, &_volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	const Quad* quads = ctx.quads[core::enumVal(FaceNames::PositiveY)][10].data();
+	ASSERT_NE(nullptr, quads);
+	const IndexType* remap = ctx.vertexRemap.data();
+	extractCubicMesh(ctx, &_volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	EXPECT_EQ(quads, ctx.quads[core::enumVal(FaceNames::PositiveY)][10].data());
+	EXPECT_EQ(remap, ctx.vertexRemap.data());
+
+	extractBinaryCubicMesh(ctx, &_volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	const Voxel* voxels = ctx.voxels.data();
+	const uint32_t* keys = ctx.keys.data();
+	extractBinaryCubicMesh(ctx, &_volume, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	EXPECT_EQ(voxels, ctx.voxels.data());
+	EXPECT_EQ(keys, ctx.keys.data());
+}
+
+}
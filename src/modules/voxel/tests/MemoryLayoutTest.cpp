@@ -0,0 +1,156 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/MemoryLayout.h"
+#include "voxel/RawVolume.h"
+#include "voxel/PagedVolume.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include <vector>
+
+namespace voxel {
+
+class MemoryLayoutTest: public app::AbstractTest {
+protected:
+	static Voxel voxelAt(int x, int y, int z) {
+		if ((x * 7 + y * 3 + z * 5) % 4 == 0) {
+			return createVoxel(VoxelType::Air, 0);
+		}
+		return createVoxel(VoxelType::Grass, (uint8_t)((x + y * 3 + z * 7) & 0xFF));
+	}
+
+	class LayoutPager: public PagedVolume::Pager {
+	public:
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			const Region& region = ctx.region;
+			for (int x = 0; x < region.getWidthInVoxels(); ++x) {
+				for (int y = 0; y < region.getHeightInVoxels(); ++y) {
+					for (int z = 0; z < region.getDepthInVoxels(); ++z) {
+						ctx.chunk->setVoxel(x, y, z, voxelAt(region.getLowerX() + x, region.getLowerY() + y, region.getLowerZ() + z));
+					}
+				}
+			}
+			return true;
+		}
+
+		void pageOut(PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	/**
+	 * @brief Checks that the sampler peeks are the same as the direct voxel access
+	 */
+	template<class Volume>
+	void checkSampler(const Volume& volume, const Region& region) {
+		typename Volume::Sampler sampler(&volume);
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				sampler.setPosition(region.getLowerX(), y, z);
+				for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					ASSERT_TRUE(volume.voxel(x, y, z).isSame(sampler.voxel())) << x << ":" << y << ":" << z;
+					ASSERT_TRUE(volume.voxel(x - 1, y - 1, z - 1).isSame(sampler.peekVoxel1nx1ny1nz())) << x << ":" << y << ":" << z;
+					ASSERT_TRUE(volume.voxel(x + 1, y + 1, z + 1).isSame(sampler.peekVoxel1px1py1pz())) << x << ":" << y << ":" << z;
+					ASSERT_TRUE(volume.voxel(x + 1, y - 1, z).isSame(sampler.peekVoxel1px1ny0pz())) << x << ":" << y << ":" << z;
+					ASSERT_TRUE(volume.voxel(x, y + 1, z - 1).isSame(sampler.peekVoxel0px1py1nz())) << x << ":" << y << ":" << z;
+					sampler.movePositiveX();
+				}
+			}
+		}
+	}
+};
+
+TEST_F(MemoryLayoutTest, testIndicesAreUnique) {
+	for (int i = 0; i < (int)MemoryLayout::Max; ++i) {
+		const VoxelLayout layout((MemoryLayout)i, 5, 7, 9);
+		ASSERT_GE(layout.size(), 5u * 7u * 9u) << toString((MemoryLayout)i);
+		std::vector<bool> used(layout.size(), false);
+		for (int z = 0; z < 9; ++z) {
+			for (int y = 0; y < 7; ++y) {
+				for (int x = 0; x < 5; ++x) {
+					const int32_t index = layout.index(x, y, z);
+					ASSERT_LT((size_t)index, layout.size()) << toString((MemoryLayout)i);
+					ASSERT_FALSE(used[index]) << toString((MemoryLayout)i) << " " << x << ":" << y << ":" << z;
+					used[index] = true;
+					if (x > 0) {
+						ASSERT_EQ(index, layout.index(x - 1, y, z) + layout.deltaX()[x - 1]);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(MemoryLayoutTest, testChunkLayoutSize) {
+	for (int i = 0; i < (int)MemoryLayout::Max; ++i) {
+		const VoxelLayout& layout = VoxelLayout::chunkLayout((MemoryLayout)i, 32);
+		EXPECT_EQ(32u * 32u * 32u, layout.size()) << toString((MemoryLayout)i);
+	}
+}
+
+TEST_F(MemoryLayoutTest, testMortonPadding) {
+	const VoxelLayout noPadding(MemoryLayout::Morton, 32, 32, 16);
+	EXPECT_EQ(MemoryLayout::Morton, noPadding.layout());
+	EXPECT_EQ(32u * 32u * 16u, noPadding.size());
+
+	const VoxelLayout padding(MemoryLayout::Morton, 256, 16, 256);
+	EXPECT_EQ(MemoryLayout::Linear, padding.layout());
+	EXPECT_EQ(256u * 16u * 256u, padding.size());
+
+	const Region region(glm::ivec3(-3, 0, 2), glm::ivec3(10, 6, 12));
+	RawVolume volume(region, MemoryLayout::Morton);
+	EXPECT_EQ(MemoryLayout::Linear, volume.memoryLayout());
+}
+
+TEST_F(MemoryLayoutTest, testRawVolumeSampler) {
+	const Region region(glm::ivec3(-3, 0, 2), glm::ivec3(12, 15, 17));
+	for (int i = 0; i < (int)MemoryLayout::Max; ++i) {
+		RawVolume volume(region, (MemoryLayout)i);
+		EXPECT_EQ((MemoryLayout)i, volume.memoryLayout());
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					volume.setVoxel(x, y, z, voxelAt(x, y, z));
+				}
+			}
+		}
+		RawVolume copy(volume);
+		checkSampler(copy, region);
+	}
+}
+
+TEST_F(MemoryLayoutTest, testPagedVolumeSampler) {
+	LayoutPager pager;
+	for (int i = 0; i < (int)MemoryLayout::Max; ++i) {
+		PagedVolume volume(&pager, 1 * 1024 * 1024, 8, 0u, (MemoryLayout)i);
+		EXPECT_EQ((MemoryLayout)i, volume.chunkMemoryLayout());
+		checkSampler(volume, Region(-5, 12));
+	}
+}
+
+TEST_F(MemoryLayoutTest, testExtractionIsIndependentOfLayout) {
+	const Region region(0, 15);
+	RawVolume linear(region, MemoryLayout::Linear);
+	RawVolume brick(region, MemoryLayout::Brick);
+	for (int32_t z = 0; z <= 15; ++z) {
+		for (int32_t y = 0; y <= 15; ++y) {
+			for (int32_t x = 0; x <= 15; ++x) {
+				linear.setVoxel(x, y, z, voxelAt(x, y, z));
+				brick.setVoxel(x, y, z, voxelAt(x, y, z));
+			}
+		}
+	}
+	Mesh linearMesh(128 * 1024, 128 * 1024);
+	Mesh brickMesh(128 * 1024, 128 * 1024);
+	extractCubicMesh(&linear, region, &linearMesh, IsQuadNeeded(), glm::ivec3(0));
+	extractCubicMesh(&brick, region, &brickMesh, IsQuadNeeded(), glm::ivec3(0));
+	ASSERT_EQ(linearMesh.getNoOfIndices(), brickMesh.getNoOfIndices());
+	ASSERT_EQ(linearMesh.getNoOfVertices(), brickMesh.getNoOfVertices());
+	for (size_t i = 0; i < linearMesh.getNoOfVertices(); ++i) {
+		EXPECT_EQ(linearMesh.getVertex(i).position, brickMesh.getVertex(i).position);
+		EXPECT_EQ(linearMesh.getVertex(i).colorIndex, brickMesh.getVertex(i).colorIndex);
+	}
+}
+
+}
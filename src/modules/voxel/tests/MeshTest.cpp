@@ -0,0 +1,150 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/Mesh.h"
+#include "voxel/RawVolume.h"
+#include <vector>
+
+namespace voxel {
+
+class MeshTest: public app::AbstractTest {
+protected:
+	void fill(RawVolume& volume) const {
+		const Region& region = volume.region();
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				const int height = 3 + (x * 3 + z * 5) % 7;
+				for (int32_t y = region.getLowerY(); y <= height; ++y) {
+					volume.setVoxel(x, y, z, createVoxel(VoxelType::Grass, (uint8_t)(1 + (x / 3 + z / 2) % 4)));
+				}
+			}
+		}
+	}
+
+	static std::vector<IndexType> indices(const Mesh& mesh) {
+		std::vector<IndexType> i;
+		for (size_t n = 0; n < mesh.getNoOfIndices(); ++n) {
+			i.push_back(mesh.getIndex((IndexType)n));
+		}
+		return i;
+	}
+
+	/**
+	 * @brief Checks that the sub meshes cover all indices and resolve to the given uncompressed indices
+	 */
+	static void checkSubMeshes(const Mesh& mesh, const std::vector<IndexType>& expected) {
+		ASSERT_TRUE(mesh.isCompressed());
+		ASSERT_EQ(expected.size(), mesh.getNoOfIndices());
+		size_t index = 0u;
+		for (const SubMesh& subMesh : mesh.subMeshes()) {
+			ASSERT_GT(subMesh.numIndices, 0u);
+			for (uint32_t i = 0u; i < subMesh.numIndices; ++i, ++index) {
+				IndexType compressed;
+				if (mesh.hasImplicitQuadIndices()) {
+					CompactIndexType quadIndices[6];
+					Mesh::fillQuadIndices(quadIndices, 1);
+					compressed = (IndexType)(i / 6u * 4u) + quadIndices[i % 6u];
+				} else {
+					EXPECT_EQ(index, subMesh.firstIndex + i);
+					compressed = mesh.compressedIndices()[subMesh.firstIndex + i];
+				}
+				ASSERT_EQ(expected[index], subMesh.baseVertex + compressed) << "index " << index;
+			}
+		}
+		ASSERT_EQ(expected.size(), index);
+	}
+};
+
+TEST_F(MeshTest, testCompressIndices) {
+	RawVolume volume(Region(0, 31));
+	fill(volume);
+	Mesh mesh(128, 128, true);
+	extractBinaryCubicMesh(&volume, Region(1, 30), &mesh, IsQuadNeeded(), glm::ivec3(0));
+	ASSERT_FALSE(mesh.isEmpty());
+	const std::vector<IndexType> expected = indices(mesh);
+	ASSERT_TRUE(mesh.compressIndices());
+	EXPECT_FALSE(mesh.hasImplicitQuadIndices());
+	EXPECT_NE(nullptr, mesh.compressedIndices());
+	EXPECT_EQ(1u, mesh.subMeshes().size());
+	checkSubMeshes(mesh, expected);
+	EXPECT_EQ(expected, indices(mesh));
+
+	Mesh copy(mesh);
+	EXPECT_TRUE(copy.isCompressed());
+	EXPECT_EQ(expected, indices(copy));
+
+	mesh.clear();
+	EXPECT_FALSE(mesh.isCompressed());
+	EXPECT_TRUE(mesh.isEmpty());
+}
+
+TEST_F(MeshTest, testImplicitQuadIndices) {
+	RawVolume volume(Region(0, 31));
+	fill(volume);
+	Mesh mesh(128, 128, true);
+	extractBinaryCubicMesh(&volume, Region(1, 30), &mesh, IsQuadNeeded(), glm::ivec3(0), true, false);
+	ASSERT_FALSE(mesh.isEmpty());
+	EXPECT_EQ(mesh.getNoOfVertices() / 4u * 6u, mesh.getNoOfIndices());
+	const std::vector<IndexType> expected = indices(mesh);
+	ASSERT_TRUE(mesh.compressIndices());
+	EXPECT_TRUE(mesh.hasImplicitQuadIndices());
+	EXPECT_EQ(nullptr, mesh.compressedIndices());
+	checkSubMeshes(mesh, expected);
+	EXPECT_EQ(expected, indices(mesh));
+}
+
+TEST_F(MeshTest, testSubMeshes) {
+	const size_t vertices = Mesh::MaxSubMeshVertices * 2u + 100u;
+	Mesh mesh((int)vertices, (int)vertices * 3, true);
+	for (size_t i = 0u; i < vertices; ++i) {
+		mesh.addVertex(VoxelVertex());
+	}
+	// no quad pattern - and each triangle references vertices that are close together
+	for (IndexType i = 0u; i + 4u < vertices; i += 3u) {
+		mesh.addTriangle(i + 4u, i, i + 2u);
+	}
+	const std::vector<IndexType> expected = indices(mesh);
+	ASSERT_TRUE(mesh.compressIndices());
+	EXPECT_FALSE(mesh.hasImplicitQuadIndices());
+	EXPECT_EQ(3u, mesh.subMeshes().size());
+	checkSubMeshes(mesh, expected);
+	EXPECT_EQ(expected, indices(mesh));
+}
+
+TEST_F(MeshTest, testQuadSubMeshes) {
+	const size_t quads = Mesh::MaxSubMeshVertices / 4u + 10u;
+	Mesh mesh((int)quads * 4, (int)quads * 6, true);
+	for (size_t i = 0u; i < quads; ++i) {
+		const IndexType v = mesh.addVertex(VoxelVertex());
+		mesh.addVertex(VoxelVertex());
+		mesh.addVertex(VoxelVertex());
+		mesh.addVertex(VoxelVertex());
+		mesh.addTriangle(v, v + 1, v + 2);
+		mesh.addTriangle(v, v + 2, v + 3);
+	}
+	const std::vector<IndexType> expected = indices(mesh);
+	ASSERT_TRUE(mesh.compressIndices());
+	EXPECT_TRUE(mesh.hasImplicitQuadIndices());
+	ASSERT_EQ(2u, mesh.subMeshes().size());
+	EXPECT_EQ((uint32_t)Mesh::MaxSubMeshVertices, mesh.subMeshes()[1].baseVertex);
+	checkSubMeshes(mesh, expected);
+}
+
+TEST_F(MeshTest, testTriangleExceedsCompactIndexRange) {
+	const size_t vertices = Mesh::MaxSubMeshVertices + 10u;
+	Mesh mesh((int)vertices, 6, true);
+	for (size_t i = 0u; i < vertices; ++i) {
+		mesh.addVertex(VoxelVertex());
+	}
+	mesh.addTriangle(0u, 1u, (IndexType)vertices - 1u);
+	EXPECT_FALSE(mesh.compressIndices());
+	EXPECT_FALSE(mesh.isCompressed());
+	ASSERT_EQ(3u, mesh.getNoOfIndices());
+	EXPECT_EQ((IndexType)vertices - 1u, mesh.getRawIndexData()[2]);
+}
+
+}
@@ -0,0 +1,370 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "core/concurrent/ThreadPool.h"
+#include <thread>
+#include <vector>
+
+namespace voxel {
+
+class PagedVolumeTest: public AbstractVoxelTest {
+protected:
+	/**
+	 * @brief Encodes the chunk position into the color index of the voxels of that chunk
+	 */
+	static uint8_t color(const glm::ivec3& chunkPos) {
+		return (uint8_t)(((chunkPos.x & 7) << 5) | ((chunkPos.y & 3) << 3) | (chunkPos.z & 7));
+	}
+
+	class ChunkPosPager: public PagedVolume::Pager {
+	public:
+		core::AtomicInt pagedIn { 0 };
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			const Voxel voxel = createVoxel(VoxelType::Generic, color(ctx.chunk->chunkPos()));
+			const int size = ctx.chunk->sideLength();
+			for (int x = 0; x < size; ++x) {
+				for (int y = 0; y < size; ++y) {
+					for (int z = 0; z < size; ++z) {
+						ctx.chunk->setVoxel(x, y, z, voxel);
+					}
+				}
+			}
+			++pagedIn;
+			return true;
+		}
+
+		void pageOut(PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	/**
+	 * @brief Keeps the voxels of the paged out chunks in memory
+	 */
+	class StoragePager: public PagedVolume::Pager {
+	public:
+		core::Lock lock;
+		std::unordered_map<glm::ivec3, std::vector<Voxel>, glm::hash<glm::ivec3>> chunks;
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			core::ScopedLock scoped(lock);
+			auto i = chunks.find(ctx.chunk->chunkPos());
+			if (i == chunks.end()) {
+				return false;
+			}
+			ctx.chunk->setData(i->second.data(), i->second.size() * sizeof(Voxel));
+			return false;
+		}
+
+		void pageOut(PagedVolume::Chunk* chunk) override {
+			core::ScopedLock scoped(lock);
+			const Voxel* data = chunk->allocatedData();
+			if (data == nullptr) {
+				chunks[chunk->chunkPos()].assign(chunk->voxels(), chunk->uniformVoxel());
+				return;
+			}
+			chunks[chunk->chunkPos()].assign(data, data + chunk->voxels());
+		}
+	};
+};
+
+TEST_F(PagedVolumeTest, testChunkIsPagedInOnce) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	for (int i = 0; i < 10; ++i) {
+		EXPECT_EQ(color(glm::ivec3(0)), volume.voxel(1, 2, 3).getColor());
+		EXPECT_EQ(color(glm::ivec3(1, 0, 0)), volume.voxel(17, 2, 3).getColor());
+	}
+	EXPECT_EQ(2, (int)pager.pagedIn);
+	EXPECT_EQ(2, volume.chunkCount());
+	volume.flushAll();
+	EXPECT_EQ(0, volume.chunkCount());
+	EXPECT_EQ(color(glm::ivec3(0)), volume.voxel(1, 2, 3).getColor());
+	EXPECT_EQ(3, (int)pager.pagedIn);
+}
+
+TEST_F(PagedVolumeTest, testChunkCountLimit) {
+	ChunkPosPager pager;
+	// 16^3 * 2 bytes per chunk - 1MB is enough for 128 chunks
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	for (int x = 0; x < 8; ++x) {
+		for (int y = 0; y < 4; ++y) {
+			for (int z = 0; z < 8; ++z) {
+				const glm::ivec3 chunkPos(x, y, z);
+				EXPECT_EQ(color(chunkPos), volume.voxel(chunkPos * 16).getColor());
+			}
+		}
+	}
+	EXPECT_EQ(256, (int)pager.pagedIn);
+	EXPECT_LT(volume.chunkCount(), 128);
+	EXPECT_EQ(256, volume.chunkCount() + volume.evictedChunks());
+}
+
+TEST_F(PagedVolumeTest, testEvictionBatch) {
+	ChunkPosPager pager;
+	// 128 chunks - evict down to 64 once the limit is reached
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	volume.setEvictionLowWaterMark(50);
+	for (int x = 0; x < 128; ++x) {
+		volume.voxel(x * 16, 0, 0);
+	}
+	EXPECT_EQ(65, volume.chunkCount());
+	EXPECT_EQ(63, volume.evictedChunks());
+}
+
+TEST_F(PagedVolumeTest, testEvictionKeepsReferencedChunks) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	for (int x = 0; x < 1024; ++x) {
+		// the chunk at the origin is accessed all the time and should never get evicted
+		EXPECT_EQ(color(glm::ivec3(0)), volume.voxel(0, 0, 0).getColor());
+		volume.voxel((x + 1) * 16, 0, 0);
+	}
+	EXPECT_EQ(1025, (int)pager.pagedIn);
+}
+
+TEST_F(PagedVolumeTest, testCompressedTier) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16, 1 * 1024 * 1024);
+	for (int n = 0; n < 2; ++n) {
+		for (int x = 0; x < 256; ++x) {
+			const glm::ivec3 chunkPos(x, 0, 0);
+			EXPECT_EQ(color(chunkPos), volume.voxel(chunkPos * 16).getColor());
+		}
+	}
+	// the second round is served by the compressed tier
+	EXPECT_EQ(256, (int)pager.pagedIn);
+	const PagedVolume::Statistics& stats = volume.statistics();
+	EXPECT_EQ(512, stats.uncompressedMisses);
+	EXPECT_EQ(256, stats.compressedHits);
+	EXPECT_EQ(256, stats.compressedMisses);
+	EXPECT_GT(stats.compressedChunks, 0);
+}
+
+TEST_F(PagedVolumeTest, testCompressRoundTrip) {
+	ChunkPosPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), 16, &pager);
+	for (int i = 0; i < 16; ++i) {
+		chunk.setVoxel(i, i, i, createVoxel(VoxelType::Grass, i));
+	}
+	PagedVolume::CompressedChunk compressed;
+	chunk.compress(compressed);
+	EXPECT_LT(compressed.sizeInBytes(), chunk.dataSizeInBytes());
+	PagedVolume::Chunk restored(glm::ivec3(0), 16, &pager);
+	ASSERT_TRUE(restored.decompress(compressed));
+	EXPECT_EQ(0, memcmp(chunk.data(), restored.data(), chunk.dataSizeInBytes()));
+}
+
+TEST_F(PagedVolumeTest, testUniformChunk) {
+	ChunkPosPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), 16, &pager);
+	EXPECT_TRUE(chunk.isUniform());
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Air, 0));
+	EXPECT_TRUE(chunk.isUniform()) << "Setting the uniform voxel should not allocate any data";
+	PagedVolume::CompressedChunk compressed;
+	chunk.compress(compressed);
+	EXPECT_EQ(nullptr, chunk.allocatedData()) << "Reading a uniform chunk should not allocate any data";
+	const Voxel voxel = createVoxel(VoxelType::Grass, 1);
+	chunk.setVoxel(1, 2, 3, voxel);
+	EXPECT_FALSE(chunk.isUniform());
+	EXPECT_TRUE(chunk.voxel(1, 2, 3).isSame(voxel));
+	EXPECT_EQ(VoxelType::Air, chunk.voxel(3, 2, 1).getMaterial());
+	EXPECT_FALSE(chunk.compact());
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Air, 0));
+	EXPECT_TRUE(chunk.compact());
+	EXPECT_TRUE(chunk.isUniform());
+}
+
+TEST_F(PagedVolumeTest, testUniformChunkCompressRoundTrip) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_TRUE(chunk->isUniform());
+	PagedVolume::CompressedChunk compressed;
+	chunk->compress(compressed);
+	PagedVolume::Chunk restored(glm::ivec3(0), 16, &pager);
+	ASSERT_TRUE(restored.decompress(compressed));
+	EXPECT_TRUE(restored.isUniform());
+	EXPECT_TRUE(restored.voxel(4, 5, 6).isSame(chunk->uniformVoxel()));
+}
+
+TEST_F(PagedVolumeTest, testUniformChunkSampler) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	PagedVolume::Sampler sampler(&volume);
+	sampler.setPosition(15, 0, 0);
+	EXPECT_EQ(color(glm::ivec3(0)), sampler.voxel().getColor());
+	EXPECT_EQ(color(glm::ivec3(1, 0, 0)), sampler.peekVoxel1px0py0pz().getColor());
+	sampler.movePositiveX();
+	EXPECT_EQ(color(glm::ivec3(1, 0, 0)), sampler.voxel().getColor());
+	EXPECT_EQ(color(glm::ivec3(0)), sampler.peekVoxel1nx0py0pz().getColor());
+	sampler.movePositiveY();
+	EXPECT_EQ(color(glm::ivec3(1, 0, 0)), sampler.voxel().getColor());
+
+	// copy-on-write on the first differing voxel
+	const Voxel voxel = createVoxel(VoxelType::Grass, 1);
+	EXPECT_TRUE(sampler.setVoxel(voxel));
+	EXPECT_FALSE(volume.chunk(glm::ivec3(16, 0, 0))->isUniform());
+	EXPECT_TRUE(volume.voxel(16, 1, 0).isSame(voxel));
+	sampler.movePositiveY();
+	EXPECT_EQ(color(glm::ivec3(1, 0, 0)), sampler.voxel().getColor());
+	EXPECT_TRUE(sampler.peekVoxel0px1ny0pz().isSame(voxel));
+	const PagedVolume::Statistics& stats = volume.statistics();
+	EXPECT_EQ(1, stats.uniformChunks);
+	EXPECT_EQ(16u * 16u * 16u * sizeof(Voxel), stats.uncompressedBytes);
+}
+
+TEST_F(PagedVolumeTest, testUniformRegion) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	Voxel voxel;
+	EXPECT_TRUE(volume.isUniform(Region(1, 1, 1, 14, 14, 14), voxel));
+	EXPECT_EQ(color(glm::ivec3(0)), voxel.getColor());
+	EXPECT_FALSE(volume.isUniform(Region(1, 1, 1, 16, 14, 14), voxel)) << "Chunks with different colors";
+}
+
+TEST_F(PagedVolumeTest, testPrefetch) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 4 * 1024 * 1024, 16);
+	core::ThreadPool threadPool(2, "PagedVolumeTest");
+	threadPool.init();
+	EXPECT_EQ(PagedVolume::ChunkState::Missing, volume.chunkState(glm::ivec3(0)));
+	EXPECT_FALSE(volume.tryChunk(glm::ivec3(0)));
+	const Region region(0, 0, 0, 63, 15, 63);
+	EXPECT_EQ(16, volume.prefetch(region, threadPool));
+	EXPECT_EQ(0, volume.prefetch(region, threadPool)) << "Chunks should only be queued once";
+	threadPool.shutdown(true);
+	for (int x = 0; x < 4; ++x) {
+		for (int z = 0; z < 4; ++z) {
+			const glm::ivec3 pos(x * 16, 0, z * 16);
+			EXPECT_EQ(PagedVolume::ChunkState::Ready, volume.chunkState(pos));
+			EXPECT_TRUE(volume.tryChunk(pos));
+		}
+	}
+	EXPECT_EQ(16, (int)pager.pagedIn);
+}
+
+TEST_F(PagedVolumeTest, testPrefetchMovement) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 4 * 1024 * 1024, 16);
+	core::ThreadPool threadPool(1, "PagedVolumeTest");
+	threadPool.init();
+	// 3 chunks around the position - 3 further chunks along the x axis
+	EXPECT_EQ(6, volume.prefetch(glm::ivec3(8), glm::ivec3(48, 0, 0), glm::ivec3(16, 0, 0), threadPool));
+	threadPool.shutdown(true);
+	EXPECT_EQ(PagedVolume::ChunkState::Ready, volume.chunkState(glm::ivec3(-16, 0, 0)));
+	EXPECT_EQ(PagedVolume::ChunkState::Ready, volume.chunkState(glm::ivec3(64, 0, 0)));
+	EXPECT_EQ(PagedVolume::ChunkState::Missing, volume.chunkState(glm::ivec3(80, 0, 0)));
+}
+
+TEST_F(PagedVolumeTest, testConcurrentReads) {
+	ChunkPosPager pager;
+	PagedVolume volume(&pager, 4 * 1024 * 1024, 16);
+	constexpr int threadCount = 4;
+	core::AtomicInt errors { 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&volume, &errors, t] () {
+			// every thread visits all 8x4x8 chunks - but starts at a different one
+			for (int i = 0; i < 20000; ++i) {
+				const int chunkIndex = (i + t * 64) % 256;
+				const glm::ivec3 chunkPos(chunkIndex % 8, (chunkIndex / 8) % 4, chunkIndex / 32);
+				const glm::ivec3 pos = chunkPos * 16 + glm::ivec3(i % 16, (i / 16) % 16, (i * 7) % 16);
+				if (volume.voxel(pos).getColor() != color(chunkPos)) {
+					++errors;
+				}
+			}
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(0, (int)errors);
+	EXPECT_EQ(8 * 4 * 8, (int)pager.pagedIn) << "Each chunk should only be paged in once";
+}
+
+TEST_F(PagedVolumeTest, testConcurrentPageIn) {
+	/**
+	 * @brief Blocks the page-ins until the given amount of page-ins was running at the same time once
+	 */
+	class BlockingPager: public ChunkPosPager {
+	public:
+		core::Lock lock;
+		core::ConditionVariable condition;
+		int running = 0;
+		int maxRunning = 0;
+		const int expected;
+
+		BlockingPager(int expectedPageIns) : expected(expectedPageIns) {
+		}
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			{
+				core::ScopedLock scoped(lock);
+				++running;
+				maxRunning = core_max(maxRunning, running);
+				condition.notify_all();
+				for (int i = 0; i < 1000 && maxRunning < expected; ++i) {
+					condition.waitTimeout(lock, 5);
+				}
+			}
+			const bool modified = ChunkPosPager::pageIn(ctx);
+			core::ScopedLock scoped(lock);
+			--running;
+			return modified;
+		}
+	};
+	constexpr int threadCount = 4;
+	BlockingPager pager(threadCount);
+	PagedVolume volume(&pager, 4 * 1024 * 1024, 16);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&volume, t] () {
+			// all threads access their own chunk - and chunk 0
+			volume.chunk(glm::ivec3((t + 1) * 16, 0, 0));
+			volume.chunk(glm::ivec3(0));
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(threadCount + 1, (int)pager.pagedIn) << "Each chunk should only be paged in once";
+	EXPECT_EQ(threadCount, pager.maxRunning) << "The page-in of different chunks should not be serialized";
+}
+
+TEST_F(PagedVolumeTest, testModifiedChunksSurviveConcurrentEviction) {
+	StoragePager pager;
+	// 128 chunks - but 256 chunks are modified
+	PagedVolume volume(&pager, 1 * 1024 * 1024, 16);
+	constexpr int chunks = 256;
+	for (int i = 0; i < chunks; ++i) {
+		volume.setVoxel(i * 16, 0, 0, createVoxel(VoxelType::Grass, (uint8_t)(i % 255 + 1)));
+	}
+	// the readers evict the modified chunks of each other - a chunk that is paged in again must
+	// not be read from the pager before its modifications were paged out
+	constexpr int threadCount = 4;
+	core::AtomicInt errors { 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&volume, &errors, t] () {
+			for (int n = 0; n < 4; ++n) {
+				for (int i = 0; i < chunks; ++i) {
+					const int chunkIndex = (i + t * chunks / threadCount) % chunks;
+					// the per-thread chunk cache of voxel() must keep the chunk alive if it's evicted by another thread
+					if (volume.voxel(chunkIndex * 16, 0, 0).getColor() != (uint8_t)(chunkIndex % 255 + 1)) {
+						++errors;
+					}
+				}
+			}
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(0, (int)errors);
+	EXPECT_GT(volume.evictedChunks(), chunks);
+}
+
+}
@@ -0,0 +1,77 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+
+namespace voxel {
+
+class RawVolumeTest: public app::AbstractTest {
+protected:
+	static void fill(RawVolume& volume) {
+		const Region& region = volume.region();
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				const int height = 4 + (x * 3 + z * 5) % 9;
+				for (int32_t y = region.getLowerY(); y <= height; ++y) {
+					volume.setVoxel(x, y, z, createVoxel(VoxelType::Grass, (uint8_t)(1 + (x / 5 + z / 3) % 4)));
+				}
+			}
+		}
+	}
+};
+
+TEST_F(RawVolumeTest, testCopyRegion) {
+	for (MemoryLayout layout : {MemoryLayout::Linear, MemoryLayout::Morton, MemoryLayout::Brick}) {
+		RawVolume volume(Region(-3, 28), layout);
+		volume.setBorderValue(createVoxel(VoxelType::Rock, 1));
+		fill(volume);
+		// partially outside of the source volume
+		const RawVolume copy(&volume, Region(glm::ivec3(5, -10, 2), glm::ivec3(17, 9, 40)));
+		// the morton layout would need padding for the copied region
+		EXPECT_EQ(layout == MemoryLayout::Morton ? MemoryLayout::Linear : layout, copy.memoryLayout());
+		EXPECT_EQ(Region(glm::ivec3(5, -3, 2), glm::ivec3(17, 9, 28)), copy.region());
+		const Region& region = volume.region();
+		for (int32_t z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int32_t y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int32_t x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					if (copy.region().containsPoint(x, y, z)) {
+						ASSERT_TRUE(volume.voxel(x, y, z).isSame(copy.voxel(x, y, z))) << x << ":" << y << ":" << z << " " << toString(layout);
+					} else {
+						ASSERT_TRUE(volume.borderValue().isSame(copy.voxel(x, y, z))) << x << ":" << y << ":" << z << " " << toString(layout);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_F(RawVolumeTest, testCopyRegionExtraction) {
+	RawVolume volume(Region(0, 31));
+	fill(volume);
+	const Region region(glm::ivec3(8, 0, 16), glm::ivec3(15, 7, 23));
+	// the extractor reads the direct neighbours of the region
+	Region snapshotRegion = region;
+	snapshotRegion.grow(1);
+	const RawVolume snapshot(&volume, snapshotRegion);
+	Mesh expected(128, 128, true);
+	Mesh mesh(128, 128, true);
+	extractBinaryCubicMesh(&volume, region, &expected, IsQuadNeeded(), region.getLowerCorner());
+	extractBinaryCubicMesh(&snapshot, region, &mesh, IsQuadNeeded(), region.getLowerCorner());
+	ASSERT_GT(expected.getNoOfIndices(), 0u);
+	ASSERT_EQ(expected.getNoOfVertices(), mesh.getNoOfVertices());
+	ASSERT_EQ(expected.getNoOfIndices(), mesh.getNoOfIndices());
+	for (size_t i = 0; i < expected.getNoOfIndices(); ++i) {
+		ASSERT_EQ(expected.getIndex(i), mesh.getIndex(i));
+	}
+	for (size_t i = 0; i < expected.getNoOfVertices(); ++i) {
+		ASSERT_EQ(expected.getVertex(i).position, mesh.getVertex(i).position);
+		ASSERT_EQ(expected.getVertex(i).colorIndex, mesh.getVertex(i).colorIndex);
+		ASSERT_EQ(expected.getVertex(i).ambientOcclusion, mesh.getVertex(i).ambientOcclusion);
+	}
+}
+
+}
@@ -11,10 +11,113 @@
 #include "app/App.h"
 #include "core/Log.h"
 #include "core/Assert.h"
+#include "core/FourCC.h"
+#include "core/Hash.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
+#include "core/concurrent/ThreadPool.h"
 #include "voxel/CubicSurfaceExtractor.h"
+#include <string.h>
+#include <vector>
 
 namespace voxelformat {
 
+namespace {
+
+constexpr uint32_t MeshCacheMagic = FourCC('V', 'M', 'S', 'H');
+// increase this whenever the layout of the cache files changes
+constexpr uint32_t MeshCacheVersion = 1u;
+// increase this whenever the mesh extraction in MeshCache::loadMesh() changes
+constexpr uint32_t MeshExtractorSettings = 1u;
+// the sections are aligned to allow to map the file and use the data directly
+constexpr size_t MeshCacheAlignment = 16u;
+
+/**
+ * @brief The header of a mesh cache file - followed by the vertices and the indices
+ */
+struct MeshCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t settings;
+	uint32_t vertexSize;
+	uint32_t indexSize;
+	// the hash and the size of the source file the mesh was extracted from
+	uint32_t sourceHash;
+	uint32_t sourceSize;
+	uint32_t vertices;
+	uint32_t indices;
+	int32_t offset[3];
+};
+static_assert(sizeof(MeshCacheHeader) % MeshCacheAlignment == 0, "The mesh cache header must keep the alignment");
+
+inline size_t align(size_t size) {
+	return (size + MeshCacheAlignment - 1u) & ~(MeshCacheAlignment - 1u);
+}
+
+bool readMeshCacheFile(const io::FilePtr& file, uint32_t sourceHash, uint32_t sourceSize, voxel::Mesh& mesh) {
+	const core::String& cacheFile = file->name();
+	uint8_t *buf = nullptr;
+	const int length = file->read((void**)&buf);
+	std::unique_ptr<uint8_t[]> data(buf);
+	if (length < (int)sizeof(MeshCacheHeader)) {
+		return false;
+	}
+	MeshCacheHeader header;
+	memcpy(&header, data.get(), sizeof(header));
+	if (header.magic != MeshCacheMagic || header.version != MeshCacheVersion || header.settings != MeshExtractorSettings
+			|| header.vertexSize != sizeof(voxel::VoxelVertex) || header.indexSize != sizeof(voxel::IndexType)) {
+		Log::debug("Outdated mesh cache file %s", cacheFile.c_str());
+		return false;
+	}
+	if (header.sourceHash != sourceHash || header.sourceSize != sourceSize) {
+		Log::debug("Source of the mesh cache file %s changed", cacheFile.c_str());
+		return false;
+	}
+	const size_t vertexBytes = (size_t)header.vertices * sizeof(voxel::VoxelVertex);
+	const size_t indexBytes = (size_t)header.indices * sizeof(voxel::IndexType);
+	const size_t indexStart = align(sizeof(header) + vertexBytes);
+	if ((size_t)length < indexStart + indexBytes) {
+		Log::warn("Truncated mesh cache file %s", cacheFile.c_str());
+		return false;
+	}
+	mesh.clear();
+	mesh.setOffset(glm::ivec3(header.offset[0], header.offset[1], header.offset[2]));
+	voxel::VertexArray& vertices = mesh.getVertexVector();
+	vertices.resize(header.vertices);
+	memcpy(vertices.data(), data.get() + sizeof(header), vertexBytes);
+	voxel::IndexArray& indices = mesh.getIndexVector();
+	indices.resize(header.indices);
+	memcpy(indices.data(), data.get() + indexStart, indexBytes);
+	return true;
+}
+
+bool writeMeshCacheFile(const core::String& cacheFile, uint32_t sourceHash, uint32_t sourceSize, const voxel::Mesh& mesh) {
+	MeshCacheHeader header;
+	header.magic = MeshCacheMagic;
+	header.version = MeshCacheVersion;
+	header.settings = MeshExtractorSettings;
+	header.vertexSize = sizeof(voxel::VoxelVertex);
+	header.indexSize = sizeof(voxel::IndexType);
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.vertices = (uint32_t)mesh.getNoOfVertices();
+	header.indices = (uint32_t)mesh.getNoOfIndices();
+	const glm::ivec3& offset = mesh.getOffset();
+	header.offset[0] = offset.x;
+	header.offset[1] = offset.y;
+	header.offset[2] = offset.z;
+	const size_t vertexBytes = (size_t)header.vertices * sizeof(voxel::VoxelVertex);
+	const size_t indexBytes = (size_t)header.indices * sizeof(voxel::IndexType);
+	const size_t indexStart = align(sizeof(header) + vertexBytes);
+	std::vector<uint8_t> data(indexStart + indexBytes, 0u);
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), mesh.getRawVertexData(), vertexBytes);
+	memcpy(data.data() + indexStart, mesh.getRawIndexData(), indexBytes);
+	return io::filesystem()->write(cacheFile, data.data(), data.size());
+}
+
+}
+
 MeshCache::~MeshCache() {
 	core_assert_msg(_initCalls == 0, "MeshCache wasn't shut down properly: %i", _initCalls);
 }
@@ -51,21 +154,96 @@ const voxel::Mesh* MeshCache::getMesh(const char *fullPath) {
 	return nullptr;
 }
 
-bool MeshCache::loadMesh(const char* fullPath, voxel::Mesh& mesh) {
-	Log::debug("Loading volume from %s", fullPath);
+core::String MeshCache::cacheFile(const char *fullPath) {
+	return core::string::format("meshcache/%s.vmesh", fullPath);
+}
+
+bool MeshCache::loadMeshes(const core::DynamicArray<core::String>& fullPaths) {
+	core_trace_scoped(LoadMeshes);
+	core::DynamicArray<core::String> paths;
+	for (const core::String& fullPath : fullPaths) {
+		const voxel::Mesh& cachedMesh = cacheEntry(fullPath.c_str());
+		if (cachedMesh.getNoOfVertices() > 0) {
+			continue;
+		}
+		paths.push_back(fullPath);
+	}
+	// every task writes into its own mesh - the cache entries are only touched by the calling thread
+	std::vector<voxel::Mesh> meshes(paths.size());
+	// not std::vector<bool> - every task writes its own element
+	std::vector<uint8_t> loaded(paths.size(), 0u);
+	core::ThreadPool& threadPool = app::App::getInstance()->threadPool();
+	core::TaskGroup group;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		const char *fullPath = paths[i].c_str();
+		voxel::Mesh* mesh = &meshes[i];
+		uint8_t* result = &loaded[i];
+		// the files are looked up here - the tasks only read files that exist
+		const io::FilePtr& file = sourceFile(fullPath);
+		const io::FilePtr& meshCacheFile = openCacheFile(fullPath);
+		threadPool.schedule(group, [this, fullPath, file, meshCacheFile, mesh, result] () {
+			*result = loadMesh(fullPath, file, meshCacheFile, *mesh) ? 1u : 0u;
+		});
+	}
+	threadPool.wait(group);
+	bool success = true;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		if (!loaded[i]) {
+			success = false;
+			continue;
+		}
+		cacheEntry(paths[i].c_str()) = core::move(meshes[i]);
+	}
+	return success;
+}
+
+io::FilePtr MeshCache::sourceFile(const char *fullPath) const {
 	const io::FilesystemPtr& fs = io::filesystem();
 	io::FilePtr file;
-
 	for (const char **ext = SUPPORTED_VOXEL_FORMATS_LOAD_LIST; *ext; ++ext) {
 		file = fs->open(core::string::format("%s.%s", fullPath, *ext));
 		if (file->exists()) {
 			break;
 		}
 	}
-	if (!file->exists()) {
+	return file;
+}
+
+io::FilePtr MeshCache::openCacheFile(const char *fullPath) const {
+	if (!_diskCache) {
+		return io::FilePtr();
+	}
+	const io::FilesystemPtr& fs = io::filesystem();
+	return fs->open(fs->homePath() + cacheFile(fullPath), io::FileMode::SysRead);
+}
+
+bool MeshCache::loadMesh(const char* fullPath, voxel::Mesh& mesh) const {
+	return loadMesh(fullPath, sourceFile(fullPath), openCacheFile(fullPath), mesh);
+}
+
+bool MeshCache::loadMesh(const char* fullPath, const io::FilePtr& file, const io::FilePtr& meshCacheFile, voxel::Mesh& mesh) const {
+	Log::debug("Loading volume from %s", fullPath);
+	if (!file || !file->exists()) {
 		Log::error("Failed to load %s for any of the supported format extensions", fullPath);
 		return false;
 	}
+
+	uint32_t sourceHash = 0u;
+	uint32_t sourceSize = 0u;
+	if (_diskCache) {
+		uint8_t *buf = nullptr;
+		const int length = file->read((void**)&buf);
+		std::unique_ptr<uint8_t[]> data(buf);
+		if (length > 0) {
+			sourceHash = core::hash(data.get(), length);
+			sourceSize = (uint32_t)length;
+		}
+		if (meshCacheFile && meshCacheFile->exists() && readMeshCacheFile(meshCacheFile, sourceHash, sourceSize, mesh)) {
+			Log::debug("Loaded cached mesh for %s", fullPath);
+			return true;
+		}
+	}
+
 	voxel::VoxelVolumes volumes;
 	if (!voxelformat::loadVolumeFormat(file, volumes)) {
 		Log::error("Failed to load %s", file->name().c_str());
@@ -87,10 +265,19 @@ bool MeshCache::loadMesh(const char* fullPath, voxel::Mesh& mesh) {
 	delete volume;
 
 	Log::info("Generated mesh for %s", fullPath);
+	if (_diskCache) {
+		const core::String& name = cacheFile(fullPath);
+		if (!writeMeshCacheFile(name, sourceHash, sourceSize, mesh)) {
+			Log::warn("Failed to write the mesh cache file %s", name.c_str());
+		}
+	}
 	return true;
 }
 
 bool MeshCache::init() {
+	if (_initCalls == 0) {
+		_diskCache = core::Var::get(cfg::VoxelMeshCacheDisk, "true", 0, "Write the extracted meshes to disk and load them from there as long as their source didn't change")->boolVal();
+	}
 	++_initCalls;
 	return true;
 }
@@ -8,12 +8,20 @@
 #include "core/IComponent.h"
 #include "core/StringUtil.h"
 #include "core/collection/StringMap.h"
+#include "core/collection/DynamicArray.h"
+#include "core/String.h"
+#include "io/File.h"
 #include <memory>
 
 namespace voxelformat {
 
 /**
  * @brief Cache @c voxel::Mesh instances by their name
+ *
+ * The extracted meshes are also written to disk (see @c cfg::VoxelMeshCacheDisk). The cache file of a mesh
+ * is only used if the hash of the source file and the extractor settings still match - otherwise the mesh
+ * is extracted again and the cache file is replaced.
+ *
  * @note The cache is @b not threadsafe
  * @sa MeshCache
  */
@@ -21,12 +29,33 @@ class MeshCache : public core::IComponent {
 protected:
 	core::StringMap<voxel::Mesh*> _meshes;
 	int _initCalls = 0;
+	bool _diskCache = false;
 
 	voxel::Mesh& cacheEntry(const char *fullPath);
-	bool loadMesh(const char* fullPath, voxel::Mesh& mesh);
+	bool loadMesh(const char* fullPath, voxel::Mesh& mesh) const;
+	/**
+	 * @param[in] file The voxel file to extract the mesh from
+	 * @param[in] meshCacheFile The cache file of the mesh - might not exist
+	 * @note This is threadsafe - it doesn't touch the cache entries
+	 */
+	bool loadMesh(const char* fullPath, const io::FilePtr& file, const io::FilePtr& meshCacheFile, voxel::Mesh& mesh) const;
+	/**
+	 * @brief Looks up the voxel file for any of the supported formats
+	 */
+	io::FilePtr sourceFile(const char *fullPath) const;
+	io::FilePtr openCacheFile(const char *fullPath) const;
 public:
 	~MeshCache();
 	const voxel::Mesh* getMesh(const char *fullPath);
+	/**
+	 * @brief Loads the meshes of the given paths that are not yet cached in parallel on the thread pool of the app
+	 * @return @c false if any of the meshes could not get loaded
+	 */
+	bool loadMeshes(const core::DynamicArray<core::String>& fullPaths);
+	/**
+	 * @return The path of the cache file for the given mesh - relative to the home path
+	 */
+	static core::String cacheFile(const char *fullPath);
 	bool removeMesh(const char *fullPath);
 	bool init() override;
 	void shutdown() override;
@@ -0,0 +1,103 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxelformat/MeshCache.h"
+#include "voxel/MaterialColor.h"
+#include "io/Filesystem.h"
+
+namespace voxelformat {
+
+class MeshCacheTest: public app::AbstractTest {
+protected:
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		ASSERT_TRUE(voxel::initDefaultMaterialColors());
+		removeCacheFile("rgb");
+		removeCacheFile("magicavoxel");
+	}
+
+	void removeCacheFile(const char *fullPath) {
+		const io::FilesystemPtr& fs = io::filesystem();
+		fs->removeFile(fs->homePath() + MeshCache::cacheFile(fullPath));
+	}
+
+	io::FilePtr openCacheFile(const char *fullPath) {
+		const io::FilesystemPtr& fs = io::filesystem();
+		return fs->open(fs->homePath() + MeshCache::cacheFile(fullPath), io::FileMode::SysRead);
+	}
+
+	void expectEqual(const voxel::Mesh& expected, const voxel::Mesh& mesh) {
+		EXPECT_EQ(expected.getOffset(), mesh.getOffset());
+		ASSERT_EQ(expected.getNoOfVertices(), mesh.getNoOfVertices());
+		ASSERT_EQ(expected.getNoOfIndices(), mesh.getNoOfIndices());
+		EXPECT_EQ(0, memcmp(expected.getRawVertexData(), mesh.getRawVertexData(), expected.getNoOfVertices() * sizeof(voxel::VoxelVertex)));
+		EXPECT_EQ(0, memcmp(expected.getRawIndexData(), mesh.getRawIndexData(), expected.getNoOfIndices() * sizeof(voxel::IndexType)));
+	}
+};
+
+TEST_F(MeshCacheTest, testWriteAndLoadCacheFile) {
+	MeshCache meshCache;
+	ASSERT_TRUE(meshCache.init());
+	const voxel::Mesh* mesh = meshCache.getMesh("rgb");
+	ASSERT_NE(nullptr, mesh);
+	ASSERT_GT(mesh->getNoOfVertices(), 0u);
+	ASSERT_TRUE(openCacheFile("rgb")->exists()) << "The extracted mesh should be written to disk";
+
+	MeshCache diskCache;
+	ASSERT_TRUE(diskCache.init());
+	const voxel::Mesh* cachedMesh = diskCache.getMesh("rgb");
+	ASSERT_NE(nullptr, cachedMesh);
+	expectEqual(*mesh, *cachedMesh);
+
+	diskCache.shutdown();
+	meshCache.shutdown();
+}
+
+TEST_F(MeshCacheTest, testRebuildInvalidCacheFile) {
+	MeshCache meshCache;
+	ASSERT_TRUE(meshCache.init());
+	const voxel::Mesh* mesh = meshCache.getMesh("rgb");
+	ASSERT_NE(nullptr, mesh);
+	const long length = openCacheFile("rgb")->length();
+
+	const uint8_t garbage[] = { 'V', 'M', 'S', 'H', 0xff, 0xff };
+	ASSERT_TRUE(io::filesystem()->write(MeshCache::cacheFile("rgb"), garbage, sizeof(garbage)));
+
+	MeshCache rebuildCache;
+	ASSERT_TRUE(rebuildCache.init());
+	const voxel::Mesh* rebuiltMesh = rebuildCache.getMesh("rgb");
+	ASSERT_NE(nullptr, rebuiltMesh);
+	expectEqual(*mesh, *rebuiltMesh);
+	EXPECT_EQ(length, openCacheFile("rgb")->length()) << "The invalid cache file should have been replaced";
+
+	rebuildCache.shutdown();
+	meshCache.shutdown();
+}
+
+TEST_F(MeshCacheTest, testLoadMeshes) {
+	MeshCache meshCache;
+	ASSERT_TRUE(meshCache.init());
+	core::DynamicArray<core::String> paths;
+	paths.push_back("rgb");
+	paths.push_back("magicavoxel");
+	ASSERT_TRUE(meshCache.loadMeshes(paths));
+	EXPECT_TRUE(openCacheFile("rgb")->exists());
+	EXPECT_TRUE(openCacheFile("magicavoxel")->exists());
+
+	MeshCache singleCache;
+	ASSERT_TRUE(singleCache.init());
+	for (const core::String& path : paths) {
+		const voxel::Mesh* mesh = meshCache.getMesh(path.c_str());
+		ASSERT_NE(nullptr, mesh);
+		const voxel::Mesh* singleMesh = singleCache.getMesh(path.c_str());
+		ASSERT_NE(nullptr, singleMesh);
+		expectEqual(*singleMesh, *mesh);
+	}
+
+	singleCache.shutdown();
+	meshCache.shutdown();
+}
+
+}
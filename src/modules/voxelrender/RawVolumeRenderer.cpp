@@ -5,7 +5,7 @@
 #include "RawVolumeRenderer.h"
 #include "core/Common.h"
 #include "core/Trace.h"
-#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
 #include "voxelutil/VolumeMerger.h"
 #include "voxel/MaterialColor.h"
 #include "video/ScopedLineWidth.h"
@@ -24,6 +24,9 @@
 #include "core/Log.h"
 #include "core/Algorithm.h"
 #include "core/StandardLib.h"
+#include "core/SharedPtr.h"
+#include "core/TimeProvider.h"
+#include "core/collection/DynamicArray.h"
 #include "VoxelShaderConstants.h"
 #include <SDL.h>
 #include <unordered_set>
@@ -139,6 +142,8 @@ void RawVolumeRenderer::update() {
 		if (!update(result.idx)) {
 			Log::error("Failed to update the mesh at index %i", result.idx);
 		}
+		const uint64_t latency = (core::TimeProvider::highResTime() - result.editTime) * 1000u / core::TimeProvider::highResTimeResolution();
+		core_trace_plot("RawVolumeRendererEditToMeshMillis", (int64_t)latency);
 		++cnt;
 	}
 	if (cnt > 0) {
@@ -369,14 +374,14 @@ bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region) {
 	const glm::ivec3& l = (region.getLowerCorner() - meshSizeMinusOne) / meshSize;
 	const glm::ivec3& u = region.getUpperCorner() / meshSize;
 
+	core::DynamicArray<voxel::Region> extractRegions;
+	voxel::Region snapshotRegion = voxel::Region::InvalidRegion;
 	for (int x = l.x; x <= u.x; ++x) {
 		for (int y = l.y; y <= u.y; ++y) {
 			for (int z = l.z; z <= u.z; ++z) {
 				const voxel::Region& finalRegion = calculateExtractRegion(x, y, z, meshSize);
-				const glm::ivec3& mins = finalRegion.getLowerCorner();
-
 				if (!voxel::intersects(completeRegion, finalRegion)) {
-					auto i = _meshes.find(mins);
+					auto i = _meshes.find(finalRegion.getLowerCorner());
 					if (i != _meshes.end()) {
 						Meshes& meshes = i->second;
 						delete meshes[idx];
@@ -384,21 +389,40 @@ bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region) {
 					}
 					continue;
 				}
-
-				voxel::RawVolume copy(volume);
-				_threadPool.enqueue([movedCopy = core::move(copy), mins, idx, finalRegion, this] () {
-					++_runningExtractorTasks;
-					voxel::Region reg = finalRegion;
-					reg.shiftUpperCorner(1, 1, 1);
-					voxel::Mesh mesh(65536, 65536, true);
-					voxel::extractCubicMesh(&movedCopy, reg, &mesh, raw::CustomIsQuadNeeded(), reg.getLowerCorner());
-					_pendingQueue.emplace(mins, idx, core::move(mesh));
-					Log::debug("Enqueue mesh for idx: %i", idx);
-					--_runningExtractorTasks;
-				});
+				if (extractRegions.empty()) {
+					snapshotRegion = finalRegion;
+				} else {
+					snapshotRegion.accumulate(finalRegion);
+				}
+				extractRegions.push_back(finalRegion);
 			}
 		}
 	}
+	if (extractRegions.empty()) {
+		return true;
+	}
+
+	// the extractor reads one voxel around the extraction region (which is one voxel bigger than the
+	// mesh region) - all tasks of this call share one copy of the voxels they need instead of copying
+	// the whole volume for every task
+	snapshotRegion.shiftLowerCorner(-1, -1, -1);
+	snapshotRegion.shiftUpperCorner(2, 2, 2);
+	const core::SharedPtr<voxel::RawVolume> snapshot = core::make_shared<voxel::RawVolume>(volume, snapshotRegion);
+	const uint64_t editTime = core::TimeProvider::highResTime();
+	for (const voxel::Region& finalRegion : extractRegions) {
+		const glm::ivec3& mins = finalRegion.getLowerCorner();
+		_threadPool.enqueue([snapshot, mins, idx, finalRegion, editTime, this] () {
+			++_runningExtractorTasks;
+			voxel::Region reg = finalRegion;
+			reg.shiftUpperCorner(1, 1, 1);
+			voxel::Mesh mesh(65536, 65536, true);
+			thread_local voxel::ExtractionContext ctx;
+			voxel::extractBinaryCubicMesh(ctx, snapshot.get(), reg, &mesh, raw::CustomIsQuadNeeded(), reg.getLowerCorner());
+			_pendingQueue.emplace(mins, idx, core::move(mesh), editTime);
+			Log::debug("Enqueue mesh for idx: %i", idx);
+			--_runningExtractorTasks;
+		});
+	}
 	return true;
 }
 
@@ -420,7 +444,8 @@ void RawVolumeRenderer::clearPendingExtractions() {
 void RawVolumeRenderer::extractVolumeRegionToMesh(voxel::RawVolume* volume, const voxel::Region& region, voxel::Mesh* mesh) const {
 	voxel::Region reg = region;
 	reg.shiftUpperCorner(1, 1, 1);
-	voxel::extractCubicMesh(volume, reg, mesh, raw::CustomIsQuadNeeded(), reg.getLowerCorner());
+	thread_local voxel::ExtractionContext ctx;
+	voxel::extractBinaryCubicMesh(ctx, volume, reg, mesh, raw::CustomIsQuadNeeded(), reg.getLowerCorner());
 }
 
 bool RawVolumeRenderer::hiddenState(int idx) const {
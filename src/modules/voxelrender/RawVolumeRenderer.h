@@ -70,12 +70,14 @@ protected:
 
 	struct ExtractionCtx {
 		ExtractionCtx() {}
-		ExtractionCtx(const glm::ivec3& _mins, int _idx, voxel::Mesh&& _mesh) :
-				mins(_mins), idx(_idx), mesh(_mesh) {
+		ExtractionCtx(const glm::ivec3& _mins, int _idx, voxel::Mesh&& _mesh, uint64_t _editTime) :
+				mins(_mins), idx(_idx), mesh(_mesh), editTime(_editTime) {
 		}
 		glm::ivec3 mins;
 		int idx;
 		voxel::Mesh mesh;
+		// the high resolution time of the extractRegion() call - to measure the time until the mesh is ready
+		uint64_t editTime = 0u;
 
 		inline bool operator<(const ExtractionCtx &rhs) const {
 			return idx < rhs.idx;
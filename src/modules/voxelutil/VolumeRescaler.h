@@ -8,6 +8,8 @@
 #include "voxel/MaterialColor.h"
 #include "voxel/Voxel.h"
 #include "voxel/Region.h"
+#include <vector>
+#include <algorithm>
 
 namespace voxel {
 
@@ -171,4 +173,52 @@ void rescaleVolume(const SourceVolume& sourceVolume, DestVolume& destVolume) {
 	rescaleVolume(sourceVolume, sourceVolume.region(), destVolume, destVolume.region());
 }
 
+/**
+ * @brief Downsamples a part of a volume by the given factor - e.g. for level of detail meshes.
+ *
+ * Other than @c rescaleVolume() this doesn't compute new colors: A target voxel is solid if at least half of
+ * the source voxels it covers are solid and it is a copy of the upper most of these solid voxels. This keeps
+ * e.g. the grass on top of a terrain. Voxels that are not solid (air and water) are turned into air.
+ *
+ * @param[in] sourceLower The source position of the first target voxel
+ * @param[in] factor The amount of source voxels per axis for one target voxel
+ * @param[in] size The amount of target voxels per axis
+ * @param[out] target Buffer for @c size.x * size.y * size.z voxels in x, then y, then z order
+ */
+template<typename SourceVolume>
+void downsampleVolume(const SourceVolume& sourceVolume, const glm::ivec3& sourceLower, int factor, const glm::ivec3& size, Voxel* target) {
+	core_trace_scoped(DownsampleVolume);
+	core_assert(factor >= 1);
+	typename SourceVolume::Sampler srcSampler(sourceVolume);
+	const int solidThreshold = (factor * factor * factor + 1) / 2;
+	std::vector<int> solidVoxels(size.x);
+	std::vector<Voxel> upperVoxels(size.x);
+	for (int32_t z = 0; z < size.z; ++z) {
+		for (int32_t y = 0; y < size.y; ++y) {
+			std::fill(solidVoxels.begin(), solidVoxels.end(), 0);
+			// the children are visited from bottom to top - the last solid child of a voxel is the upper most one
+			for (int32_t childY = 0; childY < factor; ++childY) {
+				for (int32_t childZ = 0; childZ < factor; ++childZ) {
+					const glm::ivec3 srcPos(sourceLower.x, sourceLower.y + y * factor + childY, sourceLower.z + z * factor + childZ);
+					srcSampler.setPosition(srcPos);
+					for (int32_t x = 0; x < size.x; ++x) {
+						for (int32_t childX = 0; childX < factor; ++childX) {
+							const Voxel& child = srcSampler.voxel();
+							const VoxelType material = child.getMaterial();
+							if (!isAir(material) && !isWater(material)) {
+								++solidVoxels[x];
+								upperVoxels[x] = child;
+							}
+							srcSampler.movePositiveX();
+						}
+					}
+				}
+			}
+			for (int32_t x = 0; x < size.x; ++x) {
+				*target++ = solidVoxels[x] >= solidThreshold ? upperVoxels[x] : Voxel();
+			}
+		}
+	}
+}
+
 }
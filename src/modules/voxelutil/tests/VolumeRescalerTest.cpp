@@ -0,0 +1,65 @@
+/**
+ * @file
+ */
+
+#include "voxel/tests/AbstractVoxelTest.h"
+#include "voxelutil/VolumeRescaler.h"
+
+namespace voxel {
+
+class VolumeRescalerTest: public AbstractVoxelTest {
+};
+
+TEST_F(VolumeRescalerTest, testDownsample) {
+	voxel::RawVolume volume(voxel::Region(0, 7));
+	const Voxel dirt = createVoxel(VoxelType::Dirt, 1);
+	const Voxel grass = createVoxel(VoxelType::Grass, 2);
+	for (int z = 0; z < 8; ++z) {
+		for (int x = 0; x < 8; ++x) {
+			// three dirt layers and one grass layer on top
+			for (int y = 0; y < 3; ++y) {
+				volume.setVoxel(x, y, z, dirt);
+			}
+			volume.setVoxel(x, 3, z, grass);
+		}
+	}
+
+	const glm::ivec3 size(4);
+	Voxel voxels[4 * 4 * 4];
+	downsampleVolume(volume, glm::ivec3(0), 2, size, voxels);
+	for (int z = 0; z < size.z; ++z) {
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				const Voxel& voxel = voxels[(z * size.y + y) * size.x + x];
+				if (y == 0) {
+					EXPECT_EQ(dirt, voxel) << x << ":" << y << ":" << z;
+				} else if (y == 1) {
+					// the upper most voxel is kept
+					EXPECT_EQ(grass, voxel) << x << ":" << y << ":" << z;
+				} else {
+					EXPECT_TRUE(isAir(voxel.getMaterial())) << x << ":" << y << ":" << z;
+				}
+			}
+		}
+	}
+}
+
+TEST_F(VolumeRescalerTest, testDownsampleMajority) {
+	voxel::RawVolume volume(voxel::Region(0, 3));
+	const Voxel rock = createVoxel(VoxelType::Rock, 1);
+	// three of eight solid voxels for the first target voxel - four of eight for the second one
+	volume.setVoxel(0, 0, 0, rock);
+	volume.setVoxel(1, 0, 0, rock);
+	volume.setVoxel(0, 1, 0, rock);
+	volume.setVoxel(2, 0, 0, rock);
+	volume.setVoxel(3, 0, 0, rock);
+	volume.setVoxel(2, 1, 0, rock);
+	volume.setVoxel(3, 1, 1, rock);
+
+	Voxel voxels[2];
+	downsampleVolume(volume, glm::ivec3(0), 2, glm::ivec3(2, 1, 1), voxels);
+	EXPECT_TRUE(isAir(voxels[0].getMaterial()));
+	EXPECT_EQ(rock, voxels[1]);
+}
+
+}
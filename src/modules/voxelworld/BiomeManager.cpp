@@ -9,7 +9,7 @@
 #include "core/Common.h"
 #include "core/GLM.h"
 #include "core/Log.h"
-#include "noise/Simplex.h"
+#include "noise/BatchNoise.h"
 #include "voxel/Constants.h"
 #include "voxel/Region.h"
 #include "voxel/MaterialColor.h"
@@ -18,6 +18,7 @@
 #include "core/Enum.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/norm.hpp>
+#include <algorithm>
 
 namespace voxelworld {
 
@@ -46,7 +47,11 @@ void BiomeManager::shutdown() {
 			delete zone;
 		}
 		_zones[i].clear();
+		_zoneGrid[i].clear();
 	}
+	_bandBounds.clear();
+	_climateCells.clear();
+	_candidates.clear();
 }
 
 bool BiomeManager::init(const core::String& luaString) {
@@ -96,25 +101,136 @@ Biome* BiomeManager::addBiome(int lower, int upper, float humidity, float temper
 	Biome* biome = new Biome(type, int16_t(lower), int16_t(upper),
 			humidity, temperature, underGround, treeDistribution);
 	_biomes.push_back(biome);
+	updateBiomeLookup();
 	return biome;
 }
 
+void BiomeManager::updateBiomeLookup() {
+	core_trace_scoped(BiomeUpdateLookup);
+	_bandBounds.clear();
+	for (const Biome* biome : _biomes) {
+		_bandBounds.push_back(biome->yMin);
+		_bandBounds.push_back(biome->yMax + 1);
+	}
+	std::sort(_bandBounds.begin(), _bandBounds.end());
+	_bandBounds.erase(std::unique(_bandBounds.begin(), _bandBounds.end()), _bandBounds.end());
+
+	const int bands = core_max(0, (int)_bandBounds.size() - 1);
+	constexpr int cellsPerTable = ClimateCells * ClimateCells;
+	_climateCells.assign((size_t)bands * 2 * cellsPerTable, ClimateCell());
+	_candidates.clear();
+
+	constexpr float cellSize = 1.0f / (float)ClimateCells;
+	std::vector<const Biome*> biomes;
+	std::vector<float> minDistances;
+	for (int band = 0; band < bands; ++band) {
+		const int y = _bandBounds[band];
+		for (int underground = 0; underground < 2; ++underground) {
+			biomes.clear();
+			for (const Biome* biome : _biomes) {
+				if (y > biome->yMax || y < biome->yMin || biome->underground != (underground != 0)) {
+					continue;
+				}
+				biomes.push_back(biome);
+			}
+			if (biomes.empty()) {
+				continue;
+			}
+			ClimateCell* cells = &_climateCells[((size_t)band * 2 + underground) * cellsPerTable];
+			minDistances.resize(biomes.size());
+			for (int t = 0; t < ClimateCells; ++t) {
+				const float minT = (float)t * cellSize;
+				const float maxT = minT + cellSize;
+				for (int h = 0; h < ClimateCells; ++h) {
+					const float minH = (float)h * cellSize;
+					const float maxH = minH + cellSize;
+					// a biome can only be the best match somewhere in the cell if its closest distance to the
+					// cell is not bigger than the farthest distance of any other biome
+					float threshold = (std::numeric_limits<float>::max)();
+					for (size_t i = 0; i < biomes.size(); ++i) {
+						const Biome* biome = biomes[i];
+						const float dT = biome->temperature - glm::clamp(biome->temperature, minT, maxT);
+						const float dH = biome->humidity - glm::clamp(biome->humidity, minH, maxH);
+						minDistances[i] = dT * dT + dH * dH;
+						const float farT = core_max(glm::abs(biome->temperature - minT), glm::abs(biome->temperature - maxT));
+						const float farH = core_max(glm::abs(biome->humidity - minH), glm::abs(biome->humidity - maxH));
+						threshold = core_min(threshold, farT * farT + farH * farH);
+					}
+					// some tolerance for the float precision - more candidates don't change the result
+					threshold = threshold * 1.0001f + 0.000001f;
+					ClimateCell& cell = cells[t * ClimateCells + h];
+					cell.offset = (uint32_t)_candidates.size();
+					for (size_t i = 0; i < biomes.size(); ++i) {
+						if (minDistances[i] <= threshold) {
+							_candidates.push_back(biomes[i]);
+						}
+					}
+					cell.count = (uint32_t)_candidates.size() - cell.offset;
+				}
+			}
+		}
+	}
+	Log::debug("Biome lookup with %i bands and %i candidates", bands, (int)_candidates.size());
+}
+
+const Biome* BiomeManager::findBiome(int y, float humidity, float temperature, bool underground, const Biome* const* begin, const Biome* const* end) const {
+	const Biome *biomeBestMatch = _defaultBiome;
+	float distMin = (std::numeric_limits<float>::max)();
+	for (const Biome* const* i = begin; i != end; ++i) {
+		const Biome* biome = *i;
+		if (y > biome->yMax || y < biome->yMin || biome->underground != underground) {
+			continue;
+		}
+		const float dTemperature = temperature - biome->temperature;
+		const float dHumidity = humidity - biome->humidity;
+		const float dist = (dTemperature * dTemperature) + (dHumidity * dHumidity);
+		if (dist < distMin) {
+			biomeBestMatch = biome;
+			distMin = dist;
+		}
+	}
+	return biomeBestMatch;
+}
+
+static void climateNoise(const int* x, const int* z, float frequency, float* out, int amount) {
+	constexpr int blockSize = 256;
+	float posX[blockSize];
+	float posZ[blockSize];
+	for (int block = 0; block < amount; block += blockSize) {
+		const int n = core_min(blockSize, amount - block);
+		for (int i = 0; i < n; ++i) {
+			posX[i] = x[block + i] * frequency;
+			posZ[i] = z[block + i] * frequency;
+		}
+		noise::noise(posX, posZ, out + block, n);
+		for (int i = 0; i < n; ++i) {
+			out[block + i] = noise::norm(out[block + i]);
+		}
+	}
+}
+
+static constexpr float HumidityFrequency = 0.001f;
+// TODO: apply y value
+static constexpr float TemperatureFrequency = 0.0001f;
+
 float BiomeManager::getHumidity(int x, int z) {
 	core_trace_scoped(BiomeGetHumidity);
-	const float frequency = 0.001f;
-	const glm::vec2 noisePos(x * frequency, z * frequency);
-	const float n = noise::noise(noisePos);
-	return noise::norm(n);
+	float humidity;
+	climateNoise(&x, &z, HumidityFrequency, &humidity, 1);
+	return humidity;
 }
 
 float BiomeManager::getTemperature(int x, int z) {
 	core_trace_scoped(BiomeGetTemperature);
-	const float frequency = 0.0001f;
-	// TODO: apply y value
-	// const float scaleY = pos.y / (float)MAX_HEIGHT;
-	const glm::vec2 noisePos(x * frequency, z * frequency);
-	const float n = noise::noise(noisePos);
-	return noise::norm(n);
+	float temperature;
+	climateNoise(&x, &z, TemperatureFrequency, &temperature, 1);
+	return temperature;
+}
+
+void BiomeManager::getClimate(const int* x, const int* z, float* humidity, float* temperature, int amount) {
+	core_trace_scoped(BiomeGetClimate);
+	climateNoise(x, z, HumidityFrequency, humidity, amount);
+	climateNoise(x, z, TemperatureFrequency, temperature, amount);
 }
 
 const Biome* BiomeManager::getBiome(const glm::ivec3& pos, bool underground) const {
@@ -142,23 +258,32 @@ const Biome* BiomeManager::getBiome(const glm::ivec3& pos, bool underground) con
 		last.underground = underground;
 	}
 
-	const Biome *biomeBestMatch = _defaultBiome;
-	float distMin = (std::numeric_limits<float>::max)();
+	return getBiome(pos, humidity, temperature, underground);
+}
 
-	core_trace_scoped(BiomeGetBiomeLoop);
-	for (const Biome* biome : _biomes) {
-		if (pos.y > biome->yMax || pos.y < biome->yMin || biome->underground != underground) {
-			continue;
-		}
-		const float dTemperature = temperature - biome->temperature;
-		const float dHumidity = humidity - biome->humidity;
-		const float dist = (dTemperature * dTemperature) + (dHumidity * dHumidity);
-		if (dist < distMin) {
-			biomeBestMatch = biome;
-			distMin = dist;
-		}
+const Biome* BiomeManager::getBiome(const glm::ivec3& pos, float humidity, float temperature, bool underground) const {
+	core_assert_msg(_defaultBiome != nullptr, "BiomeManager is not yet initialized");
+	core_trace_scoped(BiomeLookup);
+	if (humidity < 0.0f || humidity > 1.0f || temperature < 0.0f || temperature > 1.0f) {
+		// the lookup table only covers the range of the climate noise
+		return findBiome(pos.y, humidity, temperature, underground, _biomes.data(), _biomes.data() + _biomes.size());
 	}
-	return biomeBestMatch;
+	const int band = (int)(std::upper_bound(_bandBounds.begin(), _bandBounds.end(), pos.y) - _bandBounds.begin()) - 1;
+	if (band < 0 || band >= (int)_bandBounds.size() - 1) {
+		return _defaultBiome;
+	}
+	const int h = core_min((int)(humidity * (float)ClimateCells), ClimateCells - 1);
+	const int t = core_min((int)(temperature * (float)ClimateCells), ClimateCells - 1);
+	const size_t table = (size_t)band * 2 + (underground ? 1 : 0);
+	const ClimateCell& cell = _climateCells[table * ClimateCells * ClimateCells + t * ClimateCells + h];
+	if (cell.count == 0u) {
+		return _defaultBiome;
+	}
+	const Biome* const* candidates = _candidates.data() + cell.offset;
+	if (cell.count == 1u) {
+		return *candidates;
+	}
+	return findBiome(pos.y, humidity, temperature, underground, candidates, candidates + cell.count);
 }
 
 static inline math::Rect<int> rect(const voxel::Region& region) {
@@ -263,12 +388,49 @@ int BiomeManager::getCityDensity(const glm::ivec2& pos) const {
 	return 0;
 }
 
+static inline int zoneCellCoord(int v, int cellSize) {
+	return v >= 0 ? v / cellSize : (v + 1) / cellSize - 1;
+}
+
+static inline uint64_t zoneCellKey(int cellX, int cellZ) {
+	return ((uint64_t)(uint32_t)cellX << 32) | (uint64_t)(uint32_t)cellZ;
+}
+
 void BiomeManager::addZone(const glm::ivec3& pos, float radius, ZoneType type) {
-	_zones[core::enumVal(type)].push_back(new Zone(pos, radius, type));
+	Zone* zone = new Zone(pos, radius, type);
+	_zones[core::enumVal(type)].push_back(zone);
+	// register the zone in all cells that are touched by its bounding box - the zones of a cell keep
+	// the order in which they were added
+	const int r = (int)glm::ceil(radius);
+	const int minX = zoneCellCoord(pos.x - r, ZoneCellSize);
+	const int maxX = zoneCellCoord(pos.x + r, ZoneCellSize);
+	const int minZ = zoneCellCoord(pos.z - r, ZoneCellSize);
+	const int maxZ = zoneCellCoord(pos.z + r, ZoneCellSize);
+	for (int cellZ = minZ; cellZ <= maxZ; ++cellZ) {
+		for (int cellX = minX; cellX <= maxX; ++cellX) {
+			_zoneGrid[core::enumVal(type)][zoneCellKey(cellX, cellZ)].push_back(zone);
+		}
+	}
+}
+
+const std::vector<const Zone*>* BiomeManager::zoneCell(int x, int z, ZoneType type) const {
+	const auto& grid = _zoneGrid[core::enumVal(type)];
+	if (grid.empty()) {
+		return nullptr;
+	}
+	auto i = grid.find(zoneCellKey(zoneCellCoord(x, ZoneCellSize), zoneCellCoord(z, ZoneCellSize)));
+	if (i == grid.end()) {
+		return nullptr;
+	}
+	return &i->second;
 }
 
 const Zone* BiomeManager::getZone(const glm::ivec3& pos, ZoneType type) const {
-	for (const Zone* z : _zones[core::enumVal(type)]) {
+	const std::vector<const Zone*>* zones = zoneCell(pos.x, pos.z, type);
+	if (zones == nullptr) {
+		return nullptr;
+	}
+	for (const Zone* z : *zones) {
 		const float distance = glm::distance2(glm::vec3(pos), glm::vec3(z->pos()));
 		if (distance < glm::pow(z->radius(), 2)) {
 			return z;
@@ -278,8 +440,12 @@ const Zone* BiomeManager::getZone(const glm::ivec3& pos, ZoneType type) const {
 }
 
 const Zone* BiomeManager::getZone(const glm::ivec2& pos, ZoneType type) const {
+	const std::vector<const Zone*>* zones = zoneCell(pos.x, pos.y, type);
+	if (zones == nullptr) {
+		return nullptr;
+	}
 	const glm::vec3 p(pos.x, 0.0f, pos.y);
-	for (const Zone* z : _zones[core::enumVal(type)]) {
+	for (const Zone* z : *zones) {
 		const glm::ivec3& zp = z->pos();
 		const float distance = glm::distance2(p, glm::vec3(zp.x, 0.0f, zp.z));
 		if (distance < glm::pow(z->radius(), 2)) {
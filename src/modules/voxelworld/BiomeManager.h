@@ -10,6 +10,7 @@
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace math {
@@ -63,6 +64,34 @@ private:
 	static void distributePointsInRegion(const voxel::Region& region, std::vector<glm::vec2>& positions, math::Random& random, int border, float distribution);
 	noise::Noise _noise;
 
+	/**
+	 * @brief The amount of quantization steps for the humidity and the temperature in the biome lookup table
+	 */
+	static constexpr int ClimateCells = 32;
+	/**
+	 * @brief The biomes that can be the best match for any humidity and temperature of a quantized climate cell
+	 */
+	struct ClimateCell {
+		uint32_t offset = 0u;
+		uint32_t count = 0u;
+	};
+	/**
+	 * The y axis is split into bands in which the set of biomes doesn't change. Each band has a
+	 * @c ClimateCells x @c ClimateCells table for the surface and the underground biomes.
+	 */
+	std::vector<int> _bandBounds;
+	std::vector<ClimateCell> _climateCells;
+	std::vector<const Biome*> _candidates;
+	void updateBiomeLookup();
+	const Biome* findBiome(int y, float humidity, float temperature, bool underground, const Biome* const* begin, const Biome* const* end) const;
+
+	/**
+	 * @brief Uniform grid over the x and z axis - each cell knows the zones that intersect with it
+	 */
+	static constexpr int ZoneCellSize = 256;
+	std::unordered_map<uint64_t, std::vector<const Zone*>> _zoneGrid[int(ZoneType::Max)];
+	const std::vector<const Zone*>* zoneCell(int x, int z, ZoneType type) const;
+
 public:
 	BiomeManager();
 	~BiomeManager();
@@ -86,6 +115,15 @@ public:
 		return getVoxel(glm::ivec3(x, y, z), underground);
 	}
 
+	/**
+	 * @brief Variant for callers that already know the humidity and temperature of the position - see @c getClimate()
+	 */
+	inline voxel::Voxel getVoxel(const glm::ivec3& pos, float humidity, float temperature, bool underground = false) const {
+		core_trace_scoped(BiomeGetVoxel);
+		const Biome* biome = getBiome(pos, humidity, temperature, underground);
+		return biome->voxel();
+	}
+
 	bool hasCactus(const glm::ivec3& pos) const;
 	bool hasTrees(const glm::ivec3& pos) const;
 	bool hasCity(const glm::ivec3& pos) const;
@@ -110,10 +148,19 @@ public:
 	 * @return Temperature noise in the range [0-1]
 	 */
 	static float getTemperature(int x, int z);
+	/**
+	 * @brief Evaluates the humidity and temperature for @c amount positions in one batch
+	 * @note The values are the same as the ones that are returned by @c getHumidity() and @c getTemperature()
+	 */
+	static void getClimate(const int* x, const int* z, float* humidity, float* temperature, int amount);
 
 	void setDefaultBiome(const Biome* biome);
 
 	const Biome* getBiome(const glm::ivec3& pos, bool underground = false) const;
+	/**
+	 * @brief Looks up the best matching biome in the precomputed biome table
+	 */
+	const Biome* getBiome(const glm::ivec3& pos, float humidity, float temperature, bool underground = false) const;
 };
 
 typedef std::shared_ptr<BiomeManager> BiomeManagerPtr;
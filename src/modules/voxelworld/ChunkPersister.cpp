@@ -9,15 +9,43 @@
 #include "core/Enum.h"
 #include "core/Trace.h"
 #include "core/Log.h"
+#include <vector>
 
 namespace voxelworld {
 
-#define WORLD_FILE_VERSION 2
+// The voxels are always stored in linear order - the files don't depend on the chunk memory layout
+// that was selected at compile time
+#define WORLD_FILE_VERSION 3
+
+static inline uint32_t linearSizeInBytes(const voxel::PagedVolume::ChunkPtr& chunk) {
+	const uint32_t sideLength = chunk->sideLength();
+	return sideLength * sideLength * sideLength * (uint32_t)sizeof(voxel::Voxel);
+}
 
 bool ChunkPersister::saveCompressed(const voxel::PagedVolume::ChunkPtr& chunk, core::ByteStream& outStream) const {
 	// save the stuff
-	const voxel::Voxel* voxelBuf = chunk->data();
-	const int voxelSize = chunk->dataSizeInBytes();
+	const voxel::Voxel* voxelBuf = chunk->allocatedData();
+	const int voxelSize = (int)linearSizeInBytes(chunk);
+	// the chunk might be read by other threads, too - don't allocate the data of uniform chunks
+	std::vector<voxel::Voxel> linearBuf;
+	if (voxelBuf == nullptr) {
+		linearBuf.assign(voxelSize / sizeof(voxel::Voxel), chunk->uniformVoxel());
+		voxelBuf = linearBuf.data();
+	} else if (chunk->layout().layout() != voxel::MemoryLayout::Linear) {
+		core_trace_scoped(ChunkPersisterLinearize);
+		const int32_t sideLength = chunk->sideLength();
+		const voxel::VoxelLayout& layout = chunk->layout();
+		linearBuf.resize(voxelSize / sizeof(voxel::Voxel));
+		voxel::Voxel* target = linearBuf.data();
+		for (int32_t z = 0; z < sideLength; ++z) {
+			for (int32_t y = 0; y < sideLength; ++y) {
+				for (int32_t x = 0; x < sideLength; ++x) {
+					*target++ = voxelBuf[layout.index(x, y, z)];
+				}
+			}
+		}
+		voxelBuf = linearBuf.data();
+	}
 	uint32_t neededVoxelBufLen = core::zip::compressBound(voxelSize);
 	uint8_t* compressedVoxelBuf = new uint8_t[neededVoxelBufLen];
 	std::unique_ptr<uint8_t[]> smartBuf(compressedVoxelBuf);
@@ -55,7 +83,7 @@ bool ChunkPersister::loadCompressed(const voxel::PagedVolume::ChunkPtr& chunk, c
 				version, WORLD_FILE_VERSION);
 		return false;
 	}
-	const int sizeLimit = chunk->dataSizeInBytes();
+	const int sizeLimit = (int)linearSizeInBytes(chunk);
 	if (len != sizeLimit) {
 		Log::error("extracted memory would not fit the target chunk (%i bytes vs %i chunk size)", len, sizeLimit);
 		return false;
@@ -64,11 +92,30 @@ bool ChunkPersister::loadCompressed(const voxel::PagedVolume::ChunkPtr& chunk, c
 	const size_t remaining = fileLen - headerSize;
 
 	// TODO: doesn't work on big endian
-	uint8_t *targetBuf = (uint8_t*)chunk->data();
-	if (!core::zip::uncompress(buf, remaining, targetBuf, sizeLimit)) {
+	const voxel::VoxelLayout& layout = chunk->layout();
+	if (layout.layout() == voxel::MemoryLayout::Linear) {
+		uint8_t *targetBuf = (uint8_t*)chunk->data();
+		if (!core::zip::uncompress(buf, remaining, targetBuf, sizeLimit)) {
+			Log::error("Failed to uncompress the world data with len %i", len);
+			return false;
+		}
+		return true;
+	}
+	std::vector<voxel::Voxel> linearBuf(sizeLimit / sizeof(voxel::Voxel));
+	if (!core::zip::uncompress(buf, remaining, (uint8_t*)linearBuf.data(), sizeLimit)) {
 		Log::error("Failed to uncompress the world data with len %i", len);
 		return false;
 	}
+	const int32_t sideLength = chunk->sideLength();
+	voxel::Voxel* targetBuf = chunk->data();
+	const voxel::Voxel* source = linearBuf.data();
+	for (int32_t z = 0; z < sideLength; ++z) {
+		for (int32_t y = 0; y < sideLength; ++y) {
+			for (int32_t x = 0; x < sideLength; ++x) {
+				targetBuf[layout.index(x, y, z)] = *source++;
+			}
+		}
+	}
 	return true;
 }
 
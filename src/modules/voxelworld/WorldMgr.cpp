@@ -51,8 +51,8 @@ voxel::PagedVolume::Sampler WorldMgr::sampler() {
 	return voxel::PagedVolume::Sampler(_volumeData);
 }
 
-bool WorldMgr::init(uint32_t volumeMemoryMegaBytes, uint16_t chunkSideLength) {
-	_volumeData = new voxel::PagedVolume(_pager.get(), volumeMemoryMegaBytes * 1024 * 1024, chunkSideLength);
+bool WorldMgr::init(uint32_t volumeMemoryMegaBytes, uint16_t chunkSideLength, uint32_t compressedMemoryMegaBytes) {
+	_volumeData = new voxel::PagedVolume(_pager.get(), volumeMemoryMegaBytes * 1024 * 1024, chunkSideLength, compressedMemoryMegaBytes * 1024 * 1024);
 	return true;
 }
 
@@ -47,7 +47,12 @@ public:
 	 */
 	voxelutil::FloorTraceResult findWalkableFloor(const glm::ivec3& position, int maxDistanceUpwards = voxel::MAX_HEIGHT) const;
 
-	bool init(uint32_t volumeMemoryMegaBytes = 1024, uint16_t chunkSideLength = 256);
+	/**
+	 * @param volumeMemoryMegaBytes The memory budget for the uncompressed chunks
+	 * @param chunkSideLength The side length of the chunks of the volume
+	 * @param compressedMemoryMegaBytes The memory budget for evicted chunks that are kept in a compressed form
+	 */
+	bool init(uint32_t volumeMemoryMegaBytes = 1024, uint16_t chunkSideLength = 256, uint32_t compressedMemoryMegaBytes = 256);
 	void shutdown();
 	void reset();
 
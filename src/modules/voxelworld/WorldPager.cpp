@@ -6,10 +6,13 @@
 #include "core/ArrayLength.h"
 #include "voxel/PagedVolumeWrapper.h"
 #include "voxelutil/Raycast.h"
-#include "noise/Simplex.h"
+#include "noise/BatchNoise.h"
 #include "core/Common.h"
 #include "core/StringUtil.h"
 #include "core/collection/Array.h"
+#include "core/concurrent/Atomic.h"
+#include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
 
 namespace voxelworld {
 
@@ -33,8 +36,10 @@ bool WorldPager::pageIn(voxel::PagedVolume::PagerContext& pctx) {
 	//if (pctx.region.getLowerX() == 0 && pctx.region.getLowerZ() == 0) {
 	core_trace_scoped(CreateWorld);
 	math::Random random(_seed);
-	createWorld(wrapper);
-	placeTrees(pctx);
+	// the column buffers are reused for all the chunks that are generated by this thread
+	thread_local ChunkColumns columns;
+	createWorld(wrapper, columns);
+	placeTrees(pctx, columns);
 	_chunkPersister->save(pctx.chunk, _seed);
 	//}
 	return true;
@@ -46,10 +51,12 @@ void WorldPager::pageOut(voxel::PagedVolume::Chunk* chunk) {
 
 void WorldPager::setSeed(unsigned int seed) {
 	_seed = seed;
+	clearTreeRegions();
 }
 
 void WorldPager::setNoiseOffset(const glm::vec2& noiseOffset) {
 	_noiseSeedOffset = noiseOffset;
+	clearTreeRegions();
 }
 
 bool WorldPager::init(voxel::PagedVolume *volumeData, const core::String& worldParamsLua, const core::String& biomesLua) {
@@ -66,6 +73,8 @@ bool WorldPager::init(voxel::PagedVolume *volumeData, const core::String& worldP
 	if (!_volumeCache.init()) {
 		return false;
 	}
+	_threadPool.init();
+	clearTreeRegions();
 	_volumeData = volumeData;
 	return _volumeData != nullptr;
 }
@@ -74,70 +83,212 @@ void WorldPager::shutdown() {
 	if (_volumeData != nullptr) {
 		_volumeData->flushAll();
 	}
+	_threadPool.shutdown();
 	_noise.shutdown();
 	_volumeCache.shutdown();
 	_volumeData = nullptr;
 	_biomeManager.shutdown();
 	_worldCtx = WorldContext();
+	clearTreeRegions();
+}
+
+void WorldPager::ChunkColumns::init(const voxel::Region& chunkRegion) {
+	region = chunkRegion;
+	core_assert(region.getWidthInVoxels() % ColumnSize == 0);
+	core_assert(region.getDepthInVoxels() % ColumnSize == 0);
+	columnsX = region.getWidthInVoxels() / ColumnSize;
+	columnsZ = region.getDepthInVoxels() / ColumnSize;
+	// there are no voxels above the max terrain height
+	height = core_max(0, core_min(region.getHeightInVoxels(), voxel::MAX_TERRAIN_HEIGHT - region.getLowerY()));
+	const size_t columns = (size_t)columnsX * columnsZ;
+	voxels.resize(columns * height);
+	amounts.resize(columns);
+	terrainHeights.resize(columns);
+}
+
+int WorldPager::ChunkColumns::terrainHeight(int x, int z) const {
+	if (x < region.getLowerX() || x > region.getUpperX() || z < region.getLowerZ() || z > region.getUpperZ()) {
+		return -1;
+	}
+	const int cx = (x - region.getLowerX()) / ColumnSize;
+	const int cz = (z - region.getLowerZ()) / ColumnSize;
+	return terrainHeights[(size_t)cz * columnsX + cx];
 }
 
 // use a 2d noise to switch between different noises - to generate steep mountains
-void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume) const {
+void WorldPager::createWorld(voxel::PagedVolumeWrapper& volume, ChunkColumns& columns) {
 	core_trace_scoped(WorldGeneration);
 	const voxel::Region& region = volume.region();
 	Log::debug("Create new chunk at %i:%i:%i", region.getLowerX(), region.getLowerY(), region.getLowerZ());
-	const int width = region.getWidthInVoxels();
-	const int depth = region.getDepthInVoxels();
-	const int lowerX = region.getLowerX();
-	const int minsY = region.getLowerY();
-	const int lowerZ = region.getLowerZ();
 	core_assert(region.getLowerY() >= 0);
+	columns.init(region);
 
-	// TODO: store voxel data in local buffer and transfer in one step into the volume to reduce locking
-	const int size = 2;
-	core_assert(depth % size == 0);
-	core_assert(width % size == 0);
-	for (int z = lowerZ; z < lowerZ + depth; z += size) {
-		for (int x = lowerX; x < lowerX + width; x += size) {
-			voxel::Voxel voxels[voxel::MAX_TERRAIN_HEIGHT];
-			const int ni = fillVoxels(x, minsY, z, voxels);
-			volume.setVoxels(x, minsY, z, size, size, voxels, ni);
+	constexpr int tileColumns = TileSize / ColumnSize;
+	const int tilesX = (columns.columnsX + tileColumns - 1) / tileColumns;
+	const int tilesZ = (columns.columnsZ + tileColumns - 1) / tileColumns;
+	const int tiles = tilesX * tilesZ;
+	core::AtomicInt nextTile(0);
+	auto generateTiles = [&] () {
+		for (;;) {
+			const int tile = nextTile.increment(1);
+			if (tile >= tiles) {
+				break;
+			}
+			generateTile(columns, tile % tilesX, tile / tilesX);
+		}
+	};
+	// the calling thread generates tiles, too - helpers that are started after all
+	// tiles were taken just return
+	std::vector<std::future<void>> helpers;
+	const int helperCount = core_min((int)_threadPool.size(), tiles - 1);
+	helpers.reserve(helperCount);
+	for (int i = 0; i < helperCount; ++i) {
+		helpers.emplace_back(_threadPool.enqueue(generateTiles));
+	}
+	generateTiles();
+	for (std::future<void>& helper : helpers) {
+		if (helper.valid()) {
+			helper.wait();
+		}
+	}
+
+	// the voxels are transferred by this thread only - the chunk data is allocated with the first write
+	core_trace_scoped(TransferColumns);
+	for (int cz = 0; cz < columns.columnsZ; ++cz) {
+		for (int cx = 0; cx < columns.columnsX; ++cx) {
+			const size_t i = (size_t)cz * columns.columnsX + cx;
+			const int amount = columns.amounts[i];
+			if (amount <= 0) {
+				continue;
+			}
+			const int x = region.getLowerX() + cx * ColumnSize;
+			const int z = region.getLowerZ() + cz * ColumnSize;
+			volume.setVoxels(x, region.getLowerY(), z, ColumnSize, ColumnSize, columns.voxels.data() + i * columns.height, amount);
+		}
+	}
+}
+
+void WorldPager::generateTile(ChunkColumns& columns, int tileX, int tileZ) const {
+	core_trace_scoped(GenerateTile);
+	constexpr int tileColumns = TileSize / ColumnSize;
+	const int startX = tileX * tileColumns;
+	const int startZ = tileZ * tileColumns;
+	const int endX = core_min(startX + tileColumns, columns.columnsX);
+	const int endZ = core_min(startZ + tileColumns, columns.columnsZ);
+	const voxel::Region& region = columns.region;
+
+	// the noise values and the climate of all columns of the tile are evaluated in one batch
+	constexpr int maxColumns = tileColumns * tileColumns;
+	int xs[maxColumns];
+	int zs[maxColumns];
+	float xsf[maxColumns];
+	float zsf[maxColumns];
+	float noiseValues[maxColumns];
+	float humidity[maxColumns];
+	float temperature[maxColumns];
+	int amount = 0;
+	for (int cz = startZ; cz < endZ; ++cz) {
+		for (int cx = startX; cx < endX; ++cx, ++amount) {
+			xs[amount] = region.getLowerX() + cx * ColumnSize;
+			zs[amount] = region.getLowerZ() + cz * ColumnSize;
+			xsf[amount] = (float)xs[amount];
+			zsf[amount] = (float)zs[amount];
+		}
+	}
+	getNoiseValues(xsf, zsf, noiseValues, amount);
+	BiomeManager::getClimate(xs, zs, humidity, temperature, amount);
+
+	int n = 0;
+	for (int cz = startZ; cz < endZ; ++cz) {
+		for (int cx = startX; cx < endX; ++cx, ++n) {
+			const size_t i = (size_t)cz * columns.columnsX + cx;
+			const Climate climate { noiseValues[n], humidity[n], temperature[n] };
+			columns.amounts[i] = fillVoxels(xs[n], zs[n], climate, region, columns.voxels.data() + i * columns.height, columns.terrainHeights[i]);
 		}
 	}
 }
 
 float WorldPager::getNoiseValue(float x, float z) const {
-	core_trace_scoped(NoiseValue);
-	const glm::vec2 noisePos2d(_noiseSeedOffset.x + x, _noiseSeedOffset.y + z);
-	// TODO: move the noise settings into the biome
-	const float landscapeNoise = noise::fBm(noisePos2d * _worldCtx.landscapeNoiseFrequency, _worldCtx.landscapeNoiseOctaves,
-			_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
-	const float noiseNormalized = noise::norm(landscapeNoise);
-	const float mountainNoise = noise::fBm(noisePos2d * _worldCtx.mountainNoiseFrequency, _worldCtx.mountainNoiseOctaves,
-			_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
-	const float mountainNoiseNormalized = noise::norm(mountainNoise);
-	const float mountainMultiplier = mountainNoiseNormalized * (mountainNoiseNormalized + 0.5f);
-	const float n = glm::clamp(noiseNormalized * mountainMultiplier, 0.0f, 1.0f);
+	float n;
+	getNoiseValues(&x, &z, &n, 1);
 	return n;
 }
 
+void WorldPager::getNoiseValues(const float* x, const float* z, float* values, int amount) const {
+	core_trace_scoped(NoiseValues);
+	constexpr int blockSize = 256;
+	float posX[blockSize];
+	float posZ[blockSize];
+	float landscapeNoise[blockSize];
+	float mountainNoise[blockSize];
+	for (int block = 0; block < amount; block += blockSize) {
+		const int n = core_min(blockSize, amount - block);
+		// TODO: move the noise settings into the biome
+		for (int i = 0; i < n; ++i) {
+			posX[i] = (_noiseSeedOffset.x + x[block + i]) * _worldCtx.landscapeNoiseFrequency;
+			posZ[i] = (_noiseSeedOffset.y + z[block + i]) * _worldCtx.landscapeNoiseFrequency;
+		}
+		noise::fBm(posX, posZ, landscapeNoise, n, _worldCtx.landscapeNoiseOctaves,
+				_worldCtx.landscapeNoiseLacunarity, _worldCtx.landscapeNoiseGain);
+		for (int i = 0; i < n; ++i) {
+			posX[i] = (_noiseSeedOffset.x + x[block + i]) * _worldCtx.mountainNoiseFrequency;
+			posZ[i] = (_noiseSeedOffset.y + z[block + i]) * _worldCtx.mountainNoiseFrequency;
+		}
+		noise::fBm(posX, posZ, mountainNoise, n, _worldCtx.mountainNoiseOctaves,
+				_worldCtx.mountainNoiseLacunarity, _worldCtx.mountainNoiseGain);
+		for (int i = 0; i < n; ++i) {
+			const float noiseNormalized = noise::norm(landscapeNoise[i]);
+			const float mountainNoiseNormalized = noise::norm(mountainNoise[i]);
+			const float mountainMultiplier = mountainNoiseNormalized * (mountainNoiseNormalized + 0.5f);
+			values[block + i] = glm::clamp(noiseNormalized * mountainMultiplier, 0.0f, 1.0f);
+		}
+	}
+}
+
 float WorldPager::getDensity(float x, float y, float z, float n) const {
-	core_trace_scoped(DensityValue);
-	const glm::vec3 noisePos3d(_noiseSeedOffset.x + x, y, _noiseSeedOffset.y + z);
+	float density;
+	getDensities(x, z, n, (int)y, (int)y, &density);
+	return density;
+}
+
+void WorldPager::getDensities(float x, float z, float n, int lowerY, int upperY, float* densities) const {
+	core_trace_scoped(DensityValues);
+	const int amount = upperY - lowerY + 1;
+	if (amount <= 0) {
+		return;
+	}
+	core_assert(amount <= voxel::MAX_TERRAIN_HEIGHT);
 	// TODO: move the noise settings into the biome
-	const float noiseVal = noise::norm(
-			noise::fBm(noisePos3d * _worldCtx.caveNoiseFrequency, _worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain));
-	const float finalDensity = n + noiseVal;
-	return finalDensity;
+	const float frequency = _worldCtx.caveNoiseFrequency;
+	const float posX = (_noiseSeedOffset.x + x) * frequency;
+	const float posZ = (_noiseSeedOffset.y + z) * frequency;
+	float xs[voxel::MAX_TERRAIN_HEIGHT];
+	float ys[voxel::MAX_TERRAIN_HEIGHT];
+	float zs[voxel::MAX_TERRAIN_HEIGHT];
+	for (int i = 0; i < amount; ++i) {
+		xs[i] = posX;
+		ys[i] = (float)(lowerY + i) * frequency;
+		zs[i] = posZ;
+	}
+	noise::fBm(xs, ys, zs, densities, amount, _worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain);
+	for (int i = 0; i < amount; ++i) {
+		densities[i] = n + noise::norm(densities[i]);
+	}
 }
 
-int WorldPager::terrainHeight(int x, int y, int z) const {
+int WorldPager::terrainHeight(int x, int z) const {
+	static_assert((ColumnSize & (ColumnSize - 1)) == 0, "ColumnSize must be a power of two");
+	// all voxels of a column get the values of the lower corner
+	x &= ~(ColumnSize - 1);
+	z &= ~(ColumnSize - 1);
 	const float n = getNoiseValue(x, z);
-	return terrainHeight(x, y, z, n);
+	const int surface = surfaceHeight(x, z, n);
+	float densities[voxel::MAX_TERRAIN_HEIGHT];
+	getDensities(x, z, n, 1, surface - 1, densities);
+	return carveCaves(x, z, n, surface, densities, 1);
 }
 
-int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
-	core_trace_scoped(TerrainHeight);
+int WorldPager::surfaceHeight(int x, int z, float n) const {
 	const int maxHeight = voxel::MAX_TERRAIN_HEIGHT - 1;
 	int centerHeight;
 	// the center of a city should make the terrain more even
@@ -149,8 +300,15 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 	} else {
 		ni = n * maxHeight;
 	}
-	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
+	return glm::clamp(ni, 0, maxHeight);
+}
+
+int WorldPager::carveCaves(int x, int z, float n, int surface, const float* densities, int lowerY) const {
+	core_trace_scoped(TerrainHeight);
+	int ni = surface;
+	for (int y = ni - 1; y >= 1; --y) {
+		// the densities below the generated region are only needed if everything above is a cave
+		const float density = y >= lowerY ? densities[y - lowerY] : getDensity(x, y, z, n);
 		if (density > _worldCtx.caveDensityThreshold) {
 			break;
 		}
@@ -159,11 +317,18 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 	return ni;
 }
 
-int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const {
+int WorldPager::fillVoxels(int x, int z, const Climate& climate, const voxel::Region& region, voxel::Voxel* voxels, int& terrainHeight) const {
 	core_trace_scoped(FillVoxels);
-	const float n = getNoiseValue(x, z);
-	const int ni = terrainHeight(x, minsY, z, n);
-	if (ni < minsY) {
+	const float n = climate.noise;
+	const int surface = surfaceHeight(x, z, n);
+	// the densities are evaluated once and shared by the cave carving and the voxel generation
+	const int lowerY = core_max(1, region.getLowerY());
+	float densities[voxel::MAX_TERRAIN_HEIGHT];
+	getDensities(x, z, n, lowerY, surface - 1, densities);
+	terrainHeight = carveCaves(x, z, n, surface, densities, lowerY);
+
+	const int top = core_min(core_max(terrainHeight, voxel::MAX_WATER_HEIGHT), region.getUpperY() + 1);
+	if (top <= region.getLowerY()) {
 		return 0;
 	}
 
@@ -171,38 +336,107 @@ int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const
 	const voxel::Voxel& dirt = createColorVoxel(voxel::VoxelType::Dirt, _seed);
 	static constexpr voxel::Voxel air;
 
-	voxels[0] = dirt;
 	glm::ivec3 pos(x, 0, z);
-	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
-		if (density > _worldCtx.caveDensityThreshold) {
-			const bool cave = y < ni - 1;
+	for (int y = region.getLowerY(); y < top; ++y) {
+		voxel::Voxel& voxel = voxels[y - region.getLowerY()];
+		if (y == 0) {
+			voxel = dirt;
+		} else if (y < terrainHeight && densities[y - lowerY] > _worldCtx.caveDensityThreshold) {
+			const bool cave = y < terrainHeight - 1;
 			pos.y = y;
-			const voxel::Voxel& voxel = _biomeManager.getVoxel(pos, cave);
-			voxels[y] = voxel;
+			voxel = _biomeManager.getVoxel(pos, climate.humidity, climate.temperature, cave);
+		} else if (y < voxel::MAX_WATER_HEIGHT) {
+			voxel = water;
 		} else {
-			if (y < voxel::MAX_WATER_HEIGHT) {
-				voxels[y] = water;
-			} else {
-				voxels[y] = air;
-			}
+			voxel = air;
 		}
 	}
-	for (int i = minsY; i < voxel::MAX_WATER_HEIGHT; ++i) {
-		if (voxels[i] == air) {
-			voxels[i] = water;
+	return top - region.getLowerY();
+}
+
+void WorldPager::clearTreeRegions() {
+	core::ScopedLock lock(_treeRegionLock);
+	_treeRegions.clear();
+	_treeRegionOrder.clear();
+	_treeRegionNext = 0u;
+}
+
+void WorldPager::treeRegion(const voxel::Region& region, const ChunkColumns& columns, TreeRegion& out) {
+	// the regions are full height - the lower corner is enough to identify them
+	const uint64_t key = ((uint64_t)(uint32_t)region.getLowerX() << 32) | (uint64_t)(uint32_t)region.getLowerZ();
+	{
+		core::ScopedLock lock(_treeRegionLock);
+		auto i = _treeRegions.find(key);
+		if (i != _treeRegions.end()) {
+			out = i->second;
+			return;
 		}
 	}
-	return core_max(ni - minsY, voxel::MAX_WATER_HEIGHT - minsY);
+	// another thread might place the trees of the same region at the same time - but the result is the same
+	placeTreeRegion(region, columns, out);
+
+	core::ScopedLock lock(_treeRegionLock);
+	if (!_treeRegions.emplace(key, out).second) {
+		return;
+	}
+	if (_treeRegionOrder.size() < MaxTreeRegions) {
+		_treeRegionOrder.push_back(key);
+		return;
+	}
+	_treeRegions.erase(_treeRegionOrder[_treeRegionNext]);
+	_treeRegionOrder[_treeRegionNext] = key;
+	_treeRegionNext = (_treeRegionNext + 1u) % MaxTreeRegions;
 }
 
-void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx) {
+void WorldPager::placeTreeRegion(const voxel::Region& region, const ChunkColumns& columns, TreeRegion& out) {
+	core_trace_scoped(PlaceTreeRegion);
+	out.trees.clear();
+	const std::vector<const char*>& treeTypes = _biomeManager.getTreeTypes(region);
+	out.hasTreeTypes = !treeTypes.empty();
+	if (!out.hasTreeTypes) {
+		Log::debug("No tree types given for region %s", region.toString().c_str());
+		return;
+	}
+	std::vector<glm::vec2> positions;
+	math::Random random(_seed);
+	_biomeManager.getTreePositions(region, positions, random, 0);
+	int treeTypeIndex = random.random(0, treeTypes.size() - 1);
+	const int treeTypeSize = (int)treeTypes.size();
+	const math::Axis axes[] = {math::Axis::None, math::Axis::Y, math::Axis::Y, math::Axis::None, math::Axis::Y};
+	constexpr size_t axesSize = lengthof(axes);
+	int positionIndex = 0;
+	out.trees.reserve(positions.size());
+	for (const glm::vec2& position : positions) {
+		++positionIndex;
+		glm::ivec3 treePos(position.x, 0, position.y);
+		// the trees of the neighbours need the terrain height outside of the generated columns
+		treePos.y = columns.terrainHeight(treePos.x, treePos.z);
+		if (treePos.y < 0) {
+			treePos.y = terrainHeight(treePos.x, treePos.z);
+		}
+		if (treePos.y <= voxel::MAX_WATER_HEIGHT) {
+			continue;
+		}
+		const char *treeType = treeTypes[treeTypeIndex++];
+		treeTypeIndex %= treeTypeSize;
+		const voxel::RawVolume* v = _volumeCache.loadTree(treePos, treeType);
+		if (v == nullptr) {
+			continue;
+		}
+		out.trees.push_back({treePos, v, axes[positionIndex % axesSize]});
+	}
+}
+
+void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx, const ChunkColumns& columns) {
+	core_trace_scoped(PlaceTrees);
 	// expand region to all surrounding regions by half of the region size.
 	// we do this to be able to limit the generation on the current chunk. Otherwise
 	// we would endlessly generate new chunks just because the trees overlap to
 	// another chunk.
-	const glm::ivec3& mins = pagerCtx.region.getLowerCorner();
-	const glm::ivec3& maxs = pagerCtx.region.getUpperCorner();
+	// the trees are distributed in full height regions - all chunks of a column get the same trees
+	// and only the parts that are inside of the chunk are added.
+	const glm::ivec3 mins(pagerCtx.region.getLowerX(), 0, pagerCtx.region.getLowerZ());
+	const glm::ivec3 maxs(pagerCtx.region.getUpperX(), voxel::MAX_HEIGHT, pagerCtx.region.getUpperZ());
 	const glm::ivec3& dim = pagerCtx.region.getDimensionsInVoxels();
 	const voxel::Region regions[] = {
 		// left neighbors
@@ -222,67 +456,41 @@ void WorldPager::placeTrees(voxel::PagedVolume::PagerContext& pagerCtx) {
 		// own chunk region
 		voxel::Region(mins, maxs)
 	};
-	// the assumption here is that we get a full height paging request, otherwise we
-	// would have to loop over more regions.
-	core_assert(pagerCtx.region.getLowerY() == 0);
-	core_assert(pagerCtx.region.getUpperY() == voxel::MAX_HEIGHT);
-	voxel::PagedVolumeWrapper chunkWrapper(_volumeData, pagerCtx.chunk, pagerCtx.region);
-
-	const size_t regionsSize = lengthof(regions);
-
-	for (size_t i = 0; i < regionsSize; ++i) {
-		const voxel::Region& region = regions[i];
-		const std::vector<const char*>& treeTypes = _biomeManager.getTreeTypes(region);
-		if (treeTypes.empty()) {
-			Log::debug("No tree types given for region %s", region.toString().c_str());
+
+	// the placements are reused for all the chunks that are generated by this thread
+	thread_local TreeRegion trees;
+	for (const voxel::Region& region : regions) {
+		treeRegion(region, columns, trees);
+		if (!trees.hasTreeTypes) {
 			return;
 		}
-		std::vector<glm::vec2> positions;
-		math::Random random(_seed);
-		_biomeManager.getTreePositions(region, positions, random, 0);
-		int treeTypeIndex = random.random(0, treeTypes.size() - 1);
-		const int treeTypeSize = (int)treeTypes.size();
-		const math::Axis axes[] = {math::Axis::None, math::Axis::Y, math::Axis::Y, math::Axis::None, math::Axis::Y};
-		constexpr size_t axesSize = lengthof(axes);
-		int positionIndex = 0;
-		for (const glm::vec2& position : positions) {
-			++positionIndex;
-			glm::ivec3 treePos(position.x, 0, position.y);
-			treePos.y = terrainHeight(position.x, pagerCtx.region.getLowerY(), position.y);
-			if (treePos.y <= voxel::MAX_WATER_HEIGHT) {
-				continue;
-			}
-			const char *treeType = treeTypes[treeTypeIndex++];
-			treeTypeIndex %= treeTypeSize;
-			const voxel::RawVolume* v = _volumeCache.loadTree(treePos, treeType);
-			if (v == nullptr) {
-				continue;
-			}
-			const voxelutil::RawVolumeRotateWrapper rotateWrapper(v, axes[positionIndex % axesSize]);
-			addVolumeToPosition(chunkWrapper, rotateWrapper, treePos);
+		for (const TreePlacement& tree : trees.trees) {
+			const voxelutil::RawVolumeRotateWrapper rotateWrapper(tree.volume, tree.axis);
+			addVolumeToPosition(pagerCtx, rotateWrapper, tree.pos);
 		}
 	}
 }
 
-void WorldPager::addVolumeToPosition(voxel::PagedVolumeWrapper& target, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos) {
+void WorldPager::addVolumeToPosition(voxel::PagedVolume::PagerContext& pagerCtx, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos) {
 	const voxel::Region& region = source.region();
-	const glm::ivec3& mins = region.getLowerCorner();
-	const glm::ivec3& maxs = region.getUpperCorner();
-	const voxel::Region& targetRegion = target.region();
+	const voxel::Region& targetRegion = pagerCtx.region;
+	// clip the tree volume to the chunk once - every voxel of the remaining box is inside of the chunk
+	const glm::ivec3& targetMins = targetRegion.getLowerCorner();
+	const glm::ivec3& mins = glm::max(region.getLowerCorner(), targetMins - pos);
+	const glm::ivec3& maxs = glm::min(region.getUpperCorner(), targetRegion.getUpperCorner() - pos);
+	if (glm::any(glm::greaterThan(mins, maxs))) {
+		return;
+	}
+	const glm::ivec3 offset = pos - targetMins;
+	const voxel::PagedVolume::ChunkPtr& chunk = pagerCtx.chunk;
 	for (int x = mins.x; x <= maxs.x; ++x) {
-		const int nx = pos.x + x;
-		for (int y = mins.y; y <= maxs.y; ++y) {
-			const int ny = pos.y + y;
-			for (int z = mins.z; z <= maxs.z; ++z) {
-				const int nz = pos.z + z;
-				if (!targetRegion.containsPoint(nx, ny, nz)) {
-					continue;
-				}
+		for (int z = mins.z; z <= maxs.z; ++z) {
+			for (int y = mins.y; y <= maxs.y; ++y) {
 				const voxel::Voxel& voxel = source.voxel(x, y, z);
 				if (voxel::isAir(voxel.getMaterial())) {
 					continue;
 				}
-				target.setVoxel(nx, ny, nz, voxel);
+				chunk->setVoxel(offset.x + x, offset.y + y, offset.z + z, voxel);
 			}
 		}
 	}
@@ -15,6 +15,11 @@
 #include "ChunkPersister.h"
 #include "TreeVolumeCache.h"
 #include "voxelutil/RawVolumeRotateWrapper.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/Lock.h"
+#include <unordered_map>
+#include <vector>
 
 namespace voxel {
 class PagedVolumeWrapper;
@@ -32,7 +37,7 @@ namespace voxelworld {
 class WorldPager: public voxel::PagedVolume::Pager {
 private:
 	unsigned int _seed = 0l;
-	glm::vec2 _noiseSeedOffset;
+	glm::vec2 _noiseSeedOffset { 0.0f };
 
 	voxel::PagedVolume *_volumeData = nullptr;
 	BiomeManager _biomeManager;
@@ -41,19 +46,123 @@ private:
 	TreeVolumeCache _volumeCache;
 	ChunkPersisterPtr _chunkPersister;
 
-	void createWorld(voxel::PagedVolumeWrapper& volume) const;
-	void placeTrees(voxel::PagedVolume::PagerContext& pagerCtx);
-	void addVolumeToPosition(voxel::PagedVolumeWrapper& target, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos);
+	// all voxels of a column of this size have the same value
+	static constexpr int ColumnSize = 2;
+	// the chunks are generated in tiles of this size - one tile is generated by one thread
+	static constexpr int TileSize = 32;
+	core::ThreadPool _threadPool { core::halfcpus(), "WorldPager" };
 
-	int terrainHeight(int x, int minsY, int z) const;
-	int terrainHeight(int x, int minsY, int z, float n) const;
-	int fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const;
+	/**
+	 * @brief The generated columns of a chunk. The 2d noise and the terrain height is only evaluated
+	 * once per column and shared by the voxel generation and the tree placement.
+	 */
+	struct ChunkColumns {
+		voxel::Region region;
+		int columnsX = 0;
+		int columnsZ = 0;
+		int height = 0;
+		// height voxels per column
+		std::vector<voxel::Voxel> voxels;
+		// the amount of voxels to write into the chunk per column
+		std::vector<int> amounts;
+		std::vector<int> terrainHeights;
+
+		void init(const voxel::Region& chunkRegion);
+		/**
+		 * @return The terrain height at the given world position or @c -1 if the position isn't part of the chunk
+		 */
+		int terrainHeight(int x, int z) const;
+	};
+
+	void createWorld(voxel::PagedVolumeWrapper& volume, ChunkColumns& columns);
+	void generateTile(ChunkColumns& columns, int tileX, int tileZ) const;
+	/**
+	 * @brief A tree of a region - the placement only depends on the seed and the region
+	 */
+	struct TreePlacement {
+		// the position of the tree on the terrain
+		glm::ivec3 pos;
+		// the volume of the tree type - see TreeVolumeCache::loadTree()
+		const voxel::RawVolume* volume;
+		math::Axis axis;
+	};
+	/**
+	 * @brief The trees of a full height region. The trees are placed once per region and shared by all
+	 * the chunks of the column and the chunks of the neighbouring columns.
+	 */
+	struct TreeRegion {
+		// no tree types means that the tree placement of the chunk stops at this region
+		bool hasTreeTypes = false;
+		std::vector<TreePlacement> trees;
+	};
+	// the amount of regions that are kept - the oldest ones are evicted first
+	static constexpr size_t MaxTreeRegions = 4096;
+	core_trace_mutex(core::Lock, _treeRegionLock, "WorldPagerTreeRegions");
+	std::unordered_map<uint64_t, TreeRegion> _treeRegions;
+	// the keys of the regions in insertion order - this is a ring buffer of MaxTreeRegions entries
+	std::vector<uint64_t> _treeRegionOrder;
+	size_t _treeRegionNext = 0u;
+
+	/**
+	 * @brief Looks up the cached tree placement of the given region or computes it
+	 */
+	void treeRegion(const voxel::Region& region, const ChunkColumns& columns, TreeRegion& out);
+	void placeTreeRegion(const voxel::Region& region, const ChunkColumns& columns, TreeRegion& out);
+	/**
+	 * @brief Removes all the cached tree placements - needed whenever the terrain changes (e.g. a new seed)
+	 */
+	void clearTreeRegions();
+	void placeTrees(voxel::PagedVolume::PagerContext& pagerCtx, const ChunkColumns& columns);
+	/**
+	 * @brief Writes the non-air voxels of the given volume that are inside of the chunk into the chunk
+	 */
+	void addVolumeToPosition(voxel::PagedVolume::PagerContext& pagerCtx, const voxelutil::RawVolumeRotateWrapper& source, const glm::ivec3& pos);
+
+	/**
+	 * @brief The terrain height of the column that contains the given position
+	 */
+	int terrainHeight(int x, int z) const;
+	/**
+	 * @brief The terrain height without caves
+	 */
+	int surfaceHeight(int x, int z, float n) const;
+	/**
+	 * @param[in] densities The cave densities of the column starting at @c lowerY
+	 * @return The terrain height - the first position from the surface height on downwards that isn't a cave
+	 */
+	int carveCaves(int x, int z, float n, int surface, const float* densities, int lowerY) const;
+	/**
+	 * @brief The per column values that are evaluated in batches for all columns of a tile
+	 */
+	struct Climate {
+		// see getNoiseValue()
+		float noise;
+		// see BiomeManager::getHumidity()
+		float humidity;
+		// see BiomeManager::getTemperature()
+		float temperature;
+	};
+	/**
+	 * @brief Generates the voxels of the column for the y range of the given region
+	 * @param[out] terrainHeight The terrain height of the column
+	 * @return The amount of voxels that should be written into the chunk
+	 */
+	int fillVoxels(int x, int z, const Climate& climate, const voxel::Region& region, voxel::Voxel* voxels, int& terrainHeight) const;
 
 	/**
 	 * @return A float value between [0.0-1.0]
 	 */
 	float getNoiseValue(float x, float z) const;
+	/**
+	 * @brief Evaluates the noise values for @c amount positions in one batch
+	 * @note The values are the same as the ones that are returned by @c getNoiseValue()
+	 */
+	void getNoiseValues(const float* x, const float* z, float* values, int amount) const;
 	float getDensity(float x, float y, float z, float n) const;
+	/**
+	 * @brief Evaluates the cave densities of the column for the given y range in one batch
+	 */
+	void getDensities(float x, float z, float n, int lowerY, int upperY, float* densities) const;
 
 public:
 	WorldPager(const voxelformat::VolumeCachePtr& volumeCache, const ChunkPersisterPtr& chunkPersister);
@@ -25,6 +25,21 @@ public:
 		_volumeCache = std::make_shared<voxelformat::VolumeCache>();
 		return _volumeCache->init();
 	}
+
+	/**
+	 * @brief Reports the memory that is needed for the chunks in memory compared to fully allocated chunks
+	 */
+	static void memoryCounters(benchmark::State& state, const voxel::PagedVolume& volume) {
+		const voxel::PagedVolume::Statistics& stats = volume.statistics();
+		const double mb = 1024.0 * 1024.0;
+		const double allocated = (double)stats.uncompressedBytes / mb;
+		const double chunkSize = volume.chunkSideLength();
+		const double full = (double)volume.chunkCount() * chunkSize * chunkSize * chunkSize * sizeof(voxel::Voxel) / mb;
+		state.counters["chunks"] = (double)volume.chunkCount();
+		state.counters["uniformChunks"] = (double)stats.uniformChunks;
+		state.counters["allocatedMB"] = allocated;
+		state.counters["savedMB"] = full - allocated;
+	}
 };
 
 BENCHMARK_DEFINE_F(PagedVolumeBenchmark, pageIn) (benchmark::State& state) {
@@ -41,8 +56,101 @@ BENCHMARK_DEFINE_F(PagedVolumeBenchmark, pageIn) (benchmark::State& state) {
 		volumeData.voxel(chunkSize * i, 0, 0);
 		++i;
 	}
+	memoryCounters(state, volumeData);
+}
+
+/**
+ * @brief Pages in whole columns of the world - most of the chunks above the terrain are air and don't need any voxel data
+ */
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, pageInColumns) (benchmark::State& state) {
+	voxelworld::WorldPager pager(_volumeCache, std::make_shared<voxelworld::ChunkPersister>());
+	pager.setSeed(0l);
+	const int chunkSize = (int)state.range(0);
+	voxel::PagedVolume volumeData(&pager, 1024 * 1024 * 1024, chunkSize);
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	const core::String& luaParameters = filesystem->load("worldparams.lua");
+	const core::String& luaBiomes = filesystem->load("biomes.lua");
+	pager.init(&volumeData, luaParameters, luaBiomes);
+	int i = 0;
+	while (state.KeepRunning()) {
+		for (int y = 0; y <= voxel::MAX_HEIGHT; y += chunkSize) {
+			volumeData.voxel(chunkSize * i, y, 0);
+		}
+		++i;
+	}
+	memoryCounters(state, volumeData);
+}
+
+/**
+ * @brief Generates whole columns of the world - the chunks counter is the amount of generated chunks per second
+ */
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, generateChunks) (benchmark::State& state) {
+	voxelworld::WorldPager pager(_volumeCache, std::make_shared<voxelworld::ChunkPersister>());
+	pager.setSeed(0l);
+	const int chunkSize = (int)state.range(0);
+	voxel::PagedVolume volumeData(&pager, 1024 * 1024 * 1024, chunkSize);
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	const core::String& luaParameters = filesystem->load("worldparams.lua");
+	const core::String& luaBiomes = filesystem->load("biomes.lua");
+	pager.init(&volumeData, luaParameters, luaBiomes);
+	int i = 0;
+	int chunks = 0;
+	for (auto _ : state) {
+		for (int y = 0; y <= voxel::MAX_HEIGHT; y += chunkSize) {
+			volumeData.voxel(chunkSize * i, y, 0);
+			++chunks;
+		}
+		++i;
+	}
+	state.counters["chunks"] = benchmark::Counter((double)chunks, benchmark::Counter::kIsRate);
+	state.SetItemsProcessed((int64_t)chunks * chunkSize * chunkSize * chunkSize);
+}
+
+/**
+ * @brief Resolves the biome for every voxel of a 64x64 area - the argument defines whether the humidity and
+ * temperature are evaluated per column in one batch (like the world pager does) or per lookup
+ */
+BENCHMARK_DEFINE_F(PagedVolumeBenchmark, biomeLookup) (benchmark::State& state) {
+	voxelworld::BiomeManager biomeManager;
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	biomeManager.init(filesystem->load("biomes.lua"));
+	const bool batched = state.range(0) != 0;
+	constexpr int size = 64;
+	int xs[size * size];
+	int zs[size * size];
+	float humidity[size * size];
+	float temperature[size * size];
+	int offset = 0;
+	int64_t lookups = 0;
+	for (auto _ : state) {
+		for (int i = 0; i < size * size; ++i) {
+			xs[i] = offset + i % size;
+			zs[i] = i / size;
+		}
+		if (batched) {
+			voxelworld::BiomeManager::getClimate(xs, zs, humidity, temperature, size * size);
+		}
+		for (int i = 0; i < size * size; ++i) {
+			for (int y = 0; y < voxel::MAX_TERRAIN_HEIGHT; ++y) {
+				const glm::ivec3 pos(xs[i], y, zs[i]);
+				const voxelworld::Biome* biome;
+				if (batched) {
+					biome = biomeManager.getBiome(pos, humidity[i], temperature[i], y < 40);
+				} else {
+					biome = biomeManager.getBiome(pos, y < 40);
+				}
+				benchmark::DoNotOptimize(biome);
+			}
+		}
+		lookups += size * size * voxel::MAX_TERRAIN_HEIGHT;
+		offset += size;
+	}
+	state.SetItemsProcessed(lookups);
 }
 
 BENCHMARK_REGISTER_F(PagedVolumeBenchmark, pageIn);
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, pageInColumns)->Arg(32)->Arg(64);
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, generateChunks)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(PagedVolumeBenchmark, biomeLookup)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
 
 BENCHMARK_MAIN();
@@ -5,10 +5,34 @@
 #include "AbstractVoxelTest.h"
 #include "voxelworld/BiomeManager.h"
 #include "io/Filesystem.h"
+#include "core/ArrayLength.h"
+#include <limits>
+#include <vector>
 
 namespace voxelworld {
 
 class BiomeManagerTest: public AbstractVoxelTest {
+protected:
+	/**
+	 * @brief Reference implementation - scans all biomes for the closest humidity and temperature
+	 */
+	static const Biome* linearScan(const std::vector<const Biome*>& biomes, const Biome* defaultBiome, int y, float humidity, float temperature, bool underground) {
+		const Biome* best = defaultBiome;
+		float distMin = (std::numeric_limits<float>::max)();
+		for (const Biome* biome : biomes) {
+			if (y > biome->yMax || y < biome->yMin || biome->underground != underground) {
+				continue;
+			}
+			const float dTemperature = temperature - biome->temperature;
+			const float dHumidity = humidity - biome->humidity;
+			const float dist = (dTemperature * dTemperature) + (dHumidity * dHumidity);
+			if (dist < distMin) {
+				best = biome;
+				distMin = dist;
+			}
+		}
+		return best;
+	}
 };
 
 TEST_F(BiomeManagerTest, testInvalid) {
@@ -96,4 +120,87 @@ TEST_F(BiomeManagerTest, testCityGradient) {
 		<< "Out of the radius of the city - here we should not have any influence on the height anymore";
 }
 
+TEST_F(BiomeManagerTest, testBiomeLookupMatchesLinearScan) {
+	BiomeManager mgr;
+	mgr.init("");
+	std::vector<const Biome*> biomes;
+	const Biome* defaultBiome = mgr.getBiome(glm::ivec3(0, -1000, 0), 0.5f, 0.5f);
+	biomes.push_back(mgr.addBiome(0, 40, 0.1f, 0.9f, voxel::VoxelType::Sand, false, 90));
+	biomes.push_back(mgr.addBiome(0, 60, 0.5f, 0.5f, voxel::VoxelType::Grass, false, 90));
+	biomes.push_back(mgr.addBiome(20, 80, 0.8f, 0.3f, voxel::VoxelType::Dirt, false, 90));
+	biomes.push_back(mgr.addBiome(50, 100, 0.4f, 0.45f, voxel::VoxelType::Rock, false, 90));
+	biomes.push_back(mgr.addBiome(0, 60, 0.5f, 0.5f, voxel::VoxelType::Wood, false, 90));
+	biomes.push_back(mgr.addBiome(0, 100, 0.3f, 0.6f, voxel::VoxelType::Rock, true, 90));
+	biomes.push_back(mgr.addBiome(30, 60, 0.7f, 0.7f, voxel::VoxelType::Dirt, true, 90));
+	for (const Biome* biome : biomes) {
+		ASSERT_NE(nullptr, biome);
+	}
+
+	const int steps = 97;
+	for (int y = -2; y <= 102; y += 3) {
+		for (int underground = 0; underground < 2; ++underground) {
+			for (int t = 0; t <= steps; ++t) {
+				for (int h = 0; h <= steps; ++h) {
+					const float humidity = (float)h / (float)steps;
+					const float temperature = (float)t / (float)steps;
+					const Biome* expected = linearScan(biomes, defaultBiome, y, humidity, temperature, underground != 0);
+					ASSERT_EQ(expected, mgr.getBiome(glm::ivec3(0, y, 0), humidity, temperature, underground != 0))
+						<< "y: " << y << ", humidity: " << humidity << ", temperature: " << temperature << ", underground: " << underground;
+				}
+			}
+		}
+	}
+	// values outside of the noise range are still resolved
+	EXPECT_EQ(biomes[3], mgr.getBiome(glm::ivec3(0, 70, 0), -1.0f, 2.0f));
+}
+
+TEST_F(BiomeManagerTest, testClimateBatch) {
+	const int xs[] = { -5000, -1, 0, 17, 3001, 123456 };
+	const int zs[] = { 42, -7, 0, 99999, -3001, 3 };
+	const int amount = (int)lengthof(xs);
+	float humidity[amount];
+	float temperature[amount];
+	BiomeManager::getClimate(xs, zs, humidity, temperature, amount);
+	for (int i = 0; i < amount; ++i) {
+		EXPECT_EQ(BiomeManager::getHumidity(xs[i], zs[i]), humidity[i]);
+		EXPECT_EQ(BiomeManager::getTemperature(xs[i], zs[i]), temperature[i]);
+	}
+}
+
+TEST_F(BiomeManagerTest, testZoneGrid) {
+	BiomeManager mgr;
+	mgr.init("");
+	struct ZoneDef {
+		glm::ivec3 pos;
+		float radius;
+	};
+	const ZoneDef defs[] = { { glm::ivec3(0, 0, 0), 500.0f }, { glm::ivec3(-300, 10, 700), 200.0f },
+		{ glm::ivec3(-2000, 0, -1500), 50.5f }, { glm::ivec3(255, 0, 256), 1.0f } };
+	for (const ZoneDef& def : defs) {
+		mgr.addZone(def.pos, def.radius, ZoneType::City);
+	}
+	for (int z = -2200; z <= 1200; z += 7) {
+		for (int x = -2200; x <= 1200; x += 7) {
+			int expected = -1;
+			for (int i = 0; i < (int)lengthof(defs); ++i) {
+				const glm::vec2 d(x - defs[i].pos.x, z - defs[i].pos.z);
+				if (glm::dot(d, d) < defs[i].radius * defs[i].radius) {
+					expected = i;
+					break;
+				}
+			}
+			const Zone* zone = mgr.getZone(glm::ivec2(x, z), ZoneType::City);
+			if (expected == -1) {
+				ASSERT_EQ(nullptr, zone) << x << ":" << z;
+			} else {
+				ASSERT_NE(nullptr, zone) << x << ":" << z;
+				ASSERT_EQ(defs[expected].pos, zone->pos()) << x << ":" << z;
+			}
+		}
+	}
+	EXPECT_NE(nullptr, mgr.getZone(glm::ivec2(255, 256), ZoneType::City));
+	EXPECT_TRUE(mgr.hasCity(glm::ivec3(-2000, 0, -1450)));
+	EXPECT_FALSE(mgr.hasCity(glm::ivec3(-2000, 60, -1450)));
+}
+
 }
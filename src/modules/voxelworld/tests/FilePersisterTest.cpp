@@ -5,6 +5,7 @@
 #include "voxelworld/FilePersister.h"
 
 #include "AbstractVoxelTest.h"
+#include "core/ByteStream.h"
 
 namespace voxelworld {
 
@@ -19,4 +20,30 @@ TEST_F(WorldPersisterTest, testSaveLoad) {
 	ASSERT_EQ(voxel::VoxelType::Grass, _volData.voxel(32, 32, 32).getMaterial());
 }
 
+TEST_F(WorldPersisterTest, testSaveLoadIsIndependentOfTheMemoryLayout) {
+	const uint16_t sideLength = 16;
+	const glm::ivec3 pos(0);
+	voxel::PagedVolume::ChunkPtr morton = core::make_shared<voxel::PagedVolume::Chunk>(pos, sideLength, &_pager, voxel::MemoryLayout::Morton);
+	for (int32_t z = 0; z < sideLength; ++z) {
+		for (int32_t y = 0; y < sideLength; ++y) {
+			for (int32_t x = 0; x < sideLength; ++x) {
+				morton->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, (x + y * 3 + z * 7) % 256));
+			}
+		}
+	}
+	ChunkPersister persister;
+	core::ByteStream stream;
+	ASSERT_TRUE(persister.saveCompressed(morton, stream));
+
+	voxel::PagedVolume::ChunkPtr linear = core::make_shared<voxel::PagedVolume::Chunk>(pos, sideLength, &_pager, voxel::MemoryLayout::Linear);
+	ASSERT_TRUE(persister.loadCompressed(linear, stream.getBuffer(), stream.getSize()));
+	for (int32_t z = 0; z < sideLength; ++z) {
+		for (int32_t y = 0; y < sideLength; ++y) {
+			for (int32_t x = 0; x < sideLength; ++x) {
+				ASSERT_EQ(morton->voxel(x, y, z).getColor(), linear->voxel(x, y, z).getColor()) << x << ":" << y << ":" << z;
+			}
+		}
+	}
+}
+
 }
@@ -0,0 +1,114 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "voxelworld/WorldPager.h"
+#include "voxelformat/VolumeCache.h"
+#include "io/Filesystem.h"
+
+namespace voxelworld {
+
+class WorldPagerTest: public AbstractVoxelTest {
+protected:
+	// no trees - the tree positions depend on the chunk size
+	const core::String _biomesLua = R"(
+		function initBiomes()
+			local biome = biomeMgr.addBiome(0, 101, 0.5, 0.5, "Grass", false, 30)
+			biomeMgr.setDefault(biome)
+			biomeMgr.addBiome(0, 99, 0.5, 0.5, "Rock", true, 30)
+		end
+		function initCities()
+		end
+	)";
+	voxelformat::VolumeCachePtr _volumeCache;
+
+	void SetUp() override {
+		AbstractVoxelTest::SetUp();
+		_volumeCache = std::make_shared<voxelformat::VolumeCache>();
+		ASSERT_TRUE(_volumeCache->init());
+	}
+
+	void TearDown() override {
+		_volumeCache->shutdown();
+		AbstractVoxelTest::TearDown();
+	}
+};
+
+TEST_F(WorldPagerTest, testGenerationIsIndependentOfTheChunkSize) {
+	const core::String& worldParamsLua = io::filesystem()->load("worldparams.lua");
+	WorldPager pager1(_volumeCache, std::make_shared<ChunkPersister>());
+	WorldPager pager2(_volumeCache, std::make_shared<ChunkPersister>());
+	voxel::PagedVolume volume1(&pager1, 128 * 1024 * 1024, 32);
+	voxel::PagedVolume volume2(&pager2, 128 * 1024 * 1024, 64);
+	ASSERT_TRUE(pager1.init(&volume1, worldParamsLua, _biomesLua));
+	ASSERT_TRUE(pager2.init(&volume2, worldParamsLua, _biomesLua));
+
+	const voxel::Region region(glm::ivec3(-32, 0, -32), glm::ivec3(31, voxel::MAX_TERRAIN_HEIGHT, 31));
+	int solid = 0;
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				// the colors of the biome voxels are random
+				const voxel::VoxelType material1 = volume1.voxel(x, y, z).getMaterial();
+				const voxel::VoxelType material2 = volume2.voxel(x, y, z).getMaterial();
+				ASSERT_EQ(material1, material2) << x << ":" << y << ":" << z;
+				if (!voxel::isAir(material1) && !voxel::isWater(material1)) {
+					++solid;
+				}
+			}
+		}
+	}
+	EXPECT_GT(solid, 0);
+	EXPECT_EQ(voxel::VoxelType::Dirt, volume1.voxel(0, 0, 0).getMaterial());
+
+	pager1.shutdown();
+	pager2.shutdown();
+}
+
+TEST_F(WorldPagerTest, testTreesAreIndependentOfTheGenerationOrder) {
+	const io::FilesystemPtr& filesystem = io::filesystem();
+	const core::String& worldParamsLua = filesystem->load("worldparams.lua");
+	const core::String& biomesLua = filesystem->load("biomes.lua");
+	WorldPager pager1(_volumeCache, std::make_shared<ChunkPersister>());
+	WorldPager pager2(_volumeCache, std::make_shared<ChunkPersister>());
+	const int chunkSize = 32;
+	voxel::PagedVolume volume1(&pager1, 128 * 1024 * 1024, chunkSize);
+	voxel::PagedVolume volume2(&pager2, 128 * 1024 * 1024, chunkSize);
+	ASSERT_TRUE(pager1.init(&volume1, worldParamsLua, biomesLua));
+	ASSERT_TRUE(pager2.init(&volume2, worldParamsLua, biomesLua));
+
+	// the tree placement of the neighbour regions is cached - page in the chunks in the opposite order
+	// to get different cache states for the same chunks
+	const int chunks = 4;
+	// outside of the city - there are no trees in cities
+	const glm::ivec3 origin(4096, 0, 4096);
+	for (int i = 0; i < chunks * chunks; ++i) {
+		const int j = chunks * chunks - 1 - i;
+		for (int y = 0; y < voxel::MAX_TERRAIN_HEIGHT; y += chunkSize) {
+			volume1.voxel(origin.x + (i % chunks) * chunkSize, y, origin.z + (i / chunks) * chunkSize);
+			volume2.voxel(origin.x + (j % chunks) * chunkSize, y, origin.z + (j / chunks) * chunkSize);
+		}
+	}
+	const voxel::Region region(origin, origin + glm::ivec3(chunks * chunkSize - 1, voxel::MAX_TERRAIN_HEIGHT, chunks * chunkSize - 1));
+	int trees = 0;
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				const voxel::VoxelType material1 = volume1.voxel(x, y, z).getMaterial();
+				const voxel::VoxelType material2 = volume2.voxel(x, y, z).getMaterial();
+				ASSERT_EQ(material1, material2) << x << ":" << y << ":" << z;
+				// the voxels of the imported tree volumes are generic voxels
+				if (material1 == voxel::VoxelType::Generic) {
+					++trees;
+				}
+			}
+		}
+	}
+	EXPECT_GT(trees, 0);
+
+	pager1.shutdown();
+	pager2.shutdown();
+}
+
+}
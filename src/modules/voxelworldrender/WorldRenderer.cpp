@@ -44,7 +44,7 @@ alignas(16) static constexpr glm::vec2 waterPlaneVecs[] = {
 };
 
 WorldRenderer::WorldRenderer(const AssetVolumeCachePtr& assetVolumeCache) :
-		_threadPool(1, "WorldRenderer"), _worldChunkMgr(_threadPool), _assetVolumeCache(assetVolumeCache),
+		_threadPool(1, "WorldRenderer"), _assetVolumeCache(assetVolumeCache),
 		_shadowMapShader(shader::ShadowmapShader::getInstance()) {
 	setViewDistance(800.0f);
 }
@@ -0,0 +1,90 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxelworldrender/worldrenderer/ChunkSlotAllocator.h"
+
+namespace voxelworldrender {
+
+class ChunkSlotAllocatorTest: public app::AbstractTest {
+protected:
+	// stands in for the chunk buffer - the id is the gpu resource that should survive the release of a slot
+	struct Slot {
+		int id = -1;
+	};
+	using Allocator = ChunkSlotAllocator<Slot, 4>;
+};
+
+TEST_F(ChunkSlotAllocatorTest, testAcquire) {
+	Allocator allocator;
+	bool created = false;
+	const int slot = allocator.acquire(glm::ivec3(16, 0, 32), created);
+	EXPECT_TRUE(created);
+	EXPECT_EQ(slot, allocator.find(glm::ivec3(16, 0, 32)));
+	EXPECT_EQ(Allocator::InvalidSlot, allocator.find(glm::ivec3(0)));
+	EXPECT_EQ(glm::ivec3(16, 0, 32), allocator.origin(slot));
+	EXPECT_TRUE(allocator.inUse(slot));
+	EXPECT_EQ(1, allocator.size());
+}
+
+TEST_F(ChunkSlotAllocatorTest, testReuseReleasedSlot) {
+	Allocator allocator;
+	bool created = false;
+	const int slot = allocator.acquire(glm::ivec3(0), created);
+	allocator[slot].id = 42;
+	EXPECT_TRUE(allocator.release(slot));
+	EXPECT_FALSE(allocator.release(slot)) << "A slot should only be released once";
+	EXPECT_EQ(Allocator::InvalidSlot, allocator.find(glm::ivec3(0)));
+	EXPECT_FALSE(allocator.inUse(slot));
+
+	const int reused = allocator.acquire(glm::ivec3(16, 0, 0), created);
+	EXPECT_FALSE(created);
+	EXPECT_EQ(slot, reused);
+	EXPECT_EQ(42, allocator[reused].id) << "The resources of a released slot should be kept";
+	EXPECT_EQ(1, allocator.capacity());
+}
+
+TEST_F(ChunkSlotAllocatorTest, testGrowKeepsReferences) {
+	Allocator allocator;
+	bool created = false;
+	const int first = allocator.acquire(glm::ivec3(0), created);
+	const Slot* firstSlot = &allocator[first];
+	for (int i = 1; i < 100; ++i) {
+		allocator.acquire(glm::ivec3(i * 16, 0, 0), created);
+		EXPECT_TRUE(created);
+	}
+	EXPECT_EQ(100, allocator.size());
+	EXPECT_EQ(100, allocator.capacity());
+	EXPECT_EQ(firstSlot, &allocator[first]) << "Growing the pool should not move the slots";
+}
+
+TEST_F(ChunkSlotAllocatorTest, testUsedListStaysDense) {
+	Allocator allocator;
+	bool created = false;
+	for (int i = 0; i < 10; ++i) {
+		allocator.acquire(glm::ivec3(i, 0, 0), created);
+	}
+	// release every even origin while iterating backwards - like the eviction does
+	const std::vector<int>& used = allocator.used();
+	for (int i = (int)used.size() - 1; i >= 0; --i) {
+		const int slot = used[i];
+		if (allocator.origin(slot).x % 2 == 0) {
+			EXPECT_TRUE(allocator.release(slot));
+		}
+	}
+	ASSERT_EQ(5, allocator.size());
+	for (int slot : allocator.used()) {
+		EXPECT_TRUE(allocator.inUse(slot));
+		EXPECT_EQ(1, allocator.origin(slot).x % 2);
+		EXPECT_EQ(slot, allocator.find(allocator.origin(slot)));
+	}
+
+	allocator.releaseAll();
+	EXPECT_EQ(0, allocator.size());
+	EXPECT_EQ(10, allocator.capacity());
+	allocator.acquire(glm::ivec3(0), created);
+	EXPECT_FALSE(created);
+}
+
+}
@@ -0,0 +1,251 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxelworldrender/worldrenderer/WorldMeshExtractor.h"
+#include "voxel/MaterialColor.h"
+#include "core/GameConfig.h"
+#include <chrono>
+#include <thread>
+
+namespace voxelworldrender {
+
+class WorldMeshExtractorTest: public app::AbstractTest {
+protected:
+	// a flat ground - every mesh position has a non empty mesh - except for the empty area from z = 1024 on
+	class Pager: public voxel::PagedVolume::Pager {
+	public:
+		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+			const voxel::Region& region = ctx.region;
+			if (region.getLowerZ() >= 1024) {
+				return true;
+			}
+			const voxel::Voxel ground = voxel::createVoxel(voxel::VoxelType::Grass, 0);
+			for (int z = 0; z < region.getDepthInVoxels(); ++z) {
+				for (int y = 0; y < region.getHeightInVoxels(); ++y) {
+					if (region.getLowerY() + y >= 4) {
+						break;
+					}
+					for (int x = 0; x < region.getWidthInVoxels(); ++x) {
+						ctx.chunk->setVoxel(x, y, z, ground);
+					}
+				}
+			}
+			return true;
+		}
+
+		void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+		}
+	};
+
+	Pager _pager;
+	voxel::PagedVolume _volume { &_pager, 128 * 1024 * 1024, 32 };
+	WorldMeshExtractor _extractor;
+	int _meshSize = 0;
+
+	void SetUp() override {
+		app::AbstractTest::SetUp();
+		ASSERT_TRUE(voxel::initDefaultMaterialColors());
+		_meshSize = core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY)->intVal();
+		// full resolution for the first two rings
+		core::Var::get(cfg::VoxelMeshLodDistance, "2")->setVal(2);
+		ASSERT_TRUE(_extractor.init(&_volume));
+	}
+
+	void TearDown() override {
+		_extractor.shutdown();
+		app::AbstractTest::TearDown();
+	}
+
+	glm::ivec3 pos(int x, int z) const {
+		return glm::ivec3(x * _meshSize, 0, z * _meshSize);
+	}
+
+	/**
+	 * @brief Extracts the next scheduled mesh and returns its position
+	 */
+	glm::ivec3 extractNext() {
+		voxel::Mesh mesh;
+		int lod;
+		if (!extractNext(mesh, lod)) {
+			return glm::ivec3(-1);
+		}
+		return mesh.getOffset();
+	}
+
+	bool extractNext(voxel::Mesh& mesh, int& lod) {
+		_extractor.extractScheduledMesh();
+		return _extractor.pop(mesh, lod);
+	}
+};
+
+TEST_F(WorldMeshExtractorTest, testClosestPositionsFirst) {
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(10, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 5)));
+	EXPECT_FALSE(_extractor.scheduleMeshExtraction(pos(0, 5))) << "A position should only be scheduled once";
+	EXPECT_EQ(3, _extractor.statistics().queueDepth[(int)WorldMeshExtractor::Stage::Scheduled]);
+
+	EXPECT_EQ(pos(0, 0), extractNext());
+	EXPECT_EQ(pos(0, 5), extractNext());
+	EXPECT_EQ(pos(10, 0), extractNext());
+
+	const WorldMeshExtractor::Statistics& stats = _extractor.statistics();
+	for (int i = 0; i < (int)WorldMeshExtractor::Stage::Max; ++i) {
+		EXPECT_EQ(0, stats.queueDepth[i]) << "Stage " << i;
+	}
+	EXPECT_EQ(0, stats.cancelled);
+}
+
+TEST_F(WorldMeshExtractorTest, testUpdateExtractionOrder) {
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(20, 0)));
+	_extractor.updateExtractionOrder(pos(20, 0));
+
+	EXPECT_EQ(pos(20, 0), extractNext());
+	EXPECT_EQ(pos(0, 0), extractNext());
+}
+
+TEST_F(WorldMeshExtractorTest, testCancelScheduled) {
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(1, 0)));
+	EXPECT_TRUE(_extractor.allowReExtraction(pos(0, 0)));
+
+	// the cancelled position is skipped
+	EXPECT_EQ(pos(1, 0), extractNext());
+	EXPECT_EQ(1, _extractor.statistics().cancelled);
+}
+
+TEST_F(WorldMeshExtractorTest, testCancelExtracted) {
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 0)));
+	_extractor.extractScheduledMesh();
+	EXPECT_TRUE(_extractor.allowReExtraction(pos(0, 0)));
+
+	// the mesh of the cancelled position is not handed out for the upload
+	voxel::Mesh mesh;
+	EXPECT_FALSE(_extractor.pop(mesh));
+	EXPECT_EQ(1, _extractor.statistics().cancelled);
+
+	// but the position can get scheduled again
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 0)));
+	EXPECT_EQ(pos(0, 0), extractNext());
+}
+
+TEST_F(WorldMeshExtractorTest, testMaxDistance) {
+	_extractor.setMaxDistance(5 * _meshSize * 5 * _meshSize);
+	EXPECT_FALSE(_extractor.scheduleMeshExtraction(pos(5, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(2, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(3, 0)));
+
+	// moving the focus cancels the positions that are out of range now
+	_extractor.updateExtractionOrder(pos(-2, 0));
+	EXPECT_EQ(1, _extractor.statistics().cancelled);
+	EXPECT_EQ(pos(2, 0), extractNext());
+	EXPECT_EQ(0, _extractor.statistics().queueDepth[(int)WorldMeshExtractor::Stage::Scheduled]);
+}
+
+TEST_F(WorldMeshExtractorTest, testFrustumExtractionOrderOnlyOnFocusChange) {
+	// everything is visible
+	const math::Frustum frustum(glm::vec3(-10000.0f), glm::vec3(10000.0f));
+	const int maxDistance = 3 * _meshSize + _meshSize / 4;
+	_extractor.setMaxDistance(maxDistance * maxDistance);
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(3, 0)));
+	_extractor.updateExtractionOrder(pos(0, 0), frustum);
+	EXPECT_EQ(0, _extractor.statistics().cancelled);
+
+	// less than a mesh size - the scheduled positions are not touched
+	_extractor.updateExtractionOrder(pos(0, 0) - glm::ivec3(_meshSize / 2, 0, 0), frustum);
+	EXPECT_EQ(0, _extractor.statistics().cancelled);
+
+	_extractor.updateExtractionOrder(pos(-1, 0), frustum);
+	EXPECT_EQ(1, _extractor.statistics().cancelled);
+}
+
+TEST_F(WorldMeshExtractorTest, testLodByDistance) {
+	EXPECT_EQ(0, _extractor.lod(pos(0, 0)));
+	EXPECT_EQ(0, _extractor.lod(pos(1, 0)));
+	EXPECT_EQ(1, _extractor.lod(pos(2, 0)));
+	EXPECT_EQ(1, _extractor.lod(pos(3, 0)));
+	EXPECT_EQ(2, _extractor.lod(pos(4, 0)));
+	EXPECT_EQ(WorldMeshExtractor::MaxLod, _extractor.lod(pos(100, 0)));
+
+	// the level of detail follows the focus position
+	_extractor.updateExtractionOrder(pos(100, 0));
+	EXPECT_EQ(0, _extractor.lod(pos(100, 0)));
+	EXPECT_EQ(WorldMeshExtractor::MaxLod, _extractor.lod(pos(0, 0)));
+}
+
+TEST_F(WorldMeshExtractorTest, testLodMesh) {
+	voxel::Mesh fullMesh;
+	voxel::Mesh lodMesh;
+	int lod = -1;
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 0)));
+	ASSERT_TRUE(extractNext(fullMesh, lod));
+	EXPECT_EQ(0, lod);
+
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(4, 0)));
+	ASSERT_TRUE(extractNext(lodMesh, lod));
+	ASSERT_EQ(2, lod);
+	EXPECT_EQ(pos(4, 0), lodMesh.getOffset());
+
+	// the vertices are in world coordinates on the grid of the level of detail - and the ground
+	// has the same height in both meshes
+	const int factor = 1 << lod;
+	int maxY = 0;
+	for (const voxel::VoxelVertex& vertex : lodMesh.getVertexVector()) {
+		const glm::ivec3 p(vertex.position);
+		EXPECT_GE(p.x, pos(4, 0).x);
+		EXPECT_LE(p.x, pos(5, 0).x);
+		EXPECT_EQ(0, (p.x - pos(4, 0).x) % factor);
+		EXPECT_EQ(0, p.y % factor);
+		maxY = core_max(maxY, p.y);
+	}
+	EXPECT_EQ(4, maxY);
+}
+
+TEST_F(WorldMeshExtractorTest, testRescheduleMeshExtraction) {
+	EXPECT_FALSE(_extractor.rescheduleMeshExtraction(pos(2, 0)));
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(2, 0)));
+	voxel::Mesh mesh;
+	int lod = -1;
+	ASSERT_TRUE(extractNext(mesh, lod));
+	EXPECT_EQ(1, lod);
+
+	// the focus moves to the position - the mesh is extracted again with the full resolution
+	_extractor.updateExtractionOrder(pos(2, 0));
+	ASSERT_TRUE(_extractor.rescheduleMeshExtraction(pos(2, 0)));
+	ASSERT_TRUE(extractNext(mesh, lod));
+	EXPECT_EQ(0, lod);
+	EXPECT_EQ(pos(2, 0), mesh.getOffset());
+}
+
+TEST_F(WorldMeshExtractorTest, testEmptyMesh) {
+	ASSERT_TRUE(_extractor.scheduleMeshExtraction(pos(0, 100)));
+	voxel::Mesh mesh;
+	int lod = -1;
+	// the empty mesh is handed out - it might replace the mesh of another level of detail
+	ASSERT_TRUE(extractNext(mesh, lod));
+	EXPECT_TRUE(mesh.isEmpty());
+	EXPECT_EQ(pos(0, 100), mesh.getOffset());
+	EXPECT_EQ(WorldMeshExtractor::MaxLod, lod);
+}
+
+TEST_F(WorldMeshExtractorTest, testPrefetch) {
+	const glm::ivec3 focusPos = pos(0, 0);
+	const glm::ivec3 movement(_meshSize, 0, 0);
+	ASSERT_GT(_extractor.prefetch(focusPos, movement), 0);
+	// nobody calls extractScheduledMesh() here - the page-in must not depend on the extraction threads
+	const glm::ivec3 ahead = focusPos + movement;
+	for (int i = 0; i < 10000; ++i) {
+		if (_volume.chunkState(focusPos) == voxel::PagedVolume::ChunkState::Ready
+				&& _volume.chunkState(ahead) == voxel::PagedVolume::ChunkState::Ready) {
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_EQ(voxel::PagedVolume::ChunkState::Ready, _volume.chunkState(focusPos));
+	EXPECT_EQ(voxel::PagedVolume::ChunkState::Ready, _volume.chunkState(ahead));
+}
+
+}
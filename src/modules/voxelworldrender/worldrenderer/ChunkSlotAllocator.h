@@ -0,0 +1,156 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/Assert.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/vec3.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+namespace voxelworldrender {
+
+/**
+ * @brief Hands out the slots for the chunk meshes and maps the mesh origins to their slots.
+ *
+ * The slots are allocated in blocks that are never moved - a reference to a slot stays valid for the
+ * lifetime of the allocator. Released slots are not destroyed but put into a free list and handed out
+ * again before the pool grows. This allows to reuse the resources (e.g. the gpu buffers) of a slot.
+ */
+template<class SLOT, int BLOCKSIZE = 256>
+class ChunkSlotAllocator {
+public:
+	static constexpr int InvalidSlot = -1;
+
+private:
+	std::vector<std::unique_ptr<SLOT[]> > _blocks;
+	// the amount of slots in all blocks
+	int _capacity = 0;
+	// the slots that were released - they are handed out again first
+	std::vector<int> _free;
+	// the slots that are in use in no particular order
+	std::vector<int> _used;
+	// the index of each slot in the used slot list or -1 if the slot is not in use
+	std::vector<int> _usedIndex;
+	std::vector<glm::ivec3> _slotOrigins;
+	std::unordered_map<glm::ivec3, int, std::hash<glm::ivec3> > _origins;
+
+public:
+	/**
+	 * @brief Looks up the slot of the given mesh origin
+	 * @return @c InvalidSlot if there is no slot for the given origin
+	 */
+	int find(const glm::ivec3& origin) const {
+		auto i = _origins.find(origin);
+		if (i == _origins.end()) {
+			return InvalidSlot;
+		}
+		return i->second;
+	}
+
+	/**
+	 * @brief Hands out a slot for the given mesh origin. There must not be a slot for the origin already.
+	 * @param[out] created @c true if the slot was never used before, @c false if it is a released slot that
+	 * is reused. The resources of a reused slot are still there.
+	 */
+	int acquire(const glm::ivec3& origin, bool& created) {
+		core_assert_msg(find(origin) == InvalidSlot, "There is already a slot for %i:%i:%i", origin.x, origin.y, origin.z);
+		int slot;
+		if (!_free.empty()) {
+			slot = _free.back();
+			_free.pop_back();
+			created = false;
+		} else {
+			if (_capacity % BLOCKSIZE == 0) {
+				_blocks.emplace_back(new SLOT[BLOCKSIZE]);
+			}
+			slot = _capacity++;
+			_usedIndex.push_back(-1);
+			_slotOrigins.emplace_back(0);
+			created = true;
+		}
+		_usedIndex[slot] = (int)_used.size();
+		_used.push_back(slot);
+		_slotOrigins[slot] = origin;
+		_origins.emplace(origin, slot);
+		return slot;
+	}
+
+	/**
+	 * @brief Puts the given slot back into the free list. The slot object itself is not touched.
+	 * @return @c false if the slot wasn't in use
+	 */
+	bool release(int slot) {
+		if (slot < 0 || slot >= _capacity || _usedIndex[slot] == -1) {
+			return false;
+		}
+		// swap with the last used slot to keep the used slot list dense
+		const int index = _usedIndex[slot];
+		const int last = _used.back();
+		_used[index] = last;
+		_usedIndex[last] = index;
+		_used.pop_back();
+		_usedIndex[slot] = -1;
+		_origins.erase(_slotOrigins[slot]);
+		_free.push_back(slot);
+		return true;
+	}
+
+	/**
+	 * @brief Releases all slots that are in use - the slot objects are kept for reuse
+	 */
+	void releaseAll() {
+		for (int slot : _used) {
+			_usedIndex[slot] = -1;
+			_free.push_back(slot);
+		}
+		_used.clear();
+		_origins.clear();
+	}
+
+	inline SLOT& operator[](int slot) {
+		core_assert(slot >= 0 && slot < _capacity);
+		return _blocks[slot / BLOCKSIZE][slot % BLOCKSIZE];
+	}
+
+	inline const SLOT& operator[](int slot) const {
+		core_assert(slot >= 0 && slot < _capacity);
+		return _blocks[slot / BLOCKSIZE][slot % BLOCKSIZE];
+	}
+
+	inline const glm::ivec3& origin(int slot) const {
+		core_assert(slot >= 0 && slot < _capacity);
+		return _slotOrigins[slot];
+	}
+
+	inline bool inUse(int slot) const {
+		return slot >= 0 && slot < _capacity && _usedIndex[slot] != -1;
+	}
+
+	/**
+	 * @brief The slots that are in use in no particular order. Releasing a slot changes the order.
+	 */
+	inline const std::vector<int>& used() const {
+		return _used;
+	}
+
+	/**
+	 * @return The amount of slots that are in use
+	 */
+	inline int size() const {
+		return (int)_used.size();
+	}
+
+	/**
+	 * @return The amount of slots that were created
+	 */
+	inline int capacity() const {
+		return _capacity;
+	}
+};
+
+}
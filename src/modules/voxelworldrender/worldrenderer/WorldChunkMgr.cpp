@@ -17,18 +17,21 @@ namespace {
 constexpr double ScaleDuration = 1.5;
 }
 
-WorldChunkMgr::WorldChunkMgr(core::ThreadPool& threadPool) :
-		_octree({}, 30), _threadPool(threadPool) {
+WorldChunkMgr::WorldChunkMgr() :
+		_octree({}, 30) {
 }
 
 void WorldChunkMgr::updateViewDistance(float viewDistance) {
 	const glm::vec3 cullingThreshold(_meshExtractor.meshSize());
 	const int maxCullingThreshold = core_max(cullingThreshold.x, cullingThreshold.z) * 4;
 	_maxAllowedDistance = glm::pow(viewDistance + (float)maxCullingThreshold, 2);
+	_meshExtractor.setMaxDistance(_maxAllowedDistance);
 }
 
 bool WorldChunkMgr::init(shader::WorldShader* worldShader, voxel::PagedVolume* volume) {
 	_worldShader = worldShader;
+	_volume = volume;
+	_meshUploadBudget = core::Var::get(cfg::VoxelMeshUploadBudget, "1048576", 0, "The amount of mesh bytes that are uploaded per frame - at least one mesh is uploaded");
 	if (!_meshExtractor.init(volume)) {
 		Log::error("Failed to initialize the mesh extractor");
 		return false;
@@ -38,105 +41,212 @@ bool WorldChunkMgr::init(shader::WorldShader* worldShader, voxel::PagedVolume* v
 
 void WorldChunkMgr::shutdown() {
 	_meshExtractor.shutdown();
+	_volume = nullptr;
 }
 
 void WorldChunkMgr::reset() {
-	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
-		chunkBuffer.inuse = false;
+	for (int slot : _chunkBuffers.used()) {
+		_chunkBuffers[slot]._subMeshes.clear();
+		_chunkBuffers[slot].treeItem = Tree::InvalidItem;
 	}
-	_visibleBuffers.size = 0;
+	_chunkBuffers.releaseAll();
+	_visibleBuffers.clear();
 	_meshExtractor.reset();
 	_octree.clear();
 }
 
 void WorldChunkMgr::handleMeshQueue() {
+	core_trace_scoped(WorldRendererHandleMeshQueue);
+	const size_t budget = (size_t)core_max(0, _meshUploadBudget->intVal());
+	size_t uploaded = 0u;
+	int meshes = 0;
 	voxel::Mesh mesh;
-	if (!_meshExtractor.pop(mesh)) {
-		return;
+	int lod = 0;
+	while (uploaded < budget || meshes == 0) {
+		if (!_meshExtractor.pop(mesh, lod)) {
+			break;
+		}
+		uploaded += uploadMesh(mesh, lod);
+		++meshes;
 	}
+	core_trace_plot("WorldChunkMgrUploadedMeshes", meshes);
+	core_trace_plot("WorldChunkMgrUploadedBytes", (int64_t)uploaded);
+
+	const WorldMeshExtractor::Statistics& stats = _meshExtractor.statistics();
+	core_trace_plot("MeshExtractionScheduled", stats.queueDepth[(int)WorldMeshExtractor::Stage::Scheduled]);
+	core_trace_plot("MeshExtractionPageIn", stats.queueDepth[(int)WorldMeshExtractor::Stage::PageIn]);
+	core_trace_plot("MeshExtractionExtract", stats.queueDepth[(int)WorldMeshExtractor::Stage::Extract]);
+	core_trace_plot("MeshExtractionUploadReady", stats.queueDepth[(int)WorldMeshExtractor::Stage::UploadReady]);
+	core_trace_plot("MeshExtractionCancelled", stats.cancelled);
+	core_trace_plot("MeshExtractionScheduledMillis", stats.latencyMillis[(int)WorldMeshExtractor::Stage::Scheduled]);
+	core_trace_plot("MeshExtractionPageInMillis", stats.latencyMillis[(int)WorldMeshExtractor::Stage::PageIn]);
+	core_trace_plot("MeshExtractionExtractMillis", stats.latencyMillis[(int)WorldMeshExtractor::Stage::Extract]);
+	core_trace_plot("MeshExtractionUploadReadyMillis", stats.latencyMillis[(int)WorldMeshExtractor::Stage::UploadReady]);
+}
 
+size_t WorldChunkMgr::uploadMesh(voxel::Mesh& mesh, int lod) {
 	// Now add the mesh to the list of meshes to render.
-	core_trace_scoped(WorldRendererHandleMeshQueue);
-
-	ChunkBuffer* freeChunkBuffer = nullptr;
-	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
-		if (freeChunkBuffer == nullptr && !chunkBuffer.inuse) {
-			freeChunkBuffer = &chunkBuffer;
-		}
-		// check whether we update an existing one
-		if (chunkBuffer.aabb().mins() == mesh.getOffset()) {
-			freeChunkBuffer = &chunkBuffer;
-			break;
+	const glm::ivec3& mins = mesh.getOffset();
+	int slot = _chunkBuffers.find(mins);
+	// the mesh of another level of detail is replaced
+	const bool replace = slot != ChunkSlotAllocator<ChunkBuffer>::InvalidSlot;
+	if (mesh.isEmpty()) {
+		if (replace) {
+			// the slot is kept to release it or to change the level of detail again in evict()
+			ChunkBuffer& chunkBuffer = _chunkBuffers[slot];
+			_octree.removeItem(chunkBuffer.treeItem);
+			chunkBuffer.treeItem = Tree::InvalidItem;
+			chunkBuffer._subMeshes.clear();
+			chunkBuffer.lod = lod;
 		}
+		return 0u;
 	}
-
-	if (freeChunkBuffer == nullptr) {
-		Log::warn("Could not find free chunk buffer slot");
-		return;
+	bool created = false;
+	if (!replace) {
+		slot = _chunkBuffers.acquire(mins, created);
+		_chunkBuffers[slot].requestedLod = lod;
 	}
-
+	ChunkBuffer* freeChunkBuffer = &_chunkBuffers[slot];
 	video::Buffer& buffer = freeChunkBuffer->_buffer;
-	freeChunkBuffer->_vbo = buffer.create();
 	if (freeChunkBuffer->_vbo == -1) {
-		Log::error("Failed to create vertex buffer");
-		return;
-	}
-	const int locationPos = _worldShader->getLocationPos();
-	const video::Attribute& posAttrib = voxelrender::getPositionVertexAttribute(freeChunkBuffer->_vbo, locationPos, _worldShader->getAttributeComponents(locationPos));
-	if (!buffer.addAttribute(posAttrib)) {
-		Log::error("Failed to add position attribute");
-		return;
-	}
-	const int locationInfo = _worldShader->getLocationInfo();
-	const video::Attribute& infoAttrib = voxelrender::getInfoVertexAttribute(freeChunkBuffer->_vbo, locationInfo, _worldShader->getAttributeComponents(locationInfo));
-	if (!buffer.addAttribute(infoAttrib)) {
-		Log::error("Failed to add info attribute");
-		return;
-	}
-	freeChunkBuffer->_ibo = buffer.create(nullptr, 0, video::BufferType::IndexBuffer);
-	if (freeChunkBuffer->_ibo == -1) {
-		Log::error("Failed to create index buffer");
-		return;
+		if (!created) {
+			// the buffer creation failed for the previous mesh of this slot
+			freeChunkBuffer->reset();
+		}
+		freeChunkBuffer->_vbo = buffer.create();
+		if (freeChunkBuffer->_vbo == -1) {
+			Log::error("Failed to create vertex buffer");
+			_chunkBuffers.release(slot);
+			return 0u;
+		}
+		const int locationPos = _worldShader->getLocationPos();
+		const video::Attribute& posAttrib = voxelrender::getPositionVertexAttribute(freeChunkBuffer->_vbo, locationPos, _worldShader->getAttributeComponents(locationPos));
+		const int locationInfo = _worldShader->getLocationInfo();
+		const video::Attribute& infoAttrib = voxelrender::getInfoVertexAttribute(freeChunkBuffer->_vbo, locationInfo, _worldShader->getAttributeComponents(locationInfo));
+		freeChunkBuffer->_ibo = buffer.create(nullptr, 0, video::BufferType::IndexBuffer);
+		if (!buffer.addAttribute(posAttrib) || !buffer.addAttribute(infoAttrib) || freeChunkBuffer->_ibo == -1) {
+			Log::error("Failed to create the chunk buffer");
+			freeChunkBuffer->reset();
+			_chunkBuffers.release(slot);
+			return 0u;
+		}
 	}
-	freeChunkBuffer->_compressedIndexSize = mesh.compressedIndexSize();
-
 	const voxel::VertexArray& vertices = mesh.getVertexVector();
-	const uint8_t* indices = mesh.compressedIndices();
-	buffer.update(freeChunkBuffer->_vbo, &vertices.front(), vertices.size() * sizeof(voxel::VertexArray::value_type));
-	buffer.update(freeChunkBuffer->_ibo, indices, mesh.getNoOfIndices() * freeChunkBuffer->_compressedIndexSize);
+	size_t uploaded = vertices.size() * sizeof(voxel::VertexArray::value_type);
+	buffer.update(freeChunkBuffer->_vbo, &vertices.front(), uploaded);
+	if (!mesh.isCompressed()) {
+		freeChunkBuffer->_indexSize = sizeof(voxel::IndexType);
+		freeChunkBuffer->_subMeshes.clear();
+		freeChunkBuffer->_subMeshes.push_back(voxel::SubMesh{0u, 0u, (uint32_t)mesh.getNoOfIndices()});
+		buffer.update(freeChunkBuffer->_ibo, mesh.getRawIndexData(), mesh.getNoOfIndices() * sizeof(voxel::IndexType));
+		uploaded += mesh.getNoOfIndices() * sizeof(voxel::IndexType);
+	} else if (mesh.hasImplicitQuadIndices()) {
+		freeChunkBuffer->_indexSize = sizeof(voxel::CompactIndexType);
+		freeChunkBuffer->_subMeshes = mesh.subMeshes();
+		// all sub meshes share the same indices - only the base vertex differs
+		uint32_t numIndices = 0u;
+		for (const voxel::SubMesh& subMesh : mesh.subMeshes()) {
+			numIndices = core_max(numIndices, subMesh.numIndices);
+		}
+		if (_quadIndices.empty()) {
+			const size_t quads = voxel::Mesh::MaxSubMeshVertices / 4u;
+			_quadIndices.resize(quads * 6u);
+			voxel::Mesh::fillQuadIndices(_quadIndices.data(), quads);
+		}
+		buffer.update(freeChunkBuffer->_ibo, _quadIndices.data(), numIndices * sizeof(voxel::CompactIndexType));
+		uploaded += numIndices * sizeof(voxel::CompactIndexType);
+	} else {
+		freeChunkBuffer->_indexSize = sizeof(voxel::CompactIndexType);
+		freeChunkBuffer->_subMeshes = mesh.subMeshes();
+		buffer.update(freeChunkBuffer->_ibo, mesh.compressedIndices(), mesh.getNoOfIndices() * sizeof(voxel::CompactIndexType));
+		uploaded += mesh.getNoOfIndices() * sizeof(voxel::CompactIndexType);
+	}
 
 	const glm::ivec3& size = _meshExtractor.meshSize();
-	const glm::ivec3& mins = mesh.getOffset();
 	const glm::ivec3 maxs(mins.x + size.x, mins.y + size.y, mins.z + size.z);
-	freeChunkBuffer->_aabb = {mins, maxs};
-	if (!_octree.insert(freeChunkBuffer)) {
-		Log::warn("Failed to insert into octree");
+	if (freeChunkBuffer->treeItem == Tree::InvalidItem) {
+		// an updated mesh keeps its place in the octree
+		freeChunkBuffer->_aabb = {mins, maxs};
+		freeChunkBuffer->treeItem = _octree.add(freeChunkBuffer);
+		if (freeChunkBuffer->treeItem == Tree::InvalidItem) {
+			Log::warn("Failed to insert into octree");
+		}
+	}
+	if (!replace) {
+		// a new level of detail doesn't replay the spawn animation
+		freeChunkBuffer->uploadSeconds = _seconds;
 	}
-	freeChunkBuffer->inuse = true;
-	freeChunkBuffer->scaleSeconds = ScaleDuration;
+	freeChunkBuffer->lod = lod;
+	return uploaded;
 }
 
 void WorldChunkMgr::update(double deltaFrameSeconds, const video::Camera &camera, const glm::vec3& focusPos) {
+	_seconds += deltaFrameSeconds;
 	handleMeshQueue();
 
-	_meshExtractor.updateExtractionOrder(focusPos);
-	for (ChunkBuffer& chunkBuffer : _chunkBuffers) {
-		if (!chunkBuffer.inuse) {
-			continue;
-		}
-		chunkBuffer.scaleSeconds -= deltaFrameSeconds;
-		const glm::ivec3& pos = chunkBuffer.aabb().mins();
+	_meshExtractor.updateExtractionOrder(focusPos, camera.frustum());
+	prefetch(glm::ivec3(focusPos));
+	evict(glm::ivec3(focusPos));
+
+	cull(camera);
+}
+
+void WorldChunkMgr::releaseChunkBuffer(int slot) {
+	ChunkBuffer& chunkBuffer = _chunkBuffers[slot];
+	const glm::ivec3& pos = chunkBuffer.aabb().mins();
+	core_assert_always(_meshExtractor.allowReExtraction(pos));
+	_octree.removeItem(chunkBuffer.treeItem);
+	chunkBuffer.treeItem = Tree::InvalidItem;
+	// the gpu buffers are kept for the next mesh that gets this slot
+	chunkBuffer._subMeshes.clear();
+	_chunkBuffers.release(slot);
+	Log::trace("Remove mesh from %i:%i", pos.x, pos.z);
+}
+
+void WorldChunkMgr::evict(const glm::ivec3& focusPos) {
+	const glm::ivec3& d = glm::abs(focusPos - _evictionFocusPos);
+	const glm::ivec3& size = _meshExtractor.meshSize();
+	if (d.x < size.x && d.z < size.z && _evictionDistance == _maxAllowedDistance) {
+		return;
+	}
+	core_trace_scoped(WorldChunkMgrEvict);
+	_evictionFocusPos = focusPos;
+	_evictionDistance = _maxAllowedDistance;
+	const std::vector<int>& used = _chunkBuffers.used();
+	// releasing a slot moves the last used slot into its place - so iterate backwards
+	for (int i = (int)used.size() - 1; i >= 0; --i) {
+		const int slot = used[i];
+		const glm::ivec3& pos = _chunkBuffers.origin(slot);
 		const int distance = distance2(pos, focusPos);
-		if (distance < _maxAllowedDistance) {
+		if (distance >= _maxAllowedDistance) {
+			releaseChunkBuffer(slot);
 			continue;
 		}
-		core_assert_always(_meshExtractor.allowReExtraction(pos));
-		chunkBuffer.reset();
-		_octree.remove(&chunkBuffer);
-		Log::trace("Remove mesh from %i:%i", pos.x, pos.z);
+		// the mesh is kept until the mesh with the new level of detail is uploaded
+		ChunkBuffer& chunkBuffer = _chunkBuffers[slot];
+		const int lod = _meshExtractor.lod(pos);
+		if (lod != chunkBuffer.requestedLod && _meshExtractor.rescheduleMeshExtraction(pos)) {
+			chunkBuffer.requestedLod = lod;
+		}
 	}
+	core_trace_plot("WorldChunkMgrChunkBuffers", _chunkBuffers.size());
+}
 
-	cull(camera);
+void WorldChunkMgr::prefetch(const glm::ivec3& focusPos) {
+	const glm::ivec3 movement = focusPos - _lastFocusPos;
+	if (_volume == nullptr || movement == glm::ivec3(0)) {
+		return;
+	}
+	_lastFocusPos = focusPos;
+	core_trace_scoped(WorldChunkMgrPrefetch);
+	// look one chunk ahead in the direction we are moving to
+	const float chunkSideLength = (float)_volume->chunkSideLength();
+	const glm::vec3 dir = glm::normalize(glm::vec3(movement.x, 0.0f, movement.z));
+	if (glm::any(glm::isnan(dir))) {
+		return;
+	}
+	const glm::ivec3 lookAhead(dir * chunkSideLength);
+	_meshExtractor.prefetch(focusPos, lookAhead);
 }
 
 void WorldChunkMgr::extractScheduledMesh() {
@@ -152,14 +262,8 @@ void WorldChunkMgr::cull(const video::Camera& camera) {
 	// don't cull objects that might cast shadows
 	aabb.shift(camera.forward() * -10.0f);
 
-	size_t index = 0;
-	Tree::Contents contents;
-	_octree.query(math::AABB<int>(aabb.mins(), aabb.maxs()), contents);
-
-	for (ChunkBuffer* chunkBuffer : contents) {
-		_visibleBuffers.visible[index++] = chunkBuffer;
-	}
-	_visibleBuffers.size = index;
+	_visibleBuffers.clear();
+	_octree.query(math::AABB<int>(aabb.mins(), aabb.maxs()), _visibleBuffers);
 }
 
 int WorldChunkMgr::distance2(const glm::ivec3& pos, const glm::ivec3& pos2) const {
@@ -197,22 +301,23 @@ int WorldChunkMgr::renderTerrain() {
 	video_trace_scoped(WorldChunkMgrRenderTerrain);
 	int drawCalls = 0;
 
-	for (int i = 0; i < _visibleBuffers.size; ++i) {
-		ChunkBuffer& chunkBuffer = *_visibleBuffers.visible[i];
-		core_assert(chunkBuffer.inuse);
+	for (ChunkBuffer* visible : _visibleBuffers) {
+		ChunkBuffer& chunkBuffer = *visible;
 		const video::Buffer& buffer = chunkBuffer._buffer;
-		const int ibo = chunkBuffer._ibo;
-		const uint32_t numIndices = buffer.elements(ibo, 1, chunkBuffer._compressedIndexSize);
-		core_assert_msg(numIndices > 0u, "Empty meshes should not be part of the array");
+		core_assert_msg(!chunkBuffer._subMeshes.empty(), "Empty meshes should not be part of the array");
 		video::ScopedBuffer scopedBuf(buffer);
 		if (_worldShader->isActive()) {
-			const double delta = glm::clamp(core_max(0.0, chunkBuffer.scaleSeconds) / ScaleDuration, 0.0, 1.0);
+			const double scaleSeconds = ScaleDuration - (_seconds - chunkBuffer.uploadSeconds);
+			const double delta = glm::clamp(core_max(0.0, scaleSeconds) / ScaleDuration, 0.0, 1.0);
 			const glm::vec3& size = glm::mix(glm::vec3(1.0f), glm::vec3(1.0f, 0.4f, 1.0f), (float)delta);
 			const glm::mat4& model = glm::scale(size);
 			_worldShader->setModel(model);
 		}
-		video::drawElements(video::Primitive::Triangles, numIndices, chunkBuffer._compressedIndexSize);
-		++drawCalls;
+		for (const voxel::SubMesh& subMesh : chunkBuffer._subMeshes) {
+			video::drawElementsBaseVertex(video::Primitive::Triangles, subMesh.numIndices, chunkBuffer._indexSize,
+					(int)subMesh.firstIndex, (int)subMesh.baseVertex);
+			++drawCalls;
+		}
 	}
 	return drawCalls;
 }
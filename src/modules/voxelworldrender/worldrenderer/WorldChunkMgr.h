@@ -4,8 +4,9 @@
 
 #pragma once
 
-#include "math/Octree.h"
+#include "math/PooledOctree.h"
 #include "WorldMeshExtractor.h"
+#include "ChunkSlotAllocator.h"
 #include "video/Camera.h"
 #include "voxel/VoxelVertex.h"
 #include "WorldShader.h"
@@ -18,10 +19,16 @@ namespace voxelworldrender {
 class WorldChunkMgr {
 protected:
 	struct ChunkBuffer {
-		bool inuse = false;
-		double scaleSeconds = 0.0;
+		// the time of the first upload - a mesh with another level of detail keeps it. See WorldChunkMgr::_seconds
+		double uploadSeconds = 0.0;
+		// the level of detail of the uploaded mesh and the one of the latest scheduled extraction
+		int lod = 0;
+		int requestedLod = 0;
 		math::AABB<int> _aabb = {glm::ivec3(0), glm::ivec3(0)};
-		size_t _compressedIndexSize = 0;
+		// the id of the buffer in the octree - the aabb of a slot doesn't change while it is in use
+		int32_t treeItem = -1;
+		size_t _indexSize = 0;
+		voxel::SubMeshArray _subMeshes;
 
 		video::Buffer _buffer;
 		int32_t _vbo = -1;
@@ -35,7 +42,7 @@ protected:
 			_buffer.shutdown();
 			_vbo = -1;
 			_ibo = -1;
-			inuse = false;
+			_subMeshes.clear();
 		}
 
 		/**
@@ -48,29 +55,53 @@ protected:
 	};
 
 
-	using Tree = math::Octree<ChunkBuffer *>;
+	using Tree = math::PooledOctree<ChunkBuffer *>;
 	Tree _octree;
-	static constexpr int MAX_CHUNKBUFFERS = 2048;
-	ChunkBuffer _chunkBuffers[MAX_CHUNKBUFFERS];
+	// the chunk buffers of released slots keep their gpu buffers - they are reused for the next mesh
+	ChunkSlotAllocator<ChunkBuffer> _chunkBuffers;
 	int _maxAllowedDistance = -1;
+	core::VarPtr _meshUploadBudget;
+	// the seconds since the start - used to animate new chunks
+	double _seconds = 0.0;
+	// the focus position and view distance of the last eviction of out of range chunks
+	glm::ivec3 _evictionFocusPos { 0 };
+	int _evictionDistance = -1;
 
-	struct VisibleBuffers {
-		int size = 0;
-		ChunkBuffer* visible[MAX_CHUNKBUFFERS];
-	};
-	VisibleBuffers _visibleBuffers;
+	Tree::Contents _visibleBuffers;
+	// the index buffer content of the meshes with implicit quad indices
+	voxel::CompactIndexArray _quadIndices;
 
 	shader::WorldShader* _worldShader;
 
 	WorldMeshExtractor _meshExtractor;
-	core::ThreadPool &_threadPool;
+	voxel::PagedVolume* _volume = nullptr;
+	glm::ivec3 _lastFocusPos { 0 };
+
+	/**
+	 * @brief Queue the page-in of the chunks along the movement of the focus position before the mesh extraction needs them
+	 */
+	void prefetch(const glm::ivec3& focusPos);
 
 	int distance2(const glm::ivec3 &pos, const glm::ivec3 &pos2) const;
 
 	void cull(const video::Camera &camera);
+	/**
+	 * @brief Releases the chunk buffers that are out of range and schedules the extraction of the chunk
+	 * buffers whose level of detail changed. This only happens if the focus position moved by at least one
+	 * mesh size or the view distance changed.
+	 */
+	void evict(const glm::ivec3& focusPos);
+	void releaseChunkBuffer(int slot);
+	/**
+	 * @brief Uploads the extracted meshes until the upload budget of the frame is used up
+	 */
 	void handleMeshQueue();
+	/**
+	 * @return The amount of bytes that were uploaded
+	 */
+	size_t uploadMesh(voxel::Mesh& mesh, int lod);
 public:
-	WorldChunkMgr(core::ThreadPool& threadPool);
+	WorldChunkMgr();
 
 	int renderTerrain();
 
@@ -4,9 +4,14 @@
 
 #include "WorldMeshExtractor.h"
 #include "core/concurrent/Concurrency.h"
-#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/BinaryCubicSurfaceExtractor.h"
 #include "voxel/IsQuadNeeded.h"
 #include "voxel/Constants.h"
+#include "core/TimeProvider.h"
+#include "core/GameConfig.h"
+#include "voxelutil/VolumeRescaler.h"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 
 namespace voxelworldrender {
 
@@ -15,17 +20,30 @@ WorldMeshExtractor::WorldMeshExtractor() {
 
 bool WorldMeshExtractor::init(voxel::PagedVolume *volume) {
 	_volume = volume;
+	_abort = false;
+	_extracted.reset();
 	_meshSize = core::Var::getSafe(cfg::VoxelMeshSize);
+	_lodDistance = core::Var::get(cfg::VoxelMeshLodDistance, "4", 0, "The amount of mesh sizes around the focus that are extracted with the full resolution - every further level of detail covers twice the distance of the previous one");
+	_prefetchPool.init();
 	return true;
 }
 
 void WorldMeshExtractor::shutdown() {
-	_pendingExtraction.clear();
-	_pendingExtraction.abortWait();
+	_abort = true;
+	// the queued page-ins are dropped - the running ones are finished before the volume is released
+	_prefetchPool.shutdown();
+	_prefetchPool.abort();
+	{
+		core::ScopedLock<core::Lock> lock(_jobLock);
+		for (std::vector<ExtractionJob>& bucket : _buckets) {
+			bucket.clear();
+		}
+		_firstBucket = PriorityBuckets;
+		_positions.clear();
+		_jobCondition.notify_all();
+	}
 	_extracted.clear();
 	_extracted.abortWait();
-	_positionsExtracted.clear();
-	_extracted.clear();
 	_volume = nullptr;
 }
 
@@ -34,13 +52,48 @@ void WorldMeshExtractor::reset() {
 		_volume->flushAll();
 	}
 	_extracted.clear();
-	_positionsExtracted.clear();
-	_pendingExtraction.clear();
+	{
+		core::ScopedLock<core::Lock> lock(_jobLock);
+		for (std::vector<ExtractionJob>& bucket : _buckets) {
+			bucket.clear();
+		}
+		_firstBucket = PriorityBuckets;
+		_positions.clear();
+		_statistics = Statistics();
+	}
+	{
+		core::ScopedLock<core::Lock> lock(_lodVoxelsLock);
+		_lodVoxels.clear();
+		_lodVoxelsOrder.clear();
+		_lodVoxelsNext = 0u;
+	}
+	core::ScopedLock<core::Lock> lock(_meshBufferSizesLock);
+	_meshBufferSizes.clear();
+	_averageMeshBufferSize = MeshBufferSize();
 }
 
 bool WorldMeshExtractor::pop(voxel::Mesh& item) {
-	core_trace_value_scoped(QueryNewMesh, _positionsExtracted.size());
-	return _extracted.pop(item);
+	int lod;
+	return pop(item, lod);
+}
+
+bool WorldMeshExtractor::pop(voxel::Mesh& item, int& lod) {
+	core_trace_scoped(QueryNewMesh);
+	ExtractedMesh extracted;
+	while (_extracted.pop(extracted)) {
+		core::ScopedLock<core::Lock> lock(_jobLock);
+		core_trace_plot("WorldMeshExtractorPositions", (int64_t)_positions.size());
+		--_statistics.queueDepth[(int)Stage::UploadReady];
+		if (isCancelled(extracted.mesh.getOffset(), extracted.ticket)) {
+			++_statistics.cancelled;
+			continue;
+		}
+		finishStage(Stage::UploadReady, extracted.stageStart);
+		item = core::move(extracted.mesh);
+		lod = extracted.lod;
+		return true;
+	}
+	return false;
 }
 
 glm::ivec3 WorldMeshExtractor::meshPos(const glm::ivec3& pos) const {
@@ -56,20 +109,147 @@ glm::ivec3 WorldMeshExtractor::meshSize() const {
 	return glm::ivec3(s, voxel::MAX_MESH_CHUNK_HEIGHT, s);
 }
 
+int WorldMeshExtractor::prefetch(const glm::ivec3& focusPos, const glm::ivec3& movement) {
+	if (_volume == nullptr) {
+		return 0;
+	}
+	const glm::ivec3& size = meshSize();
+	const glm::ivec3 extent(size.x, 0, size.z);
+	return _volume->prefetch(focusPos, movement, extent, _prefetchPool);
+}
+
+WorldMeshExtractor::Statistics WorldMeshExtractor::statistics() const {
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	return _statistics;
+}
+
+int WorldMeshExtractor::priority(const glm::ivec3& pos) const {
+	const glm::ivec3& size = meshSize();
+	const glm::vec2 d(_focusPos.x - (pos.x + size.x / 2), _focusPos.z - (pos.z + size.z / 2));
+	int ring = (int)(glm::length(d) / (float)size.x);
+	if (_useFrustum && !_frustum.isVisible(glm::vec3(pos), glm::vec3(pos + size))) {
+		ring += InvisiblePenalty;
+	}
+	return glm::clamp(ring, 0, PriorityBuckets - 1);
+}
+
+int WorldMeshExtractor::lodLocked(const glm::ivec3& pos) const {
+	const int lodDistance = _lodDistance->intVal();
+	if (lodDistance <= 0) {
+		return 0;
+	}
+	const glm::ivec3& size = meshSize();
+	const glm::vec2 d(_focusPos.x - (pos.x + size.x / 2), _focusPos.z - (pos.z + size.z / 2));
+	const int ring = (int)(glm::length(d) / (float)size.x);
+	int lod = 0;
+	// a mesh needs at least two voxels per axis
+	for (int limit = lodDistance; ring >= limit && lod < MaxLod && (size.x >> (lod + 1)) >= 2; limit *= 2) {
+		++lod;
+	}
+	return lod;
+}
+
+int WorldMeshExtractor::lod(const glm::ivec3& pos) const {
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	return lodLocked(meshPos(pos));
+}
+
+bool WorldMeshExtractor::isCancelled(const glm::ivec3& pos, uint32_t ticket) const {
+	auto i = _positions.find(pos);
+	return i == _positions.end() || i->second != ticket;
+}
+
+void WorldMeshExtractor::finishStage(Stage stage, uint64_t stageStart) {
+	const double millis = (double)(core::TimeProvider::highResTime() - stageStart) * 1000.0 / (double)core::TimeProvider::highResTimeResolution();
+	double& latency = _statistics.latencyMillis[(int)stage];
+	// exponential moving average - to see the current stalls and not the ones from the start
+	latency = latency == 0.0 ? millis : glm::mix(latency, millis, 0.1);
+}
+
+void WorldMeshExtractor::setMaxDistance(int maxDistance2) {
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	_maxDistance2 = maxDistance2;
+}
+
 void WorldMeshExtractor::updateExtractionOrder(const glm::ivec3& sortPos) {
-	core_trace_value_scoped(SortExtractionOrder, _pendingExtraction.size());
-	const glm::ivec3& d = glm::abs(_pendingExtractionSortPosition - sortPos);
-	const int allowedDelta = 3 * _meshSize->intVal();
+	const glm::ivec3& d = glm::abs(_focusPos - sortPos);
+	const int allowedDelta = _meshSize->intVal();
 	if (d.x < allowedDelta && d.z < allowedDelta) {
 		return;
 	}
-	_pendingExtractionSortPosition = sortPos;
-	_pendingExtraction.setComparator(CloseToPoint(sortPos));
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	_focusPos = sortPos;
+	_useFrustum = false;
+	reprioritize();
+}
+
+void WorldMeshExtractor::updateExtractionOrder(const glm::ivec3& sortPos, const math::Frustum& frustum) {
+	// the view changes with every frame - but walking all scheduled positions blocks the extraction threads.
+	// Only do it if the focus moved by a mesh size or the view direction changed noticeably.
+	glm::vec3 viewDir = frustum.plane(math::FrustumPlanes::Far).norm();
+	const float viewDirLength = glm::length(viewDir);
+	if (viewDirLength > 0.0f) {
+		viewDir /= viewDirLength;
+	}
+	if (_useFrustum) {
+		const glm::ivec3& d = glm::abs(_focusPos - sortPos);
+		const int allowedDelta = _meshSize->intVal();
+		if (d.x < allowedDelta && d.z < allowedDelta && glm::dot(_viewDir, viewDir) >= MinViewDirDot) {
+			return;
+		}
+	}
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	_viewDir = viewDir;
+	_focusPos = sortPos;
+	_frustum = frustum;
+	_useFrustum = true;
+	reprioritize();
+}
+
+void WorldMeshExtractor::reprioritize() {
+	core_trace_value_scoped(SortExtractionOrder, _statistics.queueDepth[(int)Stage::Scheduled]);
+	_reprioritize.clear();
+	for (int i = _firstBucket; i < PriorityBuckets; ++i) {
+		_reprioritize.insert(_reprioritize.end(), _buckets[i].begin(), _buckets[i].end());
+		_buckets[i].clear();
+	}
+	_firstBucket = PriorityBuckets;
+	for (const ExtractionJob& job : _reprioritize) {
+		if (isCancelled(job.pos, job.ticket)) {
+			--_statistics.queueDepth[(int)Stage::Scheduled];
+			++_statistics.cancelled;
+			continue;
+		}
+		if (!isInRange(job.pos)) {
+			_positions.erase(job.pos);
+			--_statistics.queueDepth[(int)Stage::Scheduled];
+			++_statistics.cancelled;
+			continue;
+		}
+		const int bucket = priority(job.pos);
+		_buckets[bucket].push_back(job);
+		_buckets[bucket].back().lod = lodLocked(job.pos);
+		_firstBucket = core_min(_firstBucket, bucket);
+	}
+}
+
+bool WorldMeshExtractor::isInRange(const glm::ivec3& pos) const {
+	if (_maxDistance2 < 0) {
+		return true;
+	}
+	// we are only taking the x and z axis into account here
+	const glm::ivec2 d(pos.x - _focusPos.x, pos.z - _focusPos.z);
+	return d.x * d.x + d.y * d.y < _maxDistance2;
 }
 
 bool WorldMeshExtractor::allowReExtraction(const glm::ivec3& pos) {
 	const glm::ivec3& gridPos = meshPos(pos);
-	return _positionsExtracted.erase(gridPos) != 0;
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	{
+		core::ScopedLock<core::Lock> sizesLock(_meshBufferSizesLock);
+		_meshBufferSizes.erase(gridPos);
+	}
+	return _positions.erase(gridPos) != 0;
 }
 
 // Extract the surface for the specified region of the volume.
@@ -77,35 +257,296 @@ bool WorldMeshExtractor::allowReExtraction(const glm::ivec3& pos) {
 // is not directly suitable for rendering.
 bool WorldMeshExtractor::scheduleMeshExtraction(const glm::ivec3& p) {
 	const glm::ivec3& pos = meshPos(p);
-	auto i = _positionsExtracted.insert(pos);
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	if (!isInRange(pos)) {
+		return false;
+	}
+	auto i = _positions.emplace(pos, _nextTicket);
 	if (!i.second) {
 		return false;
 	}
 	Log::trace("mesh extraction for %i:%i:%i (%i:%i:%i)",
 			p.x, p.y, p.z, pos.x, pos.y, pos.z);
-	_pendingExtraction.push(pos);
+	ExtractionJob job;
+	job.pos = pos;
+	job.lod = lodLocked(pos);
+	job.ticket = _nextTicket++;
+	job.stageStart = core::TimeProvider::highResTime();
+	const int bucket = priority(pos);
+	_buckets[bucket].push_back(job);
+	_firstBucket = core_min(_firstBucket, bucket);
+	++_statistics.queueDepth[(int)Stage::Scheduled];
+	_jobCondition.notify_one();
 	return true;
 }
 
+bool WorldMeshExtractor::rescheduleMeshExtraction(const glm::ivec3& p) {
+	const glm::ivec3& pos = meshPos(p);
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	auto i = _positions.find(pos);
+	if (i == _positions.end()) {
+		return false;
+	}
+	// the pending job of the position (if any) is skipped because of the new ticket
+	i->second = _nextTicket;
+	ExtractionJob job;
+	job.pos = pos;
+	job.lod = lodLocked(pos);
+	job.ticket = _nextTicket++;
+	job.stageStart = core::TimeProvider::highResTime();
+	const int bucket = priority(pos);
+	_buckets[bucket].push_back(job);
+	_firstBucket = core_min(_firstBucket, bucket);
+	++_statistics.queueDepth[(int)Stage::Scheduled];
+	_jobCondition.notify_one();
+	return true;
+}
+
+bool WorldMeshExtractor::waitAndPop(ExtractionJob& job, int& jobPriority) {
+	core::ScopedLock<core::Lock> lock(_jobLock);
+	for (;;) {
+		if (_abort) {
+			return false;
+		}
+		while (_firstBucket < PriorityBuckets && _buckets[_firstBucket].empty()) {
+			++_firstBucket;
+		}
+		if (_firstBucket >= PriorityBuckets) {
+			_jobCondition.wait(_jobLock);
+			continue;
+		}
+		std::vector<ExtractionJob>& bucket = _buckets[_firstBucket];
+		job = bucket.back();
+		bucket.pop_back();
+		--_statistics.queueDepth[(int)Stage::Scheduled];
+		if (isCancelled(job.pos, job.ticket)) {
+			++_statistics.cancelled;
+			continue;
+		}
+		jobPriority = _firstBucket;
+		finishStage(Stage::Scheduled, job.stageStart);
+		++_statistics.queueDepth[(int)Stage::PageIn];
+		return true;
+	}
+}
+
+WorldMeshExtractor::MeshBufferSize WorldMeshExtractor::estimateMeshBufferSize(const glm::ivec3& pos, const voxel::Region& region) {
+	MeshBufferSize size;
+	bool extracted = false;
+	{
+		core::ScopedLock<core::Lock> lock(_meshBufferSizesLock);
+		auto i = _meshBufferSizes.find(pos);
+		extracted = i != _meshBufferSizes.end();
+		size = extracted ? i->second : _averageMeshBufferSize;
+	}
+	if (!extracted && size.vertices == 0) {
+		// nothing was extracted yet - this is just a rough guess
+		const int factor = 64;
+		size.vertices = size.indices = region.getWidthInVoxels() * region.getDepthInVoxels() * factor;
+		return size;
+	}
+	// some headroom - e.g. for modifications since the last extraction
+	size.vertices += size.vertices / 8;
+	size.indices += size.indices / 8;
+	return size;
+}
+
+void WorldMeshExtractor::updateMeshBufferSize(const glm::ivec3& pos, const MeshBufferSize& size) {
+	core::ScopedLock<core::Lock> lock(_meshBufferSizesLock);
+	_meshBufferSizes[pos] = size;
+	if (size.vertices == 0) {
+		return;
+	}
+	// exponential moving average - the buffers may grow if a mesh is bigger than that
+	MeshBufferSize& average = _averageMeshBufferSize;
+	if (average.vertices == 0) {
+		average = size;
+		return;
+	}
+	average.vertices = (int)glm::mix((double)average.vertices, (double)size.vertices, 0.1);
+	average.indices = (int)glm::mix((double)average.indices, (double)size.indices, 0.1);
+}
+
+void WorldMeshExtractor::pageIn(const voxel::Region& region) {
+	core_trace_scoped(MeshPageIn);
+	// the extractor also reads the direct neighbours of the region
+	const int chunkSize = _volume->chunkSideLength();
+	const glm::ivec3& mins = region.getLowerCorner() - 1;
+	const glm::ivec3& maxs = region.getUpperCorner() + 1;
+	for (int z = mins.z; z <= maxs.z + chunkSize - 1; z += chunkSize) {
+		for (int y = mins.y; y <= maxs.y + chunkSize - 1; y += chunkSize) {
+			for (int x = mins.x; x <= maxs.x + chunkSize - 1; x += chunkSize) {
+				_volume->voxel(core_min(x, maxs.x), core_min(y, maxs.y), core_min(z, maxs.z));
+			}
+		}
+	}
+}
+
+WorldMeshExtractor::LodVoxelsPtr WorldMeshExtractor::lodVoxels(const glm::ivec3& pos, int lod) {
+	const glm::ivec4 key(pos, lod);
+	{
+		core::ScopedLock<core::Lock> lock(_lodVoxelsLock);
+		auto i = _lodVoxels.find(key);
+		if (i != _lodVoxels.end()) {
+			return i->second;
+		}
+	}
+	core_trace_scoped(MeshDownsample);
+	const int factor = 1 << lod;
+	const glm::ivec3& size = meshSize();
+	LodVoxelsPtr entry = core::make_shared<LodVoxels>();
+	// the same height as the full resolution mesh - see extractScheduledMesh()
+	entry->size = glm::ivec3(size.x / factor, (size.y - 1) / factor, size.z / factor);
+	const glm::ivec3 padded = entry->size + 2;
+	entry->voxels.resize((size_t)padded.x * padded.y * padded.z);
+	// the border voxels are downsampled, too
+	voxel::downsampleVolume(*_volume, pos - factor, factor, padded, entry->voxels.data());
+
+	core::ScopedLock<core::Lock> lock(_lodVoxelsLock);
+	auto i = _lodVoxels.emplace(key, entry);
+	if (!i.second) {
+		// another thread was faster
+		return i.first->second;
+	}
+	if (_lodVoxelsOrder.size() < MaxLodVoxels) {
+		_lodVoxelsOrder.push_back(key);
+	} else {
+		_lodVoxels.erase(_lodVoxelsOrder[_lodVoxelsNext]);
+		_lodVoxelsOrder[_lodVoxelsNext] = key;
+		_lodVoxelsNext = (_lodVoxelsNext + 1u) % MaxLodVoxels;
+	}
+	return entry;
+}
+
+// the amount of voxels below the surface of the neighbouring columns that are removed for the skirts
+static constexpr int SkirtDepth = 2;
+
+/**
+ * @brief The neighbouring mesh might have a finer level of detail - its surface doesn't exactly match the
+ * downsampled surface. The upper voxels of the border columns on the sides are removed, so the sides of
+ * the mesh get faces (skirts) down to below the surface of the neighbours. This closes the gaps between
+ * the meshes of different levels of detail.
+ */
+static void removeSideBorderSurface(std::vector<voxel::Voxel>& voxels, const glm::ivec3& padded) {
+	for (int z = 0; z < padded.z; ++z) {
+		for (int x = 0; x < padded.x; ++x) {
+			if (x != 0 && x != padded.x - 1 && z != 0 && z != padded.z - 1) {
+				continue;
+			}
+			const size_t column = (size_t)z * padded.x * padded.y + x;
+			const size_t stride = padded.x;
+			for (int y = padded.y - 1; y >= 0; --y) {
+				const voxel::VoxelType material = voxels[column + y * stride].getMaterial();
+				if (voxel::isAir(material) || voxel::isWater(material)) {
+					continue;
+				}
+				for (int skirt = y; skirt >= 0 && skirt > y - SkirtDepth; --skirt) {
+					voxels[column + skirt * stride] = voxel::Voxel();
+				}
+				break;
+			}
+		}
+	}
+}
+
+void WorldMeshExtractor::extractLodMesh(voxel::ExtractionContext& ctx, const glm::ivec3& pos, int lod, const LodVoxels& lodVoxels, voxel::Mesh& mesh) {
+	core_trace_scoped(ExtractLodMesh);
+	// see the opaque lookup table of voxel::extractBinaryCubicMesh()
+	struct OpaqueTable {
+		bool opaque[core::enumVal(voxel::VoxelType::Max)];
+		OpaqueTable() {
+			for (int i = 0; i < core::enumVal(voxel::VoxelType::Max); ++i) {
+				opaque[i] = voxel::IsQuadNeeded()((voxel::VoxelType)i, voxel::VoxelType::Air, voxel::FaceNames::NegativeX);
+			}
+		}
+	};
+	static const OpaqueTable table;
+
+	const glm::ivec3 padded = lodVoxels.size + 2;
+	ctx.voxels = lodVoxels.voxels;
+	removeSideBorderSurface(ctx.voxels, padded);
+	mesh.clear();
+	voxel::extractBinaryCubicMesh(ctx, lodVoxels.size, table.opaque, &mesh, glm::ivec3(0), true, true, true);
+	mesh.setOffset(pos);
+	// scale the vertices of the lower resolution into the world
+	const int factor = 1 << lod;
+	for (voxel::VoxelVertex& vertex : mesh.getVertexVector()) {
+		vertex.position = glm::i16vec3(glm::ivec3(vertex.position) * factor + pos);
+	}
+}
+
 void WorldMeshExtractor::extractScheduledMesh() {
-	decltype(_pendingExtraction)::Key pos;
-	if (!_pendingExtraction.waitAndPop(pos)) {
+	ExtractionJob job;
+	int jobPriority = 0;
+	if (!waitAndPop(job, jobPriority)) {
 		return;
 	}
 	core_trace_scoped(MeshExtraction);
+	const glm::ivec3& pos = job.pos;
 	const glm::ivec3& size = meshSize();
 	const glm::ivec3 mins(pos);
 	const glm::ivec3 maxs(pos.x + size.x - 1, pos.y + size.y - 2, pos.z + size.z - 1);
 	const voxel::Region region(mins, maxs);
-	// these numbers are made up mostly by try-and-error - we need to revisit them from time to time to prevent extra mem allocs
-	// they also heavily depend on the size of the mesh region we extract
-	const int factor = 64;
-	const int vertices = region.getWidthInVoxels() * region.getDepthInVoxels() * factor;
-	voxel::Mesh mesh(vertices, vertices);
-	voxel::extractCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner());
-	if (!mesh.isEmpty()) {
-		_extracted.push(std::move(mesh));
+
+	uint64_t stageStart = core::TimeProvider::highResTime();
+	LodVoxelsPtr lodVoxels;
+	if (job.lod == 0) {
+		pageIn(region);
+	} else {
+		// this includes the page-in of the source voxels if they are not cached yet
+		lodVoxels = this->lodVoxels(pos, job.lod);
+	}
+	{
+		core::ScopedLock<core::Lock> lock(_jobLock);
+		finishStage(Stage::PageIn, stageStart);
+		--_statistics.queueDepth[(int)Stage::PageIn];
+		// the position might have been cancelled while the chunks were generated
+		if (isCancelled(pos, job.ticket)) {
+			++_statistics.cancelled;
+			return;
+		}
+		++_statistics.queueDepth[(int)Stage::Extract];
 	}
+
+	stageStart = core::TimeProvider::highResTime();
+	// the extraction buffers are reused for all the meshes that are extracted by this thread
+	thread_local voxel::ExtractionContext ctx;
+	const MeshBufferSize& bufferSize = estimateMeshBufferSize(pos, region);
+	ExtractedMesh extracted;
+	extracted.mesh = voxel::Mesh(bufferSize.vertices, bufferSize.indices, true);
+	extracted.lod = job.lod;
+	voxel::Mesh& mesh = extracted.mesh;
+	if (lodVoxels) {
+		extractLodMesh(ctx, pos, job.lod, *lodVoxels.get(), mesh);
+	} else {
+		voxel::extractBinaryCubicMesh(ctx, _volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner());
+	}
+	MeshBufferSize extractedSize;
+	extractedSize.vertices = (int)mesh.getNoOfVertices();
+	extractedSize.indices = (int)mesh.getNoOfIndices();
+	if (mesh.isEmpty()) {
+		// empty meshes are handed out, too - they replace the mesh of the previous level of detail.
+		// The reserved buffers are not needed for that.
+		mesh = voxel::Mesh(0, 0);
+		mesh.setOffset(pos);
+	} else if (!mesh.compressIndices()) {
+		// only the 16 bit indices are kept until the mesh is uploaded
+		Log::warn("Failed to compress the indices of the mesh at %i:%i:%i", pos.x, pos.y, pos.z);
+	}
+	{
+		core::ScopedLock<core::Lock> lock(_jobLock);
+		finishStage(Stage::Extract, stageStart);
+		--_statistics.queueDepth[(int)Stage::Extract];
+		++_statistics.queueDepth[(int)Stage::UploadReady];
+		// the sizes of released positions are not kept - see allowReExtraction()
+		if (!isCancelled(pos, job.ticket)) {
+			updateMeshBufferSize(pos, extractedSize);
+		}
+	}
+	extracted.ticket = job.ticket;
+	extracted.priority = jobPriority;
+	extracted.stageStart = core::TimeProvider::highResTime();
+	_extracted.push(core::move(extracted));
 }
 
-}
\ No newline at end of file
+}
@@ -10,42 +10,202 @@
 #include "core/collection/ConcurrentQueue.h"
 #include "voxel/PagedVolume.h"
 #include "core/concurrent/Atomic.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
+#include "math/Frustum.h"
 
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
 #include <glm/vec3.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+namespace voxel {
+struct ExtractionContext;
+}
+
 namespace voxelworldrender {
 
 typedef std::unordered_set<glm::ivec3, std::hash<glm::ivec3> > PositionSet;
 
+/**
+ * @brief Extracts the meshes of the world in a pipeline of stages: A scheduled position waits in a priority
+ * queue until an extraction thread picks it up, pages in the chunks of the mesh region, extracts the mesh
+ * and hands it over to be uploaded by the render thread.
+ *
+ * The scheduled positions are kept in buckets by their priority (the distance to the focus position and
+ * whether they are inside of the view frustum). Changing the focus just moves the positions into other
+ * buckets and positions that are out of range are cancelled. A cancelled position is skipped in every
+ * stage it is in - even if it was already extracted and only waits for the upload.
+ */
 class WorldMeshExtractor {
+public:
+	// the meshes of this level of detail have 1/2^MaxLod of the voxels per axis
+	static constexpr int MaxLod = 3;
+
+	enum class Stage : uint8_t {
+		// waiting for an extraction thread
+		Scheduled,
+		// the chunks of the mesh region are paged in
+		PageIn,
+		// the mesh is extracted
+		Extract,
+		// waiting for the upload by the render thread
+		UploadReady,
+
+		Max
+	};
+
+	struct Statistics {
+		// the amount of positions that are waiting in the given stage or are processed by it
+		int queueDepth[(int)Stage::Max] {};
+		// the (smoothed) time in millis that the meshes spent in the given stage
+		double latencyMillis[(int)Stage::Max] {};
+		// the amount of jobs that were cancelled since the last reset
+		int cancelled = 0;
+	};
+
 private:
-	core::ConcurrentQueue<voxel::Mesh> _extracted;
-	glm::ivec3 _pendingExtractionSortPosition { 0, 0, 0 };
-	struct CloseToPoint {
-		glm::ivec2 _refPoint;
-		CloseToPoint(const glm::ivec3& refPoint) : _refPoint(refPoint.x, refPoint.z) {
-		}
-		inline int distanceToSortPos(const glm::ivec3 &pos) const {
-			const glm::ivec2 d(_refPoint.x - pos.x, _refPoint.y - pos.z);
-			return d.x * d.x + d.y * d.y;
-		}
-		inline bool operator()(const glm::ivec3& lhs, const glm::ivec3& rhs) const {
-			return distanceToSortPos(lhs) > distanceToSortPos(rhs);
+	struct ExtractionJob {
+		glm::ivec3 pos { 0 };
+		int lod = 0;
+		// identifies the job of the position - a rescheduled position gets a new ticket
+		uint32_t ticket = 0u;
+		// the high resolution time the job entered the current stage
+		uint64_t stageStart = 0u;
+	};
+
+	struct ExtractedMesh {
+		voxel::Mesh mesh;
+		int lod = 0;
+		uint32_t ticket = 0u;
+		uint64_t stageStart = 0u;
+		int priority = 0;
+
+		// the mesh with the lowest priority value is uploaded first
+		inline bool operator<(const ExtractedMesh& rhs) const {
+			return priority > rhs.priority;
 		}
 	};
+	core::ConcurrentQueue<ExtractedMesh> _extracted;
+
+	// the rings of mesh sizes around the focus position - the ring of a position is its priority
+	static constexpr int PriorityBuckets = 64;
+	// positions outside of the view frustum are handled as if they were this amount of rings further away
+	static constexpr int InvisiblePenalty = 4;
+	std::vector<ExtractionJob> _buckets[PriorityBuckets];
+	// the scratch buffer for moving the jobs into other buckets
+	std::vector<ExtractionJob> _reprioritize;
+	// the first bucket that might contain a job
+	int _firstBucket = PriorityBuckets;
+	// the positions that are scheduled, extracted or uploaded - mapped to the ticket of their current job.
+	// a position that is removed from here is cancelled.
+	std::unordered_map<glm::ivec3, uint32_t, std::hash<glm::ivec3> > _positions;
+	uint32_t _nextTicket = 0u;
+	glm::ivec3 _focusPos { 0 };
+	math::Frustum _frustum;
+	// the view direction of the frustum the jobs were sorted with last time
+	glm::vec3 _viewDir { 0.0f };
+	// the cosine of the view direction change (~15 degrees) that leads to sorting the jobs again
+	static constexpr float MinViewDirDot = 0.966f;
+	bool _useFrustum = false;
+	// squared distance in the xz plane - scheduled positions that are further away are cancelled
+	int _maxDistance2 = -1;
+	Statistics _statistics;
+	core_trace_mutex(core::Lock, _jobLock, "WorldMeshExtractorJobs");
+	core::ConditionVariable _jobCondition;
+	core::AtomicBool _abort { false };
 
-	core::ConcurrentQueue<glm::ivec3, CloseToPoint> _pendingExtraction { CloseToPoint(_pendingExtractionSortPosition) };
-	// fast lookup for positions that are already extracted
-	PositionSet _positionsExtracted;
 	core::VarPtr _meshSize;
+	core::VarPtr _lodDistance;
 	voxel::PagedVolume *_volume = nullptr;
+	// the page-in of the chunks ahead of the extraction - the extraction threads are busy with the
+	// scheduled positions and can't pick up these tasks
+	core::ThreadPool _prefetchPool { 2, "WorldPrefetch" };
+
+	/**
+	 * @brief The downsampled voxels of a mesh position for one level of detail - with a border of one
+	 * voxel on each side in the layout that the mesh extraction needs.
+	 */
+	struct LodVoxels {
+		// the amount of voxels per axis without the border
+		glm::ivec3 size { 0 };
+		std::vector<voxel::Voxel> voxels;
+	};
+	typedef core::SharedPtr<LodVoxels> LodVoxelsPtr;
+	// the amount of downsampled mesh positions that are kept - the oldest ones are evicted first
+	static constexpr size_t MaxLodVoxels = 512;
+	core_trace_mutex(core::Lock, _lodVoxelsLock, "WorldMeshExtractorLodVoxels");
+	// the key is the mesh position and the level of detail
+	std::unordered_map<glm::ivec4, LodVoxelsPtr, std::hash<glm::ivec4> > _lodVoxels;
+	// the keys in insertion order - this is a ring buffer of MaxLodVoxels entries
+	std::vector<glm::ivec4> _lodVoxelsOrder;
+	size_t _lodVoxelsNext = 0u;
+
+	/**
+	 * @brief Looks up the cached downsampled voxels of the given mesh position or creates them
+	 */
+	LodVoxelsPtr lodVoxels(const glm::ivec3& pos, int lod);
+	void extractLodMesh(voxel::ExtractionContext& ctx, const glm::ivec3& pos, int lod, const LodVoxels& lodVoxels, voxel::Mesh& mesh);
+
+	/**
+	 * @brief The amount of vertices and indices of the last extraction of a mesh position. Used to size
+	 * the buffers of the next extraction of the same position.
+	 */
+	struct MeshBufferSize {
+		int vertices = 0;
+		int indices = 0;
+	};
+	// the entries are removed together with the extracted mesh - see allowReExtraction()
+	std::unordered_map<glm::ivec3, MeshBufferSize, std::hash<glm::ivec3> > _meshBufferSizes;
+	// the running average of the non empty meshes - the estimation for positions that weren't extracted before
+	MeshBufferSize _averageMeshBufferSize;
+	core_trace_mutex(core::Lock, _meshBufferSizesLock, "MeshBufferSizes");
+
+	MeshBufferSize estimateMeshBufferSize(const glm::ivec3& pos, const voxel::Region& region);
+	void updateMeshBufferSize(const glm::ivec3& pos, const MeshBufferSize& size);
+
+	/**
+	 * @note The job lock must be held
+	 */
+	int priority(const glm::ivec3& pos) const;
+	/**
+	 * @note The job lock must be held
+	 */
+	int lodLocked(const glm::ivec3& pos) const;
+	/**
+	 * @note The job lock must be held
+	 */
+	bool isCancelled(const glm::ivec3& pos, uint32_t ticket) const;
+	/**
+	 * @note The job lock must be held
+	 */
+	void finishStage(Stage stage, uint64_t stageStart);
+	/**
+	 * @brief Blocks until there is a job that is not cancelled or the extractor is shut down
+	 */
+	bool waitAndPop(ExtractionJob& job, int& jobPriority);
+	/**
+	 * @brief Moves the scheduled positions into the buckets of their current priority and cancels the
+	 * positions that are out of range
+	 * @note The job lock must be held
+	 */
+	void reprioritize();
+	/**
+	 * @note The job lock must be held
+	 */
+	bool isInRange(const glm::ivec3& pos) const;
+	void pageIn(const voxel::Region& region);
 
 public:
 	WorldMeshExtractor();
 
+	/**
+	 * @brief Handles the next scheduled position - blocks until there is one. This is supposed to be called
+	 * from the extraction threads.
+	 */
 	void extractScheduledMesh();
 
 	/**
@@ -53,9 +213,15 @@ public:
 	 * @return @c false if this isn't the case, @c true if the given reference was filled with valid data.
 	 */
 	bool pop(voxel::Mesh& item);
+	/**
+	 * @param[out] lod The level of detail the mesh was extracted with
+	 * @note The mesh might be empty - e.g. if nothing is left of the surface for a lower level of detail
+	 */
+	bool pop(voxel::Mesh& item, int& lod);
 
 	/**
 	 * @brief If you don't need an extracted mesh anymore, make sure to allow the reextraction at a later time.
+	 * This also cancels the extraction of the position if it wasn't uploaded yet.
 	 * @param[in] pos A world position vector that is automatically converted into a mesh tile vector
 	 * @return @c true if the given position was already extracted, @c false if not.
 	 */
@@ -65,6 +231,18 @@ public:
 	 * @brief Reorder the scheduled extraction commands that the closest chunks to the given position are handled first
 	 */
 	void updateExtractionOrder(const glm::ivec3& sortPos);
+	/**
+	 * @brief Reorder the scheduled extraction commands that the closest chunks to the given position that are
+	 * inside the given frustum are handled first.
+	 */
+	void updateExtractionOrder(const glm::ivec3& sortPos, const math::Frustum& frustum);
+
+	/**
+	 * @brief Scheduled positions that are further away from the focus position than the given distance are
+	 * cancelled with the next update of the extraction order.
+	 * @param[in] maxDistance2 The squared distance on the xz plane or @c -1 to keep all positions
+	 */
+	void setMaxDistance(int maxDistance2);
 
 	/**
 	 * @brief Performs async mesh extraction. You need to call @c pop in order to see if some extraction is ready.
@@ -74,6 +252,30 @@ public:
 	 */
 	bool scheduleMeshExtraction(const glm::ivec3& pos);
 
+	/**
+	 * @brief Schedules the extraction of an already scheduled or extracted position again - e.g. because the
+	 * level of detail of the position changed. A pending extraction of the position is replaced.
+	 * @return @c false if the position isn't scheduled or extracted
+	 */
+	bool rescheduleMeshExtraction(const glm::ivec3& pos);
+
+	/**
+	 * @brief The level of detail of the given mesh position for the current focus position. The level of
+	 * detail is increased by one with every ring around the focus position that is twice as far away as
+	 * the previous one - see @c cfg::VoxelMeshLodDistance.
+	 * @return @c 0 for the full resolution up to @c MaxLod
+	 */
+	int lod(const glm::ivec3& pos) const;
+
+	/**
+	 * @brief Queues the page-in of the chunks around the focus position and along the movement vector
+	 * in the background - the chunks are ready once the extraction of their mesh positions starts.
+	 * @return The amount of chunks that were queued
+	 */
+	int prefetch(const glm::ivec3& focusPos, const glm::ivec3& movement);
+
+	Statistics statistics() const;
+
 	void reset();
 
 	/**
@@ -87,4 +289,4 @@ public:
 	void shutdown();
 };
 
-}
\ No newline at end of file
+}
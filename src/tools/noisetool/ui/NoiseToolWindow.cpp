@@ -6,6 +6,7 @@
 #include "../NoiseTool.h"
 #include "noisedata/NoiseDataItemWidget.h"
 #include "noise/Noise.h"
+#include "noise/BatchNoise.h"
 #include "ui/turbobadger/UIApp.h"
 #include "core/Color.h"
 #include "core/TimeProvider.h"
@@ -14,6 +15,7 @@
 #include "NoiseDataNodeWindow.h"
 #include "noise/PoissonDiskDistribution.h"
 #include "noise/Simplex.h"
+#include <vector>
 
 #define IMAGE_PREFIX "2d"
 #define GRAPH_PREFIX "graph"
@@ -153,6 +155,30 @@ float NoiseToolWindow::getNoise(int x, int y, const NoiseData& data) {
 	return 0.0f;
 }
 
+bool NoiseToolWindow::getNoiseGrid(const NoiseData& data, float* out) const {
+	const glm::vec2 origin(data.offset);
+	const glm::vec2 step(data.frequency);
+	const glm::ivec2 size(_noiseWidth, _noiseHeight);
+	switch (data.noiseType) {
+	case NoiseType::simplexNoise:
+		noise::noiseGrid(origin, step, size, out);
+		return true;
+	case NoiseType::fbm:
+		noise::fBmGrid(origin, step, size, out, data.octaves, data.lacunarity, data.gain);
+		return true;
+	case NoiseType::ridgedMF:
+		noise::ridgedMFGrid(origin, step, size, out, data.ridgedOffset, data.octaves, data.lacunarity, data.gain);
+		return true;
+	case NoiseType::ridgedMFTime:
+		noise::ridgedMFGrid(glm::vec3(origin, data.millis * 0.1f), glm::vec3(step, 0.0f), glm::ivec3(size, 1), out,
+				data.ridgedOffset, data.octaves, data.lacunarity, data.gain);
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
 bool NoiseToolWindow::onEvent(const tb::TBWidgetEvent &ev) {
 	const tb::TBID& id = ev.target->getID();
 	if (ev.type == tb::EVENT_TYPE_CLICK) {
@@ -245,9 +271,11 @@ void NoiseToolWindow::generateImage(NoiseType type) {
 			}
 		} else {
 			const int h = _graphHeight - 1;
+			std::vector<float> grid((size_t)_noiseWidth * _noiseHeight);
+			const bool batched = getNoiseGrid(qd.data, grid.data());
 			for (int y = 0; y < _noiseHeight; ++y) {
 				for (int x = 0; x < _noiseWidth; ++x) {
-					const float n = getNoise(x, y, qd.data);
+					const float n = batched ? grid[(size_t)y * _noiseWidth + x] : getNoise(x, y, qd.data);
 					const float cn = noise::norm(n);
 					const uint8_t c = cn * 255;
 					uint8_t* buf = &noiseBuffer[index(x, y)];
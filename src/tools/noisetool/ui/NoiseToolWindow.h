@@ -47,6 +47,11 @@ private:
 	 * @return the noise in the range [-1.0 - 1.0]
 	 */
 	float getNoise(int x, int y, const NoiseData& _data);
+	/**
+	 * @brief Evaluates the noise for the whole image with the batched noise functions
+	 * @return @c false if there is no batched version of the noise type
+	 */
+	bool getNoiseGrid(const NoiseData& data, float* out) const;
 	int index(int x, int y) const;
 	void generateImage();
 	void updateForNoiseType(NoiseType type);